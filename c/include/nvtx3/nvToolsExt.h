@@ -23,6 +23,14 @@
  * attached to the application.  The overhead when a tool is
  * attached is specific to the tool.
  *
+ * Each NVTX call still loads a function pointer and tests it when no
+ * tool is attached.  With GCC or Clang on x86-64 Linux, defining
+ * NVTX_STATIC_KEYS to 1 (e.g. with -DNVTX_STATIC_KEYS=1) makes that test a
+ * jump instruction at the call site instead.  Once NVTX finds no tool, it
+ * rewrites the jumps of the module into CMPs, and back into jumps when
+ * nvtxAttachInjectionLibraryA attaches a tool.  The code pages of the
+ * module are briefly made writable to do so.
+ *
  * \section INITIALIZATION_SECTION Initialization
  *
  * Typically the tool's library that plugs into NVTX is indirectly 
@@ -33,6 +41,16 @@
  * of what would typically be the first function call to emit info.
  * For these rare case, see \ref INITIALIZATION for additional information.
  *
+ * Loading the tool's library blocks the first NVTX call of the process.
+ * To avoid that, define NVTX_INIT_ASYNC to 1 in every translation unit
+ * of a module (e.g. with -DNVTX_INIT_ASYNC=1).  NVTX then starts loading
+ * the tool on a helper thread when the module is loaded.  Markers and
+ * ranges made before the tool is ready return at once and are not seen
+ * by the tool, nor are the pops and ends of the ranges it did not see.
+ * Calls that create handles or name objects, such as
+ * nvtxDomainCreateA or nvtxNameCategoryA, wait for the tool as usual.
+ * This is only available on platforms with POSIX threads.
+ *
  * \section MARKERS_AND_RANGES Markers and Ranges
  *
  * Markers and ranges are used to describe events at a specific time (markers)
@@ -180,9 +198,16 @@
 
 #include "nvtxDetail/nvtxLinkOnce.h"
 
-#define NVTX_VERSIONED_IDENTIFIER_L3(NAME, VERSION) NAME##_v##VERSION
-#define NVTX_VERSIONED_IDENTIFIER_L2(NAME, VERSION) NVTX_VERSIONED_IDENTIFIER_L3(NAME, VERSION)
-#define NVTX_VERSIONED_IDENTIFIER(NAME) NVTX_VERSIONED_IDENTIFIER_L2(NAME, NVTX_VERSION)
+/* Revision of this implementation of NVTX version 3.  Its nvtxGlobals and its shared functions
+*  differ from those of earlier version 3 headers, so the revision is part of the names of every
+*  shared symbol: modules whose translation units include different version 3 headers then
+*  link one instance of each, instead of merging incompatible definitions under one name.
+*  Extension headers test it to find whether this core or an earlier one was included first. */
+#define NVTX_IMPL_REVISION 1
+
+#define NVTX_VERSIONED_IDENTIFIER_L3(NAME, VERSION, REVISION) NAME##_v##VERSION##_r##REVISION
+#define NVTX_VERSIONED_IDENTIFIER_L2(NAME, VERSION, REVISION) NVTX_VERSIONED_IDENTIFIER_L3(NAME, VERSION, REVISION)
+#define NVTX_VERSIONED_IDENTIFIER(NAME) NVTX_VERSIONED_IDENTIFIER_L2(NAME, NVTX_VERSION, NVTX_IMPL_REVISION)
 
 /**
  * The nvToolsExt library depends on stdint.h.  If the build tool chain in use
@@ -224,6 +249,7 @@ extern "C" {
 #define NVTX_ERR_INIT_MISSING_LIBRARY_ENTRY_POINT 5
 #define NVTX_ERR_INIT_FAILED_LIBRARY_ENTRY_POINT 6
 #define NVTX_ERR_NO_INJECTION_LIBRARY_AVAILABLE 7
+#define NVTX_ERR_INJECTION_LIBRARY_ALREADY_ATTACHED 8
 
 /**
  * Size of the nvtxEventAttributes_t structure.
@@ -325,6 +351,189 @@ typedef union nvtxMessageValue_t
 NVTX_DECLSPEC void NVTX_API nvtxInitialize(const void* reserved);
 /** @} */
 
+/* ------------------------------------------------------------------------- */
+/** \brief Attach a tool to a process already running without one (optional)
+*
+* When NVTX initializes and finds no tool, every NVTX call becomes a no-op
+* for the rest of the process.  nvtxAttachInjectionLibraryA loads the tool's
+* library at \p path afterwards and calls its InitializeInjectionNvtx2,
+* which fills in the function tables as it would have at startup.  Other
+* threads may keep calling NVTX meanwhile: they see each function either
+* as a no-op or as the tool's, so the tool must be ready to handle a call
+* before it stores the function pointer.  Events made before attaching are
+* lost, and the tool never sees domains or registered strings that were
+* created before: code caching such handles creates them again once
+* nvtxGetAttachGeneration changes, as nvtx3.hpp does for the handles it
+* holds itself.
+*
+* Like every NVTX function, this applies to the NVTX instance of the
+* module making the call.
+*
+* \version \NVTX_VERSION_3
+*
+* \param path - path of the tool's library, as passed to dlopen or
+* LoadLibraryA.
+*
+* \return NVTX_SUCCESS once the tool is attached,
+* NVTX_ERR_INJECTION_LIBRARY_ALREADY_ATTACHED if a tool was attached
+* before, or the NVTX_ERR_INIT_* code of the step that failed.
+*
+* @{ */
+NVTX_DECLSPEC int NVTX_API nvtxAttachInjectionLibraryA(const char* path);
+/** @} */
+
+/* ------------------------------------------------------------------------- */
+/** \brief Detach the tool and unload its library (optional)
+*
+* Turns every NVTX call back into a no-op, waits until no thread is still
+* running code of the tool reached through an NVTX call, and then unloads
+* the tool's library, so a tool can be attached for a window of a long
+* running process and leave no overhead behind.  The tool learns of the
+* detach only through its library's destructors; a tool linked statically
+* stays in memory.  A tool can be attached again afterwards with
+* nvtxAttachInjectionLibraryA.
+*
+* Waiting requires NVTX API functions to count the calls they make into the
+* tool, which costs two atomic operations per call while a tool is attached.
+* Define NVTX_SUPPORT_DETACH to 1 before including NVTX, in every translation
+* unit of the module, to enable it.  Otherwise this function still turns NVTX
+* calls into no-ops, but leaves the tool's library loaded.
+*
+* Handles the tool returned, such as domains, registered strings and sync
+* objects, are invalid after detaching, and must not be passed to a tool
+* attached later; see nvtxGetAttachGeneration.  This function must not be
+* called from a tool callback.
+*
+* \version \NVTX_VERSION_3
+*
+* \return NVTX_SUCCESS once the tool is detached, or
+* NVTX_ERR_NO_INJECTION_LIBRARY_AVAILABLE if no tool was attached.
+*
+* @{ */
+NVTX_DECLSPEC int NVTX_API nvtxDetachInjectionLibrary(void);
+/** @} */
+
+/* ------------------------------------------------------------------------- */
+/** \brief Count of tools attached and detached after initialization
+*
+* nvtxAttachInjectionLibraryA and nvtxDetachInjectionLibrary increment it
+* when they succeed.  Handles the tool returned, such as domains and
+* registered strings, belong to the tool attached when they were created,
+* so code that keeps them can remember the value this function returned
+* before creating them, and create them again when it changed.  The
+* nvtx3.hpp caches, such as the domains of nvtx3::domain::get and the
+* function names of NVTX3_FUNC_RANGE, do so.  Reading it costs a load and
+* never initializes NVTX or calls into a tool.
+*
+* \version \NVTX_VERSION_3
+*
+* \return The number of attaches and detaches so far, 0 until the first.
+*
+* @{ */
+NVTX_DECLSPEC uint32_t NVTX_API nvtxGetAttachGeneration(void);
+/** @} */
+
+/* ------------------------------------------------------------------------- */
+/** \brief Whether NVTX calls currently reach a tool
+*
+* Code that spends time preparing an event, such as formatting its message
+* or computing its payload, can test this first and skip the work when no
+* tool would receive the event.  The first call initializes NVTX like any
+* other NVTX call; afterwards the test costs a load and a branch and never
+* calls into a tool.  See nvtxDomainIsEnabled to also test whether the tool
+* has turned a domain off.
+*
+* \version \NVTX_VERSION_3
+*
+* \return Nonzero if a tool is attached and the calling thread's events
+* are not paused (see nvtxPause), zero otherwise, including while NVTX is
+* still initializing in the background and when built with NVTX_DISABLE.
+*
+* \par Example:
+* \code
+* if (nvtxIsEnabled())
+* {
+*     snprintf(buffer, sizeof(buffer), "Request %d", id);
+*     nvtxRangePushA(buffer);
+* }
+* \endcode
+*
+* @{ */
+NVTX_DECLSPEC int NVTX_API nvtxIsEnabled(void);
+/** @} */
+
+/* ------------------------------------------------------------------------- */
+/** \brief Pause or resume the events of all threads
+*
+* While paused, NVTX functions recording events -- marks, ranges,
+* synchronization events and batches -- return without calling the tool.
+* Functions naming or registering objects, such as nvtxDomainCreateA and
+* nvtxDomainRegisterStringA, still reach it, so handles obtained during a
+* pause stay valid.  A tool may also pause and resume through the
+* NVTX_ETID_PAUSE export table, which changes the same state.  This lets an
+* application skip warm-up and profile only its steady state.
+*
+* Pausing does not nest: nvtxResume resumes however many times nvtxPause
+* was called.  A range begun before a pause and ended during it, or the
+* reverse, reaches the tool unbalanced; pause between ranges.
+*
+* \version \NVTX_VERSION_3
+*
+* \return NVTX_SUCCESS, or NVTX_FAIL when built with NVTX_DISABLE.
+*
+* \par Example:
+* \code
+* nvtxPause();
+* warmUp();
+* nvtxResume();
+* \endcode
+*
+* @{ */
+NVTX_DECLSPEC int NVTX_API nvtxPause(void);
+NVTX_DECLSPEC int NVTX_API nvtxResume(void);
+/** @} */
+
+/* ------------------------------------------------------------------------- */
+/** \brief Pause or resume the events of the calling thread
+*
+* Like nvtxPause and nvtxResume, for the calling thread only, to mute noisy
+* background threads.  Until a thread is first paused, the test made by
+* every event function costs one load and one branch; from then on, event
+* functions of all threads also read a thread-local flag.  A thread exiting
+* while paused leaves the other threads unaffected.
+*
+* \version \NVTX_VERSION_3
+*
+* \return NVTX_SUCCESS, or NVTX_FAIL if the compiler offers no thread-local
+* storage or when built with NVTX_DISABLE.
+*
+* @{ */
+NVTX_DECLSPEC int NVTX_API nvtxPauseThread(void);
+NVTX_DECLSPEC int NVTX_API nvtxResumeThread(void);
+/** @} */
+
+/* ------------------------------------------------------------------------- */
+/** \brief Current time in the NVTX clock domain
+*
+* NVTX functions taking a timestamp, such as nvtxDomainMarkExAt, expect it
+* in this clock domain: nanoseconds of CLOCK_MONOTONIC on POSIX systems,
+* and of QueryPerformanceCounter on Windows.  The origin is unspecified, so
+* only differences between timestamps are meaningful, and tools convert
+* them to their own clock if it differs.  This function never calls into a
+* tool and works whether or not one is attached.
+*
+* In strict ISO C modes, such as -std=c99, define _POSIX_C_SOURCE as
+* 199309L or later before including any header, or this function returns
+* 0, which NVTX functions taking a timestamp treat as the time of the call.
+*
+* \version \NVTX_VERSION_3
+*
+* \return The current time, in nanoseconds, or 0 without a clock.
+*
+* @{ */
+NVTX_DECLSPEC uint64_t NVTX_API nvtxGetTimestamp(void);
+/** @} */
+
 
 /** @} */ /*END defgroup*/
 
@@ -912,6 +1121,93 @@ NVTX_DECLSPEC int NVTX_API nvtxDomainRangePop(nvtxDomainHandle_t domain);
 NVTX_DECLSPEC int NVTX_API nvtxRangePop(void);
 /** @} */
 
+/* ------------------------------------------------------------------------- */
+/** \brief Marker and range events at a given time.
+*
+* Same as nvtxDomainMarkEx, nvtxDomainRangeStartEx, nvtxDomainRangeEnd,
+* nvtxDomainRangePushEx and nvtxDomainRangePop, except that the event
+* happened at \p timestamp, in the NVTX clock domain of nvtxGetTimestamp,
+* instead of at the time of the call.  This allows recording events cheaply
+* on a critical path and passing them to NVTX later, or forwarding events
+* timed by hardware or by another process on the same system.  A range may
+* begin with one of these functions and end with a function without a
+* timestamp, or the other way around.  Push and pop events still belong to
+* the calling thread, and their nesting level is not reported.
+*
+* The events reach the tool as single event batches, see
+* nvtxDomainBatchSubmit.  A tool that does not handle batches receives them
+* through the function without a timestamp, at the time of the call.
+*
+* \param domain - The domain of scoping the event.
+* \param eventAttrib - The event attribute structure defining the event.
+* \param id - The range to end, returned by nvtxDomainRangeStartEx or
+* nvtxDomainRangeStartExAt.
+* \param timestamp - Time of the event in nanoseconds, see nvtxGetTimestamp.
+*
+* \par Example:
+* \code
+* uint64_t begin = nvtxGetTimestamp();
+* critical_work();
+* uint64_t end = nvtxGetTimestamp();
+*
+* // Later, off the critical path
+* nvtxDomainRangePushExAt(domain, &eventAttrib, begin);
+* nvtxDomainRangePopAt(domain, end);
+* \endcode
+*
+* \sa
+* ::nvtxGetTimestamp
+* ::nvtxDomainBatchSubmit
+*
+* \version \NVTX_VERSION_3
+* @{ */
+NVTX_DECLSPEC void NVTX_API nvtxDomainMarkExAt(nvtxDomainHandle_t domain, const nvtxEventAttributes_t* eventAttrib, uint64_t timestamp);
+NVTX_DECLSPEC nvtxRangeId_t NVTX_API nvtxDomainRangeStartExAt(nvtxDomainHandle_t domain, const nvtxEventAttributes_t* eventAttrib, uint64_t timestamp);
+NVTX_DECLSPEC void NVTX_API nvtxDomainRangeEndAt(nvtxDomainHandle_t domain, nvtxRangeId_t id, uint64_t timestamp);
+NVTX_DECLSPEC void NVTX_API nvtxDomainRangePushExAt(nvtxDomainHandle_t domain, const nvtxEventAttributes_t* eventAttrib, uint64_t timestamp);
+NVTX_DECLSPEC void NVTX_API nvtxDomainRangePopAt(nvtxDomainHandle_t domain, uint64_t timestamp);
+/** @} */
+
+/* ------------------------------------------------------------------------- */
+/** \brief Marker and range events described by a registered string.
+*
+* Same as nvtxDomainMarkEx, nvtxDomainRangeStartEx and nvtxDomainRangePushEx
+* with an event attribute structure holding only a registered message, a
+* category and a payload, but without building the structure.  The
+* arguments are passed in registers, and tools handling these functions
+* receive them without decoding the structure either, which makes them the
+* cheapest way to record such events.  The range they begin ends with
+* nvtxDomainRangeEnd or nvtxDomainRangePop.  A tool that does not handle
+* them receives the events through the functions taking attributes.
+*
+* \param domain - The domain of scoping the event.
+* \param message - Message of the event, from nvtxDomainRegisterStringA or
+* nvtxDomainRegisterStringW, or NULL for none.
+* \param category - Category of the event, 0 for none.
+* \param payloadType - Type of the payload, an ::nvtxPayloadType_t, or
+* NVTX_PAYLOAD_UNKNOWN for none.
+* \param payload - Bits of the payload; those of a 32-bit payload type are
+* the low 32 bits.
+*
+* \par Example:
+* \code
+* nvtxStringHandle_t step = nvtxDomainRegisterStringA(domain, "step");
+* nvtxDomainRangePushCompact(domain, step, 0, NVTX_PAYLOAD_TYPE_UNSIGNED_INT64, iteration);
+* nvtxDomainRangePop(domain);
+* \endcode
+*
+* \sa
+* ::nvtxDomainMarkEx
+* ::nvtxDomainRangeStartEx
+* ::nvtxDomainRangePushEx
+*
+* \version \NVTX_VERSION_3
+* @{ */
+NVTX_DECLSPEC void NVTX_API nvtxDomainMarkCompact(nvtxDomainHandle_t domain, nvtxStringHandle_t message, uint32_t category, int32_t payloadType, uint64_t payload);
+NVTX_DECLSPEC nvtxRangeId_t NVTX_API nvtxDomainRangeStartCompact(nvtxDomainHandle_t domain, nvtxStringHandle_t message, uint32_t category, int32_t payloadType, uint64_t payload);
+NVTX_DECLSPEC int NVTX_API nvtxDomainRangePushCompact(nvtxDomainHandle_t domain, nvtxStringHandle_t message, uint32_t category, int32_t payloadType, uint64_t payload);
+/** @} */
+
 
 /** @} */ /*END defgroup*/
 /* ========================================================================= */
@@ -1424,6 +1720,42 @@ NVTX_DECLSPEC nvtxDomainHandle_t NVTX_API nvtxDomainCreateW(const wchar_t* name)
 NVTX_DECLSPEC void NVTX_API nvtxDomainDestroy(nvtxDomainHandle_t domain);
 /** @} */
 
+/* ------------------------------------------------------------------------- */
+/** \brief Whether the attached tool wants the events of a domain.
+*
+* Tools may turn individual domains off, see nvtxDomainFlags_t.  Code that
+* annotates a domain can test this before preparing an event, to skip both
+* the work of building its attributes and the call into the tool.  The NVTX
+* C++ API does so in nvtx3::checked_range_in, nvtx3::checked_mark_in and
+* NVTX3_FUNC_RANGE_IN.  Calls into a disabled domain
+* remain valid; the tool may ignore them.  This function never calls into a
+* tool, but reads the flags in its domain handle; with NVTX_SUPPORT_DETACH,
+* it counts that read like a call into the tool, so the tool is not unloaded
+* while the read is in progress.
+*
+* \param domain    - the domain handle, or NULL for the default domain
+*
+* \return Zero if the tool has turned \p domain off, nonzero otherwise,
+* including when no tool has marked its domain handles as carrying flags.
+*
+* \par Example:
+* \code
+* nvtxDomainHandle_t domain = nvtxDomainCreateA("com.nvidia.nvtx.example");
+* if (nvtxDomainIsEnabled(domain))
+* {
+*     format_message(buffer, item);
+*     nvtxDomainMarkEx(domain, &attribs);
+* }
+* \endcode
+*
+* \sa
+* ::nvtxDomainCreateA
+*
+* \version \NVTX_VERSION_3
+* @{ */
+NVTX_DECLSPEC int NVTX_API nvtxDomainIsEnabled(nvtxDomainHandle_t domain);
+/** @} */
+
 
 /** @} */ /*END defgroup*/
 /* ========================================================================= */
@@ -1460,6 +1792,8 @@ NVTX_DECLSPEC void NVTX_API nvtxDomainDestroy(nvtxDomainHandle_t domain);
 #define NVTX_IMPL_GUARD /* Ensure other headers cannot included directly */
 
 #include "nvtxDetail/nvtxTypes.h"
+#include "nvtxDetail/nvtxTypesBatch_v3.h"
+#include "nvtxDetail/nvtxTypesCounters_v3.h"
 
 #ifndef NVTX_NO_IMPL
 #include "nvtxDetail/nvtxImpl.h"
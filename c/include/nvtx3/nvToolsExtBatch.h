@@ -0,0 +1,105 @@
+/*
+* Copyright 2009-2022  NVIDIA Corporation.  All rights reserved.
+*
+* Licensed under the Apache License v2.0 with LLVM Exceptions.
+* See https://llvm.org/LICENSE.txt for license information.
+* SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+*/
+
+#include "nvToolsExt.h"
+
+#ifndef NVTOOLSEXT_BATCH_V3
+#define NVTOOLSEXT_BATCH_V3
+
+#include "nvtxDetail/nvtxTypesBatch_v3.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+* \page PAGE_BATCH Batched Events
+*
+* Each NVTX event costs an indirect call into the tool, and the tool's own
+* bookkeeping for the call.  When the annotated work items are small, this
+* can dominate.  nvtxDomainBatchSubmit passes many events of a domain to the
+* tool in a single call instead.  The caller records events in an array of
+* nvtxBatchEvent_t as they happen, with their time from nvtxGetTimestamp,
+* and submits the array when it is full or at a convenient point.
+*
+* Tools receive the batch through the NVTX_CB_MODULE_BATCH callback module.
+* When the attached tool does not handle it, NVTX submits the events one by
+* one through the domain functions, and the tool timestamps them at the time
+* of the submission.  It always does so when the header of an earlier NVTX
+* version 3 release was included first.
+*
+* See module \ref BATCH for details.
+*
+* \par Example:
+* \code
+* nvtxDomainHandle_t domain = nvtxDomainCreateA("com.nvidia.nvtx.example");
+* nvtxStringHandle_t item = nvtxDomainRegisterStringA(domain, "item");
+*
+* nvtxBatchEvent_t events[2] = {{0}};
+* events[0].type = NVTX_BATCH_EVENT_RANGE_PUSH;
+* events[0].message = item;
+* events[0].timestamp = nvtxGetTimestamp();
+* process(item);
+* events[1].type = NVTX_BATCH_EVENT_RANGE_POP;
+* events[1].timestamp = nvtxGetTimestamp();
+*
+* nvtxDomainBatchSubmit(domain, events, 2);
+* \endcode
+*
+* \version \NVTX_VERSION_3
+*/
+
+/*  ------------------------------------------------------------------------- */
+/** \defgroup BATCH Batched Events
+* See page \ref PAGE_BATCH.
+* @{
+*/
+
+/* ------------------------------------------------------------------------- */
+/** \brief Submit several events of a domain in one call.
+*
+* Submits \p count events of \p events in order, as if by the domain
+* function matching each event's type, but at the time of the event's
+* timestamp.  Events with a null \p attributes have \p message, a handle
+* registered in \p domain or null, and \p category as their only attributes.
+* An NVTX_BATCH_EVENT_RANGE_END event ends the range whose id \p rangeId
+* holds, returned in an earlier batch or by nvtxDomainRangeStartEx; this
+* function writes the id of each NVTX_BATCH_EVENT_RANGE_START event to its
+* \p rangeId.  Timestamps need not increase along the batch, but the push
+* and pop events of a thread must be submitted by that thread in order.
+*
+* \param domain - The domain of scoping the events.
+* \param events - The events, in the order they happened.
+* \param count - The number of events.
+*
+* \sa
+* ::nvtxGetTimestamp
+* ::nvtxDomainMarkEx
+* ::nvtxDomainRangeStartEx
+* ::nvtxDomainRangeEnd
+* ::nvtxDomainRangePushEx
+* ::nvtxDomainRangePop
+*
+* \version \NVTX_VERSION_3
+*/
+NVTX_DECLSPEC void NVTX_API nvtxDomainBatchSubmit(nvtxDomainHandle_t domain, nvtxBatchEvent_t* events, size_t count);
+
+
+/** @} */ /*END defgroup*/
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#ifndef NVTX_NO_IMPL
+#define NVTX_IMPL_GUARD_BATCH /* Ensure other headers cannot included directly */
+#include "nvtxDetail/nvtxImplBatch_v3.h"
+#undef NVTX_IMPL_GUARD_BATCH
+#endif /*NVTX_NO_IMPL*/
+
+#endif /* NVTOOLSEXT_BATCH_V3 */
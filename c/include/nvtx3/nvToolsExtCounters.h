@@ -0,0 +1,119 @@
+/*
+* Copyright 2009-2022  NVIDIA Corporation.  All rights reserved.
+*
+* Licensed under the Apache License v2.0 with LLVM Exceptions.
+* See https://llvm.org/LICENSE.txt for license information.
+* SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+*/
+
+#include "nvToolsExt.h"
+
+#ifndef NVTOOLSEXT_COUNTERS_V3
+#define NVTOOLSEXT_COUNTERS_V3
+
+#include "nvtxDetail/nvtxTypesCounters_v3.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+* \page PAGE_COUNTERS Counters
+*
+* A counter is a named numeric value that changes over time, such as the
+* occupancy of a queue or the bytes held by an allocator.  Tools plot its
+* samples as a time series next to the ranges of the same process.  Marks
+* with a payload can carry such values too, but each costs a full event,
+* with its attributes, message and category, and tools cannot tell them
+* apart from other marks.
+*
+* A counter is registered once in a domain, with its name and unit, and
+* sampled through the returned handle.  A sample passes only the handle and
+* the value to the tool, which timestamps it and may keep only some of the
+* samples when they arrive faster than it needs them.
+*
+* Tools receive counters through the NVTX_CB_MODULE_COUNTER callback module.
+* When no tool handles it, registration returns NULL and samples do nothing.
+* This is also the case when the header of an earlier NVTX version 3 release
+* was included first.
+*
+* See module \ref COUNTERS for details.
+*
+* \par Example:
+* \code
+* nvtxDomainHandle_t domain = nvtxDomainCreateA("com.nvidia.nvtx.example");
+* nvtxCounterHandle_t depth = nvtxDomainCounterRegisterA(domain, "queue depth", "items");
+*
+* void enqueue(item_t item)
+* {
+*     push(queue, item);
+*     nvtxCounterSampleInt64(depth, size(queue));
+* }
+* \endcode
+*
+* \version \NVTX_VERSION_3
+*/
+
+/*  ------------------------------------------------------------------------- */
+/** \defgroup COUNTERS Counters
+* See page \ref PAGE_COUNTERS.
+* @{
+*/
+
+/* ------------------------------------------------------------------------- */
+/** \brief Register a counter in a domain.
+*
+* Registers a counter called \p name in \p domain, whose values are measured
+* in \p unit.  Tools may return the same handle for the same name registered
+* twice in a domain.  Counters live as long as their domain.
+*
+* \param domain - The domain of scoping the counter.
+* \param name - The name of the counter.
+* \param unit - The unit of the counter's values, such as "bytes", or an
+* empty string.
+*
+* \return A handle to pass to the sample functions, or NULL if no tool
+* records counters.
+*
+* \sa
+* ::nvtxCounterSampleInt64
+* ::nvtxCounterSampleDouble
+*
+* \version \NVTX_VERSION_3
+* @{ */
+NVTX_DECLSPEC nvtxCounterHandle_t NVTX_API nvtxDomainCounterRegisterA(nvtxDomainHandle_t domain, const char* name, const char* unit);
+/** @} */
+
+/* ------------------------------------------------------------------------- */
+/** \brief Record the current value of a counter.
+*
+* Tells the tool that \p counter holds \p value from now on.  Samples are
+* events: they are skipped while NVTX events are paused (see nvtxPause), and
+* tools may drop samples that follow the previous one too closely.
+*
+* \param counter - The handle returned by nvtxDomainCounterRegisterA, or NULL.
+* \param value - The value of the counter.
+*
+* \sa
+* ::nvtxDomainCounterRegisterA
+*
+* \version \NVTX_VERSION_3
+* @{ */
+NVTX_DECLSPEC void NVTX_API nvtxCounterSampleInt64(nvtxCounterHandle_t counter, int64_t value);
+NVTX_DECLSPEC void NVTX_API nvtxCounterSampleDouble(nvtxCounterHandle_t counter, double value);
+/** @} */
+
+
+/** @} */ /*END defgroup*/
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#ifndef NVTX_NO_IMPL
+#define NVTX_IMPL_GUARD_COUNTERS /* Ensure other headers cannot included directly */
+#include "nvtxDetail/nvtxImplCounters_v3.h"
+#undef NVTX_IMPL_GUARD_COUNTERS
+#endif /*NVTX_NO_IMPL*/
+
+#endif /* NVTOOLSEXT_COUNTERS_V3 */
@@ -16,7 +16,7 @@
 
 /* Temporary helper #defines, #undef'ed at end of header */
 #define NVTX3_CPP_VERSION_MAJOR 1
-#define NVTX3_CPP_VERSION_MINOR 0
+#define NVTX3_CPP_VERSION_MINOR 1
 
 /* This section handles the decision of whether to provide unversioned symbols.
  * If NVTX3_CPP_REQUIRE_EXPLICIT_VERSION is #defined, unversioned symbols are
@@ -71,7 +71,7 @@
      *
      * Not to be confused with the version number of the NVTX core library.
      */
-    #define NVTX3_CPP_INLINED_VERSION_MINOR 0  // NVTX3_CPP_VERSION_MINOR
+    #define NVTX3_CPP_INLINED_VERSION_MINOR 1  // NVTX3_CPP_VERSION_MINOR
   #elif NVTX3_CPP_INLINED_VERSION_MAJOR != NVTX3_CPP_VERSION_MAJOR
     /* Unsupported case -- cannot define unversioned symbols for different major versions
      * in the same translation unit.
@@ -85,7 +85,7 @@
      * redefine the minor version macro to this header's version.
      */
     #undef NVTX3_CPP_INLINED_VERSION_MINOR
-    #define NVTX3_CPP_INLINED_VERSION_MINOR 0  // NVTX3_CPP_VERSION_MINOR
+    #define NVTX3_CPP_INLINED_VERSION_MINOR 1  // NVTX3_CPP_VERSION_MINOR
     // else, already have this version or newer, nothing to do
   #endif
 #endif
@@ -216,6 +216,13 @@
  * // invocations simply return a reference.
  * nvtx3::domain const& D = nvtx3::domain::get<my_domain>();
  * \endcode
+ *
+ * A tool attached to the running process with `nvtxAttachInjectionLibraryA`
+ * cannot use handles created before, nor those of a detached tool.  The
+ * `get` functions therefore construct their object again once a tool was
+ * attached or detached since, and so does `NVTX3_FUNC_RANGE`.  Objects kept
+ * by the application, such as a `registered_string_in` member, must likewise
+ * be constructed again when `nvtxGetAttachGeneration` changes.
  * For more information about NVTX and how it can be used, see
  * https://docs.nvidia.com/cuda/profiler-users-guide/index.html#nvtx and
  * https://devblogs.nvidia.com/cuda-pro-tip-generate-custom-application-profile-timelines-nvtx/
@@ -621,6 +628,70 @@
 #define NVTX3_STATIC_ASSERT_DEFINED_HERE
 #endif
 
+/* Cache of objects holding tool handles, used by the sections below when the core of this NVTX
+ * release is present.  It is kept apart from them, since version 1.0 uses it only then. */
+
+#include "nvToolsExt.h"
+
+#if !defined(NVTX3_CPP_ATTACH_CACHE_V1) && defined(NVTX_IMPL_REVISION)
+#define NVTX3_CPP_ATTACH_CACHE_V1
+
+#include <atomic>
+
+namespace nvtx3 {
+
+NVTX3_INLINE_IF_REQUESTED namespace NVTX3_VERSION_NAMESPACE
+{
+
+namespace detail {
+
+/**
+ * @brief Function local static object holding handles of the attached tool,
+ * such as the `domain` of `domain::get`.
+ *
+ * Handles belong to the tool attached when they were created, see
+ * `nvtxGetAttachGeneration`.  `get` creates the object again once a tool
+ * attached or detached since, so a tool attached to a running process sees
+ * the domains and strings of the C++ API, and is never passed the handles of
+ * an earlier tool.  Objects created for an earlier tool are never destroyed,
+ * as other threads may still use them; concurrent callers may each create
+ * one.
+ *
+ * @tparam T Type of the object, created by the `make` passed to `get`.
+ */
+template <typename T>
+class attach_cache {
+ public:
+  /**
+   * @brief Returns the object created for the tool attached now, calling
+   * `make` to create it with `new` if there is none.
+   */
+  template <typename Make>
+  T const& get(Make make) noexcept
+  {
+    uint32_t const generation = nvtxGetAttachGeneration();
+    if (generation_.load(std::memory_order_acquire) == generation) {
+      if (T const* object = object_.load(std::memory_order_acquire)) { return *object; }
+    }
+    T const* object = make();
+    object_.store(object, std::memory_order_release);
+    generation_.store(generation, std::memory_order_release);
+    return *object;
+  }
+
+ private:
+  std::atomic<uint32_t> generation_{0};
+  std::atomic<T const*> object_{nullptr};
+};
+
+}  // namespace detail
+
+}  // namespace NVTX3_VERSION_NAMESPACE
+
+}  // namespace nvtx3
+
+#endif  // NVTX3_CPP_ATTACH_CACHE_V1
+
 /* Implementation sections, enclosed in guard macros for each minor version */
 
 #ifndef NVTX3_CPP_DEFINITIONS_V1_0
@@ -764,9 +835,9 @@ class domain {
    * when using domains with their own use of the NVTX C API.
    *
    * This function is threadsafe as of C++11. If two or more threads call
-   * `domain::get<D>` concurrently, exactly one of them is guaranteed
-   * to construct the `domain` object and the other(s) will receive a
-   * reference to the object after it is fully constructed.
+   * `domain::get<D>` concurrently, each of them receives a reference to a
+   * fully constructed `domain` object.  The object is constructed again once
+   * a tool was attached or detached since.
    *
    * The domain's name is specified via the type `D` pass as an
    * explicit template parameter. `D` is required to contain a
@@ -797,8 +868,13 @@ class domain {
     , int>::type = 0>
   static domain const& get() noexcept
   {
+#if defined(NVTX3_CPP_ATTACH_CACHE_V1)
+    static detail::attach_cache<domain> d;
+    return d.get([] { return new domain(D::name); });
+#else
     static domain const d(D::name);
     return d;
+#endif
   }
 
   /**
@@ -840,8 +916,13 @@ class domain {
   template <typename D = global>
   static domain const& get() noexcept
   {
+#if defined(NVTX3_CPP_ATTACH_CACHE_V1)
+    static detail::attach_cache<domain> d;
+    return d.get([] { return new domain(D::name); });
+#else
     static domain const d(D::name);
     return d;
+#endif
   }
 #endif
 
@@ -1249,8 +1330,13 @@ class named_category_in final : public category {
     , int>::type = 0>
   static named_category_in const& get() noexcept
   {
+#if defined(NVTX3_CPP_ATTACH_CACHE_V1)
+    static detail::attach_cache<named_category_in> cat;
+    return cat.get([] { return new named_category_in(C::id, C::name); });
+#else
     static named_category_in const cat(C::id, C::name);
     return cat;
+#endif
   }
 
   /**
@@ -1301,8 +1387,13 @@ class named_category_in final : public category {
   template <typename C>
   static named_category_in const& get() noexcept
   {
+#if defined(NVTX3_CPP_ATTACH_CACHE_V1)
+    static detail::attach_cache<named_category_in> cat;
+    return cat.get([] { return new named_category_in(C::id, C::name); });
+#else
     static named_category_in const cat(C::id, C::name);
     return cat;
+#endif
   }
 #endif
 
@@ -1447,8 +1538,13 @@ class registered_string_in {
     , int>::type = 0>
   static registered_string_in const& get() noexcept
   {
+#if defined(NVTX3_CPP_ATTACH_CACHE_V1)
+    static detail::attach_cache<registered_string_in> regstr;
+    return regstr.get([] { return new registered_string_in(M::message); });
+#else
     static registered_string_in const regstr(M::message);
     return regstr;
+#endif
   }
 
   /**
@@ -1491,8 +1587,13 @@ class registered_string_in {
   template <typename M>
   static registered_string_in const& get() noexcept
   {
+#if defined(NVTX3_CPP_ATTACH_CACHE_V1)
+    static detail::attach_cache<registered_string_in> regstr;
+    return regstr.get([] { return new registered_string_in(M::message); });
+#else
     static registered_string_in const regstr(M::message);
     return regstr;
+#endif
   }
 #endif
 
@@ -2834,6 +2935,1187 @@ inline void mark(Args const&... args) noexcept
 
 #endif  // NVTX3_CPP_DEFINITIONS_V1_0
 
+/* Version 1.1 needs the core of this NVTX release.  When an earlier NVTX version 3 header was
+ * included first, only version 1.0 is defined. */
+#if !defined(NVTX3_CPP_DEFINITIONS_V1_1) && defined(NVTX_IMPL_REVISION)
+#define NVTX3_CPP_DEFINITIONS_V1_1
+
+#include "nvToolsExtBatch.h"
+#include "nvToolsExtCounters.h"
+
+namespace nvtx3 {
+
+NVTX3_INLINE_IF_REQUESTED namespace NVTX3_VERSION_NAMESPACE
+{
+
+/**
+ * @brief Whether the attached tool wants the events of domain `D`.
+ *
+ * Tools may turn individual domains off at any time, see
+ * `nvtxDomainIsEnabled`.  `checked_range_in`, `checked_mark_in` and
+ * `NVTX3_FUNC_RANGE_IN` test this before they build `event_attributes` or
+ * call into the tool.
+ *
+ * @tparam D Type containing `name` member used to identify the `domain`.
+ * Else, `domain::global` to indicate that the global NVTX domain should be
+ * used.
+ */
+template <typename D = domain::global>
+inline bool domain_enabled() noexcept
+{
+#ifndef NVTX_DISABLE
+  return nvtxDomainIsEnabled(domain::get<D>()) != 0;
+#else
+  return false;
+#endif
+}
+
+/**
+ * @brief Whether NVTX calls currently reach a tool.
+ *
+ * Test this before work done only to annotate, such as formatting a message,
+ * to skip that work when no tool would receive the event.  After the first
+ * call, which initializes NVTX like any NVTX call, it costs a load and a
+ * branch.  See `nvtxIsEnabled`.
+ *
+ * Example:
+ * \code{.cpp}
+ * if (nvtx3::enabled()) {
+ *    nvtx3::mark(nvtx3::message{describe(request)});
+ * }
+ * \endcode
+ *
+ * The `checked_range_in` constructor and the `mark_in` overload taking a
+ * callable do this test themselves.
+ */
+inline bool enabled() noexcept
+{
+#ifndef NVTX_DISABLE
+  return nvtxIsEnabled() != 0;
+#else
+  return false;
+#endif
+}
+
+/**
+ * @brief Whether NVTX calls currently reach a tool, and the tool has not
+ * turned domain `D` off, see `domain_enabled`.
+ *
+ * @tparam D Type containing `name` member used to identify the `domain`.
+ * Else, `domain::global` to indicate that the global NVTX domain should be
+ * used.
+ */
+template <typename D = domain::global>
+inline bool enabled_in() noexcept
+{
+#ifndef NVTX_DISABLE
+  return enabled() && domain_enabled<D>();
+#else
+  return false;
+#endif
+}
+
+/**
+ * @brief Time of an event in the NVTX clock domain, see `nvtxGetTimestamp`.
+ *
+ * Passed as the first argument of `mark_in`, `checked_range_in`,
+ * `start_range_in` and `end_range_in` to record an event that happened at a
+ * known time rather than now, e.g., one reconstructed from a device or from
+ * a log.
+ *
+ * Example:
+ * \code{.cpp}
+ * nvtx3::timestamp begin = nvtx3::timestamp::now();
+ * // ...
+ * nvtx3::mark(begin, "Work began");
+ * \endcode
+ */
+class timestamp {
+ public:
+  using value_type = uint64_t;
+
+  /**
+   * @brief Construct a `timestamp` from a value in nanoseconds of the NVTX
+   * clock domain.
+   *
+   * @param value Value returned by `nvtxGetTimestamp`, or derived from one
+   */
+  constexpr explicit timestamp(value_type value) noexcept : value_{value} {}
+
+  /**
+   * @brief Return the current time in the NVTX clock domain.
+   */
+  static timestamp now() noexcept { return timestamp{nvtxGetTimestamp()}; }
+
+  /**
+   * @brief Return the value of the `timestamp`.
+   */
+  constexpr value_type get_value() const noexcept { return value_; }
+
+ private:
+  value_type value_;
+};
+
+namespace detail {
+
+/**
+ * @brief Bits of `p` as the compact event functions take them, with a 32-bit
+ * value in the low bits, see `nvtxDomainMarkCompact`.
+ */
+inline uint64_t payload_bits(payload const& p) noexcept
+{
+  switch (p.get_type()) {
+    case NVTX_PAYLOAD_TYPE_UNSIGNED_INT32:
+    case NVTX_PAYLOAD_TYPE_INT32:
+    case NVTX_PAYLOAD_TYPE_FLOAT: return p.get_value().uiValue;
+    default: return p.get_value().ullValue;
+  }
+}
+
+}  // namespace detail
+
+namespace detail {
+
+/// @cond internal
+/// Whether `F` is a callable whose result an `event_attributes` can be built from.
+template <typename F, typename = void>
+struct is_attributes_builder : std::false_type {};
+template <typename F>
+struct is_attributes_builder<
+  F,
+  typename std::enable_if<std::is_constructible<
+    event_attributes,
+    decltype(std::declval<F const&>()()) const&>::value>::type> : std::true_type {};
+/// @endcond
+
+}  // namespace detail
+
+/**
+ * @brief A `scoped_range_in` that begins only while domain `D` is enabled,
+ * see `domain_enabled`.
+ *
+ * When `D` is turned off, constructing a `checked_range_in` builds no
+ * `event_attributes` and makes no call into the tool, and destroying it makes
+ * none either.  A range begun while `D` was enabled still ends when the
+ * `checked_range_in` is destroyed.  Otherwise, it behaves like a
+ * `scoped_range_in`.
+ *
+ * Example:
+ * \code{.cpp}
+ * nvtx3::checked_range_in<my_domain> r{"range", nvtx3::payload{item.id}};
+ * \endcode
+ */
+template <class D = domain::global>
+class checked_range_in {
+ public:
+  /**
+   * @brief Construct a `checked_range_in` with the specified
+   * `event_attributes`.
+   *
+   * @param[in] attr `event_attributes` that describes the desired attributes
+   * of the range.
+   */
+  explicit checked_range_in(event_attributes const& attr) noexcept
+  {
+#ifndef NVTX_DISABLE
+    if (domain_enabled<D>()) {
+      nvtxDomainRangePushEx(domain::get<D>(), attr.get());
+      pushed_ = true;
+    }
+#else
+    (void)attr;
+#endif
+  }
+
+  /**
+   * @brief Constructs a `checked_range_in` from the constructor arguments
+   * of an `event_attributes`, constructed only while `D` is enabled.
+   *
+   * @param[in] args Arguments to used to construct an `event_attributes`
+   * associated with this range.
+   */
+  template <typename... Args>
+  explicit checked_range_in(Args const&... args) noexcept
+  {
+#ifndef NVTX_DISABLE
+    if (domain_enabled<D>()) {
+      nvtxDomainRangePushEx(domain::get<D>(), event_attributes{args...}.get());
+      pushed_ = true;
+    }
+#endif
+  }
+
+  /**
+   * @brief Construct a `checked_range_in` whose message is `message`, and
+   * nothing else.
+   *
+   * Calls `nvtxDomainRangePushCompact`, so no `event_attributes` is built, and
+   * tools handling it receive the message handle directly.
+   *
+   * Example:
+   * \code{cpp}
+   * auto& msg = nvtx3::registered_string_in<my_domain>::get<my_message>();
+   * nvtx3::checked_range_in<my_domain> r{msg};
+   * \endcode
+   *
+   * @param[in] message Message of the range, registered in domain `D`
+   */
+  explicit checked_range_in(registered_string_in<D> const& message) noexcept
+  {
+#ifndef NVTX_DISABLE
+    if (domain_enabled<D>()) {
+      nvtxDomainRangePushCompact(
+        domain::get<D>(), message.get_handle(), 0, NVTX_PAYLOAD_UNKNOWN, 0);
+      pushed_ = true;
+    }
+#else
+    (void)message;
+#endif
+  }
+
+  /**
+   * @brief Construct a `checked_range_in` whose message is `message` and
+   * whose payload is `p`, through `nvtxDomainRangePushCompact`.
+   *
+   * @param[in] message Message of the range, registered in domain `D`
+   * @param[in] p Payload of the range
+   */
+  checked_range_in(registered_string_in<D> const& message, payload const& p) noexcept
+  {
+#ifndef NVTX_DISABLE
+    if (domain_enabled<D>()) {
+      nvtxDomainRangePushCompact(
+        domain::get<D>(), message.get_handle(), 0, p.get_type(), detail::payload_bits(p));
+      pushed_ = true;
+    }
+#else
+    (void)message;
+    (void)p;
+#endif
+  }
+
+  /**
+   * @brief Construct a `checked_range_in` whose attributes `build` returns,
+   * calling `build` only if the range will be recorded.
+   *
+   * `build` takes no arguments and returns an `event_attributes`, or anything
+   * an `event_attributes` can be constructed from, such as a `std::string`
+   * message.  It is not called when no tool is attached or domain `D` is
+   * turned off, see `enabled_in`.  The result is kept until the range has
+   * begun, so a returned string need not outlive the constructor.  `build`
+   * must not throw.
+   *
+   * Example:
+   * \code{cpp}
+   * nvtx3::checked_range r{[&] { return "request " + std::to_string(id); }};
+   * \endcode
+   *
+   * @param[in] build Callable returning the attributes of the range
+   */
+  template <typename F,
+            typename std::enable_if<detail::is_attributes_builder<F>::value, int>::type = 0>
+  explicit checked_range_in(F const& build) noexcept
+  {
+#ifndef NVTX_DISABLE
+    if (enabled_in<D>()) {
+      auto const& result = build();
+      nvtxDomainRangePushEx(domain::get<D>(), event_attributes{result}.get());
+      pushed_ = true;
+    }
+#else
+    (void)build;
+#endif
+  }
+
+  /**
+   * @brief Construct a `checked_range_in` that began at `start` with the
+   * specified `event_attributes`.
+   *
+   * The range ends when the `checked_range_in` is destroyed, at the time of
+   * destruction.
+   *
+   * Example:
+   * \code{cpp}
+   * nvtx3::timestamp start = nvtx3::timestamp::now();
+   * // ... decide whether the work is worth a range ...
+   * nvtx3::checked_range range{start, nvtx3::event_attributes{"msg"}};
+   * \endcode
+   *
+   * @param[in] start Time the range began, see `nvtxGetTimestamp`
+   * @param[in] attr `event_attributes` that describes the desired attributes
+   * of the range.
+   */
+  checked_range_in(timestamp const& start, event_attributes const& attr) noexcept
+  {
+#ifndef NVTX_DISABLE
+    if (domain_enabled<D>()) {
+      nvtxDomainRangePushExAt(domain::get<D>(), attr.get(), start.get_value());
+      pushed_ = true;
+    }
+#else
+    (void)start;
+    (void)attr;
+#endif
+  }
+
+  /**
+   * @brief Constructs a `checked_range_in` that began at `start` from the
+   * constructor arguments of an `event_attributes`.
+   *
+   * @param[in] start Time the range began, see `nvtxGetTimestamp`
+   * @param[in] args Arguments to used to construct an `event_attributes`
+   * associated with this range.
+   */
+  template <typename... Args>
+  checked_range_in(timestamp const& start, Args const&... args) noexcept
+  {
+#ifndef NVTX_DISABLE
+    if (domain_enabled<D>()) {
+      nvtxDomainRangePushExAt(
+        domain::get<D>(), event_attributes{args...}.get(), start.get_value());
+      pushed_ = true;
+    }
+#else
+    (void)start;
+#endif
+  }
+
+  /**
+   * @brief Delete `operator new` to disallow heap allocated objects.
+   *
+   * `checked_range_in` must follow RAII semantics to guarantee proper push/pop semantics.
+   */
+  void* operator new(std::size_t) = delete;
+
+  checked_range_in(checked_range_in const&) = delete;
+  checked_range_in& operator=(checked_range_in const&) = delete;
+  checked_range_in(checked_range_in&&) = delete;
+  checked_range_in& operator=(checked_range_in&&) = delete;
+
+  /**
+   * @brief Destroy the `checked_range_in`, ending the NVTX range event if it
+   * began.
+   */
+  ~checked_range_in() noexcept
+  {
+#ifndef NVTX_DISABLE
+    if (pushed_) { nvtxDomainRangePop(domain::get<D>()); }
+#endif
+  }
+
+ private:
+#ifndef NVTX_DISABLE
+  /// Whether the range began, i.e., `D` was enabled on construction.
+  bool pushed_ = false;
+#endif
+};
+
+/**
+ * @brief Alias for a `checked_range_in` in the global NVTX domain.
+ */
+using checked_range = checked_range_in<domain::global>;
+
+/**
+ * @brief Manually begin an NVTX range in domain `D` whose message is
+ * `message`, and optionally whose payload is `p`.
+ *
+ * Same as `start_range_in<D>(attr)` with attributes holding only `message`
+ * and `p`, but calls `nvtxDomainRangeStartCompact`, so no `event_attributes`
+ * is built.
+ *
+ * @tparam D Type containing `name` member used to identify the `domain`
+ * to which the range belongs. Else, `domain::global` to indicate that the
+ * global NVTX domain should be used.
+ * @param[in] message Message of the range, registered in domain `D`
+ * @return Unique handle to be passed to `end_range_in` to end the range.
+ */
+template <typename D = domain::global>
+inline range_handle start_range_in(registered_string_in<D> const& message) noexcept
+{
+#ifndef NVTX_DISABLE
+  return range_handle{nvtxDomainRangeStartCompact(
+    domain::get<D>(), message.get_handle(), 0, NVTX_PAYLOAD_UNKNOWN, 0)};
+#else
+  (void)message;
+  return {};
+#endif
+}
+
+/**
+ * @brief Manually begin an NVTX range in domain `D` whose message is
+ * `message` and whose payload is `p`, see `start_range_in<D>(message)`.
+ *
+ * @param[in] message Message of the range, registered in domain `D`
+ * @param[in] p Payload of the range
+ * @return Unique handle to be passed to `end_range_in` to end the range.
+ */
+template <typename D = domain::global>
+inline range_handle start_range_in(registered_string_in<D> const& message,
+                                   payload const& p) noexcept
+{
+#ifndef NVTX_DISABLE
+  return range_handle{nvtxDomainRangeStartCompact(
+    domain::get<D>(), message.get_handle(), 0, p.get_type(), detail::payload_bits(p))};
+#else
+  (void)message;
+  (void)p;
+  return {};
+#endif
+}
+
+/**
+ * @brief Manually begin an NVTX range that began at `start`.
+ *
+ * Same as `start_range_in<D>(attr)`, but the range began at `start` rather
+ * than at the time of the call.  End it with `end_range_in<D>(r)` or, if the
+ * end time is also known, `end_range_in<D>(r, end)`.
+ *
+ * @tparam D Type containing `name` member used to identify the `domain`
+ * to which the range belongs. Else, `domain::global` to indicate that the
+ * global NVTX domain should be used.
+ * @param[in] start Time the range began, see `nvtxGetTimestamp`
+ * @param[in] attr `event_attributes` that describes the desired attributes
+ * of the range.
+ * @return Unique handle to be passed to `end_range_in` to end the range.
+ */
+template <typename D = domain::global>
+inline range_handle start_range_in(timestamp const& start, event_attributes const& attr) noexcept
+{
+#ifndef NVTX_DISABLE
+  return range_handle{
+    nvtxDomainRangeStartExAt(domain::get<D>(), attr.get(), start.get_value())};
+#else
+  (void)start;
+  (void)attr;
+  return {};
+#endif
+}
+
+/**
+ * @brief Manually begin an NVTX range that began at `start`, constructing
+ * its `event_attributes` from `args...`.
+ *
+ * @tparam D Type containing `name` member used to identify the `domain`
+ * to which the range belongs. Else, `domain::global` to indicate that the
+ * global NVTX domain should be used.
+ * @param[in] start Time the range began, see `nvtxGetTimestamp`
+ * @param args[in] Variadic parameter pack of the arguments for an `event_attributes`.
+ * @return Unique handle to be passed to `end_range_in` to end the range.
+ */
+template <typename D = domain::global, typename... Args>
+inline range_handle start_range_in(timestamp const& start, Args const&... args) noexcept
+{
+#ifndef NVTX_DISABLE
+  return start_range_in<D>(start, event_attributes{args...});
+#else
+  (void)start;
+  return {};
+#endif
+}
+
+/**
+ * @brief Manually end the range associated with the handle `r` in domain `D`
+ * at time `end`.
+ *
+ * Same as `end_range_in<D>(r)`, but the range ended at `end` rather than at
+ * the time of the call.
+ *
+ * @tparam D Type containing `name` member used to identify the `domain` to
+ * which the range belongs. Else, `domain::global` to indicate that the global
+ * NVTX domain should be used.
+ * @param r Handle to a range started by a prior call to `start_range_in`.
+ * @param end Time the range ended, see `nvtxGetTimestamp`
+ */
+template <typename D = domain::global>
+inline void end_range_in(range_handle r, timestamp const& end) noexcept
+{
+#ifndef NVTX_DISABLE
+  nvtxDomainRangeEndAt(domain::get<D>(), r.get_value(), end.get_value());
+#else
+  (void)r;
+  (void)end;
+#endif
+}
+
+/**
+ * @brief Manually end the range associated with the handle `r` in the global
+ * domain at time `end`.
+ *
+ * @param r Handle to a range started by a prior call to `start_range`.
+ * @param end Time the range ended, see `nvtxGetTimestamp`
+ */
+inline void end_range(range_handle r, timestamp const& end) noexcept
+{
+#ifndef NVTX_DISABLE
+  end_range_in<domain::global>(r, end);
+#else
+  (void)r;
+  (void)end;
+#endif
+}
+
+/**
+ * @brief Annotates an instantaneous point in time with a "marker", using the
+ * attributes specified by `attr`, while domain `D` is enabled.
+ *
+ * Same as `mark_in<D>(attr)`, but makes no call into the tool while `D` is
+ * turned off, see `domain_enabled`.
+ *
+ * @tparam D Type containing `name` member used to identify the `domain`
+ * to which the marker belongs. Else, `domain::global` to indicate that the
+ * global NVTX domain should be used.
+ * @param[in] attr `event_attributes` that describes the desired attributes
+ * of the mark.
+ */
+template <typename D = domain::global>
+inline void checked_mark_in(event_attributes const& attr) noexcept
+{
+#ifndef NVTX_DISABLE
+  if (domain_enabled<D>()) { nvtxDomainMarkEx(domain::get<D>(), attr.get()); }
+#else
+  (void)(attr);
+#endif
+}
+
+/**
+ * @brief Annotates an instantaneous point in time with a "marker", using the
+ * arguments to construct an `event_attributes`, while domain `D` is enabled.
+ *
+ * The `event_attributes` is constructed only while `D` is enabled.
+ *
+ * @tparam D Type containing `name` member used to identify the `domain`
+ * to which the marker belongs. Else, `domain::global` to indicate that the
+ * global NVTX domain should be used.
+ * @param[in] args Variadic parameter pack of arguments to construct an
+ * `event_attributes` associated with this marker.
+ */
+template <typename D = domain::global, typename... Args>
+inline void checked_mark_in(Args const&... args) noexcept
+{
+#ifndef NVTX_DISABLE
+  if (domain_enabled<D>()) {
+    nvtxDomainMarkEx(domain::get<D>(), event_attributes{args...}.get());
+  }
+#endif
+}
+
+/**
+ * @brief Annotates an instantaneous point in time with a "marker" whose
+ * message is `message`, and nothing else.
+ *
+ * Calls `nvtxDomainMarkCompact`, so no `event_attributes` is built, and tools
+ * handling it receive the message handle directly.
+ *
+ * @tparam D Type containing `name` member used to identify the `domain`
+ * to which the marker belongs. Else, `domain::global` to indicate that the
+ * global NVTX domain should be used.
+ * @param[in] message Message of the marker, registered in domain `D`
+ */
+template <typename D = domain::global>
+inline void mark_in(registered_string_in<D> const& message) noexcept
+{
+#ifndef NVTX_DISABLE
+  if (domain_enabled<D>()) {
+    nvtxDomainMarkCompact(domain::get<D>(), message.get_handle(), 0, NVTX_PAYLOAD_UNKNOWN, 0);
+  }
+#else
+  (void)message;
+#endif
+}
+
+/**
+ * @brief Annotates an instantaneous point in time with a "marker" whose
+ * message is `message` and whose payload is `p`, through
+ * `nvtxDomainMarkCompact`.
+ *
+ * @tparam D Type containing `name` member used to identify the `domain`
+ * to which the marker belongs. Else, `domain::global` to indicate that the
+ * global NVTX domain should be used.
+ * @param[in] message Message of the marker, registered in domain `D`
+ * @param[in] p Payload of the marker
+ */
+template <typename D = domain::global>
+inline void mark_in(registered_string_in<D> const& message, payload const& p) noexcept
+{
+#ifndef NVTX_DISABLE
+  if (domain_enabled<D>()) {
+    nvtxDomainMarkCompact(
+      domain::get<D>(), message.get_handle(), 0, p.get_type(), detail::payload_bits(p));
+  }
+#else
+  (void)message;
+  (void)p;
+#endif
+}
+
+/**
+ * @brief Annotates a point in time that has already passed with a "marker",
+ * using the attributes specified by `attr`.
+ *
+ * Same as `mark_in<D>(attr)`, but the marker is placed at `when` rather than
+ * at the time of the call:
+ *
+ * \code{.cpp}
+ * nvtx3::timestamp t = nvtx3::timestamp::now();
+ * bool success = do_operation(...);
+ * if (!success) {
+ *    nvtx3::mark_in<my_domain>(t, "failed operation began");
+ * }
+ * \endcode
+ *
+ * @tparam D Type containing `name` member used to identify the `domain`
+ * to which the marker belongs. Else, `domain::global` to indicate that the
+ * global NVTX domain should be used.
+ * @param[in] when Time of the marker, see `nvtxGetTimestamp`
+ * @param[in] attr `event_attributes` that describes the desired attributes
+ * of the mark.
+ */
+template <typename D = domain::global>
+inline void mark_in(timestamp const& when, event_attributes const& attr) noexcept
+{
+#ifndef NVTX_DISABLE
+  if (domain_enabled<D>()) {
+    nvtxDomainMarkExAt(domain::get<D>(), attr.get(), when.get_value());
+  }
+#else
+  (void)when;
+  (void)attr;
+#endif
+}
+
+/**
+ * @brief Annotates a point in time that has already passed with a "marker",
+ * using the arguments to construct an `event_attributes`.
+ *
+ * @tparam D Type containing `name` member used to identify the `domain`
+ * to which the marker belongs. Else, `domain::global` to indicate that the
+ * global NVTX domain should be used.
+ * @param[in] when Time of the marker, see `nvtxGetTimestamp`
+ * @param[in] args Variadic parameter pack of arguments to construct an
+ * `event_attributes` associated with this marker.
+ */
+template <typename D = domain::global, typename... Args>
+inline void mark_in(timestamp const& when, Args const&... args) noexcept
+{
+#ifndef NVTX_DISABLE
+  if (domain_enabled<D>()) {
+    nvtxDomainMarkExAt(domain::get<D>(), event_attributes{args...}.get(), when.get_value());
+  }
+#else
+  (void)when;
+#endif
+}
+
+/**
+ * @brief Annotates a point in time that has already passed with a "marker",
+ * using the attributes specified by `attr`, in the global domain.
+ *
+ * @param[in] when Time of the marker, see `nvtxGetTimestamp`
+ * @param[in] attr `event_attributes` that describes the desired attributes
+ * of the mark.
+ */
+inline void mark(timestamp const& when, event_attributes const& attr) noexcept
+{
+#ifndef NVTX_DISABLE
+  mark_in<domain::global>(when, attr);
+#else
+  (void)when;
+  (void)attr;
+#endif
+}
+
+/**
+ * @brief Annotates an instantaneous point in time with a "marker" whose
+ * attributes `build` returns, calling `build` only if the marker will be
+ * recorded.
+ *
+ * `build` takes no arguments and returns an `event_attributes`, or anything
+ * an `event_attributes` can be constructed from, such as a `std::string`
+ * message.  It is not called when no tool is attached or domain `D` is
+ * turned off, see `enabled_in`.  `build` must not throw.
+ *
+ * \code{.cpp}
+ * nvtx3::mark_in<my_domain>([&] { return "queue depth " + std::to_string(q.size()); });
+ * \endcode
+ *
+ * @tparam D Type containing `name` member used to identify the `domain`
+ * to which the marker belongs. Else, `domain::global` to indicate that the
+ * global NVTX domain should be used.
+ * @param[in] build Callable returning the attributes of the marker
+ */
+template <typename D = domain::global,
+          typename F,
+          typename std::enable_if<detail::is_attributes_builder<F>::value, int>::type = 0>
+inline void mark_in(F const& build) noexcept
+{
+#ifndef NVTX_DISABLE
+  if (enabled_in<D>()) {
+    auto const& result = build();
+    nvtxDomainMarkEx(domain::get<D>(), event_attributes{result}.get());
+  }
+#else
+  (void)build;
+#endif
+}
+
+/**
+ * @brief Static description of an instrumented call site.
+ *
+ * `NVTX3_FUNC_RANGE`, `NVTX3_FUNC_RANGE_IN`, their `_IF` forms and
+ * `NVTX3_SCOPED_RANGE_IN` define one `call_site` per use, holding the site's
+ * domain name, function, file and line.  On ELF platforms the descriptors of
+ * a module are gathered in one linker section, which an NVTX tool obtains
+ * with the `NVTX_ETID_CALLSITES` export table: it can list every instrumented
+ * site without running the code, and turn off individual sites by clearing
+ * their `enabled` byte.  A disabled site costs a load and a branch on that
+ * byte and makes no NVTX call.
+ *
+ * GCC places the descriptors of sites in inline functions and templates in
+ * their own COMDAT sections instead, so such sites can still be turned off
+ * by their `enabled` byte but are not listed in the table.
+ */
+using call_site = ::nvtxCallSite_t;
+
+namespace detail {
+
+/// @cond internal
+template <typename D, typename = void>
+struct has_narrow_name : std::false_type {};
+template <typename D>
+struct has_narrow_name<D, typename std::enable_if<
+  std::is_convertible<decltype(D::name), char const*>::value>::type> : std::true_type {};
+
+/// Domain name recorded in a `call_site` of domain `D`: null unless `D::name` is a narrow string.
+template <typename D, typename std::enable_if<has_narrow_name<D>::value, int>::type = 0>
+constexpr char const* call_site_domain() noexcept
+{
+  return D::name;
+}
+
+template <typename D, typename std::enable_if<!has_narrow_name<D>::value, int>::type = 0>
+constexpr char const* call_site_domain() noexcept
+{
+  return nullptr;
+}
+/// @endcond
+
+}  // namespace detail
+
+/**
+ * @brief Buffer of events in domain `D`, submitted to NVTX together with
+ * `nvtxDomainBatchSubmit`.
+ *
+ * Each event is stored with its time from `nvtxGetTimestamp`, and reaches the
+ * tool when the buffer is flushed: explicitly, when it is full, or when it is
+ * destroyed.  A whole buffer costs a single call into the tool, so batching
+ * pays off when annotating many short work items.  `this_thread()` returns a
+ * buffer of the calling thread, flushed when the thread exits.
+ *
+ * Events are submitted in the order they were added, after any event made
+ * directly through NVTX meanwhile: flush before mixing batched and direct
+ * push/pop ranges of `D` on a thread.  Messages given as strings must stay
+ * valid until the next flush; prefer string literals or registered strings.
+ *
+ * Example:
+ * \code{.cpp}
+ * auto& batch = nvtx3::event_batch_in<my_domain>::this_thread();
+ * for (auto& item : items) {
+ *    batch.push(nvtx3::registered_string_in<my_domain>::get<item_message>());
+ *    process(item);
+ *    batch.pop();
+ * }
+ * batch.flush();
+ * \endcode
+ */
+template <class D = domain::global>
+class event_batch_in {
+ public:
+  /// Number of events held before the buffer is flushed.
+  static constexpr std::size_t capacity = 128;
+
+  /**
+   * @brief Buffer of the calling thread, flushed when the thread exits.
+   */
+  static event_batch_in& this_thread() noexcept
+  {
+    static thread_local event_batch_in batch;
+    return batch;
+  }
+
+  event_batch_in() noexcept = default;
+  ~event_batch_in() noexcept { flush(); }
+
+  event_batch_in(event_batch_in const&) = delete;
+  event_batch_in& operator=(event_batch_in const&) = delete;
+  event_batch_in(event_batch_in&&) = delete;
+  event_batch_in& operator=(event_batch_in&&) = delete;
+
+  /**
+   * @brief Add a mark with attributes `attr`.
+   */
+  void mark(event_attributes const& attr) noexcept { add(NVTX_BATCH_EVENT_MARK, attr); }
+
+  /**
+   * @brief Add a mark with a registered message and category `c`, cheaper to
+   * store than an `event_attributes`.
+   */
+  void mark(registered_string_in<D> const& message, category const& c = category{0}) noexcept
+  {
+    add(NVTX_BATCH_EVENT_MARK, message, c);
+  }
+
+  /**
+   * @brief Add the push of a range with attributes `attr`.
+   */
+  void push(event_attributes const& attr) noexcept { add(NVTX_BATCH_EVENT_RANGE_PUSH, attr); }
+
+  /**
+   * @brief Add the push of a range with a registered message and category `c`.
+   */
+  void push(registered_string_in<D> const& message, category const& c = category{0}) noexcept
+  {
+    add(NVTX_BATCH_EVENT_RANGE_PUSH, message, c);
+  }
+
+  /**
+   * @brief Add the pop of the latest range pushed in `D`.
+   */
+  void pop() noexcept
+  {
+#ifndef NVTX_DISABLE
+    next(NVTX_BATCH_EVENT_RANGE_POP);
+#endif
+  }
+
+  /**
+   * @brief Submit the events held, if any.
+   */
+  void flush() noexcept
+  {
+#ifndef NVTX_DISABLE
+    if (size_ == 0) { return; }
+    nvtxDomainBatchSubmit(domain::get<D>(), events_, size_);
+    size_ = 0;
+#endif
+  }
+
+  /// Number of events held.
+  std::size_t size() const noexcept { return size_; }
+
+ private:
+  nvtxBatchEvent_t& next(uint32_t type) noexcept
+  {
+    if (size_ == capacity) { flush(); }
+    nvtxBatchEvent_t& e = events_[size_++];
+    e                   = nvtxBatchEvent_t{};
+    e.timestamp         = nvtxGetTimestamp();
+    e.type              = type;
+    return e;
+  }
+
+  void add(uint32_t type, event_attributes const& attr) noexcept
+  {
+#ifndef NVTX_DISABLE
+    nvtxBatchEvent_t& e              = next(type);
+    nvtxEventAttributes_t& attribute = attributes_[&e - events_];
+    attribute                        = *attr.get();
+    e.attributes                     = &attribute;
+#else
+    (void)type;
+    (void)attr;
+#endif
+  }
+
+  void add(uint32_t type, registered_string_in<D> const& message, category const& c) noexcept
+  {
+#ifndef NVTX_DISABLE
+    nvtxBatchEvent_t& e = next(type);
+    e.message           = message.get_handle();
+    e.category          = c.get_id();
+#else
+    (void)type;
+    (void)message;
+    (void)c;
+#endif
+  }
+
+  nvtxBatchEvent_t events_[capacity];
+  nvtxEventAttributes_t attributes_[capacity];  ///< Copies for events with full attributes
+  std::size_t size_{0};
+};
+
+/**
+ * @brief Alias for an `event_batch_in` in the global NVTX domain.
+ */
+using event_batch = event_batch_in<domain::global>;
+
+/**
+ * @brief Push/pop range in domain `D` recorded in the calling thread's
+ * `event_batch_in<D>::this_thread()` buffer, from construction to
+ * destruction.
+ *
+ * Example:
+ * \code{.cpp}
+ * for (auto& item : items) {
+ *    nvtx3::batched_range_in<my_domain> r{item_name};  // A registered_string_in<my_domain>
+ *    process(item);
+ * }
+ * \endcode
+ */
+template <class D = domain::global>
+class batched_range_in {
+ public:
+  explicit batched_range_in(event_attributes const& attr) noexcept
+  {
+    event_batch_in<D>::this_thread().push(attr);
+  }
+
+  explicit batched_range_in(registered_string_in<D> const& message,
+                            category const& c = category{0}) noexcept
+  {
+    event_batch_in<D>::this_thread().push(message, c);
+  }
+
+  void* operator new(std::size_t) = delete;
+
+  batched_range_in(batched_range_in const&) = delete;
+  batched_range_in& operator=(batched_range_in const&) = delete;
+  batched_range_in(batched_range_in&&) = delete;
+  batched_range_in& operator=(batched_range_in&&) = delete;
+
+  ~batched_range_in() noexcept { event_batch_in<D>::this_thread().pop(); }
+};
+
+/**
+ * @brief Alias for a `batched_range_in` in the global NVTX domain.
+ */
+using batched_range = batched_range_in<domain::global>;
+
+/**
+ * @brief Counter in domain `D`: a named value whose samples tools plot as a
+ * time series, such as the occupancy of a queue or the bytes held by an
+ * allocator.
+ *
+ * The counter is registered once, when the `counter_in` is constructed, and
+ * `sample` passes only its handle and the value to the tool, which costs
+ * less than a `mark_in` with a payload.  Like a `registered_string_in`, a
+ * `counter_in` is meant to be constructed once and reused, for example with
+ * `get<C>()`.
+ *
+ * Example:
+ * \code{.cpp}
+ * struct queue_depth {
+ *   static constexpr char const* name{"queue depth"};
+ *   static constexpr char const* unit{"items"};
+ * };
+ *
+ * void enqueue(item const& i)
+ * {
+ *   queue.push(i);
+ *   nvtx3::counter_in<my_domain>::get<queue_depth>().sample(queue.size());
+ * }
+ * \endcode
+ *
+ * @tparam D Type containing `name` member used to identify the `domain` to
+ * which the counter belongs. Else, `domain::global` to indicate that the
+ * global NVTX domain should be used.
+ */
+template <class D = domain::global>
+class counter_in {
+ public:
+  /**
+   * @brief Returns a function local static `counter_in` called `C::name`,
+   * whose values are in `C::unit`, registered upon first invocation.
+   *
+   * @tparam C Type containing the `char const*` members `C::name` and
+   * `C::unit`.
+   */
+  template <typename C>
+  static counter_in const& get() noexcept
+  {
+    static detail::attach_cache<counter_in> c;
+    return c.get([] { return new counter_in(C::name, C::unit); });
+  }
+
+  /**
+   * @brief Registers a counter called `name` in domain `D`, whose values are
+   * in `unit`.
+   */
+  explicit counter_in(char const* name, char const* unit = "") noexcept
+    : handle_{nvtxDomainCounterRegisterA(domain::get<D>(), name, unit)}
+  {
+  }
+
+  /**
+   * @brief Records `value` as the current value of the counter.
+   *
+   * Integers are sent with `nvtxCounterSampleInt64`, so unsigned values above
+   * `INT64_MAX` wrap around.  Nothing is sent while domain `D` is disabled.
+   */
+  template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+  void sample(T value) const noexcept
+  {
+#ifndef NVTX_DISABLE
+    if (domain_enabled<D>()) {
+      nvtxCounterSampleInt64(handle_, static_cast<int64_t>(value));
+    }
+#else
+    (void)value;
+#endif
+  }
+
+  /**
+   * @brief Records `value` as the current value of the counter, with
+   * `nvtxCounterSampleDouble`.
+   */
+  template <typename T,
+            typename std::enable_if<std::is_floating_point<T>::value, int>::type = 0>
+  void sample(T value) const noexcept
+  {
+#ifndef NVTX_DISABLE
+    if (domain_enabled<D>()) {
+      nvtxCounterSampleDouble(handle_, static_cast<double>(value));
+    }
+#else
+    (void)value;
+#endif
+  }
+
+  /**
+   * @brief Returns the counter's handle, null if no tool records counters.
+   */
+  nvtxCounterHandle_t get_handle() const noexcept { return handle_; }
+
+ private:
+  nvtxCounterHandle_t handle_{};
+};
+
+/**
+ * @brief Alias for a `counter_in` in the global NVTX domain.
+ */
+using counter = counter_in<domain::global>;
+
+}  // namespace NVTX3_VERSION_NAMESPACE
+
+}  // namespace nvtx3
+
+/// @cond internal
+#if defined(NVTX_CALL_SITE_SECTION)
+#define NVTX3_V1_CALL_SITE_ATTRIBUTES \
+  __attribute__((section(NVTX_CALL_SITE_SECTION), used, aligned(alignof(::nvtxCallSite_t))))
+#else
+#define NVTX3_V1_CALL_SITE_ATTRIBUTES
+#endif
+
+#define NVTX3_V1_CONCAT_LINE_IMPL(NAME, LINE) NAME##LINE
+#define NVTX3_V1_CONCAT_LINE(NAME, LINE) NVTX3_V1_CONCAT_LINE_IMPL(NAME, LINE)
+#define NVTX3_V1_LINE_NAME(NAME) NVTX3_V1_CONCAT_LINE(NAME, __LINE__)
+/// @endcond
+
+#ifndef NVTX_DISABLE
+/**
+ * @brief Define `NAME`, the static `nvtx3::call_site` describing this line in
+ * domain `D`, enabled at first.
+ */
+#define NVTX3_V1_CALL_SITE_IN(D, NAME)                                        \
+  static ::nvtx3::v1::call_site NAME NVTX3_V1_CALL_SITE_ATTRIBUTES{         \
+    ::nvtx3::v1::detail::call_site_domain<D>(), __func__, __FILE__, __LINE__, 1}
+
+/**
+ * @brief `NVTX3_V1_FUNC_RANGE_IF_IN` with a call site.  The range begins only
+ * while the site and domain `D` are enabled.
+ *
+ * `C` is evaluated on every call first, as with `NVTX3_V1_FUNC_RANGE_IF_IN`,
+ * so its side effects do not depend on the site or the domain.  Each call
+ * with `C` true costs a test of the site and of `nvtx3::domain_enabled<D>`.
+ */
+#define NVTX3_V1_CHECKED_FUNC_RANGE_IF_IN(D, C)                                      \
+  NVTX3_V1_CALL_SITE_IN(D, nvtx3_call_site__);                                       \
+  ::nvtx3::v1::detail::optional_scoped_range_in<D> optional_nvtx3_range__;           \
+  if ((C) && nvtx3_call_site__.enabled && ::nvtx3::v1::domain_enabled<D>()) {        \
+    static ::nvtx3::v1::detail::attach_cache<::nvtx3::v1::event_attributes>          \
+      nvtx3_func_attr__;                                                             \
+    char const* const nvtx3_func_name__ = __func__;                                  \
+    optional_nvtx3_range__.begin(nvtx3_func_attr__.get([nvtx3_func_name__] {         \
+      return new ::nvtx3::v1::event_attributes{                                      \
+        ::nvtx3::v1::registered_string_in<D>{nvtx3_func_name__}};                    \
+    }));                                                                             \
+  }
+
+/**
+ * @brief `NVTX3_V1_FUNC_RANGE_IN` with a call site.
+ */
+#define NVTX3_V1_CHECKED_FUNC_RANGE_IN(D) NVTX3_V1_CHECKED_FUNC_RANGE_IF_IN(D, true)
+
+/**
+ * @brief Range in domain `D` from this line to the end of the enclosing
+ * scope, with a `nvtx3::call_site`.
+ *
+ * The arguments construct the range's `event_attributes`, only while the
+ * site is enabled.  At least one argument is required, and at most one
+ * `NVTX3_SCOPED_RANGE_IN` may appear per source line.
+ *
+ * Example:
+ * \code{.cpp}
+ * for (auto& item : items) {
+ *    NVTX3_SCOPED_RANGE_IN(my_domain, "process item", nvtx3::payload{item.id});
+ *    process(item);
+ * }
+ * \endcode
+ */
+#define NVTX3_V1_SCOPED_RANGE_IN(D, ...)                                                \
+  NVTX3_V1_CALL_SITE_IN(D, NVTX3_V1_LINE_NAME(nvtx3_call_site_));                       \
+  ::nvtx3::v1::detail::optional_scoped_range_in<D> NVTX3_V1_LINE_NAME(nvtx3_range_);    \
+  if (NVTX3_V1_LINE_NAME(nvtx3_call_site_).enabled &&                                   \
+      ::nvtx3::v1::domain_enabled<D>()) {                                               \
+    NVTX3_V1_LINE_NAME(nvtx3_range_).begin(::nvtx3::v1::event_attributes{__VA_ARGS__}); \
+  }
+#else
+#define NVTX3_V1_CALL_SITE_IN(D, NAME)
+#define NVTX3_V1_CHECKED_FUNC_RANGE_IF_IN(D, C)
+#define NVTX3_V1_CHECKED_FUNC_RANGE_IN(D)
+#define NVTX3_V1_SCOPED_RANGE_IN(D, ...)
+#endif  // NVTX_DISABLE
+
+/**
+ * @brief `NVTX3_V1_CHECKED_FUNC_RANGE_IN` in the global domain.
+ */
+#define NVTX3_V1_CHECKED_FUNC_RANGE() NVTX3_V1_CHECKED_FUNC_RANGE_IN(::nvtx3::v1::domain::global)
+
+/**
+ * @brief `NVTX3_V1_CHECKED_FUNC_RANGE_IF_IN` in the global domain.
+ */
+#define NVTX3_V1_CHECKED_FUNC_RANGE_IF(C) \
+  NVTX3_V1_CHECKED_FUNC_RANGE_IF_IN(::nvtx3::v1::domain::global, C)
+
+/**
+ * @brief `NVTX3_V1_SCOPED_RANGE_IN` in the global domain.
+ */
+#define NVTX3_V1_SCOPED_RANGE(...) \
+  NVTX3_V1_SCOPED_RANGE_IN(::nvtx3::v1::domain::global, __VA_ARGS__)
+
+/* From 1.1, the unversioned NVTX3_FUNC_RANGE macros name the checked ones:
+ * their ranges also depend on the call site and the domain being enabled,
+ * while `C` is still evaluated on every call.  NVTX3_V1_FUNC_RANGE and the
+ * others keep the 1.0 behavior. */
+#if defined(NVTX3_INLINE_THIS_VERSION)
+/* clang format off */
+#undef NVTX3_FUNC_RANGE
+#undef NVTX3_FUNC_RANGE_IF
+#undef NVTX3_FUNC_RANGE_IN
+#undef NVTX3_FUNC_RANGE_IF_IN
+#define NVTX3_FUNC_RANGE       NVTX3_V1_CHECKED_FUNC_RANGE
+#define NVTX3_FUNC_RANGE_IF    NVTX3_V1_CHECKED_FUNC_RANGE_IF
+#define NVTX3_FUNC_RANGE_IN    NVTX3_V1_CHECKED_FUNC_RANGE_IN
+#define NVTX3_FUNC_RANGE_IF_IN NVTX3_V1_CHECKED_FUNC_RANGE_IF_IN
+#define NVTX3_CALL_SITE_IN     NVTX3_V1_CALL_SITE_IN
+#define NVTX3_SCOPED_RANGE     NVTX3_V1_SCOPED_RANGE
+#define NVTX3_SCOPED_RANGE_IN  NVTX3_V1_SCOPED_RANGE_IN
+/* clang format on */
+#endif
+
+#endif  // NVTX3_CPP_DEFINITIONS_V1_1
+
 /* Add functionality for new minor versions here, by copying the above section enclosed
  * in #ifndef NVTX3_CPP_DEFINITIONS_Vx_y, and incrementing the minor version.  This code
  * is an example of how additions for version 1.2 would look, indented for clarity.  Note
@@ -0,0 +1,25 @@
+/*
+* Copyright 2009-2022  NVIDIA Corporation.  All rights reserved.
+*
+* Licensed under the Apache License v2.0 with LLVM Exceptions.
+* See https://llvm.org/LICENSE.txt for license information.
+* SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+*/
+
+/* Macros of nvtxImpl.h used by the implementations of the extensions.  When the core of an
+*  earlier NVTX version 3 header was included first, NVTX_IMPL_REVISION is not defined and
+*  neither are these: the extensions then call the tool as that core does, with no static keys,
+*  no detaching and no pausing. */
+
+#ifndef NVTX_STATIC_KEY_ENABLED
+#define NVTX_STATIC_KEY_ENABLED() 1
+#endif
+
+#ifndef NVTX_TOOL_CALL_BEGIN
+#define NVTX_TOOL_CALL_BEGIN(local) (void)0
+#define NVTX_TOOL_CALL_END() (void)0
+#endif
+
+#ifndef NVTX_EVENTS_PAUSED
+#define NVTX_EVENTS_PAUSED() 0
+#endif
@@ -27,6 +27,13 @@
 #include <sched.h>
 #endif
 
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <ucontext.h>
+#endif
+
 #include <limits.h>
 #include <dlfcn.h>
 #include <fcntl.h>
@@ -40,6 +47,7 @@
 #include <sys/types.h>
 #include <pthread.h>
 #include <stdlib.h>
+#include <time.h>
 #include <wchar.h>
 
 #endif
@@ -49,6 +57,154 @@
 #define NVTX_INIT_STATE_FRESH 0
 #define NVTX_INIT_STATE_STARTED 1
 #define NVTX_INIT_STATE_COMPLETE 2
+#define NVTX_INIT_STATE_STARTED_WAITERS 3 /* Started, and another thread waits for completion */
+
+/* Define NVTX_SUPPORT_DETACH to 1 before including NVTX, in every translation unit of a module,
+*  to let nvtxDetachInjectionLibrary unload the tool.  NVTX API functions then count the calls
+*  they make into the tool, so the detach can wait until no thread runs the tool's code.  A call
+*  increments one of NVTX_TOOL_CALL_SLOTS counters, picked by hashing its stack address so that
+*  threads mostly use separate cache lines, in the half of nvtxToolCalls selected by
+*  toolCallEpoch.  The two atomic operations add about 20 ns to every call reaching a tool;
+*  calls finding a null function pointer return at once and count nothing, so a module without
+*  a tool, or whose tool was detached, pays nothing.  Without it, detaching turns NVTX calls into
+*  no-ops but leaves the tool loaded. */
+#if !defined(NVTX_SUPPORT_DETACH)
+#define NVTX_SUPPORT_DETACH 0
+#endif
+
+#define NVTX_TOOL_CALL_SLOT_BITS 5
+#define NVTX_TOOL_CALL_SLOTS (1u << NVTX_TOOL_CALL_SLOT_BITS)
+#define NVTX_TOOL_CALL_STRIDE 16 /* Counters 64 bytes apart, one per cache line */
+
+#if defined(_WIN32)
+#define NVTX_ATOMIC_INCREMENT_32(address) InterlockedIncrement((volatile LONG*)(address))
+#define NVTX_ATOMIC_DECREMENT_32(address) InterlockedDecrement((volatile LONG*)(address))
+#else
+#define NVTX_ATOMIC_INCREMENT_32(address) __sync_fetch_and_add(address, 1u)
+#define NVTX_ATOMIC_DECREMENT_32(address) __sync_fetch_and_sub(address, 1u)
+#endif
+
+#if NVTX_SUPPORT_DETACH
+#define NVTX_TOOL_CALL_SLOT(stackAddress) \
+    (((unsigned int)((size_t)(stackAddress) >> 12) * 0x9E3779B1u) >> (32 - NVTX_TOOL_CALL_SLOT_BITS))
+#define NVTX_TOOL_CALL_COUNTER(stackAddress) \
+    (&NVTX_VERSIONED_IDENTIFIER(nvtxToolCalls)[((NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).toolCallEpoch & 1u) * NVTX_TOOL_CALL_SLOTS + NVTX_TOOL_CALL_SLOT(stackAddress)) * NVTX_TOOL_CALL_STRIDE])
+/* Opens a counted call in a block whose function pointer variable is local; the caller
+*  then reloads local, since only a pointer loaded after the increment is waited for. */
+#define NVTX_TOOL_CALL_BEGIN(local) \
+    volatile unsigned int* const nvtxToolCallCounter = NVTX_TOOL_CALL_COUNTER(&(local)); \
+    NVTX_ATOMIC_INCREMENT_32(nvtxToolCallCounter)
+#define NVTX_TOOL_CALL_END() NVTX_ATOMIC_DECREMENT_32(nvtxToolCallCounter)
+#else
+#define NVTX_TOOL_CALL_BEGIN(local) (void)0
+#define NVTX_TOOL_CALL_END() (void)0
+#endif
+
+/* Define NVTX_STATIC_KEYS to 1 before including NVTX to turn the test of every NVTX API call
+*  for an attached tool into a patchable instruction, like kernel static keys.  The call site
+*  holds a 5-byte jump to the code loading the function pointer; once initialization finds no
+*  tool, every such site of the module is rewritten into a 5-byte CMP, and back into the jump
+*  when nvtxAttachInjectionLibraryA attaches one.  Without a tool, an NVTX call then costs a
+*  CMP, and no load or branch.  Sites are listed in the NVTX_STATIC_KEY_SECTION section of the
+*  module, which initialization finds through the __start_ and __stop_ symbols of the linker.
+*  Patching writes the code through /proc/self/mem, so code pages are never mapped writable,
+*  and first turns each site into an int3, as Linux does for its own code, so other threads can
+*  keep running NVTX calls meanwhile: NVTX installs a SIGTRAP handler, chaining to the previous
+*  one, which lets a thread meeting the int3 take the jump.  An application replacing the
+*  SIGTRAP handler afterwards must chain to it.  Only available with GCC or Clang on x86-64
+*  Linux, outside strict ISO C modes, which do not declare syscall(); elsewhere the setting is
+*  ignored.  Sites stay jumps, the behavior without static keys, if /proc/self/mem cannot be
+*  written. */
+#if !defined(NVTX_STATIC_KEYS)
+#define NVTX_STATIC_KEYS 0
+#endif
+
+#if defined(__GNUC__) && defined(__linux__) && defined(__x86_64__) \
+    && (defined(__cplusplus) || defined(_GNU_SOURCE) || defined(_DEFAULT_SOURCE) || defined(_BSD_SOURCE))
+#define NVTX_STATIC_KEYS_SUPPORTED 1
+#else
+#define NVTX_STATIC_KEYS_SUPPORTED 0
+#endif
+
+/* Whether <time.h> declares clock_gettime and CLOCK_MONOTONIC for nvtxGetTimestamp.  Strict
+*  ISO C modes only do when _POSIX_C_SOURCE is defined as 199309L or later before including
+*  any system header; otherwise nvtxGetTimestamp returns 0. */
+#if !defined(_WIN32) && (defined(__cplusplus) || defined(__APPLE__) \
+    || (defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 199309L))
+#define NVTX_MONOTONIC_CLOCK_SUPPORTED 1
+#else
+#define NVTX_MONOTONIC_CLOCK_SUPPORTED 0
+#endif
+
+#define NVTX_STATIC_KEY_STRINGIFY2(x) #x
+#define NVTX_STATIC_KEY_STRINGIFY(x) NVTX_STATIC_KEY_STRINGIFY2(x)
+#define NVTX_STATIC_KEY_SECTION NVTX_STATIC_KEY_STRINGIFY(NVTX_VERSIONED_IDENTIFIER(nvtxStaticKeySites))
+
+#if NVTX_STATIC_KEYS && NVTX_STATIC_KEYS_SUPPORTED
+#define NVTX_STATIC_KEY_ENABLED() NVTX_VERSIONED_IDENTIFIER(nvtxStaticKeyEnabled)()
+#else
+#define NVTX_STATIC_KEY_ENABLED() 1
+#endif
+
+/* Define NVTX_DIRECT_TOOL before including NVTX, in a module that links a tool statically, to have nvtxDomainMarkEx, nvtxDomainRangeStartEx, nvtxDomainRangeEnd,
+*  nvtxDomainRangePushEx and nvtxDomainRangePop call the tool's nvtxDirectToolDomain* functions
+*  directly instead of through the function pointers in the globals.  The calls can then be
+*  inlined with link-time optimization.  Those five functions only test that initialization has
+*  completed, and initialize otherwise; NVTX_STATIC_KEYS does not apply to them, and a tool
+*  attached later or through NVTX_INJECTION64_PATH does not receive their events. */
+#ifdef NVTX_DIRECT_TOOL
+#define NVTX_DIRECT_TOOL_READY() \
+    (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).initState == NVTX_INIT_STATE_COMPLETE || NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+#endif
+
+/* NVTX functions recording events, as opposed to those naming or registering objects, test
+*  NVTX_EVENTS_PAUSED() once they have found a tool, and return if it is nonzero.  nvtxPause,
+*  nvtxResume and the tool's NvtxExportTablePause set paused; the first nvtxPauseThread sets
+*  threadsPaused, which stays set, since a thread may exit while paused.  While both are zero the
+*  test is one load and one branch, taken the same way every time; otherwise nvtxEventsPaused
+*  checks paused and the calling thread's flag.  Pausing single threads requires thread-local
+*  storage, NVTX_THREAD_LOCAL. */
+#if defined(_MSC_VER)
+#define NVTX_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+#define NVTX_THREAD_LOCAL __thread
+#endif
+
+#define NVTX_EVENTS_PAUSED() \
+    ((NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).paused | NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).threadsPaused) != 0 && NVTX_VERSIONED_IDENTIFIER(nvtxEventsPaused)())
+
+/* Define NVTX_INIT_ASYNC to 1 before including NVTX, in every translation unit of a module,
+*  to initialize NVTX on a helper thread started when the module is loaded.  Until that thread
+*  has loaded the tool, markers and ranges return at once without reaching it; functions that
+*  create domains, register strings or name objects still wait for the initialization, so no
+*  handle or name is lost.  Only available with POSIX threads; ignored elsewhere.
+*  So that the tool never receives the end of a range whose start it missed, each thread counts
+*  the pushes dropped that way, and the pushes forwarded on top of them; a pop finding no
+*  forwarded push above a dropped one is dropped too.  Once any start was dropped, ends of range
+*  id 0, the id a dropped start returns, are dropped.  NVTX_ASYNC_* test droppedEvents first, so
+*  they cost one load and one branch until an event is dropped.  This assumes pushes and pops
+*  of a thread nest across domains; the timestamped and batched functions are not tracked. */
+#if defined(NVTX_INIT_ASYNC) && NVTX_INIT_ASYNC && defined(__GNUC__) && !defined(_WIN32)
+#define NVTX_INIT_ASYNC_ENABLED 1
+#else
+#define NVTX_INIT_ASYNC_ENABLED 0
+#endif
+
+#if NVTX_INIT_ASYNC_ENABLED
+#define NVTX_ASYNC_PUSH_DROPPED() (NVTX_VERSIONED_IDENTIFIER(nvtxAsyncPushDropped)(), 0)
+#define NVTX_ASYNC_START_DROPPED() (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).droppedEvents = 1, 0)
+#define NVTX_ASYNC_PUSH_FORWARDED(forwarded) \
+    do { if (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).droppedEvents && (forwarded)) NVTX_VERSIONED_IDENTIFIER(nvtxAsyncPushForwarded)(); } while (0)
+#define NVTX_ASYNC_POP_DROPPED() \
+    (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).droppedEvents && NVTX_VERSIONED_IDENTIFIER(nvtxAsyncPopDropped)())
+#define NVTX_ASYNC_END_DROPPED(id) (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).droppedEvents && (id) == 0)
+#else
+#define NVTX_ASYNC_PUSH_DROPPED() 0
+#define NVTX_ASYNC_START_DROPPED() 0
+#define NVTX_ASYNC_PUSH_FORWARDED(forwarded) do {} while (0)
+#define NVTX_ASYNC_POP_DROPPED() 0
+#define NVTX_ASYNC_END_DROPPED(id) 0
+#endif
 
 #ifdef NVTX_DEBUG_PRINT
 #ifdef __ANDROID__
@@ -76,24 +232,62 @@ extern "C" {
 /* ---- Forward declare all functions referenced in globals ---- */
 
 NVTX_LINKONCE_FWDDECL_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)(void);
+NVTX_LINKONCE_FWDDECL_FUNCTION int NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)(void);
+NVTX_LINKONCE_FWDDECL_FUNCTION int NVTX_VERSIONED_IDENTIFIER(nvtxAttachInjectionLibrary)(const char* path);
+NVTX_LINKONCE_FWDDECL_FUNCTION int NVTX_VERSIONED_IDENTIFIER(nvtxDetachInjectionLibrary)(void);
+NVTX_LINKONCE_FWDDECL_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxBatchReplay)(nvtxDomainHandle_t domain, nvtxBatchEvent_t* events, size_t count);
+NVTX_LINKONCE_FWDDECL_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxBatchSubmit)(nvtxDomainHandle_t domain, nvtxBatchEvent_t* events, size_t count);
+NVTX_LINKONCE_FWDDECL_FUNCTION nvtxRangeId_t NVTX_VERSIONED_IDENTIFIER(nvtxBatchSubmitAt)(nvtxDomainHandle_t domain, uint32_t type, const nvtxEventAttributes_t* eventAttrib, nvtxRangeId_t id, uint64_t timestamp);
 NVTX_LINKONCE_FWDDECL_FUNCTION int NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxEtiGetModuleFunctionTable)(
     NvtxCallbackModule module,
     NvtxFunctionTable* out_table,
     unsigned int* out_size);
 NVTX_LINKONCE_FWDDECL_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxEtiSetInjectionNvtxVersion)(
     uint32_t version);
+NVTX_LINKONCE_FWDDECL_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxEtiSetDomainFlagsSupported)(void);
+NVTX_LINKONCE_FWDDECL_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxEtiSetPaused)(int paused);
+NVTX_LINKONCE_FWDDECL_FUNCTION int NVTX_VERSIONED_IDENTIFIER(nvtxEventsPaused)(void);
+#if NVTX_INIT_ASYNC_ENABLED
+NVTX_LINKONCE_FWDDECL_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxAsyncPushDropped)(void);
+NVTX_LINKONCE_FWDDECL_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxAsyncPushForwarded)(void);
+NVTX_LINKONCE_FWDDECL_FUNCTION int NVTX_VERSIONED_IDENTIFIER(nvtxAsyncPopDropped)(void);
+#endif
 NVTX_LINKONCE_FWDDECL_FUNCTION const void* NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxGetExportTable)(
     uint32_t exportTableId);
 
 #include "nvtxInitDecls.h"
 
+/* Bounds of the call site section of this module, defined by the linker if it has any sites.
+*  Named after NVTX_CALL_SITE_SECTION, whose layout does not change with NVTX_IMPL_REVISION. */
+#if defined(NVTX_CALL_SITE_SECTION)
+extern nvtxCallSite_t __start_nvtxCallSites_v3[] __attribute__((weak));
+extern nvtxCallSite_t __stop_nvtxCallSites_v3[] __attribute__((weak));
+#define NVTX_CALL_SITES_BEGIN __start_nvtxCallSites_v3
+#define NVTX_CALL_SITES_END __stop_nvtxCallSites_v3
+#else
+#define NVTX_CALL_SITES_BEGIN 0
+#define NVTX_CALL_SITES_END 0
+#endif
+
 /* ---- Define all globals ---- */
 
 typedef struct nvtxGlobals_t
 {
     volatile unsigned int initState;
+    volatile unsigned int injectionAttached; /* Nonzero once a tool's InitializeInjectionNvtx2 succeeded */
+    volatile unsigned int toolCallEpoch; /* Its lowest bit selects the half of nvtxToolCalls counting new calls */
+    volatile unsigned int toolCallWaiter; /* Nonzero while a thread waits for calls into the tool to return */
+    volatile unsigned int attachGeneration; /* Incremented when a tool attaches or detaches after initialization */
+    void* injectionLibrary; /* Handle of the tool's dynamic library, or null if it was linked statically */
     NvtxExportTableCallbacks etblCallbacks;
     NvtxExportTableVersionInfo etblVersionInfo;
+    NvtxExportTableCallSites etblCallSites;
+    NvtxExportTableDomains etblDomains;
+    volatile unsigned int domainFlags; /* Nonzero while the tool's domain handles begin with an nvtxDomainFlags_t */
+    NvtxExportTablePause etblPause;
+    volatile unsigned int paused; /* Nonzero while events of all threads are paused */
+    volatile unsigned int threadsPaused; /* Nonzero once nvtxPauseThread was called by any thread */
+    volatile unsigned int droppedEvents; /* Nonzero once a start or push was dropped during NVTX_INIT_ASYNC initialization */
 
     /* Implementation function pointers */
     nvtxMarkEx_impl_fntype nvtxMarkEx_impl_fnptr;
@@ -158,6 +352,9 @@ typedef struct nvtxGlobals_t
     nvtxDomainCreateW_impl_fntype nvtxDomainCreateW_impl_fnptr;
     nvtxDomainDestroy_impl_fntype nvtxDomainDestroy_impl_fnptr;
     nvtxInitialize_impl_fntype nvtxInitialize_impl_fnptr;
+    nvtxDomainMarkCompact_impl_fntype nvtxDomainMarkCompact_impl_fnptr;
+    nvtxDomainRangeStartCompact_impl_fntype nvtxDomainRangeStartCompact_impl_fnptr;
+    nvtxDomainRangePushCompact_impl_fntype nvtxDomainRangePushCompact_impl_fnptr;
 
     nvtxDomainSyncUserCreate_impl_fntype nvtxDomainSyncUserCreate_impl_fnptr;
     nvtxDomainSyncUserDestroy_impl_fntype nvtxDomainSyncUserDestroy_impl_fnptr;
@@ -166,6 +363,12 @@ typedef struct nvtxGlobals_t
     nvtxDomainSyncUserAcquireSuccess_impl_fntype nvtxDomainSyncUserAcquireSuccess_impl_fnptr;
     nvtxDomainSyncUserReleasing_impl_fntype nvtxDomainSyncUserReleasing_impl_fnptr;
 
+    nvtxDomainBatchSubmit_impl_fntype nvtxDomainBatchSubmit_impl_fnptr;
+
+    nvtxDomainCounterRegisterA_impl_fntype nvtxDomainCounterRegisterA_impl_fnptr;
+    nvtxCounterSampleInt64_impl_fntype nvtxCounterSampleInt64_impl_fnptr;
+    nvtxCounterSampleDouble_impl_fntype nvtxCounterSampleDouble_impl_fnptr;
+
     /* Tables of function pointers -- Extra null added to the end to ensure
     *  a crash instead of silent corruption if a tool reads off the end. */
     NvtxFunctionPointer* functionTable_CORE  [NVTX_CBID_CORE_SIZE   + 1];
@@ -174,11 +377,18 @@ typedef struct nvtxGlobals_t
     NvtxFunctionPointer* functionTable_CUDART[NVTX_CBID_CUDART_SIZE + 1];
     NvtxFunctionPointer* functionTable_CORE2 [NVTX_CBID_CORE2_SIZE  + 1];
     NvtxFunctionPointer* functionTable_SYNC  [NVTX_CBID_SYNC_SIZE   + 1];
+    NvtxFunctionPointer* functionTable_BATCH [NVTX_CBID_BATCH_SIZE  + 1];
+    NvtxFunctionPointer* functionTable_COUNTER[NVTX_CBID_COUNTER_SIZE + 1];
 } nvtxGlobals_t;
 
 NVTX_LINKONCE_DEFINE_GLOBAL nvtxGlobals_t NVTX_VERSIONED_IDENTIFIER(nvtxGlobals) =
 {
     NVTX_INIT_STATE_FRESH,
+    0,
+    0,
+    0,
+    0,
+    0,
 
     {
         sizeof(NvtxExportTableCallbacks),
@@ -190,6 +400,23 @@ NVTX_LINKONCE_DEFINE_GLOBAL nvtxGlobals_t NVTX_VERSIONED_IDENTIFIER(nvtxGlobals)
         0,
         NVTX_VERSIONED_IDENTIFIER(nvtxEtiSetInjectionNvtxVersion)
     },
+    {
+        sizeof(NvtxExportTableCallSites),
+        NVTX_CALL_SITES_BEGIN,
+        NVTX_CALL_SITES_END
+    },
+    {
+        sizeof(NvtxExportTableDomains),
+        NVTX_VERSIONED_IDENTIFIER(nvtxEtiSetDomainFlagsSupported)
+    },
+    0,
+    {
+        sizeof(NvtxExportTablePause),
+        NVTX_VERSIONED_IDENTIFIER(nvtxEtiSetPaused)
+    },
+    0,
+    0,
+    0,
 
     /* Implementation function pointers */
     NVTX_VERSIONED_IDENTIFIER(nvtxMarkEx_impl_init),
@@ -254,6 +481,9 @@ NVTX_LINKONCE_DEFINE_GLOBAL nvtxGlobals_t NVTX_VERSIONED_IDENTIFIER(nvtxGlobals)
     NVTX_VERSIONED_IDENTIFIER(nvtxDomainCreateW_impl_init),
     NVTX_VERSIONED_IDENTIFIER(nvtxDomainDestroy_impl_init),
     NVTX_VERSIONED_IDENTIFIER(nvtxInitialize_impl_init),
+    NVTX_VERSIONED_IDENTIFIER(nvtxDomainMarkCompact_impl_init),
+    NVTX_VERSIONED_IDENTIFIER(nvtxDomainRangeStartCompact_impl_init),
+    NVTX_VERSIONED_IDENTIFIER(nvtxDomainRangePushCompact_impl_init),
 
     NVTX_VERSIONED_IDENTIFIER(nvtxDomainSyncUserCreate_impl_init),
     NVTX_VERSIONED_IDENTIFIER(nvtxDomainSyncUserDestroy_impl_init),
@@ -262,6 +492,12 @@ NVTX_LINKONCE_DEFINE_GLOBAL nvtxGlobals_t NVTX_VERSIONED_IDENTIFIER(nvtxGlobals)
     NVTX_VERSIONED_IDENTIFIER(nvtxDomainSyncUserAcquireSuccess_impl_init),
     NVTX_VERSIONED_IDENTIFIER(nvtxDomainSyncUserReleasing_impl_init),
 
+    NVTX_VERSIONED_IDENTIFIER(nvtxDomainBatchSubmit_impl_init),
+
+    NVTX_VERSIONED_IDENTIFIER(nvtxDomainCounterRegisterA_impl_init),
+    NVTX_VERSIONED_IDENTIFIER(nvtxCounterSampleInt64_impl_init),
+    NVTX_VERSIONED_IDENTIFIER(nvtxCounterSampleDouble_impl_init),
+
     /* Tables of function pointers */
     {
         0,
@@ -339,6 +575,9 @@ NVTX_LINKONCE_DEFINE_GLOBAL nvtxGlobals_t NVTX_VERSIONED_IDENTIFIER(nvtxGlobals)
         (NvtxFunctionPointer*)&NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainCreateW_impl_fnptr,
         (NvtxFunctionPointer*)&NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainDestroy_impl_fnptr,
         (NvtxFunctionPointer*)&NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxInitialize_impl_fnptr,
+        (NvtxFunctionPointer*)&NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainMarkCompact_impl_fnptr,
+        (NvtxFunctionPointer*)&NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangeStartCompact_impl_fnptr,
+        (NvtxFunctionPointer*)&NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangePushCompact_impl_fnptr,
         0
     },
     {
@@ -350,9 +589,74 @@ NVTX_LINKONCE_DEFINE_GLOBAL nvtxGlobals_t NVTX_VERSIONED_IDENTIFIER(nvtxGlobals)
         (NvtxFunctionPointer*)&NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserAcquireSuccess_impl_fnptr,
         (NvtxFunctionPointer*)&NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserReleasing_impl_fnptr,
         0
+    },
+    {
+        0,
+        (NvtxFunctionPointer*)&NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainBatchSubmit_impl_fnptr,
+        0
+    },
+    {
+        0,
+        (NvtxFunctionPointer*)&NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainCounterRegisterA_impl_fnptr,
+        (NvtxFunctionPointer*)&NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxCounterSampleInt64_impl_fnptr,
+        (NvtxFunctionPointer*)&NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxCounterSampleDouble_impl_fnptr,
+        0
     }
 };
 
+#if NVTX_SUPPORT_DETACH
+/* Counters of calls into the tool, NVTX_TOOL_CALL_STRIDE apart -- two halves of NVTX_TOOL_CALL_SLOTS */
+NVTX_LINKONCE_DEFINE_GLOBAL volatile unsigned int NVTX_VERSIONED_IDENTIFIER(nvtxToolCalls)[2 * NVTX_TOOL_CALL_SLOTS * NVTX_TOOL_CALL_STRIDE] = {0};
+#endif
+
+#if NVTX_STATIC_KEYS_SUPPORTED
+/* Entry of NVTX_STATIC_KEY_SECTION: offsets from the fields themselves to the 5-byte instruction
+*  of a call site and to the code it jumps to, so the section needs no relocation at load. */
+typedef struct NVTX_VERSIONED_IDENTIFIER(nvtxStaticKeySite_t)
+{
+    int32_t code;
+    int32_t target;
+} NVTX_VERSIONED_IDENTIFIER(nvtxStaticKeySite_t);
+
+/* Opcodes of a site: jmp rel32 while enabled, cmp eax, imm32 while disabled */
+#define NVTX_STATIC_KEY_JMP 0xe9
+#define NVTX_STATIC_KEY_CMP 0x3d
+
+/* Defined by the linker when the module has call sites, null otherwise */
+extern const NVTX_VERSIONED_IDENTIFIER(nvtxStaticKeySite_t) NVTX_VERSIONED_IDENTIFIER(__start_nvtxStaticKeySites)[] __attribute__((weak));
+extern const NVTX_VERSIONED_IDENTIFIER(nvtxStaticKeySite_t) NVTX_VERSIONED_IDENTIFIER(__stop_nvtxStaticKeySites)[] __attribute__((weak));
+
+/* Inlined into every call site.  Disabling the site turns the jump into a CMP of the same
+*  length, which only changes the flags, so patching rewrites the opcode byte alone. */
+NVTX_INLINE_STATIC __attribute__((always_inline)) int NVTX_VERSIONED_IDENTIFIER(nvtxStaticKeyEnabled)(void)
+{
+    __asm__ goto(
+        "1: .byte 0xe9\n\t"
+        ".long %l[enabled] - 2f\n\t"
+        "2:\n\t"
+        ".pushsection " NVTX_STATIC_KEY_SECTION ",\"a\"\n\t"
+        ".balign 4\n\t"
+        ".long 1b - .\n\t"
+        ".long %l[enabled] - .\n\t"
+        ".popsection"
+        : : : "cc" : enabled);
+    return 0;
+enabled:
+    return 1;
+}
+#endif
+
+#ifdef NVTX_THREAD_LOCAL
+/* Nonzero while nvtxPauseThread pauses the events of the thread */
+NVTX_LINKONCE_DEFINE_GLOBAL NVTX_THREAD_LOCAL unsigned int NVTX_VERSIONED_IDENTIFIER(nvtxThreadPaused) = 0;
+#endif
+
+#if NVTX_INIT_ASYNC_ENABLED
+/* Pushes of the thread dropped during initialization, and pushes forwarded on top of them */
+NVTX_LINKONCE_DEFINE_GLOBAL NVTX_THREAD_LOCAL unsigned int NVTX_VERSIONED_IDENTIFIER(nvtxThreadDroppedPushes) = 0;
+NVTX_LINKONCE_DEFINE_GLOBAL NVTX_THREAD_LOCAL unsigned int NVTX_VERSIONED_IDENTIFIER(nvtxThreadForwardedPushes) = 0;
+#endif
+
 /* ---- Define static inline implementations of core API functions ---- */
 
 #include "nvtxImplCore.h"
@@ -367,7 +671,8 @@ NVTX_LINKONCE_DEFINE_FUNCTION int NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxEtiGetM
     unsigned int bytes = 0;
     NvtxFunctionTable table = (NvtxFunctionTable)0;
 
-    switch (module)
+    /* As int, since the modules of extension headers are not constants of NvtxCallbackModule */
+    switch ((int)module)
     {
     case NVTX_CB_MODULE_CORE:
         table = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).functionTable_CORE;
@@ -393,6 +698,14 @@ NVTX_LINKONCE_DEFINE_FUNCTION int NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxEtiGetM
         table = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).functionTable_SYNC;
         bytes = (unsigned int)sizeof(NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).functionTable_SYNC);
         break;
+    case NVTX_CB_MODULE_BATCH:
+        table = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).functionTable_BATCH;
+        bytes = (unsigned int)sizeof(NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).functionTable_BATCH);
+        break;
+    case NVTX_CB_MODULE_COUNTER:
+        table = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).functionTable_COUNTER;
+        bytes = (unsigned int)sizeof(NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).functionTable_COUNTER);
+        break;
     default: return 0;
     }
 
@@ -411,6 +724,9 @@ NVTX_LINKONCE_DEFINE_FUNCTION const void* NVTX_API NVTX_VERSIONED_IDENTIFIER(nvt
     {
     case NVTX_ETID_CALLBACKS:       return &NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).etblCallbacks;
     case NVTX_ETID_VERSIONINFO:     return &NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).etblVersionInfo;
+    case NVTX_ETID_CALLSITES:       return &NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).etblCallSites;
+    case NVTX_ETID_DOMAINS:         return &NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).etblDomains;
+    case NVTX_ETID_PAUSE:           return &NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).etblPause;
     default:                        return 0;
     }
 }
@@ -421,6 +737,56 @@ NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxEtiSet
     (void)version;
 }
 
+NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxEtiSetDomainFlagsSupported)(void)
+{
+    NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).domainFlags = 1;
+}
+
+NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxEtiSetPaused)(int paused)
+{
+    NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).paused = paused ? 1 : 0;
+}
+
+/* Slow path of NVTX_EVENTS_PAUSED, taken while any pause is in effect */
+NVTX_LINKONCE_DEFINE_FUNCTION int NVTX_VERSIONED_IDENTIFIER(nvtxEventsPaused)(void)
+{
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).paused)
+        return 1;
+#ifdef NVTX_THREAD_LOCAL
+    return NVTX_VERSIONED_IDENTIFIER(nvtxThreadPaused) != 0;
+#else
+    return 0;
+#endif
+}
+
+#if NVTX_INIT_ASYNC_ENABLED
+NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxAsyncPushDropped)(void)
+{
+    ++NVTX_VERSIONED_IDENTIFIER(nvtxThreadDroppedPushes);
+    NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).droppedEvents = 1;
+}
+
+NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxAsyncPushForwarded)(void)
+{
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxThreadDroppedPushes) != 0)
+        ++NVTX_VERSIONED_IDENTIFIER(nvtxThreadForwardedPushes);
+}
+
+/* Returns nonzero if the pop ends a range whose push was dropped */
+NVTX_LINKONCE_DEFINE_FUNCTION int NVTX_VERSIONED_IDENTIFIER(nvtxAsyncPopDropped)(void)
+{
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxThreadForwardedPushes) != 0)
+    {
+        --NVTX_VERSIONED_IDENTIFIER(nvtxThreadForwardedPushes);
+        return 0;
+    }
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxThreadDroppedPushes) == 0)
+        return 0;
+    --NVTX_VERSIONED_IDENTIFIER(nvtxThreadDroppedPushes);
+    return 1;
+}
+#endif
+
 /* ---- Define implementations of init versions of all API functions ---- */
 
 #include "nvtxInitDefs.h"
@@ -0,0 +1,71 @@
+/*
+* Copyright 2009-2022  NVIDIA Corporation.  All rights reserved.
+*
+* Licensed under the Apache License v2.0 with LLVM Exceptions.
+* See https://llvm.org/LICENSE.txt for license information.
+* SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+*/
+
+#ifndef NVTX_IMPL_GUARD_BATCH
+#error Never include this file directly -- it is automatically included by nvToolsExtBatch.h (except when NVTX_NO_IMPL is defined).
+#endif
+
+#include "nvtxExtCompat.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#if !defined(NVTX_IMPL_REVISION)
+/* The core of an earlier NVTX version 3 header was included first.  Its tools cannot handle
+*  batches, so the events are submitted one by one, as nvtxBatchReplay of this core does. */
+NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxBatchReplay)(nvtxDomainHandle_t domain, nvtxBatchEvent_t* events, size_t count)
+{
+    size_t i;
+    nvtxEventAttributes_t compact;
+    compact.version = NVTX_VERSION;
+    compact.size = NVTX_EVENT_ATTRIB_STRUCT_SIZE;
+    compact.colorType = NVTX_COLOR_UNKNOWN;
+    compact.color = 0;
+    compact.payloadType = NVTX_PAYLOAD_UNKNOWN;
+    compact.reserved0 = 0;
+    compact.payload.ullValue = 0;
+    for (i = 0; i < count; ++i)
+    {
+        nvtxBatchEvent_t* e = &events[i];
+        const nvtxEventAttributes_t* attr = e->attributes;
+        if (!attr && (e->type == NVTX_BATCH_EVENT_MARK || e->type == NVTX_BATCH_EVENT_RANGE_START || e->type == NVTX_BATCH_EVENT_RANGE_PUSH))
+        {
+            compact.category = e->category;
+            compact.messageType = e->message ? NVTX_MESSAGE_TYPE_REGISTERED : NVTX_MESSAGE_UNKNOWN;
+            compact.message.registered = e->message;
+            attr = &compact;
+        }
+        switch (e->type)
+        {
+        case NVTX_BATCH_EVENT_MARK: nvtxDomainMarkEx(domain, attr); break;
+        case NVTX_BATCH_EVENT_RANGE_START: e->rangeId = nvtxDomainRangeStartEx(domain, attr); break;
+        case NVTX_BATCH_EVENT_RANGE_END: nvtxDomainRangeEnd(domain, e->rangeId); break;
+        case NVTX_BATCH_EVENT_RANGE_PUSH: nvtxDomainRangePushEx(domain, attr); break;
+        case NVTX_BATCH_EVENT_RANGE_POP: nvtxDomainRangePop(domain); break;
+        default: break;
+        }
+    }
+}
+#endif /* !defined(NVTX_IMPL_REVISION) */
+
+NVTX_DECLSPEC void NVTX_API nvtxDomainBatchSubmit(nvtxDomainHandle_t domain, nvtxBatchEvent_t* events, size_t count)
+{
+#ifndef NVTX_DISABLE
+#if defined(NVTX_IMPL_REVISION)
+    NVTX_VERSIONED_IDENTIFIER(nvtxBatchSubmit)(domain, events, count);
+#else
+    NVTX_VERSIONED_IDENTIFIER(nvtxBatchReplay)(domain, events, count);
+#endif
+#endif /*NVTX_DISABLE*/
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
@@ -9,36 +9,62 @@
 NVTX_DECLSPEC void NVTX_API nvtxMarkEx(const nvtxEventAttributes_t* eventAttrib)
 {
 #ifndef NVTX_DISABLE
-    nvtxMarkEx_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxMarkEx_impl_fnptr;
-    if(local!=0)
-        (*local)(eventAttrib);
+    nvtxMarkEx_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxMarkEx_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED())
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxMarkEx_impl_fnptr;
+        if(local!=0)
+            (*local)(eventAttrib);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxMarkA(const char* message)
 {
 #ifndef NVTX_DISABLE
-    nvtxMarkA_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxMarkA_impl_fnptr;
-    if(local!=0)
-        (*local)(message);
+    nvtxMarkA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxMarkA_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED())
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxMarkA_impl_fnptr;
+        if(local!=0)
+            (*local)(message);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxMarkW(const wchar_t* message)
 {
 #ifndef NVTX_DISABLE
-    nvtxMarkW_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxMarkW_impl_fnptr;
-    if(local!=0)
-        (*local)(message);
+    nvtxMarkW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxMarkW_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED())
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxMarkW_impl_fnptr;
+        if(local!=0)
+            (*local)(message);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC nvtxRangeId_t NVTX_API nvtxRangeStartEx(const nvtxEventAttributes_t* eventAttrib)
 {
 #ifndef NVTX_DISABLE
-    nvtxRangeStartEx_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangeStartEx_impl_fnptr;
-    if(local!=0)
-        return (*local)(eventAttrib);
+    nvtxRangeStartEx_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangeStartEx_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED())
+    {
+        nvtxRangeId_t result = (nvtxRangeId_t)0;
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangeStartEx_impl_fnptr;
+        if(local!=0)
+            result = (*local)(eventAttrib);
+        NVTX_TOOL_CALL_END();
+        return result;
+    }
     else
 #endif  /*NVTX_DISABLE*/
         return (nvtxRangeId_t)0;
@@ -47,9 +73,17 @@ NVTX_DECLSPEC nvtxRangeId_t NVTX_API nvtxRangeStartEx(const nvtxEventAttributes_
 NVTX_DECLSPEC nvtxRangeId_t NVTX_API nvtxRangeStartA(const char* message)
 {
 #ifndef NVTX_DISABLE
-    nvtxRangeStartA_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangeStartA_impl_fnptr;
-    if(local!=0)
-        return (*local)(message);
+    nvtxRangeStartA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangeStartA_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED())
+    {
+        nvtxRangeId_t result = (nvtxRangeId_t)0;
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangeStartA_impl_fnptr;
+        if(local!=0)
+            result = (*local)(message);
+        NVTX_TOOL_CALL_END();
+        return result;
+    }
     else
 #endif  /*NVTX_DISABLE*/
         return (nvtxRangeId_t)0;
@@ -58,9 +92,17 @@ NVTX_DECLSPEC nvtxRangeId_t NVTX_API nvtxRangeStartA(const char* message)
 NVTX_DECLSPEC nvtxRangeId_t NVTX_API nvtxRangeStartW(const wchar_t* message)
 {
 #ifndef NVTX_DISABLE
-    nvtxRangeStartW_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangeStartW_impl_fnptr;
-    if(local!=0)
-        return (*local)(message);
+    nvtxRangeStartW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangeStartW_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED())
+    {
+        nvtxRangeId_t result = (nvtxRangeId_t)0;
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangeStartW_impl_fnptr;
+        if(local!=0)
+            result = (*local)(message);
+        NVTX_TOOL_CALL_END();
+        return result;
+    }
     else
 #endif  /*NVTX_DISABLE*/
         return (nvtxRangeId_t)0;
@@ -69,18 +111,35 @@ NVTX_DECLSPEC nvtxRangeId_t NVTX_API nvtxRangeStartW(const wchar_t* message)
 NVTX_DECLSPEC void NVTX_API nvtxRangeEnd(nvtxRangeId_t id)
 {
 #ifndef NVTX_DISABLE
-    nvtxRangeEnd_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangeEnd_impl_fnptr;
-    if(local!=0)
-        (*local)(id);
+    nvtxRangeEnd_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangeEnd_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED() && !NVTX_ASYNC_END_DROPPED(id))
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangeEnd_impl_fnptr;
+        if(local!=0)
+            (*local)(id);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC int NVTX_API nvtxRangePushEx(const nvtxEventAttributes_t* eventAttrib)
 {
 #ifndef NVTX_DISABLE
-    nvtxRangePushEx_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangePushEx_impl_fnptr;
-    if(local!=0)
-        return (*local)(eventAttrib);
+    nvtxRangePushEx_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangePushEx_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED())
+    {
+        int result = (int)NVTX_NO_PUSH_POP_TRACKING;
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangePushEx_impl_fnptr;
+        if(local!=0)
+        {
+            result = (*local)(eventAttrib);
+            NVTX_ASYNC_PUSH_FORWARDED(local != NVTX_VERSIONED_IDENTIFIER(nvtxRangePushEx_impl_init));
+        }
+        NVTX_TOOL_CALL_END();
+        return result;
+    }
     else
 #endif  /*NVTX_DISABLE*/
         return (int)NVTX_NO_PUSH_POP_TRACKING;
@@ -89,9 +148,20 @@ NVTX_DECLSPEC int NVTX_API nvtxRangePushEx(const nvtxEventAttributes_t* eventAtt
 NVTX_DECLSPEC int NVTX_API nvtxRangePushA(const char* message)
 {
 #ifndef NVTX_DISABLE
-    nvtxRangePushA_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangePushA_impl_fnptr;
-    if(local!=0)
-        return (*local)(message);
+    nvtxRangePushA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangePushA_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED())
+    {
+        int result = (int)NVTX_NO_PUSH_POP_TRACKING;
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangePushA_impl_fnptr;
+        if(local!=0)
+        {
+            result = (*local)(message);
+            NVTX_ASYNC_PUSH_FORWARDED(local != NVTX_VERSIONED_IDENTIFIER(nvtxRangePushA_impl_init));
+        }
+        NVTX_TOOL_CALL_END();
+        return result;
+    }
     else
 #endif  /*NVTX_DISABLE*/
         return (int)NVTX_NO_PUSH_POP_TRACKING;
@@ -100,9 +170,20 @@ NVTX_DECLSPEC int NVTX_API nvtxRangePushA(const char* message)
 NVTX_DECLSPEC int NVTX_API nvtxRangePushW(const wchar_t* message)
 {
 #ifndef NVTX_DISABLE
-    nvtxRangePushW_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangePushW_impl_fnptr;
-    if(local!=0)
-        return (*local)(message);
+    nvtxRangePushW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangePushW_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED())
+    {
+        int result = (int)NVTX_NO_PUSH_POP_TRACKING;
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangePushW_impl_fnptr;
+        if(local!=0)
+        {
+            result = (*local)(message);
+            NVTX_ASYNC_PUSH_FORWARDED(local != NVTX_VERSIONED_IDENTIFIER(nvtxRangePushW_impl_init));
+        }
+        NVTX_TOOL_CALL_END();
+        return result;
+    }
     else
 #endif  /*NVTX_DISABLE*/
         return (int)NVTX_NO_PUSH_POP_TRACKING;
@@ -111,9 +192,17 @@ NVTX_DECLSPEC int NVTX_API nvtxRangePushW(const wchar_t* message)
 NVTX_DECLSPEC int NVTX_API nvtxRangePop(void)
 {
 #ifndef NVTX_DISABLE
-    nvtxRangePop_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangePop_impl_fnptr;
-    if(local!=0)
-        return (*local)();
+    nvtxRangePop_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangePop_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED() && !NVTX_ASYNC_POP_DROPPED())
+    {
+        int result = (int)NVTX_NO_PUSH_POP_TRACKING;
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxRangePop_impl_fnptr;
+        if(local!=0)
+            result = (*local)();
+        NVTX_TOOL_CALL_END();
+        return result;
+    }
     else
 #endif  /*NVTX_DISABLE*/
         return (int)NVTX_NO_PUSH_POP_TRACKING;
@@ -122,55 +211,104 @@ NVTX_DECLSPEC int NVTX_API nvtxRangePop(void)
 NVTX_DECLSPEC void NVTX_API nvtxNameCategoryA(uint32_t category, const char* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameCategoryA_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCategoryA_impl_fnptr;
+    nvtxNameCategoryA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCategoryA_impl_fnptr : 0;
     if(local!=0)
-        (*local)(category, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCategoryA_impl_fnptr;
+        if(local!=0)
+            (*local)(category, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameCategoryW(uint32_t category, const wchar_t* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameCategoryW_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCategoryW_impl_fnptr;
+    nvtxNameCategoryW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCategoryW_impl_fnptr : 0;
     if(local!=0)
-        (*local)(category, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCategoryW_impl_fnptr;
+        if(local!=0)
+            (*local)(category, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameOsThreadA(uint32_t threadId, const char* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameOsThreadA_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameOsThreadA_impl_fnptr;
+    nvtxNameOsThreadA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameOsThreadA_impl_fnptr : 0;
     if(local!=0)
-        (*local)(threadId, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameOsThreadA_impl_fnptr;
+        if(local!=0)
+            (*local)(threadId, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameOsThreadW(uint32_t threadId, const wchar_t* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameOsThreadW_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameOsThreadW_impl_fnptr;
+    nvtxNameOsThreadW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameOsThreadW_impl_fnptr : 0;
     if(local!=0)
-        (*local)(threadId, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameOsThreadW_impl_fnptr;
+        if(local!=0)
+            (*local)(threadId, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxDomainMarkEx(nvtxDomainHandle_t domain, const nvtxEventAttributes_t* eventAttrib)
 {
 #ifndef NVTX_DISABLE
-    nvtxDomainMarkEx_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainMarkEx_impl_fnptr;
-    if(local!=0)
-        (*local)(domain, eventAttrib);
+#ifdef NVTX_DIRECT_TOOL
+    if (NVTX_DIRECT_TOOL_READY() && !NVTX_EVENTS_PAUSED())
+        nvtxDirectToolDomainMarkEx(domain, eventAttrib);
+#else
+    nvtxDomainMarkEx_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainMarkEx_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED())
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainMarkEx_impl_fnptr;
+        if(local!=0)
+            (*local)(domain, eventAttrib);
+        NVTX_TOOL_CALL_END();
+    }
+#endif /*NVTX_DIRECT_TOOL*/
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC nvtxRangeId_t NVTX_API nvtxDomainRangeStartEx(nvtxDomainHandle_t domain, const nvtxEventAttributes_t* eventAttrib)
 {
 #ifndef NVTX_DISABLE
-    nvtxDomainRangeStartEx_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangeStartEx_impl_fnptr;
-    if(local!=0)
-        return (*local)(domain, eventAttrib);
+#ifdef NVTX_DIRECT_TOOL
+    if ((NVTX_DIRECT_TOOL_READY() || NVTX_ASYNC_START_DROPPED()) && !NVTX_EVENTS_PAUSED())
+        return nvtxDirectToolDomainRangeStartEx(domain, eventAttrib);
+    else
+#else
+    nvtxDomainRangeStartEx_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangeStartEx_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED())
+    {
+        nvtxRangeId_t result = (nvtxRangeId_t)0;
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangeStartEx_impl_fnptr;
+        if(local!=0)
+            result = (*local)(domain, eventAttrib);
+        NVTX_TOOL_CALL_END();
+        return result;
+    }
     else
+#endif /*NVTX_DIRECT_TOOL*/
 #endif  /*NVTX_DISABLE*/
         return (nvtxRangeId_t)0;
 }
@@ -178,19 +316,50 @@ NVTX_DECLSPEC nvtxRangeId_t NVTX_API nvtxDomainRangeStartEx(nvtxDomainHandle_t d
 NVTX_DECLSPEC void NVTX_API nvtxDomainRangeEnd(nvtxDomainHandle_t domain, nvtxRangeId_t id)
 {
 #ifndef NVTX_DISABLE
-    nvtxDomainRangeEnd_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangeEnd_impl_fnptr;
-    if(local!=0)
-        (*local)(domain, id);
+#ifdef NVTX_DIRECT_TOOL
+    if (NVTX_DIRECT_TOOL_READY() && !NVTX_EVENTS_PAUSED() && !NVTX_ASYNC_END_DROPPED(id))
+        nvtxDirectToolDomainRangeEnd(domain, id);
+#else
+    nvtxDomainRangeEnd_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangeEnd_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED() && !NVTX_ASYNC_END_DROPPED(id))
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangeEnd_impl_fnptr;
+        if(local!=0)
+            (*local)(domain, id);
+        NVTX_TOOL_CALL_END();
+    }
+#endif /*NVTX_DIRECT_TOOL*/
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC int NVTX_API nvtxDomainRangePushEx(nvtxDomainHandle_t domain, const nvtxEventAttributes_t* eventAttrib)
 {
 #ifndef NVTX_DISABLE
-    nvtxDomainRangePushEx_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangePushEx_impl_fnptr;
-    if(local!=0)
-        return (*local)(domain, eventAttrib);
+#ifdef NVTX_DIRECT_TOOL
+    if ((NVTX_DIRECT_TOOL_READY() || NVTX_ASYNC_PUSH_DROPPED()) && !NVTX_EVENTS_PAUSED())
+    {
+        NVTX_ASYNC_PUSH_FORWARDED(1);
+        return nvtxDirectToolDomainRangePushEx(domain, eventAttrib);
+    }
+    else
+#else
+    nvtxDomainRangePushEx_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangePushEx_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED())
+    {
+        int result = (int)NVTX_NO_PUSH_POP_TRACKING;
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangePushEx_impl_fnptr;
+        if(local!=0)
+        {
+            result = (*local)(domain, eventAttrib);
+            NVTX_ASYNC_PUSH_FORWARDED(local != NVTX_VERSIONED_IDENTIFIER(nvtxDomainRangePushEx_impl_init));
+        }
+        NVTX_TOOL_CALL_END();
+        return result;
+    }
     else
+#endif /*NVTX_DIRECT_TOOL*/
 #endif  /*NVTX_DISABLE*/
         return (int)NVTX_NO_PUSH_POP_TRACKING;
 }
@@ -198,10 +367,24 @@ NVTX_DECLSPEC int NVTX_API nvtxDomainRangePushEx(nvtxDomainHandle_t domain, cons
 NVTX_DECLSPEC int NVTX_API nvtxDomainRangePop(nvtxDomainHandle_t domain)
 {
 #ifndef NVTX_DISABLE
-    nvtxDomainRangePop_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangePop_impl_fnptr;
-    if(local!=0)
-        return (*local)(domain);
+#ifdef NVTX_DIRECT_TOOL
+    if (!NVTX_EVENTS_PAUSED() && !NVTX_ASYNC_POP_DROPPED() && NVTX_DIRECT_TOOL_READY())
+        return nvtxDirectToolDomainRangePop(domain);
+    else
+#else
+    nvtxDomainRangePop_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangePop_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED() && !NVTX_ASYNC_POP_DROPPED())
+    {
+        int result = (int)NVTX_NO_PUSH_POP_TRACKING;
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangePop_impl_fnptr;
+        if(local!=0)
+            result = (*local)(domain);
+        NVTX_TOOL_CALL_END();
+        return result;
+    }
     else
+#endif /*NVTX_DIRECT_TOOL*/
 #endif  /*NVTX_DISABLE*/
         return (int)NVTX_NO_PUSH_POP_TRACKING;
 }
@@ -209,9 +392,17 @@ NVTX_DECLSPEC int NVTX_API nvtxDomainRangePop(nvtxDomainHandle_t domain)
 NVTX_DECLSPEC nvtxResourceHandle_t NVTX_API nvtxDomainResourceCreate(nvtxDomainHandle_t domain, nvtxResourceAttributes_t* attribs)
 {
 #ifndef NVTX_DISABLE
-    nvtxDomainResourceCreate_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainResourceCreate_impl_fnptr;
+    nvtxDomainResourceCreate_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainResourceCreate_impl_fnptr : 0;
     if(local!=0)
-        return (*local)(domain, attribs);
+    {
+        nvtxResourceHandle_t result = (nvtxResourceHandle_t)0;
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainResourceCreate_impl_fnptr;
+        if(local!=0)
+            result = (*local)(domain, attribs);
+        NVTX_TOOL_CALL_END();
+        return result;
+    }
     else
 #endif  /*NVTX_DISABLE*/
         return (nvtxResourceHandle_t)0;
@@ -220,36 +411,62 @@ NVTX_DECLSPEC nvtxResourceHandle_t NVTX_API nvtxDomainResourceCreate(nvtxDomainH
 NVTX_DECLSPEC void NVTX_API nvtxDomainResourceDestroy(nvtxResourceHandle_t resource)
 {
 #ifndef NVTX_DISABLE
-    nvtxDomainResourceDestroy_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainResourceDestroy_impl_fnptr;
+    nvtxDomainResourceDestroy_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainResourceDestroy_impl_fnptr : 0;
     if(local!=0)
-        (*local)(resource);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainResourceDestroy_impl_fnptr;
+        if(local!=0)
+            (*local)(resource);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxDomainNameCategoryA(nvtxDomainHandle_t domain, uint32_t category, const char* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxDomainNameCategoryA_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainNameCategoryA_impl_fnptr;
+    nvtxDomainNameCategoryA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainNameCategoryA_impl_fnptr : 0;
     if(local!=0)
-        (*local)(domain, category, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainNameCategoryA_impl_fnptr;
+        if(local!=0)
+            (*local)(domain, category, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxDomainNameCategoryW(nvtxDomainHandle_t domain, uint32_t category, const wchar_t* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxDomainNameCategoryW_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainNameCategoryW_impl_fnptr;
+    nvtxDomainNameCategoryW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainNameCategoryW_impl_fnptr : 0;
     if(local!=0)
-        (*local)(domain, category, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainNameCategoryW_impl_fnptr;
+        if(local!=0)
+            (*local)(domain, category, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC nvtxStringHandle_t NVTX_API nvtxDomainRegisterStringA(nvtxDomainHandle_t domain, const char* string)
 {
 #ifndef NVTX_DISABLE
-    nvtxDomainRegisterStringA_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRegisterStringA_impl_fnptr;
+    nvtxDomainRegisterStringA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRegisterStringA_impl_fnptr : 0;
     if(local!=0)
-        return (*local)(domain, string);
+    {
+        nvtxStringHandle_t result = (nvtxStringHandle_t)0;
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRegisterStringA_impl_fnptr;
+        if(local!=0)
+            result = (*local)(domain, string);
+        NVTX_TOOL_CALL_END();
+        return result;
+    }
     else
 #endif  /*NVTX_DISABLE*/
         return (nvtxStringHandle_t)0;
@@ -258,9 +475,17 @@ NVTX_DECLSPEC nvtxStringHandle_t NVTX_API nvtxDomainRegisterStringA(nvtxDomainHa
 NVTX_DECLSPEC nvtxStringHandle_t NVTX_API nvtxDomainRegisterStringW(nvtxDomainHandle_t domain, const wchar_t* string)
 {
 #ifndef NVTX_DISABLE
-    nvtxDomainRegisterStringW_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRegisterStringW_impl_fnptr;
+    nvtxDomainRegisterStringW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRegisterStringW_impl_fnptr : 0;
     if(local!=0)
-        return (*local)(domain, string);
+    {
+        nvtxStringHandle_t result = (nvtxStringHandle_t)0;
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRegisterStringW_impl_fnptr;
+        if(local!=0)
+            result = (*local)(domain, string);
+        NVTX_TOOL_CALL_END();
+        return result;
+    }
     else
 #endif  /*NVTX_DISABLE*/
         return (nvtxStringHandle_t)0;
@@ -269,9 +494,17 @@ NVTX_DECLSPEC nvtxStringHandle_t NVTX_API nvtxDomainRegisterStringW(nvtxDomainHa
 NVTX_DECLSPEC nvtxDomainHandle_t NVTX_API nvtxDomainCreateA(const char* message)
 {
 #ifndef NVTX_DISABLE
-    nvtxDomainCreateA_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainCreateA_impl_fnptr;
+    nvtxDomainCreateA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainCreateA_impl_fnptr : 0;
     if(local!=0)
-        return (*local)(message);
+    {
+        nvtxDomainHandle_t result = (nvtxDomainHandle_t)0;
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainCreateA_impl_fnptr;
+        if(local!=0)
+            result = (*local)(message);
+        NVTX_TOOL_CALL_END();
+        return result;
+    }
     else
 #endif  /*NVTX_DISABLE*/
         return (nvtxDomainHandle_t)0;
@@ -280,9 +513,17 @@ NVTX_DECLSPEC nvtxDomainHandle_t NVTX_API nvtxDomainCreateA(const char* message)
 NVTX_DECLSPEC nvtxDomainHandle_t NVTX_API nvtxDomainCreateW(const wchar_t* message)
 {
 #ifndef NVTX_DISABLE
-    nvtxDomainCreateW_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainCreateW_impl_fnptr;
+    nvtxDomainCreateW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainCreateW_impl_fnptr : 0;
     if(local!=0)
-        return (*local)(message);
+    {
+        nvtxDomainHandle_t result = (nvtxDomainHandle_t)0;
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainCreateW_impl_fnptr;
+        if(local!=0)
+            result = (*local)(message);
+        NVTX_TOOL_CALL_END();
+        return result;
+    }
     else
 #endif  /*NVTX_DISABLE*/
         return (nvtxDomainHandle_t)0;
@@ -291,17 +532,369 @@ NVTX_DECLSPEC nvtxDomainHandle_t NVTX_API nvtxDomainCreateW(const wchar_t* messa
 NVTX_DECLSPEC void NVTX_API nvtxDomainDestroy(nvtxDomainHandle_t domain)
 {
 #ifndef NVTX_DISABLE
-    nvtxDomainDestroy_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainDestroy_impl_fnptr;
+    nvtxDomainDestroy_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainDestroy_impl_fnptr : 0;
     if(local!=0)
-        (*local)(domain);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainDestroy_impl_fnptr;
+        if(local!=0)
+            (*local)(domain);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxInitialize(const void* reserved)
 {
 #ifndef NVTX_DISABLE
-    nvtxInitialize_impl_fntype local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxInitialize_impl_fnptr;
+    nvtxInitialize_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxInitialize_impl_fnptr : 0;
+    if(local!=0)
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxInitialize_impl_fnptr;
+        if(local!=0)
+            (*local)(reserved);
+        NVTX_TOOL_CALL_END();
+    }
+#endif /*NVTX_DISABLE*/
+}
+
+NVTX_DECLSPEC int NVTX_API nvtxAttachInjectionLibraryA(const char* path)
+{
+#ifndef NVTX_DISABLE
+    return NVTX_VERSIONED_IDENTIFIER(nvtxAttachInjectionLibrary)(path);
+#else
+    (void)path;
+    return NVTX_FAIL;
+#endif /*NVTX_DISABLE*/
+}
+
+NVTX_DECLSPEC int NVTX_API nvtxDetachInjectionLibrary(void)
+{
+#ifndef NVTX_DISABLE
+    return NVTX_VERSIONED_IDENTIFIER(nvtxDetachInjectionLibrary)();
+#else
+    return NVTX_FAIL;
+#endif /*NVTX_DISABLE*/
+}
+
+NVTX_DECLSPEC uint32_t NVTX_API nvtxGetAttachGeneration(void)
+{
+#ifndef NVTX_DISABLE
+    return NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).attachGeneration;
+#else
+    return 0;
+#endif /*NVTX_DISABLE*/
+}
+
+NVTX_DECLSPEC int NVTX_API nvtxIsEnabled(void)
+{
+#ifndef NVTX_DISABLE
+#ifdef NVTX_DIRECT_TOOL
+    /* Initialization completes even when the tool's InitializeInjectionNvtx2 fails */
+    return NVTX_DIRECT_TOOL_READY() && NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).injectionAttached != 0 && !NVTX_EVENTS_PAUSED();
+#else
+    if (!NVTX_STATIC_KEY_ENABLED())
+        return 0;
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).initState != NVTX_INIT_STATE_COMPLETE && !NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+        return 0;
+    return NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).injectionAttached != 0 && !NVTX_EVENTS_PAUSED();
+#endif /*NVTX_DIRECT_TOOL*/
+#else
+    return 0;
+#endif /*NVTX_DISABLE*/
+}
+
+NVTX_DECLSPEC int NVTX_API nvtxPause(void)
+{
+#ifndef NVTX_DISABLE
+    NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).paused = 1;
+    return NVTX_SUCCESS;
+#else
+    return NVTX_FAIL;
+#endif /*NVTX_DISABLE*/
+}
+
+NVTX_DECLSPEC int NVTX_API nvtxResume(void)
+{
+#ifndef NVTX_DISABLE
+    NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).paused = 0;
+    return NVTX_SUCCESS;
+#else
+    return NVTX_FAIL;
+#endif /*NVTX_DISABLE*/
+}
+
+NVTX_DECLSPEC int NVTX_API nvtxPauseThread(void)
+{
+#if !defined(NVTX_DISABLE) && defined(NVTX_THREAD_LOCAL)
+    NVTX_VERSIONED_IDENTIFIER(nvtxThreadPaused) = 1;
+    NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).threadsPaused = 1;
+    return NVTX_SUCCESS;
+#else
+    return NVTX_FAIL;
+#endif
+}
+
+NVTX_DECLSPEC int NVTX_API nvtxResumeThread(void)
+{
+#if !defined(NVTX_DISABLE) && defined(NVTX_THREAD_LOCAL)
+    NVTX_VERSIONED_IDENTIFIER(nvtxThreadPaused) = 0;
+    return NVTX_SUCCESS;
+#else
+    return NVTX_FAIL;
+#endif
+}
+
+NVTX_DECLSPEC int NVTX_API nvtxDomainIsEnabled(nvtxDomainHandle_t domain)
+{
+#ifndef NVTX_DISABLE
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).domainFlags && domain)
+    {
+        /* The handle is the tool's memory: count the read like a call into the tool, so
+        *  detaching waits for it, and test domainFlags again once counted */
+        int enabled;
+        NVTX_TOOL_CALL_BEGIN(domain);
+        enabled = !NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).domainFlags
+            || !((const nvtxDomainFlags_t*)(const void*)domain)->disabled;
+        NVTX_TOOL_CALL_END();
+        return enabled;
+    }
+    return 1;
+#else
+    (void)domain;
+    return 0;
+#endif /*NVTX_DISABLE*/
+}
+
+NVTX_DECLSPEC uint64_t NVTX_API nvtxGetTimestamp(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return (uint64_t)(count.QuadPart / frequency.QuadPart) * 1000000000ull
+        + (uint64_t)(count.QuadPart % frequency.QuadPart) * 1000000000ull / (uint64_t)frequency.QuadPart;
+#elif NVTX_MONOTONIC_CLOCK_SUPPORTED
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#else
+    return 0; /* Events take it as the time of their submission */
+#endif
+}
+
+/* Submits a batch event by event through the domain functions, for tools without a handler for
+*  nvtxDomainBatchSubmit.  The tool timestamps the events at the time of this call. */
+NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxBatchReplay)(nvtxDomainHandle_t domain, nvtxBatchEvent_t* events, size_t count)
+{
+    size_t i;
+    nvtxEventAttributes_t compact;
+    compact.version = NVTX_VERSION;
+    compact.size = NVTX_EVENT_ATTRIB_STRUCT_SIZE;
+    compact.colorType = NVTX_COLOR_UNKNOWN;
+    compact.color = 0;
+    compact.payloadType = NVTX_PAYLOAD_UNKNOWN;
+    compact.reserved0 = 0;
+    compact.payload.ullValue = 0;
+    for (i = 0; i < count; ++i)
+    {
+        nvtxBatchEvent_t* e = &events[i];
+        const nvtxEventAttributes_t* attr = e->attributes;
+        if (!attr && (e->type == NVTX_BATCH_EVENT_MARK || e->type == NVTX_BATCH_EVENT_RANGE_START || e->type == NVTX_BATCH_EVENT_RANGE_PUSH))
+        {
+            compact.category = e->category;
+            compact.messageType = e->message ? NVTX_MESSAGE_TYPE_REGISTERED : NVTX_MESSAGE_UNKNOWN;
+            compact.message.registered = e->message;
+            attr = &compact;
+        }
+        switch (e->type)
+        {
+        case NVTX_BATCH_EVENT_MARK: nvtxDomainMarkEx(domain, attr); break;
+        case NVTX_BATCH_EVENT_RANGE_START: e->rangeId = nvtxDomainRangeStartEx(domain, attr); break;
+        case NVTX_BATCH_EVENT_RANGE_END: nvtxDomainRangeEnd(domain, e->rangeId); break;
+        case NVTX_BATCH_EVENT_RANGE_PUSH: nvtxDomainRangePushEx(domain, attr); break;
+        case NVTX_BATCH_EVENT_RANGE_POP: nvtxDomainRangePop(domain); break;
+        default: break;
+        }
+    }
+}
+
+/* Body of nvtxDomainBatchSubmit, also used by the timestamped event functions */
+NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxBatchSubmit)(nvtxDomainHandle_t domain, nvtxBatchEvent_t* events, size_t count)
+{
+    nvtxDomainBatchSubmit_impl_fntype local;
+    if (!NVTX_STATIC_KEY_ENABLED() || NVTX_EVENTS_PAUSED())
+        return;
+    local = (nvtxDomainBatchSubmit_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainBatchSubmit_impl_fnptr;
+    if(local!=0)
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxDomainBatchSubmit_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainBatchSubmit_impl_fnptr;
+        if(local!=0)
+            (*local)(domain, events, count);
+        NVTX_TOOL_CALL_END();
+    }
+    else /* The tool does not handle batches */
+        NVTX_VERSIONED_IDENTIFIER(nvtxBatchReplay)(domain, events, count);
+}
+
+/* Submits a single event batch, returning the event's range id */
+NVTX_LINKONCE_DEFINE_FUNCTION nvtxRangeId_t NVTX_VERSIONED_IDENTIFIER(nvtxBatchSubmitAt)(nvtxDomainHandle_t domain, uint32_t type, const nvtxEventAttributes_t* eventAttrib, nvtxRangeId_t id, uint64_t timestamp)
+{
+    nvtxBatchEvent_t event;
+    event.timestamp = timestamp;
+    event.attributes = eventAttrib;
+    event.message = NULL;
+    event.rangeId = id;
+    event.type = type;
+    event.category = 0;
+    NVTX_VERSIONED_IDENTIFIER(nvtxBatchSubmit)(domain, &event, 1);
+    return event.rangeId;
+}
+
+NVTX_DECLSPEC void NVTX_API nvtxDomainMarkExAt(nvtxDomainHandle_t domain, const nvtxEventAttributes_t* eventAttrib, uint64_t timestamp)
+{
+#ifndef NVTX_DISABLE
+    NVTX_VERSIONED_IDENTIFIER(nvtxBatchSubmitAt)(domain, NVTX_BATCH_EVENT_MARK, eventAttrib, 0, timestamp);
+#endif /*NVTX_DISABLE*/
+}
+
+NVTX_DECLSPEC nvtxRangeId_t NVTX_API nvtxDomainRangeStartExAt(nvtxDomainHandle_t domain, const nvtxEventAttributes_t* eventAttrib, uint64_t timestamp)
+{
+#ifndef NVTX_DISABLE
+    return NVTX_VERSIONED_IDENTIFIER(nvtxBatchSubmitAt)(domain, NVTX_BATCH_EVENT_RANGE_START, eventAttrib, 0, timestamp);
+#else
+    return (nvtxRangeId_t)0;
+#endif /*NVTX_DISABLE*/
+}
+
+NVTX_DECLSPEC void NVTX_API nvtxDomainRangeEndAt(nvtxDomainHandle_t domain, nvtxRangeId_t id, uint64_t timestamp)
+{
+#ifndef NVTX_DISABLE
+    NVTX_VERSIONED_IDENTIFIER(nvtxBatchSubmitAt)(domain, NVTX_BATCH_EVENT_RANGE_END, NULL, id, timestamp);
+#endif /*NVTX_DISABLE*/
+}
+
+NVTX_DECLSPEC void NVTX_API nvtxDomainRangePushExAt(nvtxDomainHandle_t domain, const nvtxEventAttributes_t* eventAttrib, uint64_t timestamp)
+{
+#ifndef NVTX_DISABLE
+    NVTX_VERSIONED_IDENTIFIER(nvtxBatchSubmitAt)(domain, NVTX_BATCH_EVENT_RANGE_PUSH, eventAttrib, 0, timestamp);
+#endif /*NVTX_DISABLE*/
+}
+
+NVTX_DECLSPEC void NVTX_API nvtxDomainRangePopAt(nvtxDomainHandle_t domain, uint64_t timestamp)
+{
+#ifndef NVTX_DISABLE
+    NVTX_VERSIONED_IDENTIFIER(nvtxBatchSubmitAt)(domain, NVTX_BATCH_EVENT_RANGE_POP, NULL, 0, timestamp);
+#endif /*NVTX_DISABLE*/
+}
+
+/* Attributes of a compact event, for tools without a handler for the compact functions */
+NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxCompactAttributes)(nvtxEventAttributes_t* eventAttrib, nvtxStringHandle_t message, uint32_t category, int32_t payloadType, uint64_t payload)
+{
+    eventAttrib->version = NVTX_VERSION;
+    eventAttrib->size = NVTX_EVENT_ATTRIB_STRUCT_SIZE;
+    eventAttrib->category = category;
+    eventAttrib->colorType = NVTX_COLOR_UNKNOWN;
+    eventAttrib->color = 0;
+    eventAttrib->payloadType = payloadType;
+    eventAttrib->reserved0 = 0;
+    switch (payloadType)
+    {
+    case NVTX_PAYLOAD_TYPE_UNSIGNED_INT32:
+    case NVTX_PAYLOAD_TYPE_INT32:
+    case NVTX_PAYLOAD_TYPE_FLOAT:
+        eventAttrib->payload.ullValue = 0;
+        eventAttrib->payload.uiValue = (uint32_t)payload;
+        break;
+    default:
+        eventAttrib->payload.ullValue = payload;
+        break;
+    }
+    eventAttrib->messageType = message ? NVTX_MESSAGE_TYPE_REGISTERED : NVTX_MESSAGE_UNKNOWN;
+    eventAttrib->message.registered = message;
+}
+
+NVTX_DECLSPEC void NVTX_API nvtxDomainMarkCompact(nvtxDomainHandle_t domain, nvtxStringHandle_t message, uint32_t category, int32_t payloadType, uint64_t payload)
+{
+#ifndef NVTX_DISABLE
+    nvtxDomainMarkCompact_impl_fntype local;
+    nvtxEventAttributes_t eventAttrib;
+    if (!NVTX_STATIC_KEY_ENABLED() || NVTX_EVENTS_PAUSED())
+        return;
+    local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainMarkCompact_impl_fnptr;
+    if(local!=0)
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainMarkCompact_impl_fnptr;
+        if(local!=0)
+            (*local)(domain, message, category, payloadType, payload);
+        NVTX_TOOL_CALL_END();
+    }
+    else if (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainMarkEx_impl_fnptr != 0) /* The tool does not handle compact events */
+    {
+        NVTX_VERSIONED_IDENTIFIER(nvtxCompactAttributes)(&eventAttrib, message, category, payloadType, payload);
+        nvtxDomainMarkEx(domain, &eventAttrib);
+    }
+#endif /*NVTX_DISABLE*/
+}
+
+NVTX_DECLSPEC nvtxRangeId_t NVTX_API nvtxDomainRangeStartCompact(nvtxDomainHandle_t domain, nvtxStringHandle_t message, uint32_t category, int32_t payloadType, uint64_t payload)
+{
+#ifndef NVTX_DISABLE
+    nvtxDomainRangeStartCompact_impl_fntype local;
+    nvtxEventAttributes_t eventAttrib;
+    nvtxRangeId_t result = (nvtxRangeId_t)0;
+    if (!NVTX_STATIC_KEY_ENABLED() || NVTX_EVENTS_PAUSED())
+        return result;
+    local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangeStartCompact_impl_fnptr;
+    if(local!=0)
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangeStartCompact_impl_fnptr;
+        if(local!=0)
+            result = (*local)(domain, message, category, payloadType, payload);
+        NVTX_TOOL_CALL_END();
+    }
+    else if (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangeStartEx_impl_fnptr != 0) /* The tool does not handle compact events */
+    {
+        NVTX_VERSIONED_IDENTIFIER(nvtxCompactAttributes)(&eventAttrib, message, category, payloadType, payload);
+        result = nvtxDomainRangeStartEx(domain, &eventAttrib);
+    }
+    return result;
+#else
+    return (nvtxRangeId_t)0;
+#endif /*NVTX_DISABLE*/
+}
+
+NVTX_DECLSPEC int NVTX_API nvtxDomainRangePushCompact(nvtxDomainHandle_t domain, nvtxStringHandle_t message, uint32_t category, int32_t payloadType, uint64_t payload)
+{
+#ifndef NVTX_DISABLE
+    nvtxDomainRangePushCompact_impl_fntype local;
+    nvtxEventAttributes_t eventAttrib;
+    int result = (int)NVTX_NO_PUSH_POP_TRACKING;
+    if (!NVTX_STATIC_KEY_ENABLED() || NVTX_EVENTS_PAUSED())
+        return result;
+    local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangePushCompact_impl_fnptr;
     if(local!=0)
-        (*local)(reserved);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangePushCompact_impl_fnptr;
+        if(local!=0)
+        {
+            result = (*local)(domain, message, category, payloadType, payload);
+            NVTX_ASYNC_PUSH_FORWARDED(local != NVTX_VERSIONED_IDENTIFIER(nvtxDomainRangePushCompact_impl_init));
+        }
+        NVTX_TOOL_CALL_END();
+    }
+    else if (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangePushEx_impl_fnptr != 0) /* The tool does not handle compact events */
+    {
+        NVTX_VERSIONED_IDENTIFIER(nvtxCompactAttributes)(&eventAttrib, message, category, payloadType, payload);
+        result = nvtxDomainRangePushEx(domain, &eventAttrib);
+    }
+    return result;
+#else
+    return (int)NVTX_NO_PUSH_POP_TRACKING;
 #endif /*NVTX_DISABLE*/
 }
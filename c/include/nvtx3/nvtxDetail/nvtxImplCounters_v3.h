@@ -0,0 +1,89 @@
+/*
+* Copyright 2009-2022  NVIDIA Corporation.  All rights reserved.
+*
+* Licensed under the Apache License v2.0 with LLVM Exceptions.
+* See https://llvm.org/LICENSE.txt for license information.
+* SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+*/
+
+#ifndef NVTX_IMPL_GUARD_COUNTERS
+#error Never include this file directly -- it is automatically included by nvToolsExtCounters.h (except when NVTX_NO_IMPL is defined).
+#endif
+
+#include "nvtxExtCompat.h"
+
+/* The core of an earlier NVTX version 3 header has no slots for counters.  When it was included
+*  first, counters behave as with NVTX_DISABLE. */
+#if !defined(NVTX_DISABLE) && defined(NVTX_IMPL_REVISION)
+#define NVTX_COUNTERS_ENABLED
+#endif
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+NVTX_DECLSPEC nvtxCounterHandle_t NVTX_API nvtxDomainCounterRegisterA(nvtxDomainHandle_t domain, const char* name, const char* unit)
+{
+#ifdef NVTX_COUNTERS_ENABLED
+    nvtxDomainCounterRegisterA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxDomainCounterRegisterA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainCounterRegisterA_impl_fnptr : 0;
+    if(local!=0)
+    {
+        nvtxCounterHandle_t result = (nvtxCounterHandle_t)0;
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxDomainCounterRegisterA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainCounterRegisterA_impl_fnptr;
+        if(local!=0)
+            result = (*local)(domain, name, unit);
+        NVTX_TOOL_CALL_END();
+        return result;
+    }
+    else
+#else
+    (void)domain;
+    (void)name;
+    (void)unit;
+#endif /*NVTX_COUNTERS_ENABLED*/
+        return (nvtxCounterHandle_t)0;
+}
+
+NVTX_DECLSPEC void NVTX_API nvtxCounterSampleInt64(nvtxCounterHandle_t counter, int64_t value)
+{
+#ifdef NVTX_COUNTERS_ENABLED
+    nvtxCounterSampleInt64_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxCounterSampleInt64_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxCounterSampleInt64_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED())
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxCounterSampleInt64_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxCounterSampleInt64_impl_fnptr;
+        if(local!=0)
+            (*local)(counter, value);
+        NVTX_TOOL_CALL_END();
+    }
+#else
+    (void)counter;
+    (void)value;
+#endif /*NVTX_COUNTERS_ENABLED*/
+}
+
+NVTX_DECLSPEC void NVTX_API nvtxCounterSampleDouble(nvtxCounterHandle_t counter, double value)
+{
+#ifdef NVTX_COUNTERS_ENABLED
+    nvtxCounterSampleDouble_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxCounterSampleDouble_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxCounterSampleDouble_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED())
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxCounterSampleDouble_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxCounterSampleDouble_impl_fnptr;
+        if(local!=0)
+            (*local)(counter, value);
+        NVTX_TOOL_CALL_END();
+    }
+#else
+    (void)counter;
+    (void)value;
+#endif /*NVTX_COUNTERS_ENABLED*/
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#undef NVTX_COUNTERS_ENABLED
@@ -10,6 +10,8 @@
 #error Never include this file directly -- it is automatically included by nvToolsExtCudaRt.h (except when NVTX_NO_IMPL is defined).
 #endif
 
+#include "nvtxExtCompat.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -24,54 +26,90 @@ typedef void (NVTX_API * nvtxNameCudaEventW_impl_fntype)(cudaEvent_t event, cons
 NVTX_DECLSPEC void NVTX_API nvtxNameCudaDeviceA(int device, const char* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameCudaDeviceA_impl_fntype local = (nvtxNameCudaDeviceA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCudaDeviceA_impl_fnptr;
+    nvtxNameCudaDeviceA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameCudaDeviceA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCudaDeviceA_impl_fnptr : 0;
     if(local!=0)
-        (*local)(device, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameCudaDeviceA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCudaDeviceA_impl_fnptr;
+        if(local!=0)
+            (*local)(device, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameCudaDeviceW(int device, const wchar_t* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameCudaDeviceW_impl_fntype local = (nvtxNameCudaDeviceW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCudaDeviceW_impl_fnptr;
+    nvtxNameCudaDeviceW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameCudaDeviceW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCudaDeviceW_impl_fnptr : 0;
     if(local!=0)
-        (*local)(device, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameCudaDeviceW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCudaDeviceW_impl_fnptr;
+        if(local!=0)
+            (*local)(device, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameCudaStreamA(cudaStream_t stream, const char* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameCudaStreamA_impl_fntype local = (nvtxNameCudaStreamA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCudaStreamA_impl_fnptr;
+    nvtxNameCudaStreamA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameCudaStreamA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCudaStreamA_impl_fnptr : 0;
     if(local!=0)
-        (*local)(stream, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameCudaStreamA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCudaStreamA_impl_fnptr;
+        if(local!=0)
+            (*local)(stream, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameCudaStreamW(cudaStream_t stream, const wchar_t* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameCudaStreamW_impl_fntype local = (nvtxNameCudaStreamW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCudaStreamW_impl_fnptr;
+    nvtxNameCudaStreamW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameCudaStreamW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCudaStreamW_impl_fnptr : 0;
     if(local!=0)
-        (*local)(stream, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameCudaStreamW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCudaStreamW_impl_fnptr;
+        if(local!=0)
+            (*local)(stream, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameCudaEventA(cudaEvent_t event, const char* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameCudaEventA_impl_fntype local = (nvtxNameCudaEventA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCudaEventA_impl_fnptr;
+    nvtxNameCudaEventA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameCudaEventA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCudaEventA_impl_fnptr : 0;
     if(local!=0)
-        (*local)(event, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameCudaEventA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCudaEventA_impl_fnptr;
+        if(local!=0)
+            (*local)(event, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameCudaEventW(cudaEvent_t event, const wchar_t* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameCudaEventW_impl_fntype local = (nvtxNameCudaEventW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCudaEventW_impl_fnptr;
+    nvtxNameCudaEventW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameCudaEventW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCudaEventW_impl_fnptr : 0;
     if(local!=0)
-        (*local)(event, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameCudaEventW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCudaEventW_impl_fnptr;
+        if(local!=0)
+            (*local)(event, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
@@ -10,6 +10,8 @@
 #error Never include this file directly -- it is automatically included by nvToolsExtCuda.h (except when NVTX_NO_IMPL is defined).
 #endif
 
+#include "nvtxExtCompat.h"
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -27,72 +29,120 @@ typedef void (NVTX_API * nvtxNameCuEventW_impl_fntype)(CUevent event, const wcha
 NVTX_DECLSPEC void NVTX_API nvtxNameCuDeviceA(CUdevice device, const char* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameCuDeviceA_impl_fntype local = (nvtxNameCuDeviceA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuDeviceA_impl_fnptr;
+    nvtxNameCuDeviceA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameCuDeviceA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuDeviceA_impl_fnptr : 0;
     if(local!=0)
-        (*local)(device, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameCuDeviceA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuDeviceA_impl_fnptr;
+        if(local!=0)
+            (*local)(device, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameCuDeviceW(CUdevice device, const wchar_t* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameCuDeviceW_impl_fntype local = (nvtxNameCuDeviceW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuDeviceW_impl_fnptr;
+    nvtxNameCuDeviceW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameCuDeviceW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuDeviceW_impl_fnptr : 0;
     if(local!=0)
-        (*local)(device, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameCuDeviceW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuDeviceW_impl_fnptr;
+        if(local!=0)
+            (*local)(device, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameCuContextA(CUcontext context, const char* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameCuContextA_impl_fntype local = (nvtxNameCuContextA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuContextA_impl_fnptr;
+    nvtxNameCuContextA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameCuContextA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuContextA_impl_fnptr : 0;
     if(local!=0)
-        (*local)(context, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameCuContextA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuContextA_impl_fnptr;
+        if(local!=0)
+            (*local)(context, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameCuContextW(CUcontext context, const wchar_t* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameCuContextW_impl_fntype local = (nvtxNameCuContextW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuContextW_impl_fnptr;
+    nvtxNameCuContextW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameCuContextW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuContextW_impl_fnptr : 0;
     if(local!=0)
-        (*local)(context, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameCuContextW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuContextW_impl_fnptr;
+        if(local!=0)
+            (*local)(context, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameCuStreamA(CUstream stream, const char* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameCuStreamA_impl_fntype local = (nvtxNameCuStreamA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuStreamA_impl_fnptr;
+    nvtxNameCuStreamA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameCuStreamA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuStreamA_impl_fnptr : 0;
     if(local!=0)
-        (*local)(stream, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameCuStreamA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuStreamA_impl_fnptr;
+        if(local!=0)
+            (*local)(stream, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameCuStreamW(CUstream stream, const wchar_t* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameCuStreamW_impl_fntype local = (nvtxNameCuStreamW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuStreamW_impl_fnptr;
+    nvtxNameCuStreamW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameCuStreamW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuStreamW_impl_fnptr : 0;
     if(local!=0)
-        (*local)(stream, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameCuStreamW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuStreamW_impl_fnptr;
+        if(local!=0)
+            (*local)(stream, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameCuEventA(CUevent event, const char* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameCuEventA_impl_fntype local = (nvtxNameCuEventA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuEventA_impl_fnptr;
+    nvtxNameCuEventA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameCuEventA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuEventA_impl_fnptr : 0;
     if(local!=0)
-        (*local)(event, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameCuEventA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuEventA_impl_fnptr;
+        if(local!=0)
+            (*local)(event, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameCuEventW(CUevent event, const wchar_t* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameCuEventW_impl_fntype local = (nvtxNameCuEventW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuEventW_impl_fnptr;
+    nvtxNameCuEventW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameCuEventW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuEventW_impl_fnptr : 0;
     if(local!=0)
-        (*local)(event, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameCuEventW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameCuEventW_impl_fnptr;
+        if(local!=0)
+            (*local)(event, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
@@ -10,6 +10,8 @@
 #error Never include this file directly -- it is automatically included by nvToolsExtCuda.h (except when NVTX_NO_IMPL is defined).
 #endif
 
+#include "nvtxExtCompat.h"
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,126 +35,210 @@ typedef void (NVTX_API * nvtxNameClEventW_impl_fntype)(cl_event evnt, const wcha
 NVTX_DECLSPEC void NVTX_API nvtxNameClDeviceA(cl_device_id device, const char* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameClDeviceA_impl_fntype local = (nvtxNameClDeviceA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClDeviceA_impl_fnptr;
+    nvtxNameClDeviceA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameClDeviceA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClDeviceA_impl_fnptr : 0;
     if(local!=0)
-        (*local)(device, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameClDeviceA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClDeviceA_impl_fnptr;
+        if(local!=0)
+            (*local)(device, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameClDeviceW(cl_device_id device, const wchar_t* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameClDeviceW_impl_fntype local = (nvtxNameClDeviceW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClDeviceW_impl_fnptr;
+    nvtxNameClDeviceW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameClDeviceW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClDeviceW_impl_fnptr : 0;
     if(local!=0)
-        (*local)(device, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameClDeviceW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClDeviceW_impl_fnptr;
+        if(local!=0)
+            (*local)(device, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameClContextA(cl_context context, const char* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameClContextA_impl_fntype local = (nvtxNameClContextA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClContextA_impl_fnptr;
+    nvtxNameClContextA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameClContextA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClContextA_impl_fnptr : 0;
     if(local!=0)
-        (*local)(context, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameClContextA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClContextA_impl_fnptr;
+        if(local!=0)
+            (*local)(context, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameClContextW(cl_context context, const wchar_t* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameClContextW_impl_fntype local = (nvtxNameClContextW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClContextW_impl_fnptr;
+    nvtxNameClContextW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameClContextW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClContextW_impl_fnptr : 0;
     if(local!=0)
-        (*local)(context, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameClContextW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClContextW_impl_fnptr;
+        if(local!=0)
+            (*local)(context, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameClCommandQueueA(cl_command_queue command_queue, const char* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameClCommandQueueA_impl_fntype local = (nvtxNameClCommandQueueA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClCommandQueueA_impl_fnptr;
+    nvtxNameClCommandQueueA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameClCommandQueueA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClCommandQueueA_impl_fnptr : 0;
     if(local!=0)
-        (*local)(command_queue, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameClCommandQueueA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClCommandQueueA_impl_fnptr;
+        if(local!=0)
+            (*local)(command_queue, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameClCommandQueueW(cl_command_queue command_queue, const wchar_t* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameClCommandQueueW_impl_fntype local = (nvtxNameClCommandQueueW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClCommandQueueW_impl_fnptr;
+    nvtxNameClCommandQueueW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameClCommandQueueW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClCommandQueueW_impl_fnptr : 0;
     if(local!=0)
-        (*local)(command_queue, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameClCommandQueueW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClCommandQueueW_impl_fnptr;
+        if(local!=0)
+            (*local)(command_queue, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameClMemObjectA(cl_mem memobj, const char* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameClMemObjectA_impl_fntype local = (nvtxNameClMemObjectA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClMemObjectA_impl_fnptr;
+    nvtxNameClMemObjectA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameClMemObjectA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClMemObjectA_impl_fnptr : 0;
     if(local!=0)
-        (*local)(memobj, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameClMemObjectA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClMemObjectA_impl_fnptr;
+        if(local!=0)
+            (*local)(memobj, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameClMemObjectW(cl_mem memobj, const wchar_t* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameClMemObjectW_impl_fntype local = (nvtxNameClMemObjectW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClMemObjectW_impl_fnptr;
+    nvtxNameClMemObjectW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameClMemObjectW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClMemObjectW_impl_fnptr : 0;
     if(local!=0)
-        (*local)(memobj, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameClMemObjectW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClMemObjectW_impl_fnptr;
+        if(local!=0)
+            (*local)(memobj, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameClSamplerA(cl_sampler sampler, const char* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameClSamplerA_impl_fntype local = (nvtxNameClSamplerA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClSamplerA_impl_fnptr;
+    nvtxNameClSamplerA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameClSamplerA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClSamplerA_impl_fnptr : 0;
     if(local!=0)
-        (*local)(sampler, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameClSamplerA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClSamplerA_impl_fnptr;
+        if(local!=0)
+            (*local)(sampler, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameClSamplerW(cl_sampler sampler, const wchar_t* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameClSamplerW_impl_fntype local = (nvtxNameClSamplerW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClSamplerW_impl_fnptr;
+    nvtxNameClSamplerW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameClSamplerW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClSamplerW_impl_fnptr : 0;
     if(local!=0)
-        (*local)(sampler, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameClSamplerW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClSamplerW_impl_fnptr;
+        if(local!=0)
+            (*local)(sampler, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameClProgramA(cl_program program, const char* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameClProgramA_impl_fntype local = (nvtxNameClProgramA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClProgramA_impl_fnptr;
+    nvtxNameClProgramA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameClProgramA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClProgramA_impl_fnptr : 0;
     if(local!=0)
-        (*local)(program, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameClProgramA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClProgramA_impl_fnptr;
+        if(local!=0)
+            (*local)(program, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameClProgramW(cl_program program, const wchar_t* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameClProgramW_impl_fntype local = (nvtxNameClProgramW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClProgramW_impl_fnptr;
+    nvtxNameClProgramW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameClProgramW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClProgramW_impl_fnptr : 0;
     if(local!=0)
-        (*local)(program, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameClProgramW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClProgramW_impl_fnptr;
+        if(local!=0)
+            (*local)(program, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameClEventA(cl_event evnt, const char* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameClEventA_impl_fntype local = (nvtxNameClEventA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClEventA_impl_fnptr;
+    nvtxNameClEventA_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameClEventA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClEventA_impl_fnptr : 0;
     if(local!=0)
-        (*local)(evnt, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameClEventA_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClEventA_impl_fnptr;
+        if(local!=0)
+            (*local)(evnt, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxNameClEventW(cl_event evnt, const wchar_t* name)
 {
 #ifndef NVTX_DISABLE
-    nvtxNameClEventW_impl_fntype local = (nvtxNameClEventW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClEventW_impl_fnptr;
+    nvtxNameClEventW_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxNameClEventW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClEventW_impl_fnptr : 0;
     if(local!=0)
-        (*local)(evnt, name);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxNameClEventW_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxNameClEventW_impl_fnptr;
+        if(local!=0)
+            (*local)(evnt, name);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
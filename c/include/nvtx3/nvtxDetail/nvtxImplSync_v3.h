@@ -10,6 +10,8 @@
 #error Never include this file directly -- it is automatically included by nvToolsExtCuda.h (except when NVTX_NO_IMPL is defined).
 #endif
 
+#include "nvtxExtCompat.h"
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -25,9 +27,17 @@ typedef void (NVTX_API * nvtxDomainSyncUserReleasing_impl_fntype)(nvtxSyncUser_t
 NVTX_DECLSPEC nvtxSyncUser_t NVTX_API nvtxDomainSyncUserCreate(nvtxDomainHandle_t domain, const nvtxSyncUserAttributes_t* attribs)
 {
 #ifndef NVTX_DISABLE
-    nvtxDomainSyncUserCreate_impl_fntype local = (nvtxDomainSyncUserCreate_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserCreate_impl_fnptr;
+    nvtxDomainSyncUserCreate_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxDomainSyncUserCreate_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserCreate_impl_fnptr : 0;
     if(local!=0)
-        return (*local)(domain, attribs);
+    {
+        nvtxSyncUser_t result = (nvtxSyncUser_t)0;
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxDomainSyncUserCreate_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserCreate_impl_fnptr;
+        if(local!=0)
+            result = (*local)(domain, attribs);
+        NVTX_TOOL_CALL_END();
+        return result;
+    }
     else
 #endif  /*NVTX_DISABLE*/
         return (nvtxSyncUser_t)0;
@@ -36,45 +46,75 @@ NVTX_DECLSPEC nvtxSyncUser_t NVTX_API nvtxDomainSyncUserCreate(nvtxDomainHandle_
 NVTX_DECLSPEC void NVTX_API nvtxDomainSyncUserDestroy(nvtxSyncUser_t handle)
 {
 #ifndef NVTX_DISABLE
-    nvtxDomainSyncUserDestroy_impl_fntype local = (nvtxDomainSyncUserDestroy_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserDestroy_impl_fnptr;
+    nvtxDomainSyncUserDestroy_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxDomainSyncUserDestroy_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserDestroy_impl_fnptr : 0;
     if(local!=0)
-        (*local)(handle);
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxDomainSyncUserDestroy_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserDestroy_impl_fnptr;
+        if(local!=0)
+            (*local)(handle);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxDomainSyncUserAcquireStart(nvtxSyncUser_t handle)
 {
 #ifndef NVTX_DISABLE
-    nvtxDomainSyncUserAcquireStart_impl_fntype local = (nvtxDomainSyncUserAcquireStart_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserAcquireStart_impl_fnptr;
-    if(local!=0)
-        (*local)(handle);
+    nvtxDomainSyncUserAcquireStart_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxDomainSyncUserAcquireStart_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserAcquireStart_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED())
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxDomainSyncUserAcquireStart_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserAcquireStart_impl_fnptr;
+        if(local!=0)
+            (*local)(handle);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxDomainSyncUserAcquireFailed(nvtxSyncUser_t handle)
 {
 #ifndef NVTX_DISABLE
-    nvtxDomainSyncUserAcquireFailed_impl_fntype local = (nvtxDomainSyncUserAcquireFailed_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserAcquireFailed_impl_fnptr;
-    if(local!=0)
-        (*local)(handle);
+    nvtxDomainSyncUserAcquireFailed_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxDomainSyncUserAcquireFailed_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserAcquireFailed_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED())
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxDomainSyncUserAcquireFailed_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserAcquireFailed_impl_fnptr;
+        if(local!=0)
+            (*local)(handle);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxDomainSyncUserAcquireSuccess(nvtxSyncUser_t handle)
 {
 #ifndef NVTX_DISABLE
-    nvtxDomainSyncUserAcquireSuccess_impl_fntype local = (nvtxDomainSyncUserAcquireSuccess_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserAcquireSuccess_impl_fnptr;
-    if(local!=0)
-        (*local)(handle);
+    nvtxDomainSyncUserAcquireSuccess_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxDomainSyncUserAcquireSuccess_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserAcquireSuccess_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED())
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxDomainSyncUserAcquireSuccess_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserAcquireSuccess_impl_fnptr;
+        if(local!=0)
+            (*local)(handle);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
 NVTX_DECLSPEC void NVTX_API nvtxDomainSyncUserReleasing(nvtxSyncUser_t handle)
 {
 #ifndef NVTX_DISABLE
-    nvtxDomainSyncUserReleasing_impl_fntype local = (nvtxDomainSyncUserReleasing_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserReleasing_impl_fnptr;
-    if(local!=0)
-        (*local)(handle);
+    nvtxDomainSyncUserReleasing_impl_fntype local = NVTX_STATIC_KEY_ENABLED() ? (nvtxDomainSyncUserReleasing_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserReleasing_impl_fnptr : 0;
+    if(local!=0 && !NVTX_EVENTS_PAUSED())
+    {
+        NVTX_TOOL_CALL_BEGIN(local);
+        local = (nvtxDomainSyncUserReleasing_impl_fntype)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserReleasing_impl_fnptr;
+        if(local!=0)
+            (*local)(handle);
+        NVTX_TOOL_CALL_END();
+    }
 #endif /*NVTX_DISABLE*/
 }
 
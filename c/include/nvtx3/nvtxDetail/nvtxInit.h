@@ -21,11 +21,13 @@
 #define NVTX_BUFSIZE    MAX_PATH
 #define NVTX_DLLHANDLE  HMODULE
 #define NVTX_DLLOPEN(x) LoadLibraryW(x)
+#define NVTX_DLLOPEN_A(x) LoadLibraryA(x)
 #define NVTX_DLLFUNC    GetProcAddress
 #define NVTX_DLLCLOSE   FreeLibrary
 #define NVTX_YIELD()    SwitchToThread()
 #define NVTX_MEMBAR()   MemoryBarrier()
 #define NVTX_ATOMIC_WRITE_32(address, value)                        InterlockedExchange((volatile LONG*)address, value)
+#define NVTX_ATOMIC_EXCHANGE_32(old, address, value)          old = InterlockedExchange((volatile LONG*)address, value)
 #define NVTX_ATOMIC_CAS_32(old, address, exchange, comparand) old = InterlockedCompareExchange((volatile LONG*)address, exchange, comparand)
 #elif defined(__GNUC__)
 #define NVTX_PATHCHAR   char
@@ -34,17 +36,37 @@
 #define NVTX_BUFSIZE    PATH_MAX
 #define NVTX_DLLHANDLE  void*
 #define NVTX_DLLOPEN(x) dlopen(x, RTLD_LAZY)
+#define NVTX_DLLOPEN_A(x) dlopen(x, RTLD_LAZY)
 #define NVTX_DLLFUNC    dlsym
 #define NVTX_DLLCLOSE   dlclose
 #define NVTX_YIELD()    sched_yield()
 #define NVTX_MEMBAR()   __sync_synchronize()
 /* Ensure full memory barrier for atomics, to match Windows functions */
 #define NVTX_ATOMIC_WRITE_32(address, value)                  __sync_synchronize();       __sync_lock_test_and_set(address, value)
+#define NVTX_ATOMIC_EXCHANGE_32(old, address, value)          __sync_synchronize(); old = __sync_lock_test_and_set(address, value)
 #define NVTX_ATOMIC_CAS_32(old, address, exchange, comparand) __sync_synchronize(); old = __sync_val_compare_and_swap(address, exchange, comparand)
 #else
 #error The library does not support your configuration!
 #endif
 
+/* Define this to 1 for platforms where threads waiting for another thread to finish
+*  initialization can sleep on the address of initState (a futex on Linux).  Otherwise,
+*  waiting threads yield in a loop.  Defining this to 0 before including NVTX forces
+*  the yield loop.  Strict ISO C modes do not declare syscall(), so they yield too. */
+#if !defined(NVTX_SUPPORT_FUTEX_WAIT)
+#if defined(__linux__) && (defined(__cplusplus) || defined(_GNU_SOURCE) || defined(_DEFAULT_SOURCE) || defined(_BSD_SOURCE))
+#define NVTX_SUPPORT_FUTEX_WAIT 1
+#else
+#define NVTX_SUPPORT_FUTEX_WAIT 0
+#endif
+#endif
+
+#if NVTX_SUPPORT_FUTEX_WAIT
+/* Sleep while *address equals value; returns at once if it does not.  May wake spuriously. */
+#define NVTX_FUTEX_WAIT(address, value) syscall(SYS_futex, (volatile int*)(address), FUTEX_WAIT_PRIVATE, (int)(value), (void*)0, (void*)0, 0)
+#define NVTX_FUTEX_WAKE_ALL(address)    syscall(SYS_futex, (volatile int*)(address), FUTEX_WAKE_PRIVATE, INT_MAX, (void*)0, (void*)0, 0)
+#endif
+
 /* Define this to 1 for platforms that where pre-injected libraries can be discovered. */
 #if defined(_WIN32)
 /* TODO */
@@ -87,11 +109,11 @@ __attribute__((weak)) NvtxInitializeInjectionNvtxFunc_t InitializeInjectionNvtx2
 *  to no-ops.  This is implemented as one function instead of several small
 *  functions to minimize the number of weak symbols the linker must resolve.
 *  Order of search is:
+*  - Statically-linked injection library defining InitializeInjectionNvtx2_fnptr
 *  - Pre-injected library exporting InitializeInjectionNvtx2
 *  - Loadable library exporting InitializeInjectionNvtx2
 *      - Path specified by env var NVTX_INJECTION??_PATH (?? is 32 or 64)
 *      - On Android, libNvtxInjection??.so within the package (?? is 32 or 64)
-*  - Statically-linked injection library defining InitializeInjectionNvtx2_fnptr
 */
 NVTX_LINKONCE_FWDDECL_FUNCTION int NVTX_VERSIONED_IDENTIFIER(nvtxInitializeInjectionLibrary)(void);
 NVTX_LINKONCE_DEFINE_FUNCTION int NVTX_VERSIONED_IDENTIFIER(nvtxInitializeInjectionLibrary)(void)
@@ -101,9 +123,22 @@ NVTX_LINKONCE_DEFINE_FUNCTION int NVTX_VERSIONED_IDENTIFIER(nvtxInitializeInject
     NVTX_DLLHANDLE injectionLibraryHandle = (NVTX_DLLHANDLE)0;
     int entryPointStatus = 0;
 
+#if NVTX_SUPPORT_STATIC_INJECTION_LIBRARY
+    /* Check weakly-defined function pointer first.  A statically-linked injection can define
+    *  this as a normal symbol and it will take precedence over a dynamic injection, without
+    *  reading the environment or calling into the dynamic loader. */
+    if (InitializeInjectionNvtx2_fnptr)
+    {
+        init_fnptr = InitializeInjectionNvtx2_fnptr;
+    }
+#endif
+
 #if NVTX_SUPPORT_ALREADY_INJECTED_LIBRARY
     /* Use POSIX global symbol chain to query for init function from any module */
-    init_fnptr = (NvtxInitializeInjectionNvtxFunc_t)NVTX_DLLFUNC(0, initFuncName);
+    if (!init_fnptr)
+    {
+        init_fnptr = (NvtxInitializeInjectionNvtxFunc_t)NVTX_DLLFUNC(0, initFuncName);
+    }
 #endif
 
 #if NVTX_SUPPORT_DYNAMIC_INJECTION_LIBRARY
@@ -234,18 +269,6 @@ NVTX_LINKONCE_DEFINE_FUNCTION int NVTX_VERSIONED_IDENTIFIER(nvtxInitializeInject
     }
 #endif
 
-#if NVTX_SUPPORT_STATIC_INJECTION_LIBRARY
-    if (!init_fnptr)
-    {
-        /* Check weakly-defined function pointer.  A statically-linked injection can define this as
-        *  a normal symbol and it will take precedence over a dynamic injection. */
-        if (InitializeInjectionNvtx2_fnptr)
-        {
-            init_fnptr = InitializeInjectionNvtx2_fnptr;
-        }
-    }
-#endif
-
     /* At this point, if init_fnptr is not set, then no tool has specified
     *  an NVTX injection library -- return non-success result so all NVTX
     *  API functions will be set to no-ops. */
@@ -267,9 +290,237 @@ NVTX_LINKONCE_DEFINE_FUNCTION int NVTX_VERSIONED_IDENTIFIER(nvtxInitializeInject
         return NVTX_ERR_INIT_FAILED_LIBRARY_ENTRY_POINT;
     }
 
+    NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).injectionLibrary = (void*)injectionLibraryHandle;
     return NVTX_SUCCESS;
 }
 
+/* Marks initialization as finished and wakes the threads waiting for it. */
+NVTX_LINKONCE_FWDDECL_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxInitComplete)(void);
+NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxInitComplete)(void)
+{
+    unsigned int old;
+
+    /* Signal that initialization has finished, so now the assigned function pointers will be used */
+    NVTX_ATOMIC_EXCHANGE_32(
+        old,
+        &NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).initState,
+        NVTX_INIT_STATE_COMPLETE);
+#if NVTX_SUPPORT_FUTEX_WAIT
+    /* Only wake sleeping threads if some announced they would sleep */
+    if (old == NVTX_INIT_STATE_STARTED_WAITERS)
+    {
+        NVTX_FUTEX_WAKE_ALL(&NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).initState);
+    }
+#else
+    (void)old;
+#endif
+}
+
+#if NVTX_STATIC_KEYS_SUPPORTED
+/* Commands of the membarrier system call, from linux/membarrier.h of Linux 4.16 and later */
+#define NVTX_MEMBARRIER_PRIVATE_EXPEDITED_SYNC_CORE (1 << 5)
+#define NVTX_MEMBARRIER_REGISTER_PRIVATE_EXPEDITED_SYNC_CORE (1 << 6)
+
+/* Has every thread of the process execute a serializing instruction before it runs patched
+*  code, as the cross-modifying code rules of the Intel SDM require.  Without membarrier, a
+*  thread may run the old instruction of a site for a while, which is either instruction. */
+NVTX_LINKONCE_FWDDECL_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxSyncCores)(void);
+NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxSyncCores)(void)
+{
+#ifdef SYS_membarrier
+    static int registered = 0;
+    if (!registered)
+    {
+        registered = syscall(SYS_membarrier, NVTX_MEMBARRIER_REGISTER_PRIVATE_EXPEDITED_SYNC_CORE, 0) == 0 ? 1 : -1;
+    }
+    if (registered > 0)
+    {
+        syscall(SYS_membarrier, NVTX_MEMBARRIER_PRIVATE_EXPEDITED_SYNC_CORE, 0);
+    }
+#endif
+}
+
+/* Address of the 5-byte instruction of a static key site, and of the code its jump goes to */
+#define NVTX_STATIC_KEY_CODE(site) ((unsigned char*)&(site)->code + (site)->code)
+#define NVTX_STATIC_KEY_TARGET(site) ((uintptr_t)&(site)->target + (site)->target)
+
+/* Byte of the int3 instruction a site starts with while it is being patched */
+#define NVTX_STATIC_KEY_INT3 0xcc
+
+/* Index of the instruction pointer in the registers of a ucontext_t, which glibc only names
+*  with _GNU_SOURCE */
+#ifdef REG_RIP
+#define NVTX_REG_RIP REG_RIP
+#else
+#define NVTX_REG_RIP 16
+#endif
+
+/* SIGTRAP handler of the process before nvtxStaticKeyTrap was installed */
+NVTX_LINKONCE_FWDDECL_FUNCTION struct sigaction* NVTX_VERSIONED_IDENTIFIER(nvtxStaticKeyPreviousTrap)(void);
+NVTX_LINKONCE_DEFINE_FUNCTION struct sigaction* NVTX_VERSIONED_IDENTIFIER(nvtxStaticKeyPreviousTrap)(void)
+{
+    static struct sigaction previous;
+    return &previous;
+}
+
+/* Handles the int3 a thread meets at a site of this module being patched.  The old and the new
+*  instruction of the site are both correct there, so the thread resumes as if it had taken the
+*  jump, whose path tests the function pointer.  Other traps go to the previous handler. */
+NVTX_LINKONCE_FWDDECL_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxStaticKeyTrap)(int sig, siginfo_t* info, void* context);
+NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxStaticKeyTrap)(int sig, siginfo_t* info, void* context)
+{
+    const NVTX_VERSIONED_IDENTIFIER(nvtxStaticKeySite_t)* site = NVTX_VERSIONED_IDENTIFIER(__start_nvtxStaticKeySites);
+    const NVTX_VERSIONED_IDENTIFIER(nvtxStaticKeySite_t)* end = NVTX_VERSIONED_IDENTIFIER(__stop_nvtxStaticKeySites);
+    const struct sigaction* previous = NVTX_VERSIONED_IDENTIFIER(nvtxStaticKeyPreviousTrap)();
+    greg_t* ip = &((ucontext_t*)context)->uc_mcontext.gregs[NVTX_REG_RIP];
+
+    for (; site && site < end; ++site)
+    {
+        /* The instruction pointer is past the int3 */
+        if ((greg_t)(uintptr_t)NVTX_STATIC_KEY_CODE(site) == *ip - 1)
+        {
+            *ip = (greg_t)NVTX_STATIC_KEY_TARGET(site);
+            return;
+        }
+    }
+
+    if (previous->sa_flags & SA_SIGINFO)
+    {
+        previous->sa_sigaction(sig, info, context);
+    }
+    else if (previous->sa_handler == SIG_DFL)
+    {
+        /* Delivered with the default action once this handler returns */
+        signal(sig, SIG_DFL);
+        raise(sig);
+    }
+    else if (previous->sa_handler != SIG_IGN)
+    {
+        previous->sa_handler(sig);
+    }
+}
+
+/* Writes one byte of code through /proc/self/mem, which the kernel allows on pages mapped
+*  read-only and executable, so code pages never become writable.  Returns 0 if it fails. */
+NVTX_LINKONCE_FWDDECL_FUNCTION int NVTX_VERSIONED_IDENTIFIER(nvtxPokeCode)(int mem, unsigned char* code, unsigned char byte);
+NVTX_LINKONCE_DEFINE_FUNCTION int NVTX_VERSIONED_IDENTIFIER(nvtxPokeCode)(int mem, unsigned char* code, unsigned char byte)
+{
+    return pwrite(mem, &byte, 1, (off_t)(uintptr_t)code) == 1;
+}
+
+/* Writes opcode over the first byte of every static key site of this module, like text_poke_bp
+*  of Linux: each site to change first becomes an int3, which nvtxStaticKeyTrap handles for the
+*  threads running into it, and only then, once every core sees the int3, gets its new opcode.
+*  The other bytes of the two instructions are the same.  Returns 0 if the code cannot be
+*  written, leaving the sites unchanged, or if the SIGTRAP handler cannot be installed. */
+NVTX_LINKONCE_FWDDECL_FUNCTION int NVTX_VERSIONED_IDENTIFIER(nvtxPatchStaticKeys)(unsigned char opcode);
+NVTX_LINKONCE_DEFINE_FUNCTION int NVTX_VERSIONED_IDENTIFIER(nvtxPatchStaticKeys)(unsigned char opcode)
+{
+    const NVTX_VERSIONED_IDENTIFIER(nvtxStaticKeySite_t)* begin = NVTX_VERSIONED_IDENTIFIER(__start_nvtxStaticKeySites);
+    const NVTX_VERSIONED_IDENTIFIER(nvtxStaticKeySite_t)* end = NVTX_VERSIONED_IDENTIFIER(__stop_nvtxStaticKeySites);
+    const NVTX_VERSIONED_IDENTIFIER(nvtxStaticKeySite_t)* site;
+    static int trapInstalled = 0;
+    int result = 1;
+    int mem;
+
+    if (!begin)
+    {
+        return 1;
+    }
+
+    /* Installed for good: a thread may still be on its way into the handler after patching */
+    if (!trapInstalled)
+    {
+        struct sigaction trap;
+        memset(&trap, 0, sizeof(trap));
+        trap.sa_sigaction = NVTX_VERSIONED_IDENTIFIER(nvtxStaticKeyTrap);
+        trap.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&trap.sa_mask);
+        if (sigaction(SIGTRAP, &trap, NVTX_VERSIONED_IDENTIFIER(nvtxStaticKeyPreviousTrap)()) != 0)
+        {
+            NVTX_ERR("Failed to install the SIGTRAP handler for NVTX call sites\n");
+            return 0;
+        }
+        trapInstalled = 1;
+    }
+
+    mem = open("/proc/self/mem", O_RDWR | O_CLOEXEC);
+    if (mem < 0)
+    {
+        NVTX_ERR("Failed to open /proc/self/mem to patch NVTX call sites\n");
+        return 0;
+    }
+
+    for (site = begin; site < end; ++site)
+    {
+        unsigned char* code = NVTX_STATIC_KEY_CODE(site);
+        if (*code != opcode && !NVTX_VERSIONED_IDENTIFIER(nvtxPokeCode)(mem, code, NVTX_STATIC_KEY_INT3))
+        {
+            NVTX_ERR("Failed to write NVTX call sites\n");
+            result = 0;
+            opcode = opcode == NVTX_STATIC_KEY_JMP ? NVTX_STATIC_KEY_CMP : NVTX_STATIC_KEY_JMP;
+            end = site;
+            break;
+        }
+    }
+    NVTX_VERSIONED_IDENTIFIER(nvtxSyncCores)();
+
+    /* After a failure, the sites that became an int3 get their old opcode back */
+    for (site = begin; site < end; ++site)
+    {
+        unsigned char* code = NVTX_STATIC_KEY_CODE(site);
+        if (*code == NVTX_STATIC_KEY_INT3)
+        {
+            NVTX_VERSIONED_IDENTIFIER(nvtxPokeCode)(mem, code, opcode);
+        }
+    }
+    NVTX_VERSIONED_IDENTIFIER(nvtxSyncCores)();
+
+    close(mem);
+    return result;
+}
+#endif
+
+/* Turns every static key site of this module into the jump to its NVTX call if enabled is
+*  nonzero, or into a CMP skipping it otherwise.  Called with initState at STARTED, so only one
+*  thread of the module patches at a time.  The two instructions differ only in their opcode
+*  byte, the rel32 of the jump being the CMP's immediate, so each site changes through an int3
+*  in its opcode byte alone.  If the sites cannot be disabled, they stay jumps, so the module
+*  keeps the behavior without static keys. */
+NVTX_LINKONCE_FWDDECL_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxSetStaticKeys)(int enabled);
+NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxSetStaticKeys)(int enabled)
+{
+#if NVTX_STATIC_KEYS_SUPPORTED
+    NVTX_VERSIONED_IDENTIFIER(nvtxPatchStaticKeys)(enabled ? NVTX_STATIC_KEY_JMP : NVTX_STATIC_KEY_CMP);
+#else
+    (void)enabled;
+#endif
+}
+
+/* Runs the initialization on the thread that moved initState away from FRESH. */
+NVTX_LINKONCE_FWDDECL_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxInitRun)(void);
+NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxInitRun)(void)
+{
+    int result;
+    int forceAllToNoops;
+
+    /* Load & initialize injection library -- it will assign the function pointers */
+    result = NVTX_VERSIONED_IDENTIFIER(nvtxInitializeInjectionLibrary)();
+    NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).injectionAttached = result == NVTX_SUCCESS;
+
+    /* Set all pointers not assigned by the injection to null */
+    forceAllToNoops = result != NVTX_SUCCESS; /* Set all to null if injection init failed */
+    NVTX_VERSIONED_IDENTIFIER(nvtxSetInitFunctionsToNoops)(forceAllToNoops);
+
+    /* Without a tool, NVTX calls need not even load their function pointer */
+    if (result != NVTX_SUCCESS)
+    {
+        NVTX_VERSIONED_IDENTIFIER(nvtxSetStaticKeys)(0);
+    }
+
+    NVTX_VERSIONED_IDENTIFIER(nvtxInitComplete)();
+}
+
 NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)(void)
 {
     unsigned int old;
@@ -285,21 +536,34 @@ NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)(void)
         NVTX_INIT_STATE_FRESH);
     if (old == NVTX_INIT_STATE_FRESH)
     {
-        int result;
-        int forceAllToNoops;
-
-        /* Load & initialize injection library -- it will assign the function pointers */
-        result = NVTX_VERSIONED_IDENTIFIER(nvtxInitializeInjectionLibrary)();
-
-        /* Set all pointers not assigned by the injection to null */
-        forceAllToNoops = result != NVTX_SUCCESS; /* Set all to null if injection init failed */
-        NVTX_VERSIONED_IDENTIFIER(nvtxSetInitFunctionsToNoops)(forceAllToNoops);
-
-        /* Signal that initialization has finished, so now the assigned function pointers will be used */
-        NVTX_ATOMIC_WRITE_32(
-            &NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).initState,
-            NVTX_INIT_STATE_COMPLETE);
+        NVTX_VERSIONED_IDENTIFIER(nvtxInitRun)();
+    }
+#if NVTX_SUPPORT_FUTEX_WAIT
+    else /* Sleep until initialization has finished */
+    {
+        while (old != NVTX_INIT_STATE_COMPLETE)
+        {
+            /* Announce this thread will sleep, unless another waiter already did */
+            if (old == NVTX_INIT_STATE_STARTED)
+            {
+                NVTX_ATOMIC_CAS_32(
+                    old,
+                    &NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).initState,
+                    NVTX_INIT_STATE_STARTED_WAITERS,
+                    NVTX_INIT_STATE_STARTED);
+                if (old == NVTX_INIT_STATE_COMPLETE)
+                {
+                    break;
+                }
+            }
+            NVTX_FUTEX_WAIT(
+                &NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).initState,
+                NVTX_INIT_STATE_STARTED_WAITERS);
+            old = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).initState;
+        }
+        NVTX_MEMBAR();
     }
+#else
     else /* Spin-wait until initialization has finished */
     {
         NVTX_MEMBAR();
@@ -309,4 +573,241 @@ NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)(void)
             NVTX_MEMBAR();
         }
     }
+#endif
+}
+
+#if NVTX_INIT_ASYNC_ENABLED
+/* Entry point of the helper thread initializing NVTX in the background. */
+NVTX_LINKONCE_FWDDECL_FUNCTION void* NVTX_VERSIONED_IDENTIFIER(nvtxInitThread)(void* arg);
+NVTX_LINKONCE_DEFINE_FUNCTION void* NVTX_VERSIONED_IDENTIFIER(nvtxInitThread)(void* arg)
+{
+    (void)arg;
+    NVTX_VERSIONED_IDENTIFIER(nvtxInitRun)();
+    return NULL;
+}
+#endif
+
+NVTX_LINKONCE_DEFINE_FUNCTION int NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)(void)
+{
+#if NVTX_INIT_ASYNC_ENABLED
+    unsigned int old = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).initState;
+    if (old == NVTX_INIT_STATE_COMPLETE)
+    {
+        return 1;
+    }
+
+    /* Only the first call pays for the compare-and-swap and the thread creation;
+    *  later calls until initialization finishes cost this load and a branch. */
+    if (old == NVTX_INIT_STATE_FRESH)
+    {
+        NVTX_ATOMIC_CAS_32(
+            old,
+            &NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).initState,
+            NVTX_INIT_STATE_STARTED,
+            NVTX_INIT_STATE_FRESH);
+        if (old == NVTX_INIT_STATE_FRESH)
+        {
+            pthread_t thread;
+            if (pthread_create(&thread, NULL, NVTX_VERSIONED_IDENTIFIER(nvtxInitThread), NULL) == 0)
+            {
+                pthread_detach(thread);
+                return 0;
+            }
+
+            /* No helper thread available, initialize on this one */
+            NVTX_VERSIONED_IDENTIFIER(nvtxInitRun)();
+            return 1;
+        }
+    }
+    return old == NVTX_INIT_STATE_COMPLETE;
+#else
+    NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
+    return 1;
+#endif
+}
+
+#if NVTX_INIT_ASYNC_ENABLED
+/* Start initializing when the module including NVTX is loaded, instead of at its first event. */
+NVTX_LINKONCE_FWDDECL_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxInitAtLoad)(void);
+NVTX_LINKONCE_DEFINE_FUNCTION __attribute__((constructor)) void NVTX_VERSIONED_IDENTIFIER(nvtxInitAtLoad)(void)
+{
+    (void)NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)();
+}
+#endif
+
+/* Waits until every call into the tool through a function pointer loaded before this function
+*  was called has returned.  Each pass moves new calls to the other half of nvtxToolCalls and
+*  waits for the half they left to drain.  The second pass catches calls that read toolCallEpoch
+*  before an earlier wait and so counted in the half that is current again.  Must not be called
+*  from the tool's callbacks, or with initState at STARTED: a counted call may be an init
+*  trampoline waiting for initState to become COMPLETE. */
+NVTX_LINKONCE_FWDDECL_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxWaitForToolCalls)(void);
+NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxWaitForToolCalls)(void)
+{
+#if NVTX_SUPPORT_DETACH
+    volatile unsigned int* counters;
+    unsigned int old;
+    unsigned int pass;
+    unsigned int slot;
+
+    /* One waiter at a time, so the epoch only moves while nobody relies on it */
+    for (;;)
+    {
+        NVTX_ATOMIC_CAS_32(
+            old,
+            &NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).toolCallWaiter,
+            1,
+            0);
+        if (old == 0)
+        {
+            break;
+        }
+        NVTX_YIELD();
+    }
+
+    for (pass = 0; pass < 2; ++pass)
+    {
+        /* Full barrier: the function pointers were reset before, the counters are read after */
+        NVTX_ATOMIC_EXCHANGE_32(
+            old,
+            &NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).toolCallEpoch,
+            NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).toolCallEpoch + 1);
+        counters = &NVTX_VERSIONED_IDENTIFIER(nvtxToolCalls)[(old & 1u) * NVTX_TOOL_CALL_SLOTS * NVTX_TOOL_CALL_STRIDE];
+        for (slot = 0; slot < NVTX_TOOL_CALL_SLOTS; ++slot)
+        {
+            while (counters[slot * NVTX_TOOL_CALL_STRIDE] != 0)
+            {
+                NVTX_YIELD();
+            }
+        }
+    }
+
+    NVTX_ATOMIC_WRITE_32(&NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).toolCallWaiter, 0);
+#endif
+}
+
+NVTX_LINKONCE_DEFINE_FUNCTION int NVTX_VERSIONED_IDENTIFIER(nvtxAttachInjectionLibrary)(const char* path)
+{
+    const char* const initFuncName = "InitializeInjectionNvtx2";
+    NvtxInitializeInjectionNvtxFunc_t init_fnptr = (NvtxInitializeInjectionNvtxFunc_t)0;
+    NVTX_DLLHANDLE injectionLibraryHandle = (NVTX_DLLHANDLE)0;
+    unsigned int old;
+    int result;
+
+    if (!path)
+    {
+        return NVTX_ERR_INIT_LOAD_PROPERTY;
+    }
+
+    /* Take initState from COMPLETE back to STARTED for the duration of the attach.  A second
+    *  attach then waits for this one, like threads still on their way through an init
+    *  trampoline do, and finds the tool attached or retries if this one failed. */
+    for (;;)
+    {
+        NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
+        if (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).injectionAttached)
+        {
+            return NVTX_ERR_INJECTION_LIBRARY_ALREADY_ATTACHED;
+        }
+        NVTX_ATOMIC_CAS_32(
+            old,
+            &NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).initState,
+            NVTX_INIT_STATE_STARTED,
+            NVTX_INIT_STATE_COMPLETE);
+        if (old == NVTX_INIT_STATE_COMPLETE)
+        {
+            break;
+        }
+    }
+
+    injectionLibraryHandle = NVTX_DLLOPEN_A(path);
+    if (!injectionLibraryHandle)
+    {
+        NVTX_ERR("Failed to load injection library\n");
+        result = NVTX_ERR_INIT_LOAD_LIBRARY;
+    }
+    else
+    {
+        init_fnptr = (NvtxInitializeInjectionNvtxFunc_t)NVTX_DLLFUNC(injectionLibraryHandle, initFuncName);
+        if (!init_fnptr)
+        {
+            NVTX_ERR("Failed to get address of function InitializeInjectionNvtx2 from injection library\n");
+            result = NVTX_ERR_INIT_MISSING_LIBRARY_ENTRY_POINT;
+        }
+        else if (init_fnptr(NVTX_VERSIONED_IDENTIFIER(nvtxGetExportTable)) == 0)
+        {
+            NVTX_ERR("Failed to initialize injection library -- initialization function returned 0\n");
+            /* The tool may have assigned some pointers before failing */
+            NVTX_VERSIONED_IDENTIFIER(nvtxSetInitFunctionsToNoops)(1);
+            result = NVTX_ERR_INIT_FAILED_LIBRARY_ENTRY_POINT;
+        }
+        else
+        {
+            result = NVTX_SUCCESS;
+            NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).injectionLibrary = (void*)injectionLibraryHandle;
+        }
+    }
+
+    NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).injectionAttached = result == NVTX_SUCCESS;
+    if (result == NVTX_SUCCESS)
+    {
+        /* Handles created before, such as the null ones returned without a tool, are not the tool's */
+        NVTX_ATOMIC_INCREMENT_32(&NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).attachGeneration);
+        NVTX_VERSIONED_IDENTIFIER(nvtxSetStaticKeys)(1);
+    }
+    NVTX_VERSIONED_IDENTIFIER(nvtxInitComplete)();
+
+    if (result != NVTX_SUCCESS && injectionLibraryHandle)
+    {
+        /* Let calls that reached the failed tool through those pointers return first */
+        NVTX_VERSIONED_IDENTIFIER(nvtxWaitForToolCalls)();
+        NVTX_DLLCLOSE(injectionLibraryHandle);
+    }
+    return result;
+}
+
+NVTX_LINKONCE_DEFINE_FUNCTION int NVTX_VERSIONED_IDENTIFIER(nvtxDetachInjectionLibrary)(void)
+{
+    NVTX_DLLHANDLE injectionLibraryHandle;
+    unsigned int old;
+
+    /* Hold initState at STARTED while the function pointers change, as attaching does */
+    for (;;)
+    {
+        NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
+        if (!NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).injectionAttached)
+        {
+            return NVTX_ERR_NO_INJECTION_LIBRARY_AVAILABLE;
+        }
+        NVTX_ATOMIC_CAS_32(
+            old,
+            &NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).initState,
+            NVTX_INIT_STATE_STARTED,
+            NVTX_INIT_STATE_COMPLETE);
+        if (old == NVTX_INIT_STATE_COMPLETE)
+        {
+            break;
+        }
+    }
+
+    NVTX_VERSIONED_IDENTIFIER(nvtxSetInitFunctionsToNoops)(1);
+    injectionLibraryHandle = (NVTX_DLLHANDLE)NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).injectionLibrary;
+    NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).injectionLibrary = (void*)0;
+    NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).injectionAttached = 0;
+    NVTX_ATOMIC_INCREMENT_32(&NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).attachGeneration);
+    NVTX_VERSIONED_IDENTIFIER(nvtxSetStaticKeys)(0);
+    NVTX_VERSIONED_IDENTIFIER(nvtxInitComplete)();
+
+    /* Grace period: no thread may still be running the tool's code when it is unloaded */
+    NVTX_VERSIONED_IDENTIFIER(nvtxWaitForToolCalls)();
+#if NVTX_SUPPORT_DETACH
+    if (injectionLibraryHandle)
+    {
+        NVTX_DLLCLOSE(injectionLibraryHandle);
+    }
+#else
+    /* Calls are not counted, so some may still be in the tool: leave it loaded */
+    (void)injectionLibraryHandle;
+#endif
+    return NVTX_SUCCESS;
 }
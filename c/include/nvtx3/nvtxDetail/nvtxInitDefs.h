@@ -11,58 +11,71 @@
 #endif
 
 NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxMarkEx_impl_init)(const nvtxEventAttributes_t* eventAttrib){
-    NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
-    nvtxMarkEx(eventAttrib);
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+        nvtxMarkEx(eventAttrib);
 }
 
 NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxMarkA_impl_init)(const char* message){
-    NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
-    nvtxMarkA(message);
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+        nvtxMarkA(message);
 }
 
 NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxMarkW_impl_init)(const wchar_t* message){
-    NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
-    nvtxMarkW(message);
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+        nvtxMarkW(message);
 }
 
 NVTX_LINKONCE_DEFINE_FUNCTION nvtxRangeId_t NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxRangeStartEx_impl_init)(const nvtxEventAttributes_t* eventAttrib){
-    NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
-    return nvtxRangeStartEx(eventAttrib);
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+        return nvtxRangeStartEx(eventAttrib);
+    (void)NVTX_ASYNC_START_DROPPED();
+    return (nvtxRangeId_t)0;
 }
 
 NVTX_LINKONCE_DEFINE_FUNCTION nvtxRangeId_t NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxRangeStartA_impl_init)(const char* message){
-    NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
-    return nvtxRangeStartA(message);
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+        return nvtxRangeStartA(message);
+    (void)NVTX_ASYNC_START_DROPPED();
+    return (nvtxRangeId_t)0;
 }
 
 NVTX_LINKONCE_DEFINE_FUNCTION nvtxRangeId_t NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxRangeStartW_impl_init)(const wchar_t* message){
-    NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
-    return nvtxRangeStartW(message);
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+        return nvtxRangeStartW(message);
+    (void)NVTX_ASYNC_START_DROPPED();
+    return (nvtxRangeId_t)0;
 }
 
 NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxRangeEnd_impl_init)(nvtxRangeId_t id){
-    NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
-    nvtxRangeEnd(id);
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+        nvtxRangeEnd(id);
 }
 
 NVTX_LINKONCE_DEFINE_FUNCTION int NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxRangePushEx_impl_init)(const nvtxEventAttributes_t* eventAttrib){
-    NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
-    return nvtxRangePushEx(eventAttrib);
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+        return nvtxRangePushEx(eventAttrib);
+    (void)NVTX_ASYNC_PUSH_DROPPED();
+    return (int)NVTX_NO_PUSH_POP_TRACKING;
 }
 
 NVTX_LINKONCE_DEFINE_FUNCTION int NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxRangePushA_impl_init)(const char* message){
-    NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
-    return nvtxRangePushA(message);
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+        return nvtxRangePushA(message);
+    (void)NVTX_ASYNC_PUSH_DROPPED();
+    return (int)NVTX_NO_PUSH_POP_TRACKING;
 }
 
 NVTX_LINKONCE_DEFINE_FUNCTION int NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxRangePushW_impl_init)(const wchar_t* message){
-    NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
-    return nvtxRangePushW(message);
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+        return nvtxRangePushW(message);
+    (void)NVTX_ASYNC_PUSH_DROPPED();
+    return (int)NVTX_NO_PUSH_POP_TRACKING;
 }
 
 NVTX_LINKONCE_DEFINE_FUNCTION int NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxRangePop_impl_init)(void){
-    NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
-    return nvtxRangePop();
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+        return nvtxRangePop();
+    return (int)NVTX_NO_PUSH_POP_TRACKING;
 }
 
 NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxNameCategoryA_impl_init)(uint32_t category, const char* name){
@@ -86,28 +99,33 @@ NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxNameOs
 }
 
 NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxDomainMarkEx_impl_init)(nvtxDomainHandle_t domain, const nvtxEventAttributes_t* eventAttrib){
-    NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
-    nvtxDomainMarkEx(domain, eventAttrib);
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+        nvtxDomainMarkEx(domain, eventAttrib);
 }
 
 NVTX_LINKONCE_DEFINE_FUNCTION nvtxRangeId_t NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxDomainRangeStartEx_impl_init)(nvtxDomainHandle_t domain, const nvtxEventAttributes_t* eventAttrib){
-    NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
-    return nvtxDomainRangeStartEx(domain, eventAttrib);
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+        return nvtxDomainRangeStartEx(domain, eventAttrib);
+    (void)NVTX_ASYNC_START_DROPPED();
+    return (nvtxRangeId_t)0;
 }
 
 NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxDomainRangeEnd_impl_init)(nvtxDomainHandle_t domain, nvtxRangeId_t id){
-    NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
-    nvtxDomainRangeEnd(domain, id);
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+        nvtxDomainRangeEnd(domain, id);
 }
 
 NVTX_LINKONCE_DEFINE_FUNCTION int NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxDomainRangePushEx_impl_init)(nvtxDomainHandle_t domain, const nvtxEventAttributes_t* eventAttrib){
-    NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
-    return nvtxDomainRangePushEx(domain, eventAttrib);
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+        return nvtxDomainRangePushEx(domain, eventAttrib);
+    (void)NVTX_ASYNC_PUSH_DROPPED();
+    return (int)NVTX_NO_PUSH_POP_TRACKING;
 }
 
 NVTX_LINKONCE_DEFINE_FUNCTION int NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxDomainRangePop_impl_init)(nvtxDomainHandle_t domain){
-    NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
-    return nvtxDomainRangePop(domain);
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+        return nvtxDomainRangePop(domain);
+    return (int)NVTX_NO_PUSH_POP_TRACKING;
 }
 
 NVTX_LINKONCE_DEFINE_FUNCTION nvtxResourceHandle_t NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxDomainResourceCreate_impl_init)(nvtxDomainHandle_t domain, nvtxResourceAttributes_t* attribs){
@@ -160,6 +178,25 @@ NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxInitia
     nvtxInitialize(reserved);
 }
 
+NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxDomainMarkCompact_impl_init)(nvtxDomainHandle_t domain, nvtxStringHandle_t message, uint32_t category, int32_t payloadType, uint64_t payload){
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+        nvtxDomainMarkCompact(domain, message, category, payloadType, payload);
+}
+
+NVTX_LINKONCE_DEFINE_FUNCTION nvtxRangeId_t NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxDomainRangeStartCompact_impl_init)(nvtxDomainHandle_t domain, nvtxStringHandle_t message, uint32_t category, int32_t payloadType, uint64_t payload){
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+        return nvtxDomainRangeStartCompact(domain, message, category, payloadType, payload);
+    (void)NVTX_ASYNC_START_DROPPED();
+    return (nvtxRangeId_t)0;
+}
+
+NVTX_LINKONCE_DEFINE_FUNCTION int NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxDomainRangePushCompact_impl_init)(nvtxDomainHandle_t domain, nvtxStringHandle_t message, uint32_t category, int32_t payloadType, uint64_t payload){
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)())
+        return nvtxDomainRangePushCompact(domain, message, category, payloadType, payload);
+    (void)NVTX_ASYNC_PUSH_DROPPED();
+    return (int)NVTX_NO_PUSH_POP_TRACKING;
+}
+
 NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxNameCuDeviceA_impl_init)(nvtx_CUdevice device, const char* name){
     nvtxNameCuDeviceA_fakeimpl_fntype local;
     NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
@@ -434,6 +471,45 @@ NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxDomain
         local(handle);
 }
 
+NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxDomainBatchSubmit_impl_init)(nvtxDomainHandle_t domain, nvtxBatchEvent_t* events, size_t count){
+    nvtxDomainBatchSubmit_impl_fntype local;
+    if (!NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)() || NVTX_EVENTS_PAUSED())
+        return;
+    local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainBatchSubmit_impl_fnptr;
+    if (local)
+        local(domain, events, count);
+    else
+        NVTX_VERSIONED_IDENTIFIER(nvtxBatchReplay)(domain, events, count);
+}
+
+NVTX_LINKONCE_DEFINE_FUNCTION nvtxCounterHandle_t NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxDomainCounterRegisterA_impl_init)(nvtxDomainHandle_t domain, const char* name, const char* unit){
+    nvtxDomainCounterRegisterA_impl_fntype local;
+    NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
+    local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainCounterRegisterA_impl_fnptr;
+    if (local) {
+        return local(domain, name, unit);
+    }
+    return (nvtxCounterHandle_t)0;
+}
+
+NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxCounterSampleInt64_impl_init)(nvtxCounterHandle_t counter, int64_t value){
+    nvtxCounterSampleInt64_impl_fntype local;
+    if (!NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)() || NVTX_EVENTS_PAUSED())
+        return;
+    local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxCounterSampleInt64_impl_fnptr;
+    if (local)
+        local(counter, value);
+}
+
+NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_API NVTX_VERSIONED_IDENTIFIER(nvtxCounterSampleDouble_impl_init)(nvtxCounterHandle_t counter, double value){
+    nvtxCounterSampleDouble_impl_fntype local;
+    if (!NVTX_VERSIONED_IDENTIFIER(nvtxTryInitOnce)() || NVTX_EVENTS_PAUSED())
+        return;
+    local = NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxCounterSampleDouble_impl_fnptr;
+    if (local)
+        local(counter, value);
+}
+
 NVTX_LINKONCE_FWDDECL_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxSetInitFunctionsToNoops)(int forceAllToNoops);
 NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxSetInitFunctionsToNoops)(int forceAllToNoops)
 {
@@ -557,6 +633,12 @@ NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxSetInitFunction
         NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainDestroy_impl_fnptr = NULL;
     if (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxInitialize_impl_fnptr == NVTX_VERSIONED_IDENTIFIER(nvtxInitialize_impl_init) || forceAllToNoops)
         NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxInitialize_impl_fnptr = NULL;
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainMarkCompact_impl_fnptr == NVTX_VERSIONED_IDENTIFIER(nvtxDomainMarkCompact_impl_init) || forceAllToNoops)
+        NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainMarkCompact_impl_fnptr = NULL;
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangeStartCompact_impl_fnptr == NVTX_VERSIONED_IDENTIFIER(nvtxDomainRangeStartCompact_impl_init) || forceAllToNoops)
+        NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangeStartCompact_impl_fnptr = NULL;
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangePushCompact_impl_fnptr == NVTX_VERSIONED_IDENTIFIER(nvtxDomainRangePushCompact_impl_init) || forceAllToNoops)
+        NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainRangePushCompact_impl_fnptr = NULL;
 
     if (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserCreate_impl_fnptr == NVTX_VERSIONED_IDENTIFIER(nvtxDomainSyncUserCreate_impl_init) || forceAllToNoops)
         NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserCreate_impl_fnptr = NULL;
@@ -570,4 +652,18 @@ NVTX_LINKONCE_DEFINE_FUNCTION void NVTX_VERSIONED_IDENTIFIER(nvtxSetInitFunction
         NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserAcquireSuccess_impl_fnptr = NULL;
     if (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserReleasing_impl_fnptr == NVTX_VERSIONED_IDENTIFIER(nvtxDomainSyncUserReleasing_impl_init) || forceAllToNoops)
         NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainSyncUserReleasing_impl_fnptr = NULL;
+
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainBatchSubmit_impl_fnptr == NVTX_VERSIONED_IDENTIFIER(nvtxDomainBatchSubmit_impl_init) || forceAllToNoops)
+        NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainBatchSubmit_impl_fnptr = NULL;
+
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainCounterRegisterA_impl_fnptr == NVTX_VERSIONED_IDENTIFIER(nvtxDomainCounterRegisterA_impl_init) || forceAllToNoops)
+        NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxDomainCounterRegisterA_impl_fnptr = NULL;
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxCounterSampleInt64_impl_fnptr == NVTX_VERSIONED_IDENTIFIER(nvtxCounterSampleInt64_impl_init) || forceAllToNoops)
+        NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxCounterSampleInt64_impl_fnptr = NULL;
+    if (NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxCounterSampleDouble_impl_fnptr == NVTX_VERSIONED_IDENTIFIER(nvtxCounterSampleDouble_impl_init) || forceAllToNoops)
+        NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).nvtxCounterSampleDouble_impl_fnptr = NULL;
+
+    /* Without the tool, its domain handles can no longer be assumed to carry flags */
+    if (forceAllToNoops)
+        NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).domainFlags = 0;
 }
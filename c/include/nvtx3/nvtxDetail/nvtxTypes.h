@@ -111,6 +111,9 @@ typedef nvtxDomainHandle_t (NVTX_API * nvtxDomainCreateA_impl_fntype)(const char
 typedef nvtxDomainHandle_t (NVTX_API * nvtxDomainCreateW_impl_fntype)(const wchar_t* message);
 typedef void (NVTX_API * nvtxDomainDestroy_impl_fntype)(nvtxDomainHandle_t domain);
 typedef void (NVTX_API * nvtxInitialize_impl_fntype)(const void* reserved);
+typedef void (NVTX_API * nvtxDomainMarkCompact_impl_fntype)(nvtxDomainHandle_t domain, nvtxStringHandle_t message, uint32_t category, int32_t payloadType, uint64_t payload);
+typedef nvtxRangeId_t (NVTX_API * nvtxDomainRangeStartCompact_impl_fntype)(nvtxDomainHandle_t domain, nvtxStringHandle_t message, uint32_t category, int32_t payloadType, uint64_t payload);
+typedef int (NVTX_API * nvtxDomainRangePushCompact_impl_fntype)(nvtxDomainHandle_t domain, nvtxStringHandle_t message, uint32_t category, int32_t payloadType, uint64_t payload);
 
 typedef nvtxSyncUser_t (NVTX_API * nvtxDomainSyncUserCreate_impl_fntype)(nvtxDomainHandle_t domain, const nvtxSyncUserAttributes_t* attribs);
 typedef void (NVTX_API * nvtxDomainSyncUserDestroy_impl_fntype)(nvtxSyncUser_t handle);
@@ -179,6 +182,9 @@ typedef enum NvtxCallbackIdCore2
     NVTX_CBID_CORE2_DomainCreateW           = 13,
     NVTX_CBID_CORE2_DomainDestroy           = 14,
     NVTX_CBID_CORE2_Initialize              = 15,
+    NVTX_CBID_CORE2_DomainMarkCompact       = 16,
+    NVTX_CBID_CORE2_DomainRangeStartCompact = 17,
+    NVTX_CBID_CORE2_DomainRangePushCompact  = 18,
     /* --- New constants must only be added directly above this line --- */
     NVTX_CBID_CORE2_SIZE,
     NVTX_CBID_CORE2_FORCE_INT               = 0x7fffffff
@@ -257,6 +263,9 @@ typedef enum NvtxExportTableID
     NVTX_ETID_CALLBACKS                    = 1,
     NVTX_ETID_RESERVED0                    = 2,
     NVTX_ETID_VERSIONINFO                  = 3,
+    NVTX_ETID_CALLSITES                    = 4,
+    NVTX_ETID_DOMAINS                      = 5,
+    NVTX_ETID_PAUSE                        = 6,
     /* --- New constants must only be added directly above this line --- */
     NVTX_ETID_SIZE,
     NVTX_ETID_FORCE_INT                    = 0x7fffffff
@@ -296,6 +305,88 @@ typedef struct NvtxExportTableVersionInfo
         uint32_t version);
 } NvtxExportTableVersionInfo;
 
+/* Description of one instrumented call site, such as a function annotated with
+*  NVTX3_FUNC_RANGE.  The NVTX C++ macros place one per site in the NVTX_CALL_SITE_SECTION
+*  section of the module containing the site, where tools find them with NVTX_ETID_CALLSITES. */
+typedef struct nvtxCallSite_t
+{
+    /* Name of the site's domain, or null for the default domain or a domain named by a wide string */
+    const char* domain;
+    const char* function;
+    const char* file;
+    uint32_t line;
+
+    /* The site makes no NVTX call while this is zero.  Tools may change it at any time;
+    *  a range begun at the site while it was nonzero still ends. */
+    volatile uint8_t enabled;
+} nvtxCallSite_t;
+
+/* Section holding the nvtxCallSite_t of a module, on platforms where the linker marks its
+*  bounds with __start_ and __stop_ symbols. */
+#if defined(__GNUC__) && defined(__ELF__)
+#define NVTX_CALL_SITE_SECTION "nvtxCallSites_v3"
+#endif
+
+typedef struct NvtxExportTableCallSites
+{
+    /* sizeof(NvtxExportTableCallSites) */
+    size_t struct_size;
+
+    /* Call sites of the module this NVTX instance belongs to, an array ending before end.
+    *  Both are null if the module has none or the platform does not collect them. */
+    nvtxCallSite_t* begin;
+    nvtxCallSite_t* end;
+} NvtxExportTableCallSites;
+
+/* Leading member of the struct a domain handle points to, for tools that call
+*  NvtxExportTableDomains::SetDomainFlagsSupported.  NVTX never dereferences the domain
+*  handles of other tools. */
+typedef struct nvtxDomainFlags_t
+{
+    /* The NVTX C++ API makes no call for events of the domain while this is nonzero.  Tools may
+    *  change it at any time; a range begun while it was zero still ends.  Tools must still
+    *  accept events of a disabled domain, such as those made through the C API. */
+    volatile uint32_t disabled;
+} nvtxDomainFlags_t;
+
+typedef struct NvtxExportTableDomains
+{
+    /* sizeof(NvtxExportTableDomains) */
+    size_t struct_size;
+
+    /* Called by a tool from InitializeInjectionNvtx2 if every handle its nvtxDomainCreateA and
+    *  nvtxDomainCreateW implementations return points to a struct beginning with an
+    *  nvtxDomainFlags_t.  Detaching the tool or a failed initialization withdraws the call. */
+    void (NVTX_API *SetDomainFlagsSupported)(void);
+} NvtxExportTableDomains;
+
+typedef struct NvtxExportTablePause
+{
+    /* sizeof(NvtxExportTablePause) */
+    size_t struct_size;
+
+    /* Pauses the events of every thread if paused is nonzero, and resumes them otherwise, like
+    *  nvtxPause and nvtxResume, which change the same state.  Tools may call it at any time. */
+    void (NVTX_API *SetPaused)(int paused);
+} NvtxExportTablePause;
+
+/* Entry points of a tool linked into the module, called directly by the domain event functions
+*  of NVTX instead of through the function table when the module is built with NVTX_DIRECT_TOOL
+*  defined.  The tool must define all five with external C linkage.  NVTX is initialized, and so
+*  the tool attached through InitializeInjectionNvtx2_fnptr, before the first call; a tool that
+*  failed to attach must still accept calls and should ignore them. */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+void NVTX_API nvtxDirectToolDomainMarkEx(nvtxDomainHandle_t domain, const nvtxEventAttributes_t* eventAttrib);
+nvtxRangeId_t NVTX_API nvtxDirectToolDomainRangeStartEx(nvtxDomainHandle_t domain, const nvtxEventAttributes_t* eventAttrib);
+void NVTX_API nvtxDirectToolDomainRangeEnd(nvtxDomainHandle_t domain, nvtxRangeId_t id);
+int NVTX_API nvtxDirectToolDomainRangePushEx(nvtxDomainHandle_t domain, const nvtxEventAttributes_t* eventAttrib);
+int NVTX_API nvtxDirectToolDomainRangePop(nvtxDomainHandle_t domain);
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
 
 
 
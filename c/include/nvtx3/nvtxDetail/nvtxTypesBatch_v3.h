@@ -0,0 +1,68 @@
+/*
+* Copyright 2009-2022  NVIDIA Corporation.  All rights reserved.
+*
+* Licensed under the Apache License v2.0 with LLVM Exceptions.
+* See https://llvm.org/LICENSE.txt for license information.
+* SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+*/
+
+/* Types of nvToolsExtBatch.h, also used by the core of nvtxImpl.h for the timestamped event
+*  functions.  They are kept out of nvtxTypes.h so that nvToolsExtBatch.h can be included after
+*  the core of an earlier NVTX version 3 header, which lacks them. */
+
+#ifndef NVTX_TYPES_BATCH_V3
+#define NVTX_TYPES_BATCH_V3
+
+/* Callback module of nvToolsExtBatch.h.  Not a constant of NvtxCallbackModule, whose size is
+*  part of the types earlier version 3 headers share. */
+#define NVTX_CB_MODULE_BATCH ((NvtxCallbackModule)7)
+
+typedef enum NvtxCallbackIdBatch
+{
+    NVTX_CBID_BATCH_INVALID                     = 0,
+    NVTX_CBID_BATCH_DomainBatchSubmit           = 1,
+    /* --- New constants must only be added directly above this line --- */
+    NVTX_CBID_BATCH_SIZE,
+    NVTX_CBID_BATCH_FORCE_INT                   = 0x7fffffff
+} NvtxCallbackIdBatch;
+
+/* Kinds of event in an nvtxBatchEvent_t, see nvToolsExtBatch.h */
+typedef enum nvtxBatchEventType_t
+{
+    NVTX_BATCH_EVENT_UNKNOWN               = 0,
+    NVTX_BATCH_EVENT_MARK                  = 1,
+    NVTX_BATCH_EVENT_RANGE_START           = 2,
+    NVTX_BATCH_EVENT_RANGE_END             = 3,
+    NVTX_BATCH_EVENT_RANGE_PUSH            = 4,
+    NVTX_BATCH_EVENT_RANGE_POP             = 5,
+    /* --- New constants must only be added directly above this line --- */
+    NVTX_BATCH_EVENT_FORCE_INT             = 0x7fffffff
+} nvtxBatchEventType_t;
+
+/* One event of a batch passed to nvtxDomainBatchSubmit, see nvToolsExtBatch.h.  The layout is
+*  fixed: a later version of the structure needs a new callback id. */
+typedef struct nvtxBatchEvent_v0
+{
+    /* Time of the event in the NVTX clock domain (see nvtxGetTimestamp), or 0 for the time of
+    *  the submission */
+    uint64_t timestamp;
+
+    /* Attributes of a mark, range start or push.  If null, the event has message and category
+    *  as its only attributes. */
+    const nvtxEventAttributes_t* attributes;
+    nvtxStringHandle_t message;
+
+    /* Set by nvtxDomainBatchSubmit for NVTX_BATCH_EVENT_RANGE_START, and read for
+    *  NVTX_BATCH_EVENT_RANGE_END */
+    nvtxRangeId_t rangeId;
+
+    /* One of nvtxBatchEventType_t; events of other types are ignored */
+    uint32_t type;
+    uint32_t category;
+} nvtxBatchEvent_v0;
+
+typedef struct nvtxBatchEvent_v0 nvtxBatchEvent_t;
+
+typedef void (NVTX_API * nvtxDomainBatchSubmit_impl_fntype)(nvtxDomainHandle_t domain, nvtxBatchEvent_t* events, size_t count);
+
+#endif /* NVTX_TYPES_BATCH_V3 */
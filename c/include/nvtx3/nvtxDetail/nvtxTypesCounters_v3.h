@@ -0,0 +1,37 @@
+/*
+* Copyright 2009-2022  NVIDIA Corporation.  All rights reserved.
+*
+* Licensed under the Apache License v2.0 with LLVM Exceptions.
+* See https://llvm.org/LICENSE.txt for license information.
+* SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+*/
+
+/* Types of nvToolsExtCounters.h, also used by the core of nvtxImpl.h for the function table
+*  of counters.  They are kept out of nvtxTypes.h for the same reason as nvtxTypesBatch_v3.h. */
+
+#ifndef NVTX_TYPES_COUNTERS_V3
+#define NVTX_TYPES_COUNTERS_V3
+
+/* Callback module of nvToolsExtCounters.h */
+#define NVTX_CB_MODULE_COUNTER ((NvtxCallbackModule)8)
+
+struct nvtxCounterRegistration_st;
+typedef struct nvtxCounterRegistration_st nvtxCounterRegistration;
+typedef nvtxCounterRegistration* nvtxCounterHandle_t;
+
+typedef nvtxCounterHandle_t (NVTX_API * nvtxDomainCounterRegisterA_impl_fntype)(nvtxDomainHandle_t domain, const char* name, const char* unit);
+typedef void (NVTX_API * nvtxCounterSampleInt64_impl_fntype)(nvtxCounterHandle_t counter, int64_t value);
+typedef void (NVTX_API * nvtxCounterSampleDouble_impl_fntype)(nvtxCounterHandle_t counter, double value);
+
+typedef enum NvtxCallbackIdCounter
+{
+    NVTX_CBID_COUNTER_INVALID                   = 0,
+    NVTX_CBID_COUNTER_DomainCounterRegisterA    = 1,
+    NVTX_CBID_COUNTER_CounterSampleInt64        = 2,
+    NVTX_CBID_COUNTER_CounterSampleDouble       = 3,
+    /* --- New constants must only be added directly above this line --- */
+    NVTX_CBID_COUNTER_SIZE,
+    NVTX_CBID_COUNTER_FORCE_INT                 = 0x7fffffff
+} NvtxCallbackIdCounter;
+
+#endif /* NVTX_TYPES_COUNTERS_V3 */
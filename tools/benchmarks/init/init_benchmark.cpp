@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+
+#include <nvtx3/nvToolsExt.h>
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+static double process_cpu_seconds()
+{
+  rusage u{};
+  getrusage(RUSAGE_SELF, &u);
+  return static_cast<double>(u.ru_utime.tv_sec + u.ru_stime.tv_sec) +
+         static_cast<double>(u.ru_utime.tv_usec + u.ru_stime.tv_usec) / 1e6;
+}
+
+/**
+ * Measure how long `state.range(0)` threads entering `nvtxInitOnce` together
+ * take to all return, and the CPU time the process spends meanwhile.  The tool
+ * in slow_tool.cpp makes initialization take a few milliseconds.  With a
+ * blocking wait the CPU time stays near zero however many threads wait; with
+ * a yield loop it grows with the thread count.
+ *
+ * Build with -DNVTX_SUPPORT_FUTEX_WAIT=0 (NVTX_INIT_YIELD_BENCH) to compare.
+ */
+static void BM_contended_init(::benchmark::State& state)
+{
+  auto const threads = static_cast<int>(state.range(0));
+  double cpu_seconds = 0;
+  for (auto _ : state) {
+    // Make the next call initialize NVTX again
+    NVTX_VERSIONED_IDENTIFIER(nvtxGlobals).initState = NVTX_INIT_STATE_FRESH;
+
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::chrono::steady_clock::time_point> done(threads);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+      workers.emplace_back([&, i] {
+        ready.fetch_add(1);
+        while (!go.load(std::memory_order_acquire)) { std::this_thread::yield(); }
+        NVTX_VERSIONED_IDENTIFIER(nvtxInitOnce)();
+        done[i] = std::chrono::steady_clock::now();
+      });
+    }
+    while (ready.load() != threads) { std::this_thread::yield(); }
+
+    double const cpu_start = process_cpu_seconds();
+    auto const start       = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& w : workers) { w.join(); }
+    cpu_seconds += process_cpu_seconds() - cpu_start;
+
+    auto const last = *std::max_element(done.begin(), done.end());
+    state.SetIterationTime(std::chrono::duration<double>(last - start).count());
+  }
+  state.counters["cpu_ms"] =
+    ::benchmark::Counter(cpu_seconds * 1e3, ::benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_contended_init)->RangeMultiplier(4)->Range(1, 128)->UseManualTime();
@@ -0,0 +1,23 @@
+/* Statically linked tool of the init benchmark.  Its own translation unit, because one
+ * that includes the NVTX implementation already holds the weak definition it replaces. */
+
+#define NVTX_NO_IMPL
+#include <nvtx3/nvToolsExt.h>
+
+#include <chrono>
+#include <thread>
+
+/**
+ * Time the tool takes to initialize, standing in for the dlopen of a real tool.
+ */
+static constexpr auto tool_load_time = std::chrono::milliseconds(2);
+
+static int NVTX_API slow_tool_init(NvtxGetExportTableFunc_t)
+{
+  std::this_thread::sleep_for(tool_load_time);
+  return 1;
+}
+
+extern "C" {
+NvtxInitializeInjectionNvtxFunc_t InitializeInjectionNvtx2_fnptr = slow_tool_init;
+}
@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "registry.hpp"
+#include "sink.hpp"
+#include "trace_format.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace nvtx_collector {
+
+namespace {
+
+/// Segments mapped at a time.  The file grows by this many segments whenever
+/// the mapped ones are all handed out.
+constexpr uint64_t segments_per_extent = 64;
+
+/**
+ * @brief Appends the entries of one table to a byte buffer.
+ */
+class table_writer {
+ public:
+  table_writer(std::vector<char>& out, trace_format::table_kind kind) : out_{out}, start_{out.size()}
+  {
+    trace_format::table_header h{kind, 0, 0};
+    append(&h, sizeof(h));
+  }
+
+  void add(uint32_t key, uint32_t key2, std::string const& name)
+  {
+    trace_format::table_entry e{key, key2, static_cast<uint32_t>(name.size()), 0};
+    std::size_t const end = out_.size() + trace_format::entry_size(e.length);
+    append(&e, sizeof(e));
+    append(name.data(), name.size());
+    out_.resize(end, '\0');  // NUL terminator and padding
+    ++count_;
+  }
+
+  ~table_writer()
+  {
+    trace_format::table_header h{};
+    std::memcpy(&h, out_.data() + start_, sizeof(h));
+    h.count = count_;
+    h.size  = out_.size() - start_ - sizeof(h);
+    std::memcpy(out_.data() + start_, &h, sizeof(h));
+  }
+
+ private:
+  void append(void const* p, std::size_t n)
+  {
+    char const* c = static_cast<char const*>(p);
+    out_.insert(out_.end(), c, c + n);
+  }
+
+  std::vector<char>& out_;
+  std::size_t start_;
+  uint32_t count_{0};
+};
+
+class binary_sink final : public sink {
+ public:
+  binary_sink(std::string const& path, registry const& reg, uint32_t segment_size)
+    : registry_{reg}, path_{path}, segment_size_{round_to_pages(segment_size)}
+  {
+    extent_size_     = segment_size_ * segments_per_extent;
+    segments_offset_ = segment_size_;  // Keeps every segment aligned for mmap
+    next_offset_     = segments_offset_;
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+      fail("cannot open");
+      return;
+    }
+    if (!write_header(0, 0, 0, 0)) { fail("cannot write"); }
+  }
+
+  ~binary_sink() override { finish(registry_); }
+
+  void write(thread_info const& thread, event_record const* events, std::size_t count) override
+  {
+    if (fd_ < 0) { return; }
+    if (thread.index >= segments_.size()) { segments_.resize(thread.index + 1u); }
+    open_segment& s = segments_[thread.index];
+    while (count > 0) {
+      if (!s.header || s.header->event_count == s.capacity) {
+        if (s.header) { release(s); }
+        if (!acquire(thread, s)) { return; }
+      }
+      std::size_t const n =
+        static_cast<std::size_t>(std::min<uint64_t>(count, s.capacity - s.header->event_count));
+      std::memcpy(s.records + s.header->event_count, events, n * sizeof(event_record));
+      s.header->event_count += n;
+      events += n;
+      count -= n;
+    }
+  }
+
+  void flush() override
+  {
+    for (extent const& x : extents_) {
+      if (x.base) { ::msync(x.base, extent_size_, MS_ASYNC); }
+    }
+  }
+
+  void close(registry const& reg) override { finish(reg); }
+
+ private:
+  struct extent {
+    char* base;       ///< Null once unmapped
+    uint64_t offset;  ///< File offset of `base`
+    uint32_t open;    ///< Segments of this extent still being filled
+  };
+
+  struct open_segment {
+    trace_format::segment_header* header{nullptr};
+    event_record* records{nullptr};
+    uint64_t capacity{0};
+    std::size_t extent{0};
+    uint32_t next_sequence{0};
+  };
+
+  static uint32_t round_to_pages(uint32_t size)
+  {
+    uint32_t const page = static_cast<uint32_t>(::sysconf(_SC_PAGESIZE));
+    size = std::max<uint32_t>(size, sizeof(trace_format::segment_header) + sizeof(event_record));
+    return (size + page - 1u) / page * page;
+  }
+
+  void fail(char const* what)
+  {
+    std::fprintf(stderr, "NVTX collector: %s '%s': %s\n", what, path_.c_str(), std::strerror(errno));
+    unmap_all();
+    if (fd_ >= 0) { ::close(fd_); }
+    fd_ = -1;
+  }
+
+  void unmap_all()
+  {
+    for (extent& e : extents_) {
+      if (e.base) { ::munmap(e.base, extent_size_); }
+      e.base = nullptr;
+    }
+    segments_.clear();
+  }
+
+  bool write_header(uint64_t segments_end, uint64_t tables_offset, uint64_t tables_size, uint32_t flags)
+  {
+    trace_format::file_header h{};
+    std::memcpy(h.magic, trace_format::magic, sizeof(h.magic));
+    h.version         = trace_format::version;
+    h.header_size     = sizeof(h);
+    h.record_size     = sizeof(event_record);
+    h.segment_size    = segment_size_;
+    h.segments_offset = segments_offset_;
+    h.segments_end    = segments_end;
+    h.tables_offset   = tables_offset;
+    h.tables_size     = tables_size;
+    h.flags           = flags;
+    h.pid             = static_cast<uint32_t>(::getpid());
+    return ::pwrite(fd_, &h, sizeof(h), 0) == static_cast<ssize_t>(sizeof(h));
+  }
+
+  /// Give `thread` the next unused segment, growing the file if needed.
+  bool acquire(thread_info const& thread, open_segment& s)
+  {
+    std::size_t const x = static_cast<std::size_t>((next_offset_ - segments_offset_) / extent_size_);
+    if (x == extents_.size()) {
+      uint64_t const offset = segments_offset_ + x * extent_size_;
+      void* base            = MAP_FAILED;
+      if (::ftruncate(fd_, static_cast<off_t>(offset + extent_size_)) == 0) {
+        base = ::mmap(nullptr, extent_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_,
+                      static_cast<off_t>(offset));
+      }
+      if (base == MAP_FAILED) {
+        fail("cannot extend");
+        return false;
+      }
+      extents_.push_back(extent{static_cast<char*>(base), offset, 0});
+      if (x > 0) { retire(x - 1); }
+    }
+
+    char* p     = extents_[x].base + (next_offset_ - extents_[x].offset);
+    s.header    = reinterpret_cast<trace_format::segment_header*>(p);
+    s.records   = reinterpret_cast<event_record*>(p + sizeof(trace_format::segment_header));
+    s.capacity  = trace_format::segment_capacity(segment_size_);
+    s.extent    = x;
+    *s.header   = trace_format::segment_header{
+      trace_format::segment_magic, thread.index, thread.os_tid, s.next_sequence++, 0, 0};
+    extents_[x].open++;
+    next_offset_ += segment_size_;
+    return true;
+  }
+
+  void release(open_segment& s)
+  {
+    extents_[s.extent].open--;
+    retire(s.extent);
+    s.header  = nullptr;
+    s.records = nullptr;
+  }
+
+  /// Unmap extent `x` once all its segments are handed out and full, which
+  /// lets the kernel write it back and reclaim its pages.
+  void retire(std::size_t x)
+  {
+    extent& e = extents_[x];
+    if (e.base && e.open == 0 && next_offset_ >= e.offset + extent_size_) {
+      ::munmap(e.base, extent_size_);
+      e.base = nullptr;
+    }
+  }
+
+  void finish(registry const& reg)
+  {
+    if (fd_ < 0) { return; }
+    unmap_all();
+
+    std::vector<char> tables;
+    {
+      table_writer t(tables, trace_format::table_kind::strings);
+      std::vector<std::string> const strings = reg.strings();
+      for (std::size_t id = 1; id < strings.size(); ++id) {
+        t.add(static_cast<uint32_t>(id), 0, strings[id]);
+      }
+    }
+    {
+      table_writer t(tables, trace_format::table_kind::domains);
+      for (auto const& d : reg.domains()) { t.add(d.id, 0, d.name); }
+    }
+    {
+      table_writer t(tables, trace_format::table_kind::categories);
+      for (auto const& c : reg.categories()) { t.add(c.domain, c.category, c.name); }
+    }
+    {
+      table_writer t(tables, trace_format::table_kind::thread_names);
+      for (auto const& n : reg.thread_names()) { t.add(n.os_tid, 0, n.name); }
+    }
+    {
+      table_writer t(tables, trace_format::table_kind::counters);
+      for (auto const& c : reg.counters()) { t.add(c.domain, c.name, c.unit); }
+    }
+
+    uint64_t const end = next_offset_;
+    bool ok = ::ftruncate(fd_, static_cast<off_t>(end)) == 0 &&
+              ::pwrite(fd_, tables.data(), tables.size(), static_cast<off_t>(end)) ==
+                static_cast<ssize_t>(tables.size()) &&
+              write_header(end, end, tables.size(), trace_format::file_complete);
+    if (!ok) {
+      fail("cannot finish");
+      return;
+    }
+    ::close(fd_);
+    fd_ = -1;
+  }
+
+  registry const& registry_;
+  std::string path_;
+  int fd_{-1};
+  uint32_t segment_size_;
+  uint64_t extent_size_{0};
+  uint64_t segments_offset_{0};
+  uint64_t next_offset_{0};  ///< File offset of the next segment to hand out
+  std::vector<extent> extents_;
+  std::vector<open_segment> segments_;  ///< Indexed by `thread_info::index`
+};
+
+}  // namespace
+
+std::unique_ptr<sink> make_binary_sink(std::string const& path,
+                                       registry const& reg,
+                                       uint32_t segment_size)
+{
+  return std::unique_ptr<sink>(new binary_sink(path, reg, segment_size));
+}
+
+}  // namespace nvtx_collector
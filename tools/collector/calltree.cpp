@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "calltree.hpp"
+
+#include "collector_impl.hpp"
+#include "handlers.hpp"
+#include "sampling.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <deque>
+
+namespace nvtx_collector {
+
+namespace {
+
+/// Index of no node in a thread's arena.
+constexpr uint32_t no_node = UINT32_MAX;
+
+/**
+ * @brief Call path of one thread: a range and the ranges open around it.
+ *
+ * Nodes refer to each other by arena index.  Children form a singly linked
+ * list, newest first.
+ */
+struct tree_node {
+  tree_node(range_key const& k, uint32_t p) noexcept : key{k}, parent{p} {}
+
+  range_key key;
+  uint32_t parent;
+  uint32_t first_child{no_node};
+  uint32_t next_sibling{no_node};
+
+  shard_counter count{0};
+  shard_counter inclusive{0};
+  shard_counter children{0};  ///< Inclusive time of the children, as they were left
+};
+
+/// A push/pop range waiting for its pop.
+struct open_frame {
+  uint32_t node;
+  uint16_t domain;
+  uint64_t start;
+};
+
+/**
+ * @brief Call tree of one thread.
+ *
+ * Only the owning thread adds nodes or updates counters.  Nodes are appended
+ * to `nodes` and linked under `mutex`, which the report also takes while
+ * walking the tree, so the owner's walks need no lock.  A deque never moves
+ * its elements, so the counters can be read while nodes are appended.
+ *
+ * Ranges of all domains share one stack, so the tree shows how the domains
+ * nest; `nvtxDomainRangePop` closes the innermost open range of its domain.
+ */
+struct calltree_thread {
+  explicit calltree_thread(registry& reg) : strings{reg}
+  {
+    nodes.emplace_back(range_key{}, no_node);
+  }
+
+  string_cache strings;
+  std::mutex mutex;
+  std::deque<tree_node> nodes;  ///< Node 0 is the root: outside any range
+  std::vector<open_frame> stack;
+
+  /// Number of open ranges on `stack`, indexed by domain id.
+  std::vector<int> depths;
+
+  std::atomic<bool> exited{false};
+
+  /// The child of `parent` for `key`, added if new.
+  uint32_t child(uint32_t parent, range_key const& key)
+  {
+    for (uint32_t c = nodes[parent].first_child; c != no_node; c = nodes[c].next_sibling) {
+      if (NVTX_COLLECTOR_LIKELY(nodes[c].key == key)) { return c; }
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    auto const c = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back(key, parent);
+    nodes[c].next_sibling     = nodes[parent].first_child;
+    nodes[parent].first_child = c;
+    return c;
+  }
+
+  int& depth_of(uint16_t domain)
+  {
+    if (NVTX_COLLECTOR_UNLIKELY(domain >= depths.size())) { depths.resize(domain + 1u, 0); }
+    return depths[domain];
+  }
+};
+
+struct calltree_state {
+  /// Guards `threads` and `retired`.
+  std::mutex mutex;
+  std::vector<std::unique_ptr<calltree_thread>> threads;
+
+  /// Trees of threads that have exited, already merged.  Holds the children
+  /// time in `exclusive_ns` until the report computes it.
+  call_tree_node retired{};
+};
+
+calltree_state* g_calltree = nullptr;
+thread_local calltree_thread* tls_calltree = nullptr;
+
+struct calltree_exit_guard {
+  ~calltree_exit_guard()
+  {
+    if (tls_calltree) {
+      tls_calltree->exited.store(true, std::memory_order_release);
+      tls_calltree = nullptr;
+    }
+  }
+};
+
+thread_local calltree_exit_guard tls_calltree_exit_guard;
+
+/**
+ * @brief Add the subtree of `t` below `node` to the children of `into`.
+ *
+ * Children are matched by key, so threads that took the same path share a
+ * node.  Children time is summed into `exclusive_ns`; see `finish`.
+ */
+void merge_children(calltree_thread const& t, uint32_t node, call_tree_node& into)
+{
+  for (uint32_t c = t.nodes[node].first_child; c != no_node; c = t.nodes[c].next_sibling) {
+    tree_node const& n = t.nodes[c];
+    auto it = std::find_if(into.children.begin(), into.children.end(), [&](call_tree_node const& m) {
+      return range_key{m.message, m.category, m.domain} == n.key;
+    });
+    if (it == into.children.end()) {
+      into.children.push_back(
+        call_tree_node{n.key.domain, n.key.message, n.key.category, 0, 0, 0, {}});
+      it = std::prev(into.children.end());
+    }
+    it->count += n.count.load(std::memory_order_relaxed);
+    it->inclusive_ns += n.inclusive.load(std::memory_order_relaxed);
+    it->exclusive_ns += n.children.load(std::memory_order_relaxed);
+    merge_children(t, c, *it);
+  }
+}
+
+/// Turn the children time of merged nodes into exclusive time and sort.
+void finish(call_tree_node& node)
+{
+  uint64_t const children = node.exclusive_ns;
+  node.exclusive_ns       = node.inclusive_ns > children ? node.inclusive_ns - children : 0;
+  for (call_tree_node& c : node.children) { finish(c); }
+  std::sort(node.children.begin(),
+            node.children.end(),
+            [](call_tree_node const& a, call_tree_node const& b) {
+              return a.inclusive_ns > b.inclusive_ns;
+            });
+}
+
+/// Fold the trees of exited threads into `retired`.  Caller holds `s.mutex`.
+void retire_exited(calltree_state& s)
+{
+  auto keep = s.threads.begin();
+  for (auto& t : s.threads) {
+    if (t->exited.load(std::memory_order_acquire)) {
+      merge_children(*t, 0, s.retired);
+    } else {
+      *keep++ = std::move(t);
+    }
+  }
+  s.threads.erase(keep, s.threads.end());
+}
+
+calltree_thread& register_calltree_thread()
+{
+  calltree_thread* t = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(g_calltree->mutex);
+    retire_exited(*g_calltree);
+    g_calltree->threads.emplace_back(new calltree_thread(g_state->names));
+    t = g_calltree->threads.back().get();
+  }
+  (void)&tls_calltree_exit_guard;  // Construct the guard so its destructor runs at thread exit
+  tls_calltree = t;
+  return *t;
+}
+
+inline calltree_thread& current_calltree_thread()
+{
+  calltree_thread* t = tls_calltree;
+  if (NVTX_COLLECTOR_LIKELY(t != nullptr)) { return *t; }
+  return register_calltree_thread();
+}
+
+/**
+ * @brief Event primitives of the call-tree mode: push/pop ranges update the
+ * node of their call path when they are popped; no event is stored.
+ */
+struct calltree_mode {
+  /// Marks have no duration and are not counted.
+  template <typename Message>
+  static void mark(uint16_t, Message const*, nvtxEventAttributes_t const*, uint64_t)
+  {
+  }
+
+  /// Start/end ranges need not nest, so they have no place in a call tree.
+  template <typename Message>
+  static nvtxRangeId_t range_start(uint16_t,
+                                   Message const*,
+                                   nvtxEventAttributes_t const*,
+                                   uint64_t)
+  {
+    return 0;
+  }
+
+  static void range_end(uint16_t, nvtxRangeId_t, uint64_t) {}
+
+  template <typename Message>
+  static int range_push(uint16_t domain,
+                        Message const* message,
+                        nvtxEventAttributes_t const* attr,
+                        uint64_t time)
+  {
+    calltree_thread& t    = current_calltree_thread();
+    uint32_t const parent = t.stack.empty() ? 0 : t.stack.back().node;
+    uint32_t const node   = t.child(parent, key_of(domain, t.strings, message, attr));
+    t.stack.push_back(open_frame{node, domain, 0});
+    t.stack.back().start = event_time(time);
+    return t.depth_of(domain)++;
+  }
+
+  static int range_pop(uint16_t domain, uint64_t time)
+  {
+    uint64_t const end = event_time(time);
+    calltree_thread& t = current_calltree_thread();
+    auto frame         = t.stack.rbegin();
+    while (frame != t.stack.rend() && frame->domain != domain) { ++frame; }
+    if (frame == t.stack.rend()) { return -1; }
+
+    tree_node& n            = t.nodes[frame->node];
+    uint64_t const duration = end - frame->start;
+    bump(n.count, 1);
+    bump(n.inclusive, duration);
+    bump(t.nodes[n.parent].children, duration);
+    t.stack.erase(std::prev(frame.base()));
+    return --t.depth_of(domain);
+  }
+};
+
+void create_calltree_state() { g_calltree = new calltree_state; }
+
+void write_node(std::FILE* f,
+                call_tree_node const& node,
+                unsigned indent,
+                registry const& reg,
+                std::vector<registry::domain_entry> const& domains)
+{
+  auto us            = [](uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+  char const* domain = node.domain < domains.size() ? domains[node.domain].name.c_str() : "";
+  std::fprintf(f,
+               "%14.3f %14.3f %12" PRIu64 "  %*s%s:%" PRIu32 ":%s\n",
+               us(node.inclusive_ns),
+               us(node.exclusive_ns),
+               node.count,
+               static_cast<int>(2 * indent),
+               "",
+               domain,
+               node.category,
+               reg.lookup(node.message));
+  for (call_tree_node const& c : node.children) { write_node(f, c, indent + 1, reg, domains); }
+}
+
+}  // namespace
+
+void install_calltree_handlers(module_tables const& tables)
+{
+  static std::once_flag created;
+  std::call_once(created, create_calltree_state);
+  install_mode_handlers<calltree_mode>(g_state->opts, tables);
+}
+
+call_tree_node call_tree()
+{
+  call_tree_node root{};
+  if (!g_calltree) { return root; }
+  {
+    std::lock_guard<std::mutex> lock(g_calltree->mutex);
+    root = g_calltree->retired;
+    for (auto const& t : g_calltree->threads) {
+      std::lock_guard<std::mutex> nodes_lock(t->mutex);
+      merge_children(*t, 0, root);
+    }
+  }
+  finish(root);
+  root.exclusive_ns = 0;
+  return root;
+}
+
+void write_calltree_report(std::string const& path, registry const& reg)
+{
+  std::FILE* f = path == "-" ? stdout : std::fopen(path.c_str(), "w");
+  if (!f) {
+    std::fprintf(stderr, "NVTX collector: cannot open '%s', writing to stdout\n", path.c_str());
+    f = stdout;
+  }
+
+  std::vector<registry::domain_entry> const domains = reg.domains();
+  std::fprintf(
+    f, "%14s %14s %12s  %s\n", "inclusive_us", "exclusive_us", "count", "domain:category:name");
+  for (call_tree_node const& c : call_tree().children) { write_node(f, c, 0, reg, domains); }
+  if (f != stdout) {
+    std::fclose(f);
+  } else {
+    std::fflush(f);
+  }
+}
+
+}  // namespace nvtx_collector
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* Call-tree mode of the collector (NVTX_COLLECTOR_MODE=calltree).  Not installed. */
+
+#pragma once
+
+#include "registry.hpp"
+
+#include <nvtx3/nvToolsExt.h>
+
+#include <string>
+
+namespace nvtx_collector {
+
+struct module_tables;
+
+/**
+ * @brief Point the NVTX event slots at the call-tree mode.
+ */
+void install_calltree_handlers(module_tables const& tables);
+
+/**
+ * @brief Write `call_tree()` as an indented table to `path` ("-" for stdout).
+ */
+void write_calltree_report(std::string const& path, registry const& reg);
+
+}  // namespace nvtx_collector
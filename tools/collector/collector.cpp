@@ -0,0 +1,1085 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "calltree.hpp"
+#include "collector_impl.hpp"
+#include "flight.hpp"
+#include "handlers.hpp"
+#include "sampling.hpp"
+#include "stats.hpp"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace nvtx_collector {
+
+collector_state* g_state = nullptr;
+thread_local thread_state* tls_thread = nullptr;
+
+namespace {
+
+/* ---- Configuration ---- */
+
+std::size_t env_size(char const* name, std::size_t fallback)
+{
+  char const* v = std::getenv(name);
+  if (!v || !*v) { return fallback; }
+  char* end = nullptr;
+  unsigned long long const n = std::strtoull(v, &end, 10);
+  return (end && *end == '\0' && n > 0) ? static_cast<std::size_t>(n) : fallback;
+}
+
+double env_fraction(char const* name, double fallback)
+{
+  char const* v = std::getenv(name);
+  if (!v || !*v) { return fallback; }
+  char* end      = nullptr;
+  double const x = std::strtod(v, &end);
+  return (end && *end == '\0' && x >= 0.0 && x <= 1.0) ? x : fallback;
+}
+
+/// Items of the comma-separated environment variable `name`, empty ones skipped.
+std::vector<std::string> env_list(char const* name)
+{
+  std::vector<std::string> items;
+  char const* v = std::getenv(name);
+  if (!v) { return items; }
+  for (char const* p = v;; ++p) {
+    char const* end = std::strchr(p, ',');
+    if (!end) { end = p + std::strlen(p); }
+    if (end != p) { items.emplace_back(p, end); }
+    if (*end == '\0') { break; }
+    p = end;
+  }
+  return items;
+}
+
+/* ---- Call sites ---- */
+
+/// Whether `pattern` names `site`: its function, or its `file:line` with
+/// `file` matching the site's path or a trailing part of it.
+bool site_matches(std::string const& pattern, nvtxCallSite_t const& site)
+{
+  if (site.function && pattern == site.function) { return true; }
+  std::size_t const colon = pattern.rfind(':');
+  if (colon == std::string::npos || !site.file) { return false; }
+  if (pattern.compare(colon + 1, std::string::npos, std::to_string(site.line)) != 0) {
+    return false;
+  }
+  std::size_t const file_len = std::strlen(site.file);
+  if (colon > file_len) { return false; }
+  char const* tail = site.file + (file_len - colon);
+  return pattern.compare(0, colon, tail) == 0 &&
+         (colon == file_len || tail[-1] == '/' || tail[-1] == '\\');
+}
+
+/// Remember the call sites of one NVTX instance and apply `opts.disabled_sites`.
+void add_call_sites(collector_state& s, NvtxGetExportTableFunc_t get_export_table)
+{
+  auto const* sites =
+    static_cast<NvtxExportTableCallSites const*>(get_export_table(NVTX_ETID_CALLSITES));
+  if (!sites || sites->struct_size < sizeof(NvtxExportTableCallSites) ||
+      sites->begin == sites->end) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(s.sites_mutex);
+  for (auto const& t : s.site_tables) {
+    if (t.begin == sites->begin) { return; }
+  }
+  s.site_tables.push_back(*sites);
+  for (nvtxCallSite_t* site = sites->begin; site != sites->end; ++site) {
+    for (auto const& pattern : s.opts.disabled_sites) {
+      if (site_matches(pattern, *site)) { site->enabled = 0; }
+    }
+  }
+}
+
+/// Remember the pause table of one NVTX instance and apply the current pause state.
+void add_pause_table(collector_state& s, NvtxGetExportTableFunc_t get_export_table)
+{
+  auto const* pause = static_cast<NvtxExportTablePause const*>(get_export_table(NVTX_ETID_PAUSE));
+  if (!pause || pause->struct_size < sizeof(NvtxExportTablePause) || !pause->SetPaused) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(s.pause_mutex);
+  s.pause_tables.push_back(*pause);
+  if (s.paused) { pause->SetPaused(1); }
+}
+
+/* ---- Thread registration ---- */
+
+void store_held_samples(thread_state& t);
+
+/// Marks the thread's state as exited so the drain thread can reclaim it.
+struct thread_exit_guard {
+  ~thread_exit_guard()
+  {
+    if (tls_thread) {
+      store_held_samples(*tls_thread);
+      if (tls_thread->live) { tls_thread->live->release(); }
+      tls_thread->exited.store(true, std::memory_order_release);
+      tls_thread = nullptr;
+    }
+  }
+};
+
+thread_local thread_exit_guard tls_exit_guard;
+
+uint32_t os_thread_id() { return static_cast<uint32_t>(::syscall(SYS_gettid)); }
+
+/// Free the states of exited threads in live mode; their rings were released
+/// at exit and nothing is left to drain.  Caller holds `s.threads_mutex`.
+void retire_live_threads(collector_state& s)
+{
+  for (auto it = s.threads.begin(); it != s.threads.end();) {
+    if ((*it)->exited.load(std::memory_order_acquire)) {
+      s.retired_dropped += (*it)->dropped.load(std::memory_order_relaxed);
+      it = s.threads.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+/* ---- Draining ---- */
+
+/// Write the counter samples `t` holds whose interval has ended, or all of
+/// them if `all`, so a thread recording nothing more still shows its last
+/// values.  Caller holds `sink_mutex`.
+void drain_held_samples(collector_state& s, thread_state& t, bool all)
+{
+  uint64_t const now = now_ns();
+  std::lock_guard<std::mutex> lock(t.counters_mutex);
+  for (auto const& slot : t.counters) {
+    if (!all && slot->next.load(std::memory_order_relaxed) > now) { continue; }
+    if (!slot->holding.exchange(false, std::memory_order_acquire)) { continue; }
+    uint32_t const version = slot->version.load(std::memory_order_acquire);
+    event_record const e   = slot->held();
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // Rewritten meanwhile: the owner holds a newer sample in its place
+    if ((version & 1u) != 0 || slot->version.load(std::memory_order_relaxed) != version) {
+      continue;
+    }
+    if (s.out) { s.out->write(t.info, &e, 1); }
+    ++s.written;
+  }
+}
+
+/// Move every pending event to the sink, with the held counter samples whose
+/// interval has ended, or all of them if `all_held`.  Caller holds `sink_mutex`.
+void drain_locked(collector_state& s, bool all_held = true)
+{
+  std::vector<thread_state*> live;
+  {
+    std::lock_guard<std::mutex> lock(s.threads_mutex);
+    live.reserve(s.threads.size());
+    for (auto const& t : s.threads) { live.push_back(t.get()); }
+  }
+
+  for (thread_state* t : live) {
+    // Read `exited` before draining: once set, the owner records nothing more,
+    // so an empty ring afterwards means the state can be reclaimed.
+    bool const exited = t->exited.load(std::memory_order_acquire);
+    s.written += t->events.consume([&](event_record const* e, std::size_t n) {
+      if (s.out) { s.out->write(t->info, e, n); }
+    });
+    if (s.opts.mode == collector_mode::trace) { drain_held_samples(s, *t, all_held); }
+    // The flight recorder keeps exited threads for later dumps
+    if (exited && s.opts.mode != collector_mode::flight) {
+      std::lock_guard<std::mutex> lock(s.threads_mutex);
+      s.retired_dropped += t->dropped.load(std::memory_order_relaxed);
+      for (auto it = s.threads.begin(); it != s.threads.end(); ++it) {
+        if (it->get() == t) {
+          s.threads.erase(it);
+          break;
+        }
+      }
+    }
+  }
+  if (s.out) { s.out->flush(); }
+}
+
+void drain_loop(collector_state& s)
+{
+  std::unique_lock<std::mutex> lock(s.drain_mutex);
+  while (!s.stopping) {
+    s.drain_cv.wait_for(lock, std::chrono::milliseconds(s.opts.flush_interval_ms));
+    if (s.stopping) { break; }
+    lock.unlock();
+    {
+      std::lock_guard<std::mutex> sink_lock(s.sink_mutex);
+      drain_locked(s, false);
+    }
+    lock.lock();
+  }
+}
+
+/* ---- Event construction ---- */
+
+inline event_record make_event(event_type type, uint16_t domain) noexcept
+{
+  event_record e;
+  std::memset(&e, 0, sizeof(e));
+  e.type   = type;
+  e.domain = domain;
+  return e;
+}
+
+void apply_attributes(event_record& e, thread_state& t, nvtxEventAttributes_t const* a)
+{
+  if (!a) { return; }
+  e.message  = message_id<char>(t.strings, nullptr, a);
+  e.category = a->category;
+  if (a->colorType == NVTX_COLOR_ARGB) { e.color = a->color; }
+  switch (a->payloadType) {
+    case NVTX_PAYLOAD_TYPE_UNSIGNED_INT64:
+    case NVTX_PAYLOAD_TYPE_INT64:
+    case NVTX_PAYLOAD_TYPE_DOUBLE: e.payload = a->payload.ullValue; break;
+    case NVTX_PAYLOAD_TYPE_UNSIGNED_INT32:
+    case NVTX_PAYLOAD_TYPE_INT32:
+    case NVTX_PAYLOAD_TYPE_FLOAT: e.payload = a->payload.uiValue; break;
+    default: return;
+  }
+  e.payload_type = static_cast<uint8_t>(a->payloadType);
+}
+
+void apply_compact(event_record& e, compact_event const& c)
+{
+  e.message  = c.message ? c.message->id : 0;
+  e.category = c.category;
+  switch (c.payload_type) {
+    case NVTX_PAYLOAD_TYPE_UNSIGNED_INT64:
+    case NVTX_PAYLOAD_TYPE_INT64:
+    case NVTX_PAYLOAD_TYPE_DOUBLE: e.payload = c.payload; break;
+    case NVTX_PAYLOAD_TYPE_UNSIGNED_INT32:
+    case NVTX_PAYLOAD_TYPE_INT32:
+    case NVTX_PAYLOAD_TYPE_FLOAT: e.payload = static_cast<uint32_t>(c.payload); break;
+    default: return;
+  }
+  e.payload_type = static_cast<uint8_t>(c.payload_type);
+}
+
+/* ---- Recording ---- */
+
+/// Set the message of `e` from the NVTX call's arguments.
+template <typename Message>
+void describe(event_record& e,
+              thread_state& t,
+              Message const* message,
+              nvtxEventAttributes_t const* attr)
+{
+  if (attr) {
+    apply_attributes(e, t, attr);
+  } else {
+    e.message = t.strings.intern(message);
+  }
+}
+
+inline void describe(event_record& e,
+                     thread_state&,
+                     compact_event const* c,
+                     nvtxEventAttributes_t const*)
+{
+  apply_compact(e, *c);
+}
+
+template <typename Store>
+void store_due_samples(thread_state& t, uint64_t now) noexcept;
+
+/// Storage of the tracing mode: the ring emptied by the drain thread.
+struct drained_store {
+  static void store(thread_state& t, event_record const& e) noexcept
+  {
+    if (NVTX_COLLECTOR_UNLIKELY(e.timestamp >= t.held_due)) {
+      store_due_samples<drained_store>(t, e.timestamp);
+    }
+    t.record(e);
+  }
+};
+
+/// Storage of the flight recorder: the ring copied by `dump`.
+struct flight_store {
+  static void store(thread_state& t, event_record const& e) noexcept
+  {
+    if (NVTX_COLLECTOR_UNLIKELY(e.timestamp >= t.held_due)) {
+      store_due_samples<flight_store>(t, e.timestamp);
+    }
+    t.recent->push(e);
+  }
+};
+
+/// Storage of the live mode: the ring in shared memory.
+struct live_store {
+  static void store(thread_state& t, event_record const& e) noexcept
+  {
+    if (NVTX_COLLECTOR_UNLIKELY(e.timestamp >= t.held_due)) {
+      store_due_samples<live_store>(t, e.timestamp);
+    }
+    if (NVTX_COLLECTOR_UNLIKELY(!t.live || !t.live->try_push(e))) {
+      t.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+};
+
+/// Store, ahead of an event at `now`, the held counter samples whose interval
+/// has ended by then.  Called by the owning thread.
+template <typename Store>
+void store_due_samples(thread_state& t, uint64_t now) noexcept
+{
+  t.held_due = UINT64_MAX;
+  for (auto const& slot : t.counters) {
+    if (!slot->holding.load(std::memory_order_relaxed)) { continue; }
+    uint64_t const next = slot->next.load(std::memory_order_relaxed);
+    if (next > now) {
+      t.held_due = std::min(t.held_due, next);
+    } else if (slot->holding.exchange(false, std::memory_order_acquire)) {
+      Store::store(t, slot->held());
+    }
+  }
+}
+
+/**
+ * @brief Event primitives of the recording modes: every event becomes an
+ * `event_record` in one of the calling thread's rings, chosen by `Store`.
+ */
+template <typename Store>
+struct recording_mode {
+  template <typename Message>
+  static void mark(uint16_t domain,
+                   Message const* message,
+                   nvtxEventAttributes_t const* attr,
+                   uint64_t time)
+  {
+    thread_state& t = current_thread();
+    event_record e  = make_event(event_type::mark, domain);
+    e.timestamp     = event_time(time);
+    describe(e, t, message, attr);
+    Store::store(t, e);
+  }
+
+  template <typename Message>
+  static nvtxRangeId_t range_start(uint16_t domain,
+                                   Message const* message,
+                                   nvtxEventAttributes_t const* attr,
+                                   uint64_t time)
+  {
+    thread_state& t = current_thread();
+    event_record e  = make_event(event_type::range_start, domain);
+    e.timestamp     = event_time(time);
+    describe(e, t, message, attr);
+    e.range_id = (static_cast<uint64_t>(t.info.index + 1) << 40) | ++t.next_range;
+    Store::store(t, e);
+    return e.range_id;
+  }
+
+  static void range_end(uint16_t domain, nvtxRangeId_t id, uint64_t time)
+  {
+    thread_state& t = current_thread();
+    event_record e  = make_event(event_type::range_end, domain);
+    e.timestamp     = event_time(time);
+    e.range_id      = id;
+    Store::store(t, e);
+  }
+
+  template <typename Message>
+  static int range_push(uint16_t domain,
+                        Message const* message,
+                        nvtxEventAttributes_t const* attr,
+                        uint64_t time)
+  {
+    thread_state& t = current_thread();
+    event_record e  = make_event(event_type::push, domain);
+    e.timestamp     = event_time(time);
+    describe(e, t, message, attr);
+    Store::store(t, e);
+    return static_cast<int>(t.depth_of(domain)++);
+  }
+
+  static int range_pop(uint16_t domain, uint64_t time)
+  {
+    thread_state& t = current_thread();
+    uint32_t& depth = t.depth_of(domain);
+    if (depth == 0) { return -1; }
+    event_record e = make_event(event_type::pop, domain);
+    e.timestamp    = event_time(time);
+    Store::store(t, e);
+    return static_cast<int>(--depth);
+  }
+};
+
+using trace_mode  = recording_mode<drained_store>;
+using flight_mode = recording_mode<flight_store>;
+using live_mode   = recording_mode<live_store>;
+
+/**
+ * @brief Counter entry points of the recording modes.
+ *
+ * A thread stores the first sample of a counter in each interval of
+ * `options::counter_interval_ns` and holds the later ones, keeping only the
+ * last.  The held sample is stored once its interval has ended, ahead of the
+ * next event of the thread, when the thread exits, or, in the tracing mode,
+ * by the drain thread.  A burst of samples thus costs two events: its first
+ * value and the value the counter was left at.
+ */
+template <typename Store>
+struct counter_entry_points {
+  static void sample(nvtxCounterHandle_t c, uint64_t value, nvtxPayloadType_t type)
+  {
+    if (NVTX_COLLECTOR_UNLIKELY(!c)) { return; }
+    thread_state& t = current_thread();
+    event_record e  = make_event(event_type::counter, c->domain);
+    e.timestamp     = now_ns();
+    e.message       = c->name;
+    e.payload       = value;
+    e.payload_type  = static_cast<uint8_t>(type);
+    thread_state::counter_slot& slot = t.counter_of(c->index);
+    uint64_t const next              = slot.next.load(std::memory_order_relaxed);
+    if (e.timestamp < next) {
+      // The sample held so far is superseded
+      slot.holding.store(false, std::memory_order_relaxed);
+      slot.hold(e);
+      slot.holding.store(true, std::memory_order_release);
+      t.held_due = std::min(t.held_due, next);
+      return;
+    }
+    // Stores the held sample of this counter first, its interval having ended
+    Store::store(t, e);
+    slot.next.store(e.timestamp + g_state->opts.counter_interval_ns, std::memory_order_relaxed);
+  }
+
+  static void NVTX_API SampleInt64(nvtxCounterHandle_t c, int64_t value)
+  {
+    sample(c, static_cast<uint64_t>(value), NVTX_PAYLOAD_TYPE_INT64);
+  }
+  static void NVTX_API SampleDouble(nvtxCounterHandle_t c, double value)
+  {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    sample(c, bits, NVTX_PAYLOAD_TYPE_DOUBLE);
+  }
+};
+
+/// Store the samples `t` still holds; called when the thread exits.
+void store_held_samples(thread_state& t)
+{
+  for (auto const& slot : t.counters) {
+    if (!slot->holding.exchange(false, std::memory_order_acquire)) { continue; }
+    switch (g_state->opts.mode) {
+      case collector_mode::flight: flight_store::store(t, slot->held()); break;
+      case collector_mode::live: live_store::store(t, slot->held()); break;
+      default: drained_store::store(t, slot->held()); break;
+    }
+  }
+}
+
+/**
+ * @brief Tracing mode that keeps only ranges lasting at least
+ * `options::min_duration_ns`.
+ *
+ * A push is held on the thread's stack for its domain until its pop.  A range
+ * that lasted long enough is written with its original start time, preceded
+ * by the held pushes enclosing it: those last at least as long, so they are
+ * kept too and the recorded pushes and pops still nest.  A short range is
+ * forgotten.  Start/end ranges are held in `collector_state::held_starts` and
+ * both their events are written by the thread that ends them.  Marks are
+ * written at once, so one may precede the push of its enclosing range in the
+ * ring; timestamps are exact either way.
+ */
+struct threshold_mode {
+  template <typename Message>
+  static void mark(uint16_t domain,
+                   Message const* message,
+                   nvtxEventAttributes_t const* attr,
+                   uint64_t time)
+  {
+    trace_mode::mark(domain, message, attr, time);
+  }
+
+  template <typename Message>
+  static nvtxRangeId_t range_start(uint16_t domain,
+                                   Message const* message,
+                                   nvtxEventAttributes_t const* attr,
+                                   uint64_t time)
+  {
+    thread_state& t = current_thread();
+    event_record e  = make_event(event_type::range_start, domain);
+    describe(e, t, message, attr);
+    e.timestamp            = event_time(time);
+    nvtxRangeId_t const id = g_state->held_starts->open(e, t.cursor);
+    if (NVTX_COLLECTOR_UNLIKELY(id == 0)) { t.dropped.fetch_add(1, std::memory_order_relaxed); }
+    return id;
+  }
+
+  static void range_end(uint16_t domain, nvtxRangeId_t id, uint64_t time)
+  {
+    uint64_t const end = event_time(time);
+    event_record start;
+    if (!g_state->held_starts->close(id, start)) { return; }
+    if (end - start.timestamp < g_state->opts.min_duration_ns) { return; }
+    thread_state& t = current_thread();
+    start.range_id  = id;
+    t.record(start);
+    event_record e = make_event(event_type::range_end, domain);
+    e.timestamp    = end;
+    e.range_id     = id;
+    t.record(e);
+  }
+
+  template <typename Message>
+  static int range_push(uint16_t domain,
+                        Message const* message,
+                        nvtxEventAttributes_t const* attr,
+                        uint64_t time)
+  {
+    thread_state& t              = current_thread();
+    thread_state::held_pushes& h = t.held_of(domain);
+    event_record e               = make_event(event_type::push, domain);
+    describe(e, t, message, attr);
+    e.timestamp = event_time(time);
+    h.pushes.push_back(e);
+    return static_cast<int>(h.pushes.size() - 1);
+  }
+
+  static int range_pop(uint16_t domain, uint64_t time)
+  {
+    uint64_t const end           = event_time(time);
+    thread_state& t              = current_thread();
+    thread_state::held_pushes& h = t.held_of(domain);
+    if (h.pushes.empty()) { return -1; }
+    std::size_t const depth = h.pushes.size() - 1;
+    if (depth >= h.written && end - h.pushes.back().timestamp >= g_state->opts.min_duration_ns) {
+      for (; h.written <= depth; ++h.written) { t.record(h.pushes[h.written]); }
+    }
+    if (depth < h.written) {
+      event_record e = make_event(event_type::pop, domain);
+      e.timestamp    = end;
+      t.record(e);
+      h.written = depth;
+    }
+    h.pushes.pop_back();
+    return static_cast<int>(depth);
+  }
+};
+
+/* ---- NVTX handlers ---- */
+
+void NVTX_API handle_NameCategoryA(uint32_t category, char const* name)
+{
+  g_state->names.name_category(nullptr, category, name ? name : "");
+}
+void NVTX_API handle_NameCategoryW(uint32_t category, wchar_t const* name)
+{
+  g_state->names.name_category(nullptr, category, narrow(name));
+}
+void NVTX_API handle_NameOsThreadA(uint32_t tid, char const* name)
+{
+  g_state->names.name_thread(tid, name ? name : "");
+}
+void NVTX_API handle_NameOsThreadW(uint32_t tid, wchar_t const* name)
+{
+  g_state->names.name_thread(tid, narrow(name));
+}
+
+nvtxResourceHandle_t NVTX_API handle_DomainResourceCreate(nvtxDomainHandle_t,
+                                                          nvtxResourceAttributes_t*)
+{
+  return nullptr;
+}
+void NVTX_API handle_DomainResourceDestroy(nvtxResourceHandle_t) {}
+
+void NVTX_API handle_DomainNameCategoryA(nvtxDomainHandle_t d, uint32_t category, char const* name)
+{
+  g_state->names.name_category(d, category, name ? name : "");
+}
+void NVTX_API handle_DomainNameCategoryW(nvtxDomainHandle_t d,
+                                         uint32_t category,
+                                         wchar_t const* name)
+{
+  g_state->names.name_category(d, category, narrow(name));
+}
+
+nvtxStringHandle_t NVTX_API handle_DomainRegisterStringA(nvtxDomainHandle_t d, char const* s)
+{
+  return g_state->names.register_string(d, s ? s : "");
+}
+nvtxStringHandle_t NVTX_API handle_DomainRegisterStringW(nvtxDomainHandle_t d, wchar_t const* s)
+{
+  return g_state->names.register_string(d, narrow(s));
+}
+
+nvtxDomainHandle_t NVTX_API handle_DomainCreateA(char const* name)
+{
+  return g_state->names.create_domain(name ? name : "");
+}
+nvtxDomainHandle_t NVTX_API handle_DomainCreateW(wchar_t const* name)
+{
+  return g_state->names.create_domain(narrow(name));
+}
+
+// Domains are kept alive for the whole run: events recorded in a destroyed
+// domain may still be waiting in a ring buffer.
+void NVTX_API handle_DomainDestroy(nvtxDomainHandle_t) {}
+
+void NVTX_API handle_Initialize(void const*) {}
+
+nvtxCounterHandle_t NVTX_API handle_DomainCounterRegisterA(nvtxDomainHandle_t d,
+                                                           char const* name,
+                                                           char const* unit)
+{
+  return g_state->names.register_counter(d, name ? name : "", unit ? unit : "");
+}
+
+/// Install the counter module, whose samples only the recording modes keep.
+template <typename Store>
+void install_counter_handlers(module_tables const& t)
+{
+  using ep = counter_entry_points<Store>;
+  install(t.counter,
+          t.counter_size,
+          NVTX_CBID_COUNTER_DomainCounterRegisterA,
+          handle_DomainCounterRegisterA);
+  install(t.counter, t.counter_size, NVTX_CBID_COUNTER_CounterSampleInt64, ep::SampleInt64);
+  install(t.counter, t.counter_size, NVTX_CBID_COUNTER_CounterSampleDouble, ep::SampleDouble);
+}
+
+/* ---- Direct entry points ---- */
+
+/// How `nvtxDirectTool*` reach the collector's handlers.
+enum class direct_route : int {
+  none,   ///< Not attached: events are ignored
+  trace,  ///< Plain tracing: call `trace_mode` inline
+  table,  ///< Any other mode: call the handlers installed in the NVTX function table
+};
+
+std::atomic<direct_route> g_direct_route{direct_route::none};
+
+/// Handlers installed for the direct entry points, read when the route is `table`.
+struct {
+  nvtxDomainMarkEx_impl_fntype mark;
+  nvtxDomainRangeStartEx_impl_fntype range_start;
+  nvtxDomainRangeEnd_impl_fntype range_end;
+  nvtxDomainRangePushEx_impl_fntype range_push;
+  nvtxDomainRangePop_impl_fntype range_pop;
+} g_direct_table;
+
+template <typename F>
+F installed(NvtxFunctionTable table, unsigned size, unsigned id)
+{
+  return (table && id < size && table[id]) ? reinterpret_cast<F>(*table[id]) : nullptr;
+}
+
+/// Choose the route of the direct entry points once the handlers are in `core2`.
+void route_direct_calls(NvtxFunctionTable core2, unsigned core2_size)
+{
+  options const& o = g_state->opts;
+  if (o.mode == collector_mode::trace && o.min_duration_ns == 0 && !sampling_enabled(o)) {
+    g_direct_route.store(direct_route::trace, std::memory_order_release);
+    return;
+  }
+  g_direct_table.mark = installed<nvtxDomainMarkEx_impl_fntype>(
+    core2, core2_size, NVTX_CBID_CORE2_DomainMarkEx);
+  g_direct_table.range_start = installed<nvtxDomainRangeStartEx_impl_fntype>(
+    core2, core2_size, NVTX_CBID_CORE2_DomainRangeStartEx);
+  g_direct_table.range_end = installed<nvtxDomainRangeEnd_impl_fntype>(
+    core2, core2_size, NVTX_CBID_CORE2_DomainRangeEnd);
+  g_direct_table.range_push = installed<nvtxDomainRangePushEx_impl_fntype>(
+    core2, core2_size, NVTX_CBID_CORE2_DomainRangePushEx);
+  g_direct_table.range_pop = installed<nvtxDomainRangePop_impl_fntype>(
+    core2, core2_size, NVTX_CBID_CORE2_DomainRangePop);
+  if (g_direct_table.mark && g_direct_table.range_start && g_direct_table.range_end &&
+      g_direct_table.range_push && g_direct_table.range_pop) {
+    g_direct_route.store(direct_route::table, std::memory_order_release);
+  }
+}
+
+inline direct_route current_route() noexcept
+{
+  return g_direct_route.load(std::memory_order_acquire);
+}
+
+/* ---- Attaching ---- */
+
+void install_handlers(module_tables const& tables)
+{
+  NvtxFunctionTable const core  = tables.core;
+  NvtxFunctionTable const core2 = tables.core2;
+  unsigned const core_size      = tables.core_size;
+  unsigned const core2_size     = tables.core2_size;
+  install(core, core_size, NVTX_CBID_CORE_NameCategoryA, handle_NameCategoryA);
+  install(core, core_size, NVTX_CBID_CORE_NameCategoryW, handle_NameCategoryW);
+  install(core, core_size, NVTX_CBID_CORE_NameOsThreadA, handle_NameOsThreadA);
+  install(core, core_size, NVTX_CBID_CORE_NameOsThreadW, handle_NameOsThreadW);
+
+  install(core2, core2_size, NVTX_CBID_CORE2_DomainResourceCreate, handle_DomainResourceCreate);
+  install(core2, core2_size, NVTX_CBID_CORE2_DomainResourceDestroy, handle_DomainResourceDestroy);
+  install(core2, core2_size, NVTX_CBID_CORE2_DomainNameCategoryA, handle_DomainNameCategoryA);
+  install(core2, core2_size, NVTX_CBID_CORE2_DomainNameCategoryW, handle_DomainNameCategoryW);
+  install(core2, core2_size, NVTX_CBID_CORE2_DomainRegisterStringA, handle_DomainRegisterStringA);
+  install(core2, core2_size, NVTX_CBID_CORE2_DomainRegisterStringW, handle_DomainRegisterStringW);
+  install(core2, core2_size, NVTX_CBID_CORE2_DomainCreateA, handle_DomainCreateA);
+  install(core2, core2_size, NVTX_CBID_CORE2_DomainCreateW, handle_DomainCreateW);
+  install(core2, core2_size, NVTX_CBID_CORE2_DomainDestroy, handle_DomainDestroy);
+  install(core2, core2_size, NVTX_CBID_CORE2_Initialize, handle_Initialize);
+
+  switch (g_state->opts.mode) {
+    case collector_mode::stats: install_stats_handlers(tables); break;
+    case collector_mode::calltree: install_calltree_handlers(tables); break;
+    case collector_mode::flight:
+      install_mode_handlers<flight_mode>(g_state->opts, tables);
+      install_counter_handlers<flight_store>(tables);
+      break;
+    case collector_mode::live:
+      install_mode_handlers<live_mode>(g_state->opts, tables);
+      install_counter_handlers<live_store>(tables);
+      break;
+    default:
+      if (g_state->opts.min_duration_ns > 0) {
+        install_mode_handlers<threshold_mode>(g_state->opts, tables);
+      } else {
+        install_mode_handlers<trace_mode>(g_state->opts, tables);
+      }
+      install_counter_handlers<drained_store>(tables);
+      break;
+  }
+}
+
+void create_state()
+{
+  g_state = new collector_state(options::from_environment());
+  g_state->names.enable_only(g_state->opts.domains);
+  g_state->paused = g_state->opts.start_paused;
+  if (g_state->opts.mode == collector_mode::trace) {
+    g_state->out     = make_default_sink(g_state->opts, g_state->names);
+    g_state->drainer = std::thread(drain_loop, std::ref(*g_state));
+    if (g_state->opts.min_duration_ns > 0) {
+      g_state->held_starts.reset(new pending_ranges<event_record>);
+    }
+  } else {
+    g_state->out = make_null_sink();
+  }
+  if (g_state->opts.mode == collector_mode::flight) { start_flight_recorder(*g_state); }
+  if (g_state->opts.mode == collector_mode::live) {
+    std::string const name = g_state->opts.output.empty()
+                               ? "/nvtx-" + std::to_string(::getpid())
+                               : g_state->opts.output;
+    g_state->stream =
+      live_stream::create(name, g_state->opts.live_threads, g_state->opts.buffer_events);
+    if (g_state->stream) { g_state->names.set_listener(g_state->stream.get()); }
+  }
+  std::atexit(shutdown);
+}
+
+}  // namespace
+
+std::unique_ptr<sink> make_default_sink(options const& o, registry const& reg)
+{
+  if (o.output.empty()) { return make_null_sink(); }
+  uint32_t const pid = static_cast<uint32_t>(::getpid());
+  switch (o.format) {
+    case output_format::binary:
+      // Binary traces are written through a file mapping, which stdout cannot provide
+      if (o.output == "-") { break; }
+      return make_binary_sink(o.output, reg);
+    case output_format::perfetto:
+      if (o.output == "-") { break; }
+      return make_perfetto_sink(o.output, reg, pid);
+    case output_format::json: return make_json_sink(o.output, reg, pid);
+    default: break;
+  }
+  return make_text_sink(o.output, reg);
+}
+
+options options::from_environment()
+{
+  options o;
+  if (char const* v = std::getenv("NVTX_COLLECTOR_MODE")) {
+    if (std::strcmp(v, "stats") == 0) {
+      o.mode = collector_mode::stats;
+    } else if (std::strcmp(v, "calltree") == 0) {
+      o.mode = collector_mode::calltree;
+    } else if (std::strcmp(v, "flight") == 0) {
+      o.mode = collector_mode::flight;
+    } else if (std::strcmp(v, "live") == 0) {
+      o.mode = collector_mode::live;
+    }
+  }
+  if (char const* v = std::getenv("NVTX_COLLECTOR_OUTPUT")) { o.output = v; }
+  if (char const* v = std::getenv("NVTX_COLLECTOR_FORMAT")) {
+    if (std::strcmp(v, "binary") == 0) {
+      o.format = output_format::binary;
+    } else if (std::strcmp(v, "perfetto") == 0) {
+      o.format = output_format::perfetto;
+    } else if (std::strcmp(v, "json") == 0) {
+      o.format = output_format::json;
+    }
+  }
+  o.buffer_events     = env_size("NVTX_COLLECTOR_BUFFER_EVENTS", o.buffer_events);
+  o.flush_interval_ms = static_cast<unsigned>(env_size("NVTX_COLLECTOR_FLUSH_MS", o.flush_interval_ms));
+  o.sample_every =
+    static_cast<uint32_t>(env_size("NVTX_COLLECTOR_SAMPLE_EVERY", o.sample_every));
+  o.sample_fraction = env_fraction("NVTX_COLLECTOR_SAMPLE_FRACTION", o.sample_fraction);
+  o.min_duration_ns = env_size("NVTX_COLLECTOR_MIN_DURATION_NS", o.min_duration_ns);
+  o.counter_interval_ns =
+    env_size("NVTX_COLLECTOR_COUNTER_INTERVAL_NS", o.counter_interval_ns);
+  o.flight_seconds =
+    static_cast<unsigned>(env_size("NVTX_COLLECTOR_FLIGHT_SECONDS", o.flight_seconds));
+  o.live_threads =
+    static_cast<uint32_t>(env_size("NVTX_COLLECTOR_LIVE_THREADS", o.live_threads));
+  if (char const* v = std::getenv("NVTX_COLLECTOR_DUMP_SIGNAL")) {
+    o.dump_signal = static_cast<int>(std::strtol(v, nullptr, 10));
+  }
+  if (char const* v = std::getenv("NVTX_COLLECTOR_SAMPLE_SEED")) {
+    o.sample_seed = std::strtoull(v, nullptr, 10);
+  }
+  o.disabled_sites = env_list("NVTX_COLLECTOR_DISABLE_SITES");
+  o.domains        = env_list("NVTX_COLLECTOR_DOMAINS");
+  o.start_paused   = env_size("NVTX_COLLECTOR_START_PAUSED", 0) != 0;
+  return o;
+}
+
+collector_state::collector_state(options o) : opts{std::move(o)} {}
+
+thread_state& register_thread()
+{
+  collector_state& s = *g_state;
+  thread_state* t    = nullptr;
+  {
+    bool const flight  = s.opts.mode == collector_mode::flight;
+    bool const live    = s.opts.mode == collector_mode::live;
+    uint32_t const tid = os_thread_id();
+    std::lock_guard<std::mutex> lock(s.threads_mutex);
+    if (flight) { retire_flight_threads(s); }
+    if (live) { retire_live_threads(s); }
+    // In flight and live modes the drained ring is never written to
+    s.threads.emplace_back(new thread_state(
+      s.next_thread_index++, tid, flight || live ? 1 : s.opts.buffer_events, s.names));
+    t = s.threads.back().get();
+    if (flight) { t->recent.reset(new overwrite_ring<event_record>(s.opts.buffer_events)); }
+    if (live && s.stream) { t->live = s.stream->claim(t->info.index, tid); }
+  }
+  (void)&tls_exit_guard;  // Construct the guard so its destructor runs at thread exit
+  tls_thread = t;
+  return *t;
+}
+
+int attach(NvtxGetExportTableFunc_t get_export_table)
+{
+  if (!get_export_table) { return 0; }
+
+  auto const* callbacks =
+    static_cast<NvtxExportTableCallbacks const*>(get_export_table(NVTX_ETID_CALLBACKS));
+  if (!callbacks || callbacks->struct_size < sizeof(NvtxExportTableCallbacks) ||
+      !callbacks->GetModuleFunctionTable) {
+    return 0;
+  }
+
+  module_tables tables;
+  if (!callbacks->GetModuleFunctionTable(NVTX_CB_MODULE_CORE, &tables.core, &tables.core_size) ||
+      !callbacks->GetModuleFunctionTable(NVTX_CB_MODULE_CORE2, &tables.core2, &tables.core2_size)) {
+    return 0;
+  }
+  // Optional: NVTX instances older than the batch module have no table for it
+  if (!callbacks->GetModuleFunctionTable(NVTX_CB_MODULE_BATCH, &tables.batch, &tables.batch_size)) {
+    tables.batch      = nullptr;
+    tables.batch_size = 0;
+  }
+  if (!callbacks->GetModuleFunctionTable(
+        NVTX_CB_MODULE_COUNTER, &tables.counter, &tables.counter_size)) {
+    tables.counter      = nullptr;
+    tables.counter_size = 0;
+  }
+
+  auto const* version =
+    static_cast<NvtxExportTableVersionInfo const*>(get_export_table(NVTX_ETID_VERSIONINFO));
+  if (version && version->struct_size >= sizeof(NvtxExportTableVersionInfo) &&
+      version->SetInjectionNvtxVersion) {
+    version->SetInjectionNvtxVersion(NVTX_VERSION);
+  }
+
+  static std::once_flag created;
+  std::call_once(created, create_state);
+
+  // The domain handles of the registry begin with their flags
+  auto const* domains =
+    static_cast<NvtxExportTableDomains const*>(get_export_table(NVTX_ETID_DOMAINS));
+  if (domains && domains->struct_size >= sizeof(NvtxExportTableDomains) &&
+      domains->SetDomainFlagsSupported) {
+    domains->SetDomainFlagsSupported();
+  }
+
+  add_call_sites(*g_state, get_export_table);
+  add_pause_table(*g_state, get_export_table);
+  install_handlers(tables);
+  if (current_route() == direct_route::none) {
+    route_direct_calls(tables.core2, tables.core2_size);
+  }
+  return 1;
+}
+
+void flush()
+{
+  if (!g_state) { return; }
+  std::lock_guard<std::mutex> lock(g_state->sink_mutex);
+  drain_locked(*g_state);
+}
+
+void shutdown()
+{
+  collector_state* s = g_state;
+  if (!s || s->stopped.exchange(true)) { return; }
+  {
+    std::lock_guard<std::mutex> lock(s->drain_mutex);
+    s->stopping = true;
+  }
+  s->drain_cv.notify_all();
+  if (s->drainer.joinable()) { s->drainer.join(); }
+
+  std::lock_guard<std::mutex> lock(s->sink_mutex);
+  drain_locked(*s);
+  if (s->out) {
+    s->out->close(s->names);
+    s->out = make_null_sink();
+  }
+  if (s->stream) { s->stream->close(); }
+  if (!s->opts.output.empty()) {
+    switch (s->opts.mode) {
+      case collector_mode::stats: write_stats_report(s->opts.output, s->names); break;
+      case collector_mode::calltree: write_calltree_report(s->opts.output, s->names); break;
+      default: break;
+    }
+  }
+}
+
+void set_sink(std::unique_ptr<sink> next)
+{
+  if (!g_state) { return; }
+  std::lock_guard<std::mutex> lock(g_state->sink_mutex);
+  drain_locked(*g_state);
+  if (g_state->out) { g_state->out->close(g_state->names); }
+  g_state->out = next ? std::move(next) : make_null_sink();
+}
+
+registry const& names() { return g_state->names; }
+
+std::vector<nvtxCallSite_t*> call_sites()
+{
+  std::vector<nvtxCallSite_t*> sites;
+  if (!g_state) { return sites; }
+  std::lock_guard<std::mutex> lock(g_state->sites_mutex);
+  for (auto const& t : g_state->site_tables) {
+    for (nvtxCallSite_t* site = t.begin; site != t.end; ++site) { sites.push_back(site); }
+  }
+  return sites;
+}
+
+bool set_domain_enabled(std::string const& name, bool enabled)
+{
+  return g_state && g_state->names.set_enabled(name, enabled);
+}
+
+void set_paused(bool paused)
+{
+  if (!g_state) { return; }
+  std::lock_guard<std::mutex> lock(g_state->pause_mutex);
+  g_state->paused = paused;
+  for (auto const& t : g_state->pause_tables) { t.SetPaused(paused ? 1 : 0); }
+}
+
+counters statistics()
+{
+  counters c{0, 0, 0};
+  if (!g_state) { return c; }
+  std::lock_guard<std::mutex> sink_lock(g_state->sink_mutex);
+  std::lock_guard<std::mutex> lock(g_state->threads_mutex);
+  c.written = g_state->written;
+  c.dropped = g_state->retired_dropped;
+  for (auto const& t : g_state->threads) { c.dropped += t->dropped.load(std::memory_order_relaxed); }
+  c.threads = g_state->next_thread_index;
+  return c;
+}
+
+}  // namespace nvtx_collector
+
+/* Called directly by the NVTX domain event functions of modules built with
+ * NVTX_DIRECT_TOOL, see nvtxTypes.h.  In plain tracing, the recording code is
+ * reachable without an indirect call and can be inlined with link-time
+ * optimization. */
+
+using nvtx_collector::direct_route;
+
+extern "C" void NVTX_API nvtxDirectToolDomainMarkEx(nvtxDomainHandle_t d,
+                                                    nvtxEventAttributes_t const* a)
+{
+  switch (nvtx_collector::current_route()) {
+    case direct_route::trace:
+      nvtx_collector::trace_mode::mark<char>(
+        nvtx_collector::registry::domain_id(d), nullptr, a, 0);
+      break;
+    case direct_route::table: nvtx_collector::g_direct_table.mark(d, a); break;
+    default: break;
+  }
+}
+
+extern "C" nvtxRangeId_t NVTX_API nvtxDirectToolDomainRangeStartEx(nvtxDomainHandle_t d,
+                                                                   nvtxEventAttributes_t const* a)
+{
+  switch (nvtx_collector::current_route()) {
+    case direct_route::trace:
+      return nvtx_collector::trace_mode::range_start<char>(
+        nvtx_collector::registry::domain_id(d), nullptr, a, 0);
+    case direct_route::table: return nvtx_collector::g_direct_table.range_start(d, a);
+    default: return 0;
+  }
+}
+
+extern "C" void NVTX_API nvtxDirectToolDomainRangeEnd(nvtxDomainHandle_t d, nvtxRangeId_t id)
+{
+  switch (nvtx_collector::current_route()) {
+    case direct_route::trace:
+      nvtx_collector::trace_mode::range_end(nvtx_collector::registry::domain_id(d), id, 0);
+      break;
+    case direct_route::table: nvtx_collector::g_direct_table.range_end(d, id); break;
+    default: break;
+  }
+}
+
+extern "C" int NVTX_API nvtxDirectToolDomainRangePushEx(nvtxDomainHandle_t d,
+                                                       nvtxEventAttributes_t const* a)
+{
+  switch (nvtx_collector::current_route()) {
+    case direct_route::trace:
+      return nvtx_collector::trace_mode::range_push<char>(
+        nvtx_collector::registry::domain_id(d), nullptr, a, 0);
+    case direct_route::table: return nvtx_collector::g_direct_table.range_push(d, a);
+    default: return NVTX_NO_PUSH_POP_TRACKING;
+  }
+}
+
+extern "C" int NVTX_API nvtxDirectToolDomainRangePop(nvtxDomainHandle_t d)
+{
+  switch (nvtx_collector::current_route()) {
+    case direct_route::trace:
+      return nvtx_collector::trace_mode::range_pop(nvtx_collector::registry::domain_id(d), 0);
+    case direct_route::table: return nvtx_collector::g_direct_table.range_pop(d);
+    default: return NVTX_NO_PUSH_POP_TRACKING;
+  }
+}
@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file collector.hpp
+ *
+ * @brief Programmatic interface of the reference NVTX collector.
+ *
+ * The collector is normally loaded by NVTX itself through
+ * `NVTX_INJECTION64_PATH` and configured with environment variables (see
+ * README.md).  Applications that link the collector directly can use the
+ * functions declared here to configure it and to force output.
+ */
+
+#pragma once
+
+#include "histogram.hpp"
+
+#include <nvtx3/nvToolsExt.h>
+
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace nvtx_collector {
+
+class registry;
+class sink;
+
+/**
+ * @brief File format written to `options::output`.
+ */
+enum class output_format {
+  text,      ///< One comma-separated line per event
+  binary,    ///< Memory-mapped binary trace, see `trace_format.hpp`
+  perfetto,  ///< Perfetto protobuf trace
+  json,      ///< Chrome trace event JSON
+};
+
+/**
+ * @brief What the collector keeps of each event.
+ */
+enum class collector_mode {
+  trace,     ///< Record every event and write it to `options::output`
+  stats,     ///< Keep per-range duration statistics only, reported at shutdown
+  calltree,  ///< Keep time per push/pop call path only, reported at shutdown
+  flight,    ///< Keep the latest events in memory, written only by `dump`
+  live,      ///< Publish events in shared memory for another process to read
+};
+
+/**
+ * @brief Collector configuration.
+ */
+struct options {
+  collector_mode mode{collector_mode::trace};
+
+  /// Output path, "-" for stdout.  Empty disables output.  In live mode, the
+  /// name of the shared memory object, "/nvtx-<pid>" if empty.
+  std::string output;
+
+  output_format format{output_format::text};
+
+  /// Capacity of each thread's event ring, in events.
+  std::size_t buffer_events{1u << 16};
+
+  /// Period of the background drain thread.
+  unsigned flush_interval_ms{100};
+
+  /// Flight mode: write only the events of the last this many seconds; 0 writes all.
+  unsigned flight_seconds{0};
+
+  /// Flight mode: signal that writes a dump to `output`.N; 0 for none.
+  int dump_signal{SIGUSR2};
+
+  /// Live mode: threads that can publish events at the same time.
+  uint32_t live_threads{64};
+
+  /// Trace mode: drop ranges shorter than this many nanoseconds; 0 keeps all.
+  uint64_t min_duration_ns{0};
+
+  /// Recording modes: store the first sample of each counter and thread in
+  /// every interval of this many nanoseconds, and the last one before it.
+  uint64_t counter_interval_ns{100000};
+
+  /// Record only every Nth instance of each range key; 1 records all.
+  uint32_t sample_every{1};
+
+  /// Fraction of outermost ranges recorded together with their subtree.
+  double sample_fraction{1.0};
+
+  /// Seed of the `sample_fraction` decisions.
+  uint64_t sample_seed{0};
+
+  /// Call sites turned off when their NVTX instance attaches, each given as a
+  /// function name or as `file:line`; see `call_sites()`.
+  std::vector<std::string> disabled_sites;
+
+  /// Names of the only domains whose events the NVTX C++ API sends; all if
+  /// empty.  The global domain is always on.  See `set_domain_enabled()`.
+  std::vector<std::string> domains;
+
+  /// Attach with the events of the application paused, until it calls
+  /// `nvtxResume` or `set_paused(false)` is called; see `set_paused()`.
+  bool start_paused{false};
+
+  /**
+   * @brief Read options from the `NVTX_COLLECTOR_*` environment variables,
+   * falling back to the defaults above.
+   */
+  static options from_environment();
+};
+
+/**
+ * @brief Running totals, for monitoring the collector itself.
+ */
+struct counters {
+  uint64_t written;  ///< Events handed to the sink
+  uint64_t dropped;  ///< Events lost because a thread's ring was full
+  uint32_t threads;  ///< Threads that have recorded at least one event
+};
+
+/**
+ * @brief Durations of one kind of range, aggregated over every thread.
+ *
+ * Ranges are grouped by domain, message and category; push/pop and start/end
+ * ranges with the same key are counted together.
+ */
+struct range_statistics {
+  uint16_t domain;    ///< Domain id, see `registry::domains()`
+  uint32_t message;   ///< Interned message id, see `registry::lookup()`
+  uint32_t category;  ///< User category, 0 if unset
+  uint64_t count;
+  uint64_t total_ns;
+  uint64_t min_ns;
+  uint64_t max_ns;
+  log_linear_histogram histogram;  ///< Durations in nanoseconds
+};
+
+/**
+ * @brief Node of the call tree built from nested push/pop ranges.
+ *
+ * A node stands for one call path: the same range entered under different
+ * parents gives different nodes.
+ */
+struct call_tree_node {
+  uint16_t domain;        ///< Domain id, see `registry::domains()`
+  uint32_t message;       ///< Interned message id, see `registry::lookup()`
+  uint32_t category;      ///< User category, 0 if unset
+  uint64_t count;         ///< Times the path was entered and left
+  uint64_t inclusive_ns;  ///< Time in the range, nested ranges included
+  uint64_t exclusive_ns;  ///< Time in the range, nested ranges excluded
+  std::vector<call_tree_node> children;  ///< Largest inclusive time first
+};
+
+/**
+ * @brief Attach the collector to the NVTX instance exposing `get_export_table`.
+ *
+ * This is the body of `InitializeInjectionNvtx2`.  The first call creates the
+ * collector with `options::from_environment()`; later calls, made by other
+ * NVTX instances in the process, only install the handlers into their tables.
+ *
+ * @return 1 on success, 0 on failure (matching the injection entry point).
+ */
+int attach(NvtxGetExportTableFunc_t get_export_table);
+
+/**
+ * @brief Write every event recorded so far to the sink.
+ */
+void flush();
+
+/**
+ * @brief Stop the drain thread, write remaining events and close the sink.
+ *
+ * Registered with `atexit` on the first `attach`.  Events recorded after
+ * shutdown are dropped.
+ */
+void shutdown();
+
+/**
+ * @brief Replace the sink.  Pending events are written to the old sink first.
+ */
+void set_sink(std::unique_ptr<sink> s);
+
+/**
+ * @brief Names referenced by recorded events.
+ */
+registry const& names();
+
+counters statistics();
+
+/**
+ * @brief Write the events kept by `collector_mode::flight` to `path`, in
+ * `options::format`.
+ *
+ * May be called from any thread; recording continues meanwhile.
+ *
+ * @return false if the collector is not in flight mode.
+ */
+bool dump(std::string const& path);
+
+/**
+ * @brief Merge the per-thread range statistics of `collector_mode::stats`,
+ * largest total duration first.  Empty in other modes.
+ */
+std::vector<range_statistics> range_report();
+
+/**
+ * @brief Merge the per-thread call trees of `collector_mode::calltree`.
+ *
+ * The returned root stands for "outside any range" and only has children.
+ * Empty in other modes.
+ */
+call_tree_node call_tree();
+
+/**
+ * @brief Call sites of every attached NVTX instance, in section order.
+ *
+ * Sites come from the `NVTX_ETID_CALLSITES` export table, which lists the
+ * `nvtx3::call_site` descriptors of NVTX C++ macros on ELF platforms.  Clearing
+ * a site's `enabled` byte stops its ranges from the next time it runs.
+ */
+std::vector<nvtxCallSite_t*> call_sites();
+
+/**
+ * @brief Turn the domain called `name` on or off.
+ *
+ * The collector marks its domain handles as carrying `nvtxDomainFlags_t`, so
+ * `nvtxDomainIsEnabled` and the NVTX C++ API see the change at their next
+ * event and skip the domain entirely while it is off.  Events that still
+ * arrive, through the NVTX C API or to end a range begun earlier, are
+ * recorded.
+ *
+ * @return false if no domain of that name has been created.
+ */
+bool set_domain_enabled(std::string const& name, bool enabled);
+
+/**
+ * @brief Pause or resume the events of every thread, in every attached NVTX
+ * instance and in those attaching later.
+ *
+ * Goes through the `NVTX_ETID_PAUSE` export table, so a paused NVTX call
+ * returns before reaching the collector.  Changes the same state as
+ * `nvtxPause` and `nvtxResume`; the last call wins.
+ */
+void set_paused(bool paused);
+
+}  // namespace nvtx_collector
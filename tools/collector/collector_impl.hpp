@@ -0,0 +1,353 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Internal state shared by the collector's translation units.  Not installed. */
+
+#pragma once
+
+#include "collector.hpp"
+#include "event.hpp"
+#include "live_stream.hpp"
+#include "pending_ranges.hpp"
+#include "registry.hpp"
+#include "ring_buffer.hpp"
+#include "sink.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__GNUC__)
+#define NVTX_COLLECTOR_LIKELY(x) __builtin_expect(!!(x), 1)
+#define NVTX_COLLECTOR_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define NVTX_COLLECTOR_LIKELY(x) (x)
+#define NVTX_COLLECTOR_UNLIKELY(x) (x)
+#endif
+
+namespace nvtx_collector {
+
+/**
+ * @brief Current time in nanoseconds on the collector's monotonic clock.
+ */
+inline uint64_t now_ns() noexcept
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+/**
+ * @brief Time of an event: `time` if the application gave one, in the NVTX
+ * clock domain, or the current time if `time` is 0.
+ *
+ * The NVTX clock domain is `CLOCK_MONOTONIC`, the collector's clock, so no
+ * conversion is needed.
+ */
+inline uint64_t event_time(uint64_t time) noexcept { return time ? time : now_ns(); }
+
+/**
+ * @brief Arguments of a compact entry point such as `nvtxDomainMarkCompact`,
+ * passed to the mode primitives as their `Message`.
+ */
+struct compact_event {
+  nvtxStringHandle_t message;  ///< Registered message, null if none
+  uint32_t category;           ///< User category, 0 if unset
+  int32_t payload_type;        ///< `nvtxPayloadType_t` of `payload`
+  uint64_t payload;            ///< Raw payload bits, 32-bit types in the low bits
+};
+
+/**
+ * @brief Interned id of an event's message, given either the string passed
+ * to an A/W entry point or the attributes passed to an Ex entry point.
+ */
+template <typename Message>
+inline uint32_t message_id(string_cache& strings,
+                           Message const* message,
+                           nvtxEventAttributes_t const* attr)
+{
+  if (!attr) { return strings.intern(message); }
+  switch (attr->messageType) {
+    case NVTX_MESSAGE_TYPE_ASCII: return strings.intern(attr->message.ascii);
+    case NVTX_MESSAGE_TYPE_UNICODE: return strings.intern(attr->message.unicode);
+    case NVTX_MESSAGE_TYPE_REGISTERED:
+      return attr->message.registered ? attr->message.registered->id : 0;
+    default: return 0;
+  }
+}
+
+/**
+ * @brief Id of the message of a compact event: its registered id, with no
+ * string to intern.
+ */
+inline uint32_t message_id(string_cache&, compact_event const* c, nvtxEventAttributes_t const*)
+{
+  return c->message ? c->message->id : 0;
+}
+
+/// Counter written by one thread and read by a reporting thread.  The owner
+/// updates it with a plain load and store; no read-modify-write is needed.
+using shard_counter = std::atomic<uint64_t>;
+
+inline void bump(shard_counter& c, uint64_t n) noexcept
+{
+  c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+/**
+ * @brief What aggregating modes group ranges by.
+ */
+struct range_key {
+  uint32_t message;   ///< Interned message id
+  uint32_t category;  ///< User category, 0 if unset
+  uint16_t domain;    ///< Domain id
+
+  bool operator==(range_key const& o) const noexcept
+  {
+    return message == o.message && category == o.category && domain == o.domain;
+  }
+  bool operator!=(range_key const& o) const noexcept { return !(*this == o); }
+};
+
+struct range_key_hash {
+  std::size_t operator()(range_key const& k) const noexcept
+  {
+    uint64_t h = (static_cast<uint64_t>(k.domain) << 48) ^
+                 (static_cast<uint64_t>(k.category) << 32) ^ k.message;
+    h *= 0x9e3779b97f4a7c15ull;
+    return static_cast<std::size_t>(h ^ (h >> 29));
+  }
+};
+
+/**
+ * @brief Key of an event, given either the string passed to an A/W entry point
+ * or the attributes passed to an Ex entry point.
+ */
+template <typename Message>
+inline range_key key_of(uint16_t domain,
+                        string_cache& strings,
+                        Message const* message,
+                        nvtxEventAttributes_t const* attr)
+{
+  return range_key{message_id(strings, message, attr), attr ? attr->category : 0u, domain};
+}
+
+inline range_key key_of(uint16_t domain,
+                        string_cache& strings,
+                        compact_event const* c,
+                        nvtxEventAttributes_t const* attr)
+{
+  return range_key{message_id(strings, c, attr), c->category, domain};
+}
+
+/**
+ * @brief Everything a thread touches while recording an event.
+ *
+ * Owned by `collector_state::threads` so the drain thread can empty the ring
+ * after the recording thread has exited.
+ */
+struct thread_state {
+  thread_state(uint32_t index, uint32_t os_tid, std::size_t capacity, registry& reg)
+    : info{index, os_tid}, events{capacity}, strings{reg}
+  {
+  }
+
+  thread_info const info;
+  ring_buffer<event_record> events;
+  string_cache strings;
+
+  /// Latest events, instead of `events`, in `collector_mode::flight`.
+  std::unique_ptr<overwrite_ring<event_record>> recent;
+
+  /// Shared-memory ring, instead of `events`, in `collector_mode::live`.
+  std::unique_ptr<live_ring> live;
+
+  /// Push/pop nesting depth, indexed by domain id.
+  std::vector<uint32_t> depth;
+
+  /// Source of start/end range ids; combined with `info.index` to be unique.
+  uint64_t next_range{0};
+
+  /// Push ranges of one domain not yet known to last `options::min_duration_ns`.
+  struct held_pushes {
+    std::vector<event_record> pushes;
+    std::size_t written{0};  ///< Number of leading `pushes` already recorded
+  };
+
+  /// Held push ranges, indexed by domain id.
+  std::vector<held_pushes> held;
+
+  /// Search position in `collector_state::held_starts`.
+  uint32_t cursor{0};
+
+  /// Samples of one counter, downsampled to `options::counter_interval_ns`.
+  ///
+  /// Only the owning thread writes the held sample, bumping `version` to an
+  /// odd value while it does, so the drain thread can copy it like a seqlock.
+  /// The sample is kept in relaxed atomic words, so a copy racing with a write
+  /// is only discarded, not a data race.  Whoever stores the held sample first
+  /// clears `holding`, so it is stored once.
+  struct counter_slot {
+    static constexpr std::size_t words = sizeof(event_record) / sizeof(uint64_t);
+    static_assert(sizeof(event_record) % sizeof(uint64_t) == 0, "event_record is whole words");
+
+    std::atomic<uint64_t> next{0};  ///< Time from which the next sample is stored at once
+    std::atomic<uint32_t> version{0};
+    std::atomic<uint64_t> held_words[words]{};
+    std::atomic<bool> holding{false};  ///< Whether the held sample is not yet stored
+
+    /// Replace the held sample; called by the owning thread.
+    void hold(event_record const& e) noexcept
+    {
+      uint64_t w[words];
+      std::memcpy(w, &e, sizeof(e));
+      version.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      for (std::size_t i = 0; i < words; ++i) {
+        held_words[i].store(w[i], std::memory_order_relaxed);
+      }
+      version.fetch_add(1, std::memory_order_release);
+    }
+
+    /// Copy of the held sample, which may be torn unless `version` was even
+    /// and unchanged around the copy.
+    event_record held() const noexcept
+    {
+      uint64_t w[words];
+      for (std::size_t i = 0; i < words; ++i) {
+        w[i] = held_words[i].load(std::memory_order_relaxed);
+      }
+      event_record e;
+      std::memcpy(&e, w, sizeof(e));
+      return e;
+    }
+  };
+
+  /// Counter samples, indexed by counter index.  Slots never move once added.
+  std::vector<std::unique_ptr<counter_slot>> counters;
+
+  /// Taken by the owner to add `counters`, and by the drain thread to read them.
+  std::mutex counters_mutex;
+
+  /// No held sample has to be stored before this time.
+  uint64_t held_due{UINT64_MAX};
+
+  std::atomic<uint64_t> dropped{0};
+  std::atomic<bool> exited{false};
+
+  void record(event_record const& e) noexcept
+  {
+    if (NVTX_COLLECTOR_UNLIKELY(!events.try_push(e))) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  uint32_t& depth_of(uint16_t domain)
+  {
+    if (NVTX_COLLECTOR_UNLIKELY(domain >= depth.size())) { depth.resize(domain + 1u, 0); }
+    return depth[domain];
+  }
+
+  held_pushes& held_of(uint16_t domain)
+  {
+    if (NVTX_COLLECTOR_UNLIKELY(domain >= held.size())) { held.resize(domain + 1u); }
+    return held[domain];
+  }
+
+  counter_slot& counter_of(uint32_t index)
+  {
+    if (NVTX_COLLECTOR_UNLIKELY(index >= counters.size())) {
+      std::lock_guard<std::mutex> lock(counters_mutex);
+      while (counters.size() <= index) { counters.emplace_back(new counter_slot); }
+    }
+    return *counters[index];
+  }
+};
+
+/**
+ * @brief Process-wide collector state, created by the first `attach`.
+ */
+struct collector_state {
+  explicit collector_state(options o);
+
+  options opts;
+  registry names;
+
+  /// Guards `threads` and `next_thread_index`; taken once per thread lifetime
+  /// by the recording side and once per drain pass by the drain thread.
+  std::mutex threads_mutex;
+  std::vector<std::unique_ptr<thread_state>> threads;
+  uint32_t next_thread_index{0};
+
+  /// Serializes every access to `out`.
+  std::mutex sink_mutex;
+  std::unique_ptr<sink> out;
+  uint64_t written{0};
+  uint64_t retired_dropped{0};  ///< Drops of threads already removed from `threads`
+
+  std::mutex drain_mutex;
+  std::condition_variable drain_cv;
+  bool stopping{false};
+  std::thread drainer;
+
+  /// Shared-memory segment in `collector_mode::live`, null if it could not be created.
+  std::unique_ptr<live_stream> stream;
+
+  /// Start/end ranges not yet ended, when `opts.min_duration_ns` is set.
+  std::unique_ptr<pending_ranges<event_record>> held_starts;
+
+  /// Call-site tables of the attached NVTX instances, see `call_sites()`.
+  std::mutex sites_mutex;
+  std::vector<NvtxExportTableCallSites> site_tables;
+
+  /// Pause tables of the attached NVTX instances, see `set_paused()`.
+  std::mutex pause_mutex;
+  std::vector<NvtxExportTablePause> pause_tables;
+  bool paused{false};
+
+  std::atomic<bool> stopped{false};
+};
+
+/**
+ * @brief Sink writing to `o.output` in `o.format`.
+ */
+std::unique_ptr<sink> make_default_sink(options const& o, registry const& reg);
+
+/// Set once by the first `attach`, never reset.
+extern collector_state* g_state;
+
+/// Per-thread pointer into `g_state->threads`, null until the first event.
+extern thread_local thread_state* tls_thread;
+
+thread_state& register_thread();
+
+/**
+ * @brief State of the calling thread, registering it on first use.
+ */
+inline thread_state& current_thread()
+{
+  thread_state* t = tls_thread;
+  if (NVTX_COLLECTOR_LIKELY(t != nullptr)) { return *t; }
+  return register_thread();
+}
+
+}  // namespace nvtx_collector
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace nvtx_collector {
+
+/**
+ * @brief Kind of NVTX call an `event_record` was produced by.
+ */
+enum class event_type : uint8_t {
+  invalid     = 0,
+  mark        = 1,  ///< `nvtxMark*`, `nvtxDomainMarkEx`
+  push        = 2,  ///< `nvtxRangePush*`, `nvtxDomainRangePushEx`
+  pop         = 3,  ///< `nvtxRangePop`, `nvtxDomainRangePop`
+  range_start = 4,  ///< `nvtxRangeStart*`, `nvtxDomainRangeStartEx`
+  range_end   = 5,  ///< `nvtxRangeEnd`, `nvtxDomainRangeEnd`
+  counter     = 6,  ///< `nvtxCounterSample*`: `message` names the counter, `payload` holds its value
+};
+
+/**
+ * @brief Fixed-size record of a single NVTX event.
+ *
+ * Records are written by the calling thread into its own ring buffer, so they
+ * only hold plain integers: strings and domains are referenced by the ids
+ * assigned in the collector's `registry`.
+ */
+struct event_record {
+  uint64_t timestamp;     ///< Nanoseconds on the collector's monotonic clock
+  uint64_t range_id;      ///< Start/end correlation id, 0 for other events
+  uint64_t payload;       ///< Raw payload bits, interpreted via `payload_type`
+  uint32_t message;       ///< Interned string id, 0 if no message
+  uint32_t category;      ///< User category, 0 if unset
+  uint32_t color;         ///< ARGB color, 0 if unset
+  uint16_t domain;        ///< Domain id, 0 for the global domain
+  event_type type;        ///< Kind of event
+  uint8_t payload_type;   ///< `nvtxPayloadType_t` of `payload`, 0 if unset
+};
+
+static_assert(sizeof(event_record) == 40, "event_record layout must stay fixed-size");
+
+}  // namespace nvtx_collector
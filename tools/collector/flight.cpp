@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "flight.hpp"
+
+#include <semaphore.h>
+#include <signal.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+
+namespace nvtx_collector {
+
+namespace {
+
+/// Exited threads whose rings are kept so a later dump still shows them.
+constexpr std::size_t max_exited_threads = 64;
+
+/// Posted by the signal handler; waited for by the dump thread.
+sem_t g_dump_request;
+
+/// Number of signalled dumps written so far, used to name them.
+uint32_t g_signalled_dumps = 0;
+
+/// Serializes dumps, which may be requested from several threads at once.
+std::mutex g_dump_mutex;
+
+void on_dump_signal(int)
+{
+  int const saved = errno;
+  ::sem_post(&g_dump_request);  // Async-signal-safe, unlike anything that writes a file
+  errno = saved;
+}
+
+void dump_loop()
+{
+  for (;;) {
+    if (::sem_wait(&g_dump_request) != 0) { continue; }
+    dump(g_state->opts.output + "." + std::to_string(++g_signalled_dumps));
+  }
+}
+
+}  // namespace
+
+void start_flight_recorder(collector_state& s)
+{
+  int const signal = s.opts.dump_signal;
+  if (signal <= 0 || s.opts.output.empty()) { return; }
+
+  struct sigaction previous;
+  if (::sigaction(signal, nullptr, &previous) != 0) { return; }
+  if ((previous.sa_flags & SA_SIGINFO) || previous.sa_handler != SIG_DFL) {
+    std::fprintf(stderr,
+                 "NVTX collector: signal %d is handled by the application, dump with "
+                 "nvtxCollectorDump instead\n",
+                 signal);
+    return;
+  }
+
+  ::sem_init(&g_dump_request, 0, 0);
+  std::thread(dump_loop).detach();
+
+  struct sigaction action;
+  std::memset(&action, 0, sizeof(action));
+  action.sa_handler = on_dump_signal;
+  action.sa_flags   = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  ::sigaction(signal, &action, nullptr);
+}
+
+void retire_flight_threads(collector_state& s)
+{
+  std::size_t exited = 0;
+  for (auto const& t : s.threads) {
+    if (t->exited.load(std::memory_order_acquire)) { ++exited; }
+  }
+  // `threads` is in registration order, so the oldest exited threads come first
+  for (auto it = s.threads.begin(); exited > max_exited_threads && it != s.threads.end();) {
+    if ((*it)->exited.load(std::memory_order_acquire)) {
+      it = s.threads.erase(it);
+      --exited;
+    } else {
+      ++it;
+    }
+  }
+}
+
+bool dump(std::string const& path)
+{
+  collector_state* s = g_state;
+  if (!s || s->opts.mode != collector_mode::flight || path.empty()) { return false; }
+
+  // Copy under the lock, write without it: threads keep recording meanwhile
+  std::vector<std::pair<thread_info, std::vector<event_record>>> copies;
+  {
+    std::lock_guard<std::mutex> lock(s->threads_mutex);
+    copies.reserve(s->threads.size());
+    for (auto const& t : s->threads) {
+      copies.emplace_back(t->info, std::vector<event_record>{});
+      t->recent->snapshot(copies.back().second);
+    }
+  }
+
+  uint64_t const window = static_cast<uint64_t>(s->opts.flight_seconds) * 1000000000ull;
+  uint64_t const now    = now_ns();
+  uint64_t const oldest = window && now > window ? now - window : 0;
+
+  options o = s->opts;
+  o.output  = path;
+  std::lock_guard<std::mutex> lock(g_dump_mutex);
+  std::unique_ptr<sink> out = make_default_sink(o, s->names);
+  for (auto const& c : copies) {
+    std::vector<event_record> const& events = c.second;
+    auto const first = std::find_if(events.begin(), events.end(), [&](event_record const& e) {
+      return e.timestamp >= oldest;
+    });
+    if (first != events.end()) {
+      out->write(c.first, &*first, static_cast<std::size_t>(events.end() - first));
+    }
+  }
+  out->flush();
+  out->close(s->names);
+  return true;
+}
+
+}  // namespace nvtx_collector
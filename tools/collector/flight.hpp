@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/* Flight-recorder mode of the collector (NVTX_COLLECTOR_MODE=flight).  Not installed. */
+
+#pragma once
+
+#include "collector_impl.hpp"
+
+namespace nvtx_collector {
+
+/**
+ * @brief Start the thread that writes a dump whenever `opts.dump_signal` is
+ * received.  Does nothing if the application already handles that signal.
+ */
+void start_flight_recorder(collector_state& s);
+
+/**
+ * @brief Free the rings of exited threads beyond the number kept for dumps,
+ * oldest threads first.  Caller holds `s.threads_mutex`.
+ */
+void retire_flight_threads(collector_state& s);
+
+}  // namespace nvtx_collector
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Installation of NVTX event handlers for the collector's modes.  Not installed. */
+
+#pragma once
+
+#include "collector_impl.hpp"
+#include "registry.hpp"
+
+#include <nvtx3/nvToolsExt.h>
+#include <nvtx3/nvToolsExtBatch.h>
+#include <nvtx3/nvToolsExtCounters.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nvtx_collector {
+
+/**
+ * @brief Store `fn` into slot `id` of an NVTX module function table.
+ */
+template <typename F>
+void install(NvtxFunctionTable table, unsigned size, unsigned id, F fn)
+{
+  if (table && id < size && table[id]) { *table[id] = reinterpret_cast<NvtxFunctionPointer>(fn); }
+}
+
+/**
+ * @brief Function tables of the NVTX modules holding event slots.
+ *
+ * A table is null if the NVTX instance lacks its module, as older ones lack
+ * `NVTX_CB_MODULE_BATCH` and `NVTX_CB_MODULE_COUNTER`.
+ */
+struct module_tables {
+  NvtxFunctionTable core{nullptr};
+  unsigned core_size{0};
+  NvtxFunctionTable core2{nullptr};
+  unsigned core2_size{0};
+  NvtxFunctionTable batch{nullptr};
+  unsigned batch_size{0};
+  NvtxFunctionTable counter{nullptr};
+  unsigned counter_size{0};
+};
+
+/**
+ * @brief NVTX event entry points forwarding to the primitives of `Mode`.
+ *
+ * A collection mode is a type with these static member functions, where
+ * `Message` is `char`, `wchar_t` or, for the compact entry points,
+ * `compact_event`, exactly one of `message` and `attr` is non-null, and
+ * `time` is the time of the event given by the application, or 0 for the
+ * current time (see `event_time`):
+ *
+ * @code{.cpp}
+ * template <typename Message>
+ * static void mark(uint16_t domain, Message const* message, nvtxEventAttributes_t const* attr,
+ *                  uint64_t time);
+ * template <typename Message>
+ * static nvtxRangeId_t range_start(uint16_t domain, Message const* message,
+ *                                  nvtxEventAttributes_t const* attr, uint64_t time);
+ * static void range_end(uint16_t domain, nvtxRangeId_t id, uint64_t time);
+ * template <typename Message>
+ * static int range_push(uint16_t domain, Message const* message, nvtxEventAttributes_t const* attr,
+ *                       uint64_t time);
+ * static int range_pop(uint16_t domain, uint64_t time);
+ * @endcode
+ */
+template <typename Mode>
+struct event_entry_points {
+  static void NVTX_API MarkEx(nvtxEventAttributes_t const* a)
+  {
+    Mode::template mark<char>(0, nullptr, a, 0);
+  }
+  static void NVTX_API MarkA(char const* m) { Mode::mark(0, m, nullptr, 0); }
+  static void NVTX_API MarkW(wchar_t const* m) { Mode::mark(0, m, nullptr, 0); }
+
+  static nvtxRangeId_t NVTX_API RangeStartEx(nvtxEventAttributes_t const* a)
+  {
+    return Mode::template range_start<char>(0, nullptr, a, 0);
+  }
+  static nvtxRangeId_t NVTX_API RangeStartA(char const* m)
+  {
+    return Mode::range_start(0, m, nullptr, 0);
+  }
+  static nvtxRangeId_t NVTX_API RangeStartW(wchar_t const* m)
+  {
+    return Mode::range_start(0, m, nullptr, 0);
+  }
+  static void NVTX_API RangeEnd(nvtxRangeId_t id) { Mode::range_end(0, id, 0); }
+
+  static int NVTX_API RangePushEx(nvtxEventAttributes_t const* a)
+  {
+    return Mode::template range_push<char>(0, nullptr, a, 0);
+  }
+  static int NVTX_API RangePushA(char const* m) { return Mode::range_push(0, m, nullptr, 0); }
+  static int NVTX_API RangePushW(wchar_t const* m) { return Mode::range_push(0, m, nullptr, 0); }
+  static int NVTX_API RangePop() { return Mode::range_pop(0, 0); }
+
+  static void NVTX_API DomainMarkEx(nvtxDomainHandle_t d, nvtxEventAttributes_t const* a)
+  {
+    Mode::template mark<char>(registry::domain_id(d), nullptr, a, 0);
+  }
+  static nvtxRangeId_t NVTX_API DomainRangeStartEx(nvtxDomainHandle_t d,
+                                                   nvtxEventAttributes_t const* a)
+  {
+    return Mode::template range_start<char>(registry::domain_id(d), nullptr, a, 0);
+  }
+  static void NVTX_API DomainRangeEnd(nvtxDomainHandle_t d, nvtxRangeId_t id)
+  {
+    Mode::range_end(registry::domain_id(d), id, 0);
+  }
+  static int NVTX_API DomainRangePushEx(nvtxDomainHandle_t d, nvtxEventAttributes_t const* a)
+  {
+    return Mode::template range_push<char>(registry::domain_id(d), nullptr, a, 0);
+  }
+  static int NVTX_API DomainRangePop(nvtxDomainHandle_t d)
+  {
+    return Mode::range_pop(registry::domain_id(d), 0);
+  }
+
+  static void NVTX_API DomainMarkCompact(
+    nvtxDomainHandle_t d, nvtxStringHandle_t m, uint32_t category, int32_t type, uint64_t payload)
+  {
+    compact_event const c{m, category, type, payload};
+    Mode::mark(registry::domain_id(d), &c, nullptr, 0);
+  }
+  static nvtxRangeId_t NVTX_API DomainRangeStartCompact(
+    nvtxDomainHandle_t d, nvtxStringHandle_t m, uint32_t category, int32_t type, uint64_t payload)
+  {
+    compact_event const c{m, category, type, payload};
+    return Mode::range_start(registry::domain_id(d), &c, nullptr, 0);
+  }
+  static int NVTX_API DomainRangePushCompact(
+    nvtxDomainHandle_t d, nvtxStringHandle_t m, uint32_t category, int32_t type, uint64_t payload)
+  {
+    compact_event const c{m, category, type, payload};
+    return Mode::range_push(registry::domain_id(d), &c, nullptr, 0);
+  }
+
+  /// Events without a timestamp share the time of the submission.
+  static void NVTX_API DomainBatchSubmit(nvtxDomainHandle_t d,
+                                         nvtxBatchEvent_t* events,
+                                         size_t count)
+  {
+    uint16_t const domain = registry::domain_id(d);
+    uint64_t const now    = count ? now_ns() : 0;
+    nvtxEventAttributes_t compact{};
+    compact.version = NVTX_VERSION;
+    compact.size    = NVTX_EVENT_ATTRIB_STRUCT_SIZE;
+    for (size_t i = 0; i < count; ++i) {
+      nvtxBatchEvent_t& e            = events[i];
+      uint64_t const time            = e.timestamp ? e.timestamp : now;
+      nvtxEventAttributes_t const* a = e.attributes;
+      if (!a) {
+        compact.category    = e.category;
+        compact.messageType = e.message ? NVTX_MESSAGE_TYPE_REGISTERED : NVTX_MESSAGE_UNKNOWN;
+        compact.message.registered = e.message;
+        a                          = &compact;
+      }
+      switch (e.type) {
+        case NVTX_BATCH_EVENT_MARK: Mode::template mark<char>(domain, nullptr, a, time); break;
+        case NVTX_BATCH_EVENT_RANGE_START:
+          e.rangeId = Mode::template range_start<char>(domain, nullptr, a, time);
+          break;
+        case NVTX_BATCH_EVENT_RANGE_END: Mode::range_end(domain, e.rangeId, time); break;
+        case NVTX_BATCH_EVENT_RANGE_PUSH:
+          Mode::template range_push<char>(domain, nullptr, a, time);
+          break;
+        case NVTX_BATCH_EVENT_RANGE_POP: Mode::range_pop(domain, time); break;
+        default: break;
+      }
+    }
+  }
+};
+
+/**
+ * @brief Point every NVTX event slot of `tables` at `Mode`.
+ */
+template <typename Mode>
+void install_event_handlers(module_tables const& t)
+{
+  using ep = event_entry_points<Mode>;
+  install(t.core, t.core_size, NVTX_CBID_CORE_MarkEx, ep::MarkEx);
+  install(t.core, t.core_size, NVTX_CBID_CORE_MarkA, ep::MarkA);
+  install(t.core, t.core_size, NVTX_CBID_CORE_MarkW, ep::MarkW);
+  install(t.core, t.core_size, NVTX_CBID_CORE_RangeStartEx, ep::RangeStartEx);
+  install(t.core, t.core_size, NVTX_CBID_CORE_RangeStartA, ep::RangeStartA);
+  install(t.core, t.core_size, NVTX_CBID_CORE_RangeStartW, ep::RangeStartW);
+  install(t.core, t.core_size, NVTX_CBID_CORE_RangeEnd, ep::RangeEnd);
+  install(t.core, t.core_size, NVTX_CBID_CORE_RangePushEx, ep::RangePushEx);
+  install(t.core, t.core_size, NVTX_CBID_CORE_RangePushA, ep::RangePushA);
+  install(t.core, t.core_size, NVTX_CBID_CORE_RangePushW, ep::RangePushW);
+  install(t.core, t.core_size, NVTX_CBID_CORE_RangePop, ep::RangePop);
+
+  install(t.core2, t.core2_size, NVTX_CBID_CORE2_DomainMarkEx, ep::DomainMarkEx);
+  install(t.core2, t.core2_size, NVTX_CBID_CORE2_DomainRangeStartEx, ep::DomainRangeStartEx);
+  install(t.core2, t.core2_size, NVTX_CBID_CORE2_DomainRangeEnd, ep::DomainRangeEnd);
+  install(t.core2, t.core2_size, NVTX_CBID_CORE2_DomainRangePushEx, ep::DomainRangePushEx);
+  install(t.core2, t.core2_size, NVTX_CBID_CORE2_DomainRangePop, ep::DomainRangePop);
+  install(t.core2, t.core2_size, NVTX_CBID_CORE2_DomainMarkCompact, ep::DomainMarkCompact);
+  install(t.core2,
+          t.core2_size,
+          NVTX_CBID_CORE2_DomainRangeStartCompact,
+          ep::DomainRangeStartCompact);
+  install(t.core2,
+          t.core2_size,
+          NVTX_CBID_CORE2_DomainRangePushCompact,
+          ep::DomainRangePushCompact);
+
+  install(t.batch, t.batch_size, NVTX_CBID_BATCH_DomainBatchSubmit, ep::DomainBatchSubmit);
+}
+
+}  // namespace nvtx_collector
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace nvtx_collector {
+
+/**
+ * @brief Fixed-size histogram of 64-bit values with log-linear buckets.
+ *
+ * Values below `sub_buckets` get a bucket each.  Above that, every power of
+ * two is split into `sub_buckets` equal buckets, so a value is known to within
+ * 1/`sub_buckets` (12.5%) of itself across the whole 64-bit range.  The
+ * histogram has a fixed number of buckets, so its size never depends on the
+ * values added.
+ */
+class log_linear_histogram {
+ public:
+  static constexpr unsigned sub_bucket_bits = 3;
+  static constexpr unsigned sub_buckets     = 1u << sub_bucket_bits;
+  static constexpr unsigned bucket_count    = (64 - sub_bucket_bits + 1) * sub_buckets;
+
+  /// Index of the bucket holding `value`.
+  static constexpr unsigned bucket_of(uint64_t value) noexcept
+  {
+    if (value < sub_buckets) { return static_cast<unsigned>(value); }
+    unsigned const shift = msb(value) - sub_bucket_bits;
+    return (shift + 1) * sub_buckets + static_cast<unsigned>((value >> shift) - sub_buckets);
+  }
+
+  /// Smallest value that falls into bucket `b`.
+  static constexpr uint64_t lower_bound(unsigned b) noexcept
+  {
+    unsigned const group = b / sub_buckets;
+    uint64_t const sub   = b % sub_buckets;
+    return group == 0 ? sub : (sub_buckets + sub) << (group - 1);
+  }
+
+  /// Largest value that falls into bucket `b`.
+  static constexpr uint64_t upper_bound(unsigned b) noexcept
+  {
+    return b + 1 < bucket_count ? lower_bound(b + 1) - 1 : UINT64_MAX;
+  }
+
+  void add(uint64_t value, uint64_t n = 1) noexcept { counts_[bucket_of(value)] += n; }
+
+  void add_bucket(unsigned b, uint64_t n) noexcept { counts_[b] += n; }
+
+  void merge(log_linear_histogram const& other) noexcept
+  {
+    for (unsigned b = 0; b < bucket_count; ++b) { counts_[b] += other.counts_[b]; }
+  }
+
+  uint64_t bucket(unsigned b) const noexcept { return counts_[b]; }
+
+  uint64_t count() const noexcept
+  {
+    uint64_t n = 0;
+    for (uint64_t c : counts_) { n += c; }
+    return n;
+  }
+
+  /**
+   * @brief Value below which a fraction `q` (0 to 1) of the values fall.
+   *
+   * Returns the upper bound of the bucket holding that value, or 0 if the
+   * histogram is empty.
+   */
+  uint64_t percentile(double q) const noexcept
+  {
+    uint64_t const total = count();
+    if (total == 0) { return 0; }
+    double const wanted = q <= 0 ? 1.0 : q >= 1 ? static_cast<double>(total) : q * total;
+    uint64_t seen       = 0;
+    for (unsigned b = 0; b < bucket_count; ++b) {
+      seen += counts_[b];
+      if (counts_[b] && static_cast<double>(seen) >= wanted) { return upper_bound(b); }
+    }
+    return UINT64_MAX;
+  }
+
+ private:
+  static constexpr unsigned msb(uint64_t v) noexcept
+  {
+#if defined(__GNUC__)
+    return 63u - static_cast<unsigned>(__builtin_clzll(v));
+#else
+    unsigned r = 0;
+    while (v >>= 1) { ++r; }
+    return r;
+#endif
+  }
+
+  std::array<uint64_t, bucket_count> counts_{};
+};
+
+}  // namespace nvtx_collector
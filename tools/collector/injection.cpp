@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Entry points of the dynamically loaded collector (NVTX_INJECTION64_PATH). */
+
+#include "collector.hpp"
+
+#define NVTX_COLLECTOR_EXPORT extern "C" __attribute__((visibility("default")))
+
+/**
+ * @brief Called by NVTX during its first API call, once per NVTX instance.
+ */
+NVTX_COLLECTOR_EXPORT int InitializeInjectionNvtx2(NvtxGetExportTableFunc_t get_export_table)
+{
+  return nvtx_collector::attach(get_export_table);
+}
+
+/**
+ * @brief Write all events recorded so far.  Looked up with `dlsym` by
+ * applications that want output at a point of their choosing.
+ */
+NVTX_COLLECTOR_EXPORT void nvtxCollectorFlush(void) { nvtx_collector::flush(); }
+
+/**
+ * @brief Write the events kept in flight-recorder mode to `path`.  Looked up
+ * with `dlsym`, like `nvtxCollectorFlush`.
+ *
+ * @return 1 on success, 0 if the collector is not in flight mode.
+ */
+NVTX_COLLECTOR_EXPORT int nvtxCollectorDump(char const* path)
+{
+  return path && nvtx_collector::dump(path) ? 1 : 0;
+}
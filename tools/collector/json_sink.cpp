@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "registry.hpp"
+#include "sink.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace nvtx_collector {
+
+namespace {
+
+/**
+ * @brief Streams events in the Chrome trace event JSON format.
+ *
+ * Each event is printed as one object of the `traceEvents` array as soon as it
+ * is written.  Meant for small captures and for viewers without Perfetto
+ * protobuf support; prefer the Perfetto sink for anything large.
+ */
+class json_sink final : public sink {
+ public:
+  json_sink(std::string const& path, registry const& reg, uint32_t pid) : registry_{reg}, pid_{pid}
+  {
+    file_ = path.empty() || path == "-" ? stdout : std::fopen(path.c_str(), "w");
+    if (!file_) {
+      std::fprintf(stderr, "NVTX collector: cannot open '%s', writing to stdout\n", path.c_str());
+      file_ = stdout;
+    }
+    std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", file_);
+    std::fprintf(file_,
+                 "{\"ph\":\"M\",\"pid\":%" PRIu32 ",\"name\":\"process_name\","
+                 "\"args\":{\"name\":\"NVTX\"}}",
+                 pid_);
+  }
+
+  ~json_sink() override { finish(registry_); }
+
+  void write(thread_info const& thread, event_record const* events, std::size_t count) override
+  {
+    if (!file_) { return; }
+    for (std::size_t i = 0; i < count; ++i) {
+      event_record const& e = events[i];
+      char const* phase     = nullptr;
+      switch (e.type) {
+        case event_type::push: phase = "B"; break;
+        case event_type::pop: phase = "E"; break;
+        case event_type::mark: phase = "i"; break;
+        case event_type::range_start: phase = "b"; break;
+        case event_type::range_end: phase = "e"; break;
+        case event_type::counter: phase = "C"; break;
+        default: continue;
+      }
+      // Timestamps are microseconds; keep nanosecond precision in the fraction
+      std::fprintf(file_,
+                   ",\n{\"ph\":\"%s\",\"pid\":%" PRIu32 ",\"tid\":%" PRIu32
+                   ",\"ts\":%" PRIu64 ".%03" PRIu64,
+                   phase,
+                   pid_,
+                   thread.os_tid,
+                   e.timestamp / 1000,
+                   e.timestamp % 1000);
+      if (e.type == event_type::pop) {
+        std::fputc('}', file_);
+        continue;
+      }
+      if (e.type == event_type::counter) {
+        counter(e);
+        continue;
+      }
+      std::fputs(",\"cat\":", file_);
+      quote(domain_name(e.domain));
+      if (e.type == event_type::mark) { std::fputs(",\"s\":\"t\"", file_); }
+      if (e.range_id) { std::fprintf(file_, ",\"id\":\"0x%" PRIx64 "\"", e.range_id); }
+      if (e.type != event_type::range_end) {
+        std::fputs(",\"name\":", file_);
+        quote(registry_.lookup(e.message));
+      }
+      if (e.category || e.payload_type) {
+        std::fprintf(file_,
+                     ",\"args\":{\"category\":%" PRIu32 ",\"payload\":%" PRIu64 "}",
+                     e.category,
+                     e.payload);
+      }
+      std::fputc('}', file_);
+    }
+  }
+
+  void flush() override
+  {
+    if (file_) { std::fflush(file_); }
+  }
+
+  void close(registry const& reg) override { finish(reg); }
+
+ private:
+  /// Counters are drawn per process, so their name also carries the domain.
+  void counter(event_record const& e)
+  {
+    std::fputs(",\"name\":", file_);
+    quote((std::string(domain_name(e.domain)) + ": " + registry_.lookup(e.message)).c_str());
+    if (e.payload_type == NVTX_PAYLOAD_TYPE_DOUBLE) {
+      double value;
+      std::memcpy(&value, &e.payload, sizeof(value));
+      std::fprintf(file_, ",\"args\":{\"value\":%.17g}}", value);
+    } else {
+      std::fprintf(file_,
+                   ",\"args\":{\"value\":%" PRId64 "}}",
+                   static_cast<int64_t>(e.payload));
+    }
+  }
+
+  void finish(registry const& reg)
+  {
+    if (!file_) { return; }
+    for (auto const& n : reg.thread_names()) {
+      std::fprintf(file_,
+                   ",\n{\"ph\":\"M\",\"pid\":%" PRIu32 ",\"tid\":%" PRIu32
+                   ",\"name\":\"thread_name\",\"args\":{\"name\":",
+                   pid_,
+                   n.os_tid);
+      quote(n.name.c_str());
+      std::fputs("}}", file_);
+    }
+    std::fputs("\n]}\n", file_);
+    if (file_ != stdout) {
+      std::fclose(file_);
+    } else {
+      std::fflush(file_);
+    }
+    file_ = nullptr;
+  }
+
+  char const* domain_name(uint16_t domain)
+  {
+    if (domain >= domains_.size()) {
+      domains_.clear();
+      for (auto const& d : registry_.domains()) { domains_.push_back(d.name); }
+      if (domain >= domains_.size()) { return ""; }
+    }
+    return domain == 0 ? "NVTX" : domains_[domain].c_str();
+  }
+
+  void quote(char const* s)
+  {
+    std::fputc('"', file_);
+    for (; *s; ++s) {
+      unsigned char const c = static_cast<unsigned char>(*s);
+      if (c == '"' || c == '\\') {
+        std::fputc('\\', file_);
+        std::fputc(c, file_);
+      } else if (c < 0x20) {
+        std::fprintf(file_, "\\u%04x", c);
+      } else {
+        std::fputc(c, file_);
+      }
+    }
+    std::fputc('"', file_);
+  }
+
+  registry const& registry_;
+  uint32_t pid_;
+  std::FILE* file_;
+  std::vector<std::string> domains_;  ///< Domain names by id, refreshed on a miss
+};
+
+}  // namespace
+
+std::unique_ptr<sink> make_json_sink(std::string const& path, registry const& reg, uint32_t pid)
+{
+  return std::unique_ptr<sink>(new json_sink(path, reg, pid));
+}
+
+}  // namespace nvtx_collector
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file live_format.hpp
+ *
+ * @brief Layout of the shared-memory segment of the collector's live mode.
+ *
+ * The segment is a POSIX shared memory object holding a `segment_header`,
+ * a log of name entries, and a fixed number of rings:
+ *
+ * ```
+ * +----------------+-------------+--------+--------+-----+----------+
+ * | segment_header | name log    | ring 0 | ring 1 | ... | ring N-1 |
+ * +----------------+-------------+--------+--------+-----+----------+
+ * ```
+ *
+ * Each ring is a `ring_header` followed by `segment_header::ring_capacity`
+ * `event_record`s.  A ring belongs to one recording thread at a time and is
+ * a single-producer/single-consumer queue: the producer stores records and
+ * then publishes `head` with a release store; the consumer reads records up
+ * to `head` in place and then releases them by storing `tail`.  The producer
+ * never waits and makes no system call; when a ring is full, records are
+ * dropped.
+ *
+ * The name log holds the registry's names in the binary trace's entry format
+ * (`trace_format::table_entry`, with `reserved` holding the
+ * `trace_format::table_kind`), appended as they are created.  `names_size`
+ * is stored after the entries, and a name is appended before any record can
+ * refer to it, so a consumer that loads a ring's `head` and then `names_size`
+ * knows every name those records use.
+ *
+ * Producer and consumer must run on the same machine; integers are native.
+ */
+
+#pragma once
+
+#include "event.hpp"
+#include "trace_format.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace nvtx_collector {
+namespace live_format {
+
+constexpr char magic[8]    = {'N', 'V', 'T', 'X', 'L', 'I', 'V', 'E'};
+constexpr uint32_t version = 1;
+
+/// `segment_header::state`
+constexpr uint32_t segment_live   = 1;  ///< The producer is running
+constexpr uint32_t segment_closed = 2;  ///< The producer shut down; no more records follow
+
+/// `ring_header::state`
+constexpr uint32_t ring_unused = 0;  ///< Never claimed
+constexpr uint32_t ring_live   = 1;  ///< Owned by a running thread
+constexpr uint32_t ring_exited = 2;  ///< Its thread exited; reused once drained
+
+/// Bytes reserved for the name log.
+constexpr uint64_t default_names_capacity = 1u << 20;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "shared-memory atomics must not depend on a process-local lock");
+
+struct segment_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;     ///< `sizeof(segment_header)`
+  uint32_t record_size;     ///< `sizeof(event_record)`
+  uint32_t pid;             ///< Process recording the events
+  uint32_t ring_count;      ///< Rings in the segment
+  uint32_t ring_capacity;   ///< Records per ring, a power of two
+  uint64_t ring_size;       ///< Bytes per ring, header included
+  uint64_t rings_offset;    ///< Offset of ring 0 from the start of the segment
+  uint64_t names_offset;    ///< Offset of the name log
+  uint64_t names_capacity;  ///< Bytes reserved for the name log
+  std::atomic<uint64_t> names_size;  ///< Bytes of the name log published
+  std::atomic<uint32_t> state;
+  std::atomic<uint32_t> rings_used;  ///< Rings from this index on were never claimed
+};
+
+static_assert(sizeof(segment_header) == 80, "segment_header layout must stay fixed-size");
+
+struct ring_header {
+  alignas(64) std::atomic<uint64_t> head;  ///< Records published; written by the producer
+  alignas(64) std::atomic<uint64_t> tail;  ///< Records released; written by the consumer
+  alignas(64) std::atomic<uint32_t> state;
+  uint32_t thread_index;  ///< Collector thread index of the current owner
+  uint32_t os_tid;        ///< Operating system thread id of the current owner
+  uint32_t reserved;
+};
+
+static_assert(sizeof(ring_header) == 192, "ring_header layout must stay fixed-size");
+
+}  // namespace live_format
+}  // namespace nvtx_collector
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "live_reader.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace nvtx_collector {
+
+namespace {
+
+[[noreturn]] void invalid(std::string const& name, char const* why)
+{
+  throw std::runtime_error("NVTX live stream '" + name + "': " + why);
+}
+
+}  // namespace
+
+live_reader::live_reader(std::string const& name)
+{
+  // Read-write: the consumer stores each ring's tail
+  int const fd = ::shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0) { invalid(name, std::strerror(errno)); }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    invalid(name, std::strerror(errno));
+  }
+  size_ = static_cast<std::size_t>(st.st_size);
+  if (size_ < sizeof(live_format::segment_header)) {
+    ::close(fd);
+    invalid(name, "segment is too small");
+  }
+  void* p = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) { invalid(name, std::strerror(errno)); }
+  base_   = static_cast<char*>(p);
+  header_ = reinterpret_cast<live_format::segment_header*>(base_);
+
+  char const* why = nullptr;
+  if (std::memcmp(header_->magic, live_format::magic, sizeof(header_->magic)) != 0) {
+    why = "not an NVTX live stream";
+  } else if (header_->version != live_format::version) {
+    why = "unsupported version";
+  } else if (header_->record_size != sizeof(event_record) ||
+             header_->ring_capacity == 0 ||
+             (header_->ring_capacity & (header_->ring_capacity - 1)) != 0 ||
+             header_->rings_offset + uint64_t{header_->ring_count} * header_->ring_size > size_ ||
+             header_->names_offset + header_->names_capacity > header_->rings_offset) {
+    why = "corrupt header";
+  }
+  if (why) {
+    ::munmap(base_, size_);
+    invalid(name, why);
+  }
+  mask_ = header_->ring_capacity - 1u;
+}
+
+live_reader::~live_reader() { ::munmap(base_, size_); }
+
+void live_reader::read_names()
+{
+  uint64_t const size = header_->names_size.load(std::memory_order_acquire);
+  char const* log     = base_ + header_->names_offset;
+  while (names_read_ < size) {
+    trace_format::table_entry e;
+    std::memcpy(&e, log + names_read_, sizeof(e));
+    std::string name(log + names_read_ + sizeof(e), e.length);
+    names_read_ += trace_format::entry_size(e.length);
+
+    switch (static_cast<trace_format::table_kind>(e.reserved)) {
+      case trace_format::table_kind::strings:
+        if (strings_.size() <= e.key) { strings_.resize(e.key + 1u); }
+        strings_[e.key] = std::move(name);
+        break;
+      case trace_format::table_kind::domains: domains_[e.key] = std::move(name); break;
+      case trace_format::table_kind::categories:
+        categories_[{e.key, e.key2}] = std::move(name);
+        break;
+      case trace_format::table_kind::thread_names: thread_names_[e.key] = std::move(name); break;
+      case trace_format::table_kind::counters: counters_[{e.key, e.key2}] = std::move(name); break;
+      default: break;
+    }
+  }
+}
+
+char const* live_reader::string(uint32_t id) const noexcept
+{
+  return id < strings_.size() ? strings_[id].c_str() : "";
+}
+
+char const* live_reader::domain_name(uint16_t domain) const noexcept
+{
+  auto it = domains_.find(domain);
+  return it != domains_.end() ? it->second.c_str() : "";
+}
+
+char const* live_reader::category_name(uint16_t domain, uint32_t category) const noexcept
+{
+  auto it = categories_.find({domain, category});
+  return it != categories_.end() ? it->second.c_str() : "";
+}
+
+char const* live_reader::thread_name(uint32_t os_tid) const noexcept
+{
+  auto it = thread_names_.find(os_tid);
+  return it != thread_names_.end() ? it->second.c_str() : "";
+}
+
+char const* live_reader::counter_unit(uint16_t domain, uint32_t name) const noexcept
+{
+  auto it = counters_.find({domain, name});
+  return it != counters_.end() ? it->second.c_str() : "";
+}
+
+}  // namespace nvtx_collector
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file live_reader.hpp
+ *
+ * @brief Consumer of the collector's live mode.
+ *
+ * Maps the shared memory object a collector in `NVTX_COLLECTOR_MODE=live`
+ * publishes (see `live_format.hpp`) and drains its rings in place.  One
+ * process may consume a segment at a time.
+ */
+
+#pragma once
+
+#include "event.hpp"
+#include "live_format.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace nvtx_collector {
+
+class live_reader {
+ public:
+  /// Owner of a ring at the time its records were read.
+  struct thread {
+    uint32_t ring;
+    uint32_t index;
+    uint32_t os_tid;
+  };
+
+  /**
+   * @brief Map the shared memory object `name`, for example "/nvtx-1234".
+   *
+   * @throws std::runtime_error if it does not exist or is not a live segment
+   * of a supported version.
+   */
+  explicit live_reader(std::string const& name);
+  ~live_reader();
+
+  live_reader(live_reader const&) = delete;
+  live_reader& operator=(live_reader const&) = delete;
+
+  /// Process publishing the events.
+  uint32_t pid() const noexcept { return header_->pid; }
+
+  /// True once the producer has shut down; records published before remain readable.
+  bool closed() const noexcept
+  {
+    return header_->state.load(std::memory_order_acquire) == live_format::segment_closed;
+  }
+
+  /**
+   * @brief Call `f(thread const&, event_record const&)` for every record
+   * published since the previous call, ring by ring, each ring's records in
+   * publication order, then hand their slots back to the producer.
+   *
+   * Names used by the records are available when `f` is called.
+   *
+   * @return Number of records passed to `f`.
+   */
+  template <typename F>
+  std::size_t poll(F&& f)
+  {
+    uint32_t const rings = header_->rings_used.load(std::memory_order_acquire);
+    heads_.resize(rings);
+    for (uint32_t i = 0; i < rings; ++i) {
+      heads_[i] = ring(i).head.load(std::memory_order_acquire);
+    }
+    read_names();
+
+    std::size_t count = 0;
+    for (uint32_t i = 0; i < rings; ++i) {
+      live_format::ring_header& r = ring(i);
+      uint64_t const tail         = r.tail.load(std::memory_order_relaxed);
+      thread const t{i, r.thread_index, r.os_tid};
+      event_record const* slots = reinterpret_cast<event_record const*>(&r + 1);
+      for (uint64_t n = tail; n < heads_[i]; ++n) { f(t, slots[n & mask_]); }
+      r.tail.store(heads_[i], std::memory_order_release);
+      count += static_cast<std::size_t>(heads_[i] - tail);
+    }
+    return count;
+  }
+
+  /// Names referenced by records; empty strings for unknown ids.  Valid until
+  /// the next `poll`, which may rename categories and threads.
+  char const* string(uint32_t id) const noexcept;
+  char const* domain_name(uint16_t domain) const noexcept;
+  char const* category_name(uint16_t domain, uint32_t category) const noexcept;
+  char const* thread_name(uint32_t os_tid) const noexcept;
+  /// Unit of the counter whose samples have this domain and message.
+  char const* counter_unit(uint16_t domain, uint32_t name) const noexcept;
+
+ private:
+  live_format::ring_header& ring(uint32_t i) const noexcept
+  {
+    return *reinterpret_cast<live_format::ring_header*>(base_ + header_->rings_offset +
+                                                        i * header_->ring_size);
+  }
+
+  void read_names();
+
+  char* base_{nullptr};
+  std::size_t size_{0};
+  live_format::segment_header* header_{nullptr};
+  uint64_t mask_{0};
+  uint64_t names_read_{0};
+  std::vector<uint64_t> heads_;
+  std::deque<std::string> strings_;
+  std::unordered_map<uint32_t, std::string> domains_;
+  std::map<std::pair<uint32_t, uint32_t>, std::string> categories_;
+  std::unordered_map<uint32_t, std::string> thread_names_;
+  std::map<std::pair<uint32_t, uint32_t>, std::string> counters_;
+};
+
+}  // namespace nvtx_collector
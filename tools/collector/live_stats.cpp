@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/* nvtx3-live-stats: print per-range statistics of a process running the collector in live mode. */
+
+#include "live_reader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+int usage()
+{
+  std::fputs("usage: nvtx3-live-stats [--interval MS] [--top N] NAME|PID\n", stderr);
+  return 2;
+}
+
+volatile std::sig_atomic_t g_interrupted = 0;
+
+void on_interrupt(int) { g_interrupted = 1; }
+
+struct range_stats {
+  uint64_t count{0};
+  uint64_t total_ns{0};
+  uint64_t max_ns{0};
+};
+
+/// A range waiting for its pop or end.
+struct open_range {
+  uint16_t domain;
+  uint32_t message;
+  uint64_t start;
+};
+
+/**
+ * @brief Durations of the ranges read so far, by (domain, message).
+ */
+class aggregator {
+ public:
+  void add(nvtx_collector::live_reader::thread const& t, nvtx_collector::event_record const& e)
+  {
+    using nvtx_collector::event_type;
+    switch (e.type) {
+      case event_type::push:
+        stacks_[{t.ring, e.domain}].push_back(open_range{e.domain, e.message, e.timestamp});
+        break;
+      case event_type::pop: {
+        auto& stack = stacks_[{t.ring, e.domain}];
+        if (stack.empty()) { break; }
+        close(stack.back(), e.timestamp);
+        stack.pop_back();
+        break;
+      }
+      case event_type::range_start:
+        started_[e.range_id] = open_range{e.domain, e.message, e.timestamp};
+        break;
+      case event_type::range_end: {
+        auto it = started_.find(e.range_id);
+        if (it == started_.end()) { break; }
+        close(it->second, e.timestamp);
+        started_.erase(it);
+        break;
+      }
+      default: break;
+    }
+  }
+
+  void print(nvtx_collector::live_reader const& reader, uint64_t events, std::size_t top) const
+  {
+    std::vector<std::pair<std::pair<uint16_t, uint32_t>, range_stats>> rows(stats_.begin(),
+                                                                             stats_.end());
+    std::sort(rows.begin(), rows.end(), [](auto const& a, auto const& b) {
+      return a.second.total_ns > b.second.total_ns;
+    });
+    if (rows.size() > top) { rows.resize(top); }
+
+    std::printf("-- pid %u: %llu events%s\n",
+                reader.pid(),
+                static_cast<unsigned long long>(events),
+                reader.closed() ? ", closed" : "");
+    std::printf(
+      "%12s %14s %12s %12s  %s\n", "count", "total_ms", "mean_us", "max_us", "domain:name");
+    for (auto const& r : rows) {
+      range_stats const& s = r.second;
+      std::printf("%12llu %14.3f %12.3f %12.3f  %s:%s\n",
+                  static_cast<unsigned long long>(s.count),
+                  static_cast<double>(s.total_ns) / 1e6,
+                  static_cast<double>(s.total_ns) / 1e3 / static_cast<double>(s.count),
+                  static_cast<double>(s.max_ns) / 1e3,
+                  reader.domain_name(r.first.first),
+                  reader.string(r.first.second));
+    }
+    std::fflush(stdout);
+  }
+
+ private:
+  void close(open_range const& r, uint64_t end)
+  {
+    range_stats& s        = stats_[{r.domain, r.message}];
+    uint64_t const length = end > r.start ? end - r.start : 0;
+    ++s.count;
+    s.total_ns += length;
+    s.max_ns = std::max(s.max_ns, length);
+  }
+
+  std::map<std::pair<uint32_t, uint16_t>, std::vector<open_range>> stacks_;
+  std::unordered_map<uint64_t, open_range> started_;
+  std::map<std::pair<uint16_t, uint32_t>, range_stats> stats_;
+};
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  unsigned interval_ms = 1000;
+  std::size_t top      = 20;
+  int arg              = 1;
+  for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2) {
+    if (std::strcmp(argv[arg], "--interval") == 0) {
+      interval_ms = static_cast<unsigned>(std::strtoul(argv[arg + 1], nullptr, 10));
+    } else if (std::strcmp(argv[arg], "--top") == 0) {
+      top = static_cast<std::size_t>(std::strtoul(argv[arg + 1], nullptr, 10));
+    } else {
+      return usage();
+    }
+  }
+  if (arg + 1 != argc) { return usage(); }
+
+  // A bare number names the default segment of that process
+  std::string name = argv[arg];
+  if (name.find_first_not_of("0123456789") == std::string::npos) { name = "/nvtx-" + name; }
+
+  try {
+    nvtx_collector::live_reader reader(name);
+    std::signal(SIGINT, on_interrupt);
+    std::signal(SIGTERM, on_interrupt);
+
+    aggregator stats;
+    uint64_t events = 0;
+    auto add        = [&](nvtx_collector::live_reader::thread const& t,
+                   nvtx_collector::event_record const& e) { stats.add(t, e); };
+    auto next_print = std::chrono::steady_clock::now();
+    while (!g_interrupted) {
+      bool const closed     = reader.closed();
+      std::size_t const got = reader.poll(add);
+      events += got;
+      if (std::chrono::steady_clock::now() >= next_print || (closed && got == 0)) {
+        stats.print(reader, events, top);
+        next_print += std::chrono::milliseconds(interval_ms);
+      }
+      if (closed && got == 0) { break; }
+      if (got == 0) { std::this_thread::sleep_for(std::chrono::milliseconds(10)); }
+    }
+  } catch (std::exception const& e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
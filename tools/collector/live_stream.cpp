@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "live_stream.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace nvtx_collector {
+
+namespace {
+
+uint64_t round_up_pow2(uint64_t n) noexcept
+{
+  uint64_t p = 1;
+  while (p < n) { p <<= 1; }
+  return p;
+}
+
+uint64_t align_up(uint64_t n, uint64_t alignment) noexcept
+{
+  return (n + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+std::unique_ptr<live_stream> live_stream::create(std::string const& name,
+                                                 uint32_t ring_count,
+                                                 std::size_t ring_capacity)
+{
+  using namespace live_format;
+  uint64_t const capacity     = round_up_pow2(ring_capacity);
+  uint64_t const ring_size    = align_up(sizeof(ring_header) + capacity * sizeof(event_record), 64);
+  uint64_t const names_offset = align_up(sizeof(segment_header), 64);
+  uint64_t const rings_offset = align_up(names_offset + default_names_capacity, 64);
+  uint64_t const size         = rings_offset + ring_count * ring_size;
+
+  auto fail = [&](char const* what) {
+    std::fprintf(
+      stderr, "NVTX collector: %s '%s': %s\n", what, name.c_str(), std::strerror(errno));
+    return nullptr;
+  };
+  int const fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (fd < 0) { return fail("cannot create shared memory"); }
+  if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    ::close(fd);
+    ::shm_unlink(name.c_str());
+    return fail("cannot size shared memory");
+  }
+  void* base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    ::shm_unlink(name.c_str());
+    return fail("cannot map shared memory");
+  }
+
+  // The object is zero-filled, which is the initial state of every atomic
+  auto* h = new (base) segment_header;
+  std::memcpy(h->magic, magic, sizeof(magic));
+  h->version        = version;
+  h->header_size    = sizeof(segment_header);
+  h->record_size    = sizeof(event_record);
+  h->pid            = static_cast<uint32_t>(::getpid());
+  h->ring_count     = ring_count;
+  h->ring_capacity  = static_cast<uint32_t>(capacity);
+  h->ring_size      = ring_size;
+  h->rings_offset   = rings_offset;
+  h->names_offset   = names_offset;
+  h->names_capacity = default_names_capacity;
+  h->names_size.store(0, std::memory_order_relaxed);
+  h->rings_used.store(0, std::memory_order_relaxed);
+  h->state.store(segment_live, std::memory_order_release);
+  return std::unique_ptr<live_stream>(
+    new live_stream(name, static_cast<char*>(base), static_cast<std::size_t>(size)));
+}
+
+live_stream::live_stream(std::string name, char* base, std::size_t size) noexcept
+  : name_{std::move(name)}, base_{base}, size_{size}
+{
+}
+
+live_stream::~live_stream() { ::munmap(base_, size_); }
+
+live_format::ring_header& live_stream::ring(uint32_t i) const noexcept
+{
+  return *reinterpret_cast<live_format::ring_header*>(base_ + header().rings_offset +
+                                                      i * header().ring_size);
+}
+
+std::unique_ptr<live_ring> live_stream::claim(uint32_t thread_index, uint32_t os_tid)
+{
+  using namespace live_format;
+  std::lock_guard<std::mutex> lock(claim_mutex_);
+  segment_header& h = header();
+  uint32_t const used = h.rings_used.load(std::memory_order_relaxed);
+  uint32_t i          = 0;
+  for (; i < used; ++i) {
+    ring_header& r = ring(i);
+    if (r.state.load(std::memory_order_acquire) == ring_exited &&
+        r.tail.load(std::memory_order_acquire) == r.head.load(std::memory_order_relaxed)) {
+      break;
+    }
+  }
+  if (i == used && used == h.ring_count) { return nullptr; }
+
+  ring_header* r = i < used ? &ring(i) : new (&ring(i)) ring_header;
+  r->thread_index = thread_index;
+  r->os_tid       = os_tid;
+  r->state.store(ring_live, std::memory_order_release);
+  if (i == used) { h.rings_used.store(used + 1, std::memory_order_release); }
+  return std::unique_ptr<live_ring>(
+    new live_ring(r, reinterpret_cast<event_record*>(r + 1), h.ring_capacity));
+}
+
+void live_stream::close()
+{
+  header().state.store(live_format::segment_closed, std::memory_order_release);
+  ::shm_unlink(name_.c_str());
+}
+
+void live_stream::name_added(trace_format::table_kind kind,
+                             uint32_t key,
+                             uint32_t key2,
+                             std::string const& name)
+{
+  live_format::segment_header& h = header();
+  auto const length              = static_cast<uint32_t>(name.size());
+  uint64_t const used            = h.names_size.load(std::memory_order_relaxed);
+  uint64_t const size            = trace_format::entry_size(length);
+  if (used + size > h.names_capacity) {
+    if (!names_full_) {
+      std::fprintf(stderr, "NVTX collector: name log of '%s' is full\n", name_.c_str());
+      names_full_ = true;
+    }
+    return;
+  }
+  char* at = base_ + h.names_offset + used;
+  trace_format::table_entry const entry{key, key2, length, static_cast<uint32_t>(kind)};
+  std::memcpy(at, &entry, sizeof(entry));
+  std::memcpy(at + sizeof(entry), name.data(), length);  // NUL and padding are already zero
+  h.names_size.store(used + size, std::memory_order_release);
+}
+
+}  // namespace nvtx_collector
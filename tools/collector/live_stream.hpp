@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/* Producer side of the collector's live mode (NVTX_COLLECTOR_MODE=live).  Not installed. */
+
+#pragma once
+
+#include "event.hpp"
+#include "live_format.hpp"
+#include "registry.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace nvtx_collector {
+
+/**
+ * @brief Producer view of one ring of the live segment.
+ */
+class live_ring {
+ public:
+  live_ring(live_format::ring_header* header, event_record* slots, uint64_t capacity) noexcept
+    : header_{header}, slots_{slots}, capacity_{capacity}, tail_cache_{header->tail.load()}
+  {
+  }
+
+  /**
+   * @brief Publish `e`.
+   *
+   * @return false if the consumer has not released enough records yet.
+   */
+  bool try_push(event_record const& e) noexcept
+  {
+    uint64_t const head = header_->head.load(std::memory_order_relaxed);
+    if (head - tail_cache_ >= capacity_) {
+      tail_cache_ = header_->tail.load(std::memory_order_acquire);
+      if (head - tail_cache_ >= capacity_) { return false; }
+    }
+    slots_[head & (capacity_ - 1)] = e;
+    header_->head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Give the ring up when its thread exits; it is reused once drained.
+  void release() noexcept
+  {
+    header_->state.store(live_format::ring_exited, std::memory_order_release);
+  }
+
+ private:
+  live_format::ring_header* header_;
+  event_record* slots_;
+  uint64_t capacity_;
+  uint64_t tail_cache_;  ///< Last observed `tail`
+};
+
+/**
+ * @brief Shared-memory segment of the live mode, see `live_format.hpp`.
+ *
+ * Registered as the registry's listener, so every name is appended to the
+ * segment's name log as it is created.
+ */
+class live_stream : public registry::listener {
+ public:
+  /**
+   * @brief Create the shared memory object `name` with `ring_count` rings of
+   * at least `ring_capacity` records.
+   *
+   * @return null, after printing why, if the segment cannot be created.
+   */
+  static std::unique_ptr<live_stream> create(std::string const& name,
+                                             uint32_t ring_count,
+                                             std::size_t ring_capacity);
+
+  ~live_stream() override;
+
+  live_stream(live_stream const&) = delete;
+  live_stream& operator=(live_stream const&) = delete;
+
+  /**
+   * @brief Claim a ring for a new thread: a never used one, or one whose
+   * thread exited and whose records were all consumed.
+   *
+   * @return null if every ring is in use.
+   */
+  std::unique_ptr<live_ring> claim(uint32_t thread_index, uint32_t os_tid);
+
+  /**
+   * @brief Mark the segment closed and remove its name.  Consumers that
+   * already mapped it can still read the remaining records.
+   */
+  void close();
+
+  void name_added(trace_format::table_kind kind,
+                  uint32_t key,
+                  uint32_t key2,
+                  std::string const& name) override;
+
+ private:
+  live_stream(std::string name, char* base, std::size_t size) noexcept;
+
+  live_format::segment_header& header() const noexcept
+  {
+    return *reinterpret_cast<live_format::segment_header*>(base_);
+  }
+  live_format::ring_header& ring(uint32_t i) const noexcept;
+
+  std::string name_;
+  char* base_;
+  std::size_t size_;
+  std::mutex claim_mutex_;
+  bool names_full_{false};
+};
+
+}  // namespace nvtx_collector
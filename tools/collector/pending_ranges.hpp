@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Process-wide table of open start/end ranges.  Not installed. */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace nvtx_collector {
+
+/**
+ * @brief Fixed-capacity table of start/end ranges that have not ended yet.
+ *
+ * Modes that aggregate instead of recording events need the data of
+ * `nvtxRangeStart*` again at `nvtxRangeEnd`, which may be called on another
+ * thread.  `open` stores the data in a free slot and returns an
+ * `nvtxRangeId_t` naming the slot and its generation; `close` hands the data
+ * back exactly once.  Slots are claimed with a compare-and-swap, so threads
+ * only contend when they touch the same slot.
+ *
+ * Each slot's state word is `generation << 2 | phase`, the phase being free,
+ * open or closing.  The generation advances every time a slot is freed, so a
+ * stale or repeated `close` finds a different state word and fails.
+ */
+template <typename T>
+class pending_ranges {
+ public:
+  static constexpr uint32_t capacity = 1u << 16;
+
+  pending_ranges() : slots_{new slot[capacity]} {}
+
+  /**
+   * @brief Store `value`, returning the range id or 0 if no slot was free.
+   *
+   * `cursor` is the caller's per-thread search position, so threads start
+   * looking at different slots.
+   */
+  uint64_t open(T const& value, uint32_t& cursor) noexcept
+  {
+    for (uint32_t tries = 0; tries < max_probes; ++tries) {
+      uint32_t const i = cursor++ & (capacity - 1);
+      slot& s          = slots_[i];
+      uint32_t state   = s.state.load(std::memory_order_relaxed);
+      if ((state & phase_mask) != phase_free) { continue; }
+      uint32_t const opened = state | phase_open;
+      if (s.state.compare_exchange_strong(state, opened, std::memory_order_acquire)) {
+        s.value = value;
+        return (static_cast<uint64_t>(opened) << 32) | (i + 1u);
+      }
+    }
+    return 0;
+  }
+
+  /**
+   * @brief Retrieve and release the data of range `id`.
+   *
+   * @return false if `id` is not an open range of this table.
+   */
+  bool close(uint64_t id, T& value) noexcept
+  {
+    uint32_t const i = static_cast<uint32_t>(id) - 1u;
+    uint32_t state   = static_cast<uint32_t>(id >> 32);
+    if (i >= capacity || (state & phase_mask) != phase_open) { return false; }
+    slot& s = slots_[i];
+    if (!s.state.compare_exchange_strong(
+          state, (state & ~phase_mask) | phase_closing, std::memory_order_acquire)) {
+      return false;
+    }
+    value = s.value;
+    s.state.store((state & ~phase_mask) + (1u << phase_bits), std::memory_order_release);
+    return true;
+  }
+
+ private:
+  static constexpr uint32_t phase_bits    = 2;
+  static constexpr uint32_t phase_mask    = (1u << phase_bits) - 1u;
+  static constexpr uint32_t phase_free    = 0;
+  static constexpr uint32_t phase_open    = 1;
+  static constexpr uint32_t phase_closing = 2;
+
+  /// Slots tried before `open` gives up; a table that full is leaking ranges.
+  static constexpr uint32_t max_probes = 64;
+
+  struct slot {
+    std::atomic<uint32_t> state{0};
+    T value;
+  };
+
+  std::unique_ptr<slot[]> slots_;
+};
+
+}  // namespace nvtx_collector
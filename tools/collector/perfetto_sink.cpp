@@ -0,0 +1,386 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "protobuf.hpp"
+#include "registry.hpp"
+#include "sink.hpp"
+
+#include <nvtx3/nvToolsExt.h>
+
+#include <cstdio>
+#include <cstring>
+#include <unordered_set>
+#include <vector>
+
+namespace nvtx_collector {
+
+namespace {
+
+/* Field numbers from Perfetto's protos/perfetto/trace/... .proto files */
+namespace trace {
+constexpr uint32_t packet = 1;
+}
+namespace packet {
+constexpr uint32_t timestamp                  = 8;
+constexpr uint32_t trusted_packet_sequence_id = 10;
+constexpr uint32_t track_event                = 11;
+constexpr uint32_t interned_data              = 12;
+constexpr uint32_t sequence_flags             = 13;
+constexpr uint32_t trace_packet_defaults      = 59;
+constexpr uint32_t track_descriptor           = 60;
+}  // namespace packet
+namespace defaults {
+constexpr uint32_t timestamp_clock_id = 58;
+}
+namespace track {
+constexpr uint32_t uuid        = 1;
+constexpr uint32_t name        = 2;
+constexpr uint32_t process     = 3;
+constexpr uint32_t thread      = 4;
+constexpr uint32_t parent_uuid = 5;
+constexpr uint32_t counter     = 8;
+}  // namespace track
+namespace counter {
+constexpr uint32_t unit_name = 6;
+}
+namespace process {
+constexpr uint32_t pid = 1;
+}
+namespace thread {
+constexpr uint32_t pid         = 1;
+constexpr uint32_t tid         = 2;
+constexpr uint32_t thread_name = 5;
+}  // namespace thread
+namespace event {
+constexpr uint32_t category_iids     = 3;
+constexpr uint32_t debug_annotations = 4;
+constexpr uint32_t type              = 9;
+constexpr uint32_t name_iid          = 10;
+constexpr uint32_t track_uuid        = 11;
+constexpr uint32_t slice_begin       = 1;
+constexpr uint32_t slice_end         = 2;
+constexpr uint32_t instant           = 3;
+constexpr uint32_t counter           = 4;
+constexpr uint32_t counter_value     = 30;
+constexpr uint32_t double_value      = 44;
+}  // namespace event
+namespace annotation {
+constexpr uint32_t uint_value   = 3;
+constexpr uint32_t int_value    = 4;
+constexpr uint32_t double_value = 5;
+constexpr uint32_t name         = 10;
+}  // namespace annotation
+namespace interned {
+constexpr uint32_t event_categories = 1;
+constexpr uint32_t event_names      = 2;
+constexpr uint32_t iid              = 1;
+constexpr uint32_t name             = 2;
+}  // namespace interned
+
+constexpr uint32_t sequence_id                   = 1;
+constexpr uint32_t seq_incremental_state_cleared = 1;
+constexpr uint32_t seq_needs_incremental_state   = 2;
+constexpr uint32_t clock_monotonic               = 3;  ///< BUILTIN_CLOCK_MONOTONIC
+
+/// Track uuids: the process track is the pid; threads, start/end ranges and
+/// counters use disjoint ranges above it.
+constexpr uint64_t counter_track_bit = uint64_t{1} << 61;
+constexpr uint64_t thread_track_bit  = uint64_t{1} << 62;
+constexpr uint64_t range_track_bit   = uint64_t{1} << 63;
+
+/**
+ * @brief Streams events as a Perfetto `Trace` protobuf.
+ *
+ * Every event becomes one `TracePacket` appended to the file as soon as it is
+ * written, so memory use does not depend on the length of the capture.
+ * Messages and domains are interned on the packet sequence: each name is
+ * written once and events refer to it by id.  Push/pop ranges and marks are
+ * slices and instants on the recording thread's track; start/end ranges,
+ * which may end on another thread, each get a track of their own.  Each
+ * counter is a counter track of the process, fed by every thread.
+ */
+class perfetto_sink final : public sink {
+ public:
+  perfetto_sink(std::string const& path, registry const& reg, uint32_t pid)
+    : registry_{reg}, pid_{pid}
+  {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+      std::fprintf(stderr, "NVTX collector: cannot open '%s', writing no trace\n", path.c_str());
+      return;
+    }
+    std::setvbuf(file_, nullptr, _IOFBF, 1u << 20);
+
+    // Reset incremental state and default every packet to the collector's clock
+    auto p = begin_packet(seq_incremental_state_cleared);
+    auto d = out_.begin_message(packet::trace_packet_defaults);
+    out_.add_varint(defaults::timestamp_clock_id, clock_monotonic);
+    out_.end_message(d);
+    end_packet(p);
+
+    p       = begin_packet(0);
+    auto t  = out_.begin_message(packet::track_descriptor);
+    out_.add_varint(track::uuid, pid_);
+    auto pr = out_.begin_message(track::process);
+    out_.add_varint(process::pid, pid_);
+    out_.end_message(pr);
+    out_.end_message(t);
+    end_packet(p);
+  }
+
+  ~perfetto_sink() override
+  {
+    if (file_) { std::fclose(file_); }
+  }
+
+  void write(thread_info const& thread, event_record const* events, std::size_t count) override
+  {
+    if (!file_) { return; }
+    if (thread.index >= described_.size()) { described_.resize(thread.index + 1u, false); }
+    if (!described_[thread.index]) {
+      described_[thread.index] = true;
+      thread_descriptor(thread.os_tid, nullptr);
+    }
+    uint64_t const thread_track = thread_track_bit | thread.os_tid;
+
+    for (std::size_t i = 0; i < count; ++i) {
+      event_record const& e = events[i];
+      switch (e.type) {
+        case event_type::push: slice(e, event::slice_begin, thread_track, true); break;
+        case event_type::pop: slice(e, event::slice_end, thread_track, false); break;
+        case event_type::mark: slice(e, event::instant, thread_track, true); break;
+        case event_type::range_start:
+          range_descriptor(e);
+          slice(e, event::slice_begin, range_track_bit | e.range_id, true);
+          break;
+        case event_type::range_end:
+          slice(e, event::slice_end, range_track_bit | e.range_id, false);
+          break;
+        case event_type::counter: counter_sample(e); break;
+        default: break;
+      }
+    }
+  }
+
+  void flush() override
+  {
+    if (file_) { std::fflush(file_); }
+  }
+
+  void close(registry const& reg) override
+  {
+    if (!file_) { return; }
+    // Threads may have been named after their first event
+    for (auto const& n : reg.thread_names()) { thread_descriptor(n.os_tid, n.name.c_str()); }
+    std::fclose(file_);
+    file_ = nullptr;
+  }
+
+ private:
+  proto_writer::message begin_packet(uint32_t flags)
+  {
+    out_.clear();
+    auto p = out_.begin_message(trace::packet);
+    out_.add_varint(packet::trusted_packet_sequence_id, sequence_id);
+    if (flags) { out_.add_varint(packet::sequence_flags, flags); }
+    return p;
+  }
+
+  void end_packet(proto_writer::message p)
+  {
+    out_.end_message(p);
+    std::fwrite(out_.data(), 1, out_.size(), file_);
+  }
+
+  void thread_descriptor(uint32_t os_tid, char const* name)
+  {
+    auto p  = begin_packet(0);
+    auto t  = out_.begin_message(packet::track_descriptor);
+    out_.add_varint(track::uuid, thread_track_bit | os_tid);
+    out_.add_varint(track::parent_uuid, pid_);
+    auto th = out_.begin_message(track::thread);
+    out_.add_varint(thread::pid, pid_);
+    out_.add_varint(thread::tid, os_tid);
+    if (name) { out_.add_string(thread::thread_name, name); }
+    out_.end_message(th);
+    out_.end_message(t);
+    end_packet(p);
+  }
+
+  void range_descriptor(event_record const& e)
+  {
+    auto p = begin_packet(0);
+    auto t = out_.begin_message(packet::track_descriptor);
+    out_.add_varint(track::uuid, range_track_bit | e.range_id);
+    out_.add_varint(track::parent_uuid, pid_);
+    out_.add_string(track::name, registry_.lookup(e.message));
+    out_.end_message(t);
+    end_packet(p);
+  }
+
+  void counter_descriptor(uint64_t uuid, event_record const& e)
+  {
+    std::string unit;
+    for (auto const& c : registry_.counters()) {
+      if (c.domain == e.domain && c.name == e.message) { unit = c.unit; }
+    }
+    std::string const name = domain_name(e.domain) + ": " + registry_.lookup(e.message);
+    auto p = begin_packet(0);
+    auto t = out_.begin_message(packet::track_descriptor);
+    out_.add_varint(track::uuid, uuid);
+    out_.add_varint(track::parent_uuid, pid_);
+    out_.add_string(track::name, name.data(), name.size());
+    auto c = out_.begin_message(track::counter);
+    if (!unit.empty()) { out_.add_string(counter::unit_name, unit.data(), unit.size()); }
+    out_.end_message(c);
+    out_.end_message(t);
+    end_packet(p);
+  }
+
+  void counter_sample(event_record const& e)
+  {
+    uint64_t const uuid = counter_track_bit | (uint64_t{e.domain} << 32) | e.message;
+    if (counters_.insert(uuid).second) { counter_descriptor(uuid, e); }
+
+    auto p = begin_packet(0);
+    out_.add_varint(packet::timestamp, e.timestamp);
+    auto t = out_.begin_message(packet::track_event);
+    out_.add_varint(event::type, event::counter);
+    out_.add_varint(event::track_uuid, uuid);
+    if (e.payload_type == NVTX_PAYLOAD_TYPE_DOUBLE) {
+      double d;
+      std::memcpy(&d, &e.payload, sizeof(d));
+      out_.add_double(event::double_value, d);
+    } else {
+      out_.add_int(event::counter_value, static_cast<int64_t>(e.payload));
+    }
+    out_.end_message(t);
+    end_packet(p);
+  }
+
+  /// Add the interned names used by `e` that were not written yet.
+  void intern(event_record const& e, bool named)
+  {
+    bool const new_name   = named && e.message && !seen(names_, e.message);
+    bool const new_domain = !seen(domains_, e.domain);
+    if (!new_name && !new_domain) { return; }
+
+    auto d = out_.begin_message(packet::interned_data);
+    if (new_domain) {
+      auto c                 = out_.begin_message(interned::event_categories);
+      std::string const name = domain_name(e.domain);
+      out_.add_varint(interned::iid, e.domain + 1u);
+      out_.add_string(interned::name, name.data(), name.size());
+      out_.end_message(c);
+    }
+    if (new_name) {
+      auto n = out_.begin_message(interned::event_names);
+      out_.add_varint(interned::iid, e.message);
+      out_.add_string(interned::name, registry_.lookup(e.message));
+      out_.end_message(n);
+    }
+    out_.end_message(d);
+  }
+
+  static bool seen(std::vector<bool>& set, uint32_t id)
+  {
+    if (id >= set.size()) { set.resize(id + 1u, false); }
+    bool const was = set[id];
+    set[id]        = true;
+    return was;
+  }
+
+  std::string domain_name(uint16_t domain) const
+  {
+    if (domain == 0) { return "NVTX"; }
+    for (auto const& d : registry_.domains()) {
+      if (d.id == domain) { return d.name; }
+    }
+    return std::string();
+  }
+
+  void slice(event_record const& e, uint32_t type, uint64_t track_uuid, bool named)
+  {
+    auto p = begin_packet(seq_needs_incremental_state);
+    out_.add_varint(packet::timestamp, e.timestamp);
+    intern(e, named);
+
+    auto t = out_.begin_message(packet::track_event);
+    out_.add_varint(event::type, type);
+    out_.add_varint(event::track_uuid, track_uuid);
+    out_.add_varint(event::category_iids, e.domain + 1u);
+    if (named && e.message) { out_.add_varint(event::name_iid, e.message); }
+    if (named && e.category) { annotate_category(e.category); }
+    if (named && e.payload_type) { annotate_payload(e); }
+    out_.end_message(t);
+    end_packet(p);
+  }
+
+  void annotate_category(uint32_t category)
+  {
+    auto a = out_.begin_message(event::debug_annotations);
+    out_.add_string(annotation::name, "category");
+    out_.add_varint(annotation::uint_value, category);
+    out_.end_message(a);
+  }
+
+  void annotate_payload(event_record const& e)
+  {
+    auto a = out_.begin_message(event::debug_annotations);
+    out_.add_string(annotation::name, "payload");
+    switch (e.payload_type) {
+      case NVTX_PAYLOAD_TYPE_INT64:
+        out_.add_int(annotation::int_value, static_cast<int64_t>(e.payload));
+        break;
+      case NVTX_PAYLOAD_TYPE_INT32:
+        out_.add_int(annotation::int_value, static_cast<int32_t>(static_cast<uint32_t>(e.payload)));
+        break;
+      case NVTX_PAYLOAD_TYPE_DOUBLE: {
+        double d;
+        std::memcpy(&d, &e.payload, sizeof(d));
+        out_.add_double(annotation::double_value, d);
+        break;
+      }
+      case NVTX_PAYLOAD_TYPE_FLOAT: {
+        uint32_t const bits = static_cast<uint32_t>(e.payload);
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        out_.add_double(annotation::double_value, f);
+        break;
+      }
+      default: out_.add_varint(annotation::uint_value, e.payload); break;
+    }
+    out_.end_message(a);
+  }
+
+  registry const& registry_;
+  uint32_t pid_;
+  std::FILE* file_{nullptr};
+  proto_writer out_;
+  std::vector<bool> described_;  ///< Thread indices whose track was written
+  std::vector<bool> names_;      ///< Interned message ids already written
+  std::vector<bool> domains_;    ///< Interned domain ids already written
+  std::unordered_set<uint64_t> counters_;  ///< Counter tracks already described
+};
+
+}  // namespace
+
+std::unique_ptr<sink> make_perfetto_sink(std::string const& path, registry const& reg, uint32_t pid)
+{
+  return std::unique_ptr<sink>(new perfetto_sink(path, reg, pid));
+}
+
+}  // namespace nvtx_collector
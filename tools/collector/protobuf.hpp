@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* Minimal protocol buffers encoder used by the Perfetto sink.  Internal. */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace nvtx_collector {
+
+/**
+ * @brief Append-only protobuf encoder into a reusable byte buffer.
+ *
+ * Nested messages are written in place: `begin_message` reserves a
+ * fixed-width length that `end_message` fills in with a redundant varint
+ * encoding, so no message is ever encoded twice.  This is the same technique
+ * Perfetto's own protozero library uses.
+ */
+class proto_writer {
+ public:
+  /// Token returned by `begin_message`.
+  using message = std::size_t;
+
+  void clear() noexcept { buffer_.clear(); }
+  char const* data() const noexcept { return buffer_.data(); }
+  std::size_t size() const noexcept { return buffer_.size(); }
+
+  void add_varint(uint32_t field, uint64_t value)
+  {
+    tag(field, wire_varint);
+    varint(value);
+  }
+
+  void add_int(uint32_t field, int64_t value)
+  {
+    add_varint(field, static_cast<uint64_t>(value));
+  }
+
+  void add_double(uint32_t field, double value)
+  {
+    tag(field, wire_fixed64);
+    char bytes[sizeof(value)];
+    std::memcpy(bytes, &value, sizeof(value));
+    buffer_.append(bytes, sizeof(bytes));
+  }
+
+  void add_string(uint32_t field, char const* s, std::size_t length)
+  {
+    tag(field, wire_length);
+    varint(length);
+    buffer_.append(s, length);
+  }
+
+  void add_string(uint32_t field, char const* s) { add_string(field, s, std::strlen(s)); }
+
+  message begin_message(uint32_t field)
+  {
+    tag(field, wire_length);
+    buffer_.append(length_bytes, '\0');
+    return buffer_.size();
+  }
+
+  void end_message(message m)
+  {
+    std::size_t length = buffer_.size() - m;
+    char* p            = &buffer_[m - length_bytes];
+    for (std::size_t i = 0; i < length_bytes; ++i, length >>= 7) {
+      p[i] = static_cast<char>((length & 0x7f) | (i + 1 < length_bytes ? 0x80 : 0));
+    }
+  }
+
+ private:
+  static constexpr uint32_t wire_varint  = 0;
+  static constexpr uint32_t wire_fixed64 = 1;
+  static constexpr uint32_t wire_length  = 2;
+
+  /// Nested messages are limited to 2^28 bytes, far above any packet we write.
+  static constexpr std::size_t length_bytes = 4;
+
+  void tag(uint32_t field, uint32_t wire) { varint((static_cast<uint64_t>(field) << 3) | wire); }
+
+  void varint(uint64_t v)
+  {
+    char bytes[10];
+    std::size_t n = 0;
+    do {
+      bytes[n++] = static_cast<char>((v & 0x7f) | (v > 0x7f ? 0x80 : 0));
+      v >>= 7;
+    } while (v);
+    buffer_.append(bytes, n);
+  }
+
+  std::string buffer_;
+};
+
+}  // namespace nvtx_collector
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "registry.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace nvtx_collector {
+
+namespace {
+
+constexpr uint64_t fnv_offset = 14695981039346656037ull;
+constexpr uint64_t fnv_prime  = 1099511628211ull;
+
+}  // namespace
+
+std::string narrow(wchar_t const* s)
+{
+  std::string out;
+  if (!s) { return out; }
+  for (; *s; ++s) {
+    uint32_t c = static_cast<uint32_t>(*s);
+    if (c < 0x80) {
+      out.push_back(static_cast<char>(c));
+    } else if (c < 0x800) {
+      out.push_back(static_cast<char>(0xC0 | (c >> 6)));
+      out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    } else if (c < 0x10000) {
+      out.push_back(static_cast<char>(0xE0 | (c >> 12)));
+      out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    } else {
+      out.push_back(static_cast<char>(0xF0 | (c >> 18)));
+      out.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    }
+  }
+  return out;
+}
+
+registry::registry()
+{
+  strings_.emplace_back();  // id 0: no message
+  domain_names_.emplace_back();
+}
+
+uint32_t registry::intern(char const* s, std::size_t length)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::string key(s, length);
+  auto it = string_ids_.find(key);
+  if (it != string_ids_.end()) { return it->second; }
+  auto const id = static_cast<uint32_t>(strings_.size());
+  strings_.push_back(key);
+  string_ids_.emplace(std::move(key), id);
+  notify(trace_format::table_kind::strings, id, 0, strings_.back());
+  return id;
+}
+
+char const* registry::lookup(uint32_t id) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return id < strings_.size() ? strings_[id].c_str() : strings_[0].c_str();
+}
+
+nvtxDomainHandle_t registry::create_domain(std::string const& name)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& d : domains_) {
+    if (domain_names_[d.id] == name) { return &d; }
+  }
+  if (domain_names_.size() > max_domain_id) { return nullptr; }
+  uint32_t const disabled = enabled_locked(name) ? 0u : 1u;
+  uint16_t const id       = static_cast<uint16_t>(domain_names_.size());
+  domains_.push_back(nvtxDomainRegistration_st{nvtxDomainFlags_t{disabled}, id});
+  domain_names_.push_back(name);
+  notify(trace_format::table_kind::domains, domains_.back().id, 0, name);
+  return &domains_.back();
+}
+
+void registry::enable_only(std::vector<std::string> names)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  enabled_only_ = std::move(names);
+  for (auto& d : domains_) {
+    d.flags.disabled = enabled_locked(domain_names_[d.id]) ? 0u : 1u;
+  }
+}
+
+bool registry::enabled_locked(std::string const& name) const
+{
+  return enabled_only_.empty() ||
+         std::find(enabled_only_.begin(), enabled_only_.end(), name) != enabled_only_.end();
+}
+
+bool registry::set_enabled(std::string const& name, bool enabled)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& d : domains_) {
+    if (domain_names_[d.id] == name) {
+      d.flags.disabled = enabled ? 0u : 1u;
+      return true;
+    }
+  }
+  return false;
+}
+
+nvtxStringHandle_t registry::register_string(nvtxDomainHandle_t domain, std::string const& s)
+{
+  uint32_t const id = intern(s);
+  std::lock_guard<std::mutex> lock(mutex_);
+  registered_strings_.push_back(nvtxStringRegistration_st{id, domain_id(domain)});
+  return &registered_strings_.back();
+}
+
+nvtxCounterHandle_t registry::register_counter(nvtxDomainHandle_t domain,
+                                               std::string const& name,
+                                               std::string const& unit)
+{
+  uint32_t const id = intern(name);
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& c : counters_) {
+    if (c.name == id && c.domain == domain_id(domain)) { return &c; }
+  }
+  auto const index = static_cast<uint32_t>(counters_.size());
+  counters_.push_back(nvtxCounterRegistration_st{id, index, domain_id(domain)});
+  counter_units_.push_back(unit);
+  notify(trace_format::table_kind::counters, domain_id(domain), id, unit);
+  return &counters_.back();
+}
+
+void registry::name_category(nvtxDomainHandle_t domain, uint32_t category, std::string name)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  notify(trace_format::table_kind::categories, domain_id(domain), category, name);
+  categories_[std::make_pair(domain_id(domain), category)] = std::move(name);
+}
+
+void registry::name_thread(uint32_t os_tid, std::string name)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  notify(trace_format::table_kind::thread_names, os_tid, 0, name);
+  thread_names_[os_tid] = std::move(name);
+}
+
+void registry::set_listener(listener* l)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  listener_ = l;
+  if (!l) { return; }
+  for (std::size_t id = 1; id < strings_.size(); ++id) {
+    l->name_added(trace_format::table_kind::strings, static_cast<uint32_t>(id), 0, strings_[id]);
+  }
+  for (std::size_t id = 1; id < domain_names_.size(); ++id) {
+    l->name_added(
+      trace_format::table_kind::domains, static_cast<uint32_t>(id), 0, domain_names_[id]);
+  }
+  for (auto const& c : categories_) {
+    l->name_added(trace_format::table_kind::categories, c.first.first, c.first.second, c.second);
+  }
+  for (auto const& t : thread_names_) {
+    l->name_added(trace_format::table_kind::thread_names, t.first, 0, t.second);
+  }
+  for (auto const& c : counters_) {
+    l->name_added(trace_format::table_kind::counters, c.domain, c.name, counter_units_[c.index]);
+  }
+}
+
+std::vector<std::string> registry::strings() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return std::vector<std::string>(strings_.begin(), strings_.end());
+}
+
+std::vector<registry::domain_entry> registry::domains() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<domain_entry> out;
+  out.reserve(domain_names_.size());
+  for (std::size_t i = 0; i < domain_names_.size(); ++i) {
+    out.push_back(domain_entry{static_cast<uint16_t>(i), domain_names_[i]});
+  }
+  return out;
+}
+
+std::vector<registry::category_entry> registry::categories() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<category_entry> out;
+  out.reserve(categories_.size());
+  for (auto const& c : categories_) {
+    out.push_back(category_entry{c.first.first, c.first.second, c.second});
+  }
+  return out;
+}
+
+std::vector<registry::thread_name_entry> registry::thread_names() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<thread_name_entry> out;
+  out.reserve(thread_names_.size());
+  for (auto const& t : thread_names_) { out.push_back(thread_name_entry{t.first, t.second}); }
+  return out;
+}
+
+std::vector<registry::counter_entry> registry::counters() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<counter_entry> out;
+  out.reserve(counters_.size());
+  for (auto const& c : counters_) {
+    out.push_back(counter_entry{c.domain, c.name, counter_units_[c.index]});
+  }
+  return out;
+}
+
+string_cache::string_cache(registry& reg, std::size_t initial_capacity)
+  : registry_{&reg}, entries_(initial_capacity, entry{0, nullptr, 0})
+{
+}
+
+uint32_t string_cache::intern(char const* s)
+{
+  if (!s) { return 0; }
+
+  uint64_t hash = fnv_offset;
+  std::size_t length = 0;
+  for (; s[length]; ++length) {
+    hash = (hash ^ static_cast<unsigned char>(s[length])) * fnv_prime;
+  }
+
+  std::size_t const mask = entries_.size() - 1;
+  for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+    entry const& e = entries_[i];
+    if (!e.text) { break; }
+    if (e.hash == hash && std::strcmp(e.text, s) == 0) { return e.id; }
+  }
+  return insert(hash, s, length);
+}
+
+uint32_t string_cache::intern(wchar_t const* s)
+{
+  if (!s) { return 0; }
+  scratch_ = narrow(s);
+  return intern(scratch_.c_str());
+}
+
+uint32_t string_cache::insert(uint64_t hash, char const* s, std::size_t length)
+{
+  if ((size_ + 1) * 2 > entries_.size()) { grow(); }
+
+  uint32_t const id = registry_->intern(s, length);
+  std::size_t const mask = entries_.size() - 1;
+  std::size_t i = hash & mask;
+  while (entries_[i].text) { i = (i + 1) & mask; }
+  entries_[i] = entry{hash, registry_->lookup(id), id};
+  ++size_;
+  return id;
+}
+
+void string_cache::grow()
+{
+  std::vector<entry> old(entries_.size() * 2, entry{0, nullptr, 0});
+  old.swap(entries_);
+  std::size_t const mask = entries_.size() - 1;
+  for (auto const& e : old) {
+    if (!e.text) { continue; }
+    std::size_t i = e.hash & mask;
+    while (entries_[i].text) { i = (i + 1) & mask; }
+    entries_[i] = e;
+  }
+}
+
+}  // namespace nvtx_collector
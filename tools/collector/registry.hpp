@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "trace_format.hpp"
+
+#include <nvtx3/nvToolsExt.h>
+#include <nvtx3/nvToolsExtCounters.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Collector-side definition of the opaque handle returned by
+ * `nvtxDomainCreateA`/`nvtxDomainCreateW`.
+ */
+struct nvtxDomainRegistration_st {
+  nvtxDomainFlags_t flags;  ///< First, as `NVTX_ETID_DOMAINS` requires
+  uint16_t id;
+};
+
+/**
+ * @brief Collector-side definition of the opaque handle returned by
+ * `nvtxDomainRegisterStringA`/`nvtxDomainRegisterStringW`.
+ */
+struct nvtxStringRegistration_st {
+  uint32_t id;      ///< Interned string id, usable directly as `event_record::message`
+  uint16_t domain;  ///< Domain the string was registered in
+};
+
+/**
+ * @brief Collector-side definition of the opaque handle returned by
+ * `nvtxDomainCounterRegisterA`.
+ */
+struct nvtxCounterRegistration_st {
+  uint32_t name;    ///< Interned name id, usable directly as `event_record::message`
+  uint32_t index;   ///< Dense counter index, from 0
+  uint16_t domain;  ///< Domain the counter was registered in
+};
+
+namespace nvtx_collector {
+
+/**
+ * @brief Convert a wide string to UTF-8.
+ */
+std::string narrow(wchar_t const* s);
+
+/**
+ * @brief Process-wide tables of names referenced by event records.
+ *
+ * Every table is guarded by a single mutex.  The recording hot path never
+ * calls into the registry except through a per-thread `string_cache` miss,
+ * which happens once per distinct string per thread.
+ */
+class registry {
+ public:
+  struct domain_entry {
+    uint16_t id;
+    std::string name;
+  };
+
+  struct category_entry {
+    uint16_t domain;
+    uint32_t category;
+    std::string name;
+  };
+
+  struct thread_name_entry {
+    uint32_t os_tid;
+    std::string name;
+  };
+
+  struct counter_entry {
+    uint16_t domain;
+    uint32_t name;  ///< Interned name id
+    std::string unit;
+  };
+
+  /**
+   * @brief Receiver of every name the registry learns.
+   *
+   * Called with the registry lock held, so names arrive in the order they
+   * were added, and a string arrives before any event can refer to it.
+   */
+  class listener {
+   public:
+    virtual ~listener() = default;
+
+    /// Keys as in the binary trace's tables, see `trace_format::table_kind`.
+    virtual void name_added(trace_format::table_kind kind,
+                            uint32_t key,
+                            uint32_t key2,
+                            std::string const& name) = 0;
+  };
+
+  /// Largest domain id; creating more domains returns the global domain.
+  static constexpr uint16_t max_domain_id = UINT16_MAX;
+
+  registry();
+  registry(registry const&) = delete;
+  registry& operator=(registry const&) = delete;
+
+  /**
+   * @brief Return the id of `s`, adding it to the table if needed.
+   *
+   * Ids are dense and start at 1; id 0 means "no message".
+   */
+  uint32_t intern(char const* s, std::size_t length);
+  uint32_t intern(std::string const& s) { return intern(s.data(), s.size()); }
+
+  /**
+   * @brief Look up an interned string.
+   *
+   * The returned pointer stays valid for the life of the registry.
+   * Returns an empty string for unknown ids.
+   */
+  char const* lookup(uint32_t id) const;
+
+  /**
+   * @brief Find or create the domain called `name`.
+   *
+   * Creating the same name twice returns the same handle, so events from
+   * libraries that each create "their" domain aggregate together.
+   */
+  nvtxDomainHandle_t create_domain(std::string const& name);
+
+  /**
+   * @brief Turn off every domain not named in `names`, including those created
+   * later.  An empty list enables all domains.  The global domain, which has
+   * no handle, cannot be turned off.
+   */
+  void enable_only(std::vector<std::string> names);
+
+  /**
+   * @brief Turn the domain called `name` on or off, see `nvtxDomainFlags_t`.
+   *
+   * @return false if no domain of that name has been created.
+   */
+  bool set_enabled(std::string const& name, bool enabled);
+
+  nvtxStringHandle_t register_string(nvtxDomainHandle_t domain, std::string const& s);
+
+  /**
+   * @brief Find or create the counter called `name` in `domain`.  The unit of
+   * the first registration is kept.
+   */
+  nvtxCounterHandle_t register_counter(nvtxDomainHandle_t domain,
+                                       std::string const& name,
+                                       std::string const& unit);
+
+  void name_category(nvtxDomainHandle_t domain, uint32_t category, std::string name);
+  void name_thread(uint32_t os_tid, std::string name);
+
+  /// Domain id of `handle`, 0 for the global domain.
+  static uint16_t domain_id(nvtxDomainHandle_t handle) noexcept
+  {
+    return handle ? handle->id : uint16_t{0};
+  }
+
+  /**
+   * @brief Send every name known so far to `l`, then every new one.  Null
+   * stops sending.  `l` must outlive the registry or be replaced.
+   */
+  void set_listener(listener* l);
+
+  /// Snapshot of every interned string, indexed by id (index 0 is empty).
+  std::vector<std::string> strings() const;
+  std::vector<domain_entry> domains() const;
+  std::vector<category_entry> categories() const;
+  std::vector<thread_name_entry> thread_names() const;
+  std::vector<counter_entry> counters() const;
+
+ private:
+  void notify(trace_format::table_kind kind, uint32_t key, uint32_t key2, std::string const& name)
+  {
+    if (listener_) { listener_->name_added(kind, key, key2, name); }
+  }
+
+  /// Whether a domain called `name` starts enabled; `mutex_` must be held.
+  bool enabled_locked(std::string const& name) const;
+
+  mutable std::mutex mutex_;
+  listener* listener_{nullptr};
+  std::deque<std::string> strings_;
+  std::unordered_map<std::string, uint32_t> string_ids_;
+  std::deque<nvtxDomainRegistration_st> domains_;
+  std::vector<std::string> enabled_only_;
+  std::vector<std::string> domain_names_;
+  std::deque<nvtxStringRegistration_st> registered_strings_;
+  std::map<std::pair<uint16_t, uint32_t>, std::string> categories_;
+  std::map<uint32_t, std::string> thread_names_;
+  std::deque<nvtxCounterRegistration_st> counters_;
+  std::vector<std::string> counter_units_;  ///< Indexed by counter index
+};
+
+/**
+ * @brief Per-thread cache from string contents to interned ids.
+ *
+ * NVTX passes messages as raw pointers whose contents may change between
+ * calls (for example `std::string::c_str()` of a reused buffer), so entries
+ * are keyed by the string contents rather than the pointer.  Lookups hash the
+ * string once and compare against the interned copy; only a miss takes the
+ * registry lock.  The table is open-addressed, never shrinks, and is only
+ * touched by its owning thread.
+ */
+class string_cache {
+ public:
+  explicit string_cache(registry& reg, std::size_t initial_capacity = 256);
+
+  uint32_t intern(char const* s);
+  uint32_t intern(wchar_t const* s);
+
+ private:
+  struct entry {
+    uint64_t hash;
+    char const* text;  ///< Interned copy owned by the registry
+    uint32_t id;
+  };
+
+  uint32_t insert(uint64_t hash, char const* s, std::size_t length);
+  void grow();
+
+  registry* registry_;
+  std::vector<entry> entries_;
+  std::size_t size_{0};
+  std::string scratch_;  ///< Conversion buffer for wide strings
+};
+
+}  // namespace nvtx_collector
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace nvtx_collector {
+
+/**
+ * @brief Bounded single-producer/single-consumer ring of `T`.
+ *
+ * The owning thread is the only producer and the collector's drain thread is
+ * the only consumer, so both sides make progress with one acquire load and one
+ * release store and never block each other.  When the ring is full `try_push`
+ * fails instead of waiting; the caller accounts the dropped element.
+ *
+ * `T` must be trivially copyable.
+ */
+template <typename T>
+class ring_buffer {
+ public:
+  /**
+   * @brief Construct a ring holding at least `capacity` elements.
+   *
+   * The capacity is rounded up to a power of two so indices can be masked.
+   */
+  explicit ring_buffer(std::size_t capacity)
+    : capacity_{round_up_pow2(capacity)},
+      mask_{capacity_ - 1},
+      slots_{new T[capacity_]}
+  {
+  }
+
+  ring_buffer(ring_buffer const&) = delete;
+  ring_buffer& operator=(ring_buffer const&) = delete;
+
+  std::size_t capacity() const noexcept { return capacity_; }
+
+  /**
+   * @brief Append `value`.  Producer side only.
+   *
+   * @return `false` if the ring was full and `value` was not stored.
+   */
+  bool try_push(T const& value) noexcept
+  {
+    uint64_t const head = head_.load(std::memory_order_relaxed);
+    if (head - tail_cache_ >= capacity_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head - tail_cache_ >= capacity_) { return false; }
+    }
+    slots_[head & mask_] = value;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Hand every element currently in the ring to `f`, oldest first.
+   * Consumer side only.
+   *
+   * `f` is called with `(T const* first, std::size_t count)` once or twice,
+   * depending on whether the readable region wraps around the end of storage.
+   *
+   * @return Number of elements consumed.
+   */
+  template <typename F>
+  std::size_t consume(F&& f)
+  {
+    uint64_t const tail = tail_.load(std::memory_order_relaxed);
+    uint64_t const head = head_.load(std::memory_order_acquire);
+    if (head == tail) { return 0; }
+
+    std::size_t const count = static_cast<std::size_t>(head - tail);
+    std::size_t const first = static_cast<std::size_t>(tail & mask_);
+    std::size_t const until_end = capacity_ - first;
+    if (count <= until_end) {
+      f(slots_.get() + first, count);
+    } else {
+      f(slots_.get() + first, until_end);
+      f(slots_.get(), count - until_end);
+    }
+    tail_.store(head, std::memory_order_release);
+    return count;
+  }
+
+  /**
+   * @brief Number of elements waiting to be consumed.  Approximate when
+   * called concurrently with the producer.
+   */
+  std::size_t size() const noexcept
+  {
+    return static_cast<std::size_t>(head_.load(std::memory_order_acquire) -
+                                    tail_.load(std::memory_order_acquire));
+  }
+
+ private:
+  static std::size_t round_up_pow2(std::size_t n) noexcept
+  {
+    std::size_t p = 1;
+    while (p < n) { p <<= 1; }
+    return p;
+  }
+
+  std::size_t const capacity_;
+  std::size_t const mask_;
+  std::unique_ptr<T[]> slots_;
+
+  // Producer and consumer indices live on separate cache lines so the two
+  // threads do not invalidate each other's line on every event.
+  alignas(64) std::atomic<uint64_t> head_{0};
+  uint64_t tail_cache_{0};  ///< Producer's last observed `tail_`
+  alignas(64) std::atomic<uint64_t> tail_{0};
+};
+
+/**
+ * @brief Fixed-size ring of `T` that overwrites its oldest elements.
+ *
+ * The owning thread appends without ever failing or waiting; any other thread
+ * may copy the ring at any time.  A copy cannot stop the producer, so after
+ * copying it re-reads the producer's index and discards the elements that may
+ * have been overwritten meanwhile.
+ *
+ * `T` must be trivially copyable.
+ */
+template <typename T>
+class overwrite_ring {
+ public:
+  /**
+   * @brief Construct a ring holding at least `capacity` elements.
+   */
+  explicit overwrite_ring(std::size_t capacity)
+    : capacity_{round_up_pow2(capacity)}, mask_{capacity_ - 1}, slots_{new T[capacity_]}
+  {
+  }
+
+  overwrite_ring(overwrite_ring const&) = delete;
+  overwrite_ring& operator=(overwrite_ring const&) = delete;
+
+  std::size_t capacity() const noexcept { return capacity_; }
+
+  /**
+   * @brief Append `value`, replacing the oldest element if full.  Producer
+   * side only.
+   */
+  void push(T const& value) noexcept
+  {
+    uint64_t const head  = head_.load(std::memory_order_relaxed);
+    slots_[head & mask_] = value;
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  /**
+   * @brief Replace `out` with the elements in the ring, oldest first.
+   *
+   * Once the ring has wrapped, the oldest slot may be in the middle of being
+   * overwritten, so at most `capacity() - 1` elements are returned.
+   */
+  void snapshot(std::vector<T>& out) const
+  {
+    uint64_t const head  = head_.load(std::memory_order_acquire);
+    uint64_t const first = head > capacity_ ? head - capacity_ : 0;
+    out.clear();
+    out.reserve(static_cast<std::size_t>(head - first));
+    for (uint64_t i = first; i < head; ++i) { out.push_back(slots_[i & mask_]); }
+
+    // Writing element `now` (not yet published) and every element up to it
+    // reuses the slots of the elements `capacity_` older.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t const now = head_.load(std::memory_order_relaxed);
+    if (now + 1 > first + capacity_) {
+      uint64_t const stale = std::min<uint64_t>(out.size(), now + 1 - capacity_ - first);
+      out.erase(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(stale));
+    }
+  }
+
+ private:
+  static std::size_t round_up_pow2(std::size_t n) noexcept
+  {
+    std::size_t p = 1;
+    while (p < n) { p <<= 1; }
+    return p;
+  }
+
+  std::size_t const capacity_;
+  std::size_t const mask_;
+  std::unique_ptr<T[]> slots_;
+  alignas(64) std::atomic<uint64_t> head_{0};
+};
+
+}  // namespace nvtx_collector
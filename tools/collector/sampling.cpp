@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "sampling.hpp"
+
+#include <cmath>
+
+namespace nvtx_collector {
+
+thread_local sampler_thread* tls_sampler = nullptr;
+
+namespace {
+
+/// Frees the thread's sampler at thread exit; no other thread refers to it.
+struct sampler_exit_guard {
+  ~sampler_exit_guard()
+  {
+    delete tls_sampler;
+    tls_sampler = nullptr;
+  }
+};
+
+thread_local sampler_exit_guard tls_sampler_exit_guard;
+
+}  // namespace
+
+sampler_thread::sampler_thread(options const& o, registry& reg)
+  : every_{o.sample_every},
+    threshold_{o.sample_fraction >= 1.0 ? all
+               : o.sample_fraction <= 0.0
+                 ? 0
+                 : static_cast<uint64_t>(std::ldexp(o.sample_fraction, 64))},
+    seed_{o.sample_seed},
+    strings_{reg}
+{
+}
+
+sampler_thread& register_sampler()
+{
+  (void)&tls_sampler_exit_guard;  // Construct the guard so its destructor runs at thread exit
+  tls_sampler = new sampler_thread(g_state->opts, g_state->names);
+  return *tls_sampler;
+}
+
+}  // namespace nvtx_collector
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/* Sampling of NVTX events, shared by the collector's modes.  Not installed. */
+
+#pragma once
+
+#include "collector_impl.hpp"
+#include "handlers.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace nvtx_collector {
+
+/**
+ * @brief Sampling decisions of one thread.
+ *
+ * Two independent rules, both deterministic for a given sequence of events on
+ * the thread:
+ *
+ * - every `options::sample_every`-th instance of each range key is recorded,
+ *   starting with the first;
+ * - of the ranges and marks opened outside any push/pop range, a fraction
+ *   `options::sample_fraction` is recorded, chosen by hashing
+ *   `options::sample_seed` with the number of such events so far.
+ *
+ * Push/pop ranges nest per domain, as in NVTX.  Once a push range is dropped,
+ * everything its domain opens until the matching pop is dropped without being
+ * counted, so recorded push/pop ranges always form a consistent tree.
+ */
+class sampler_thread {
+ public:
+  explicit sampler_thread(options const& o, registry& reg);
+
+  /// Nesting of one domain's push/pop ranges.
+  struct domain_stack {
+    uint32_t depth{0};
+    /// Depth of the outermost dropped range that is still open, or `none`.
+    uint32_t dropped_from{none};
+  };
+
+  static constexpr uint32_t none = UINT32_MAX;
+
+  domain_stack& stack_of(uint16_t domain)
+  {
+    if (NVTX_COLLECTOR_UNLIKELY(domain >= stacks_.size())) { stacks_.resize(domain + 1u); }
+    return stacks_[domain];
+  }
+
+  /**
+   * @brief Decide whether an event not inside a dropped range is recorded.
+   *
+   * @param top_level true if no push/pop range of the domain is open.
+   */
+  template <typename Message>
+  bool sample(uint16_t domain,
+              Message const* message,
+              nvtxEventAttributes_t const* attr,
+              bool top_level)
+  {
+    if (top_level && threshold_ != all && mix(seed_ + ++top_level_events_) >= threshold_) {
+      return false;
+    }
+    if (every_ <= 1) { return true; }
+    uint32_t& n     = seen_[key_of(domain, strings_, message, attr)];
+    bool const keep = n == 0;
+    if (++n == every_) { n = 0; }
+    return keep;
+  }
+
+  /**
+   * @brief Decide whether a mark or start/end range is recorded.
+   */
+  template <typename Message>
+  bool admit(uint16_t domain, Message const* message, nvtxEventAttributes_t const* attr)
+  {
+    domain_stack const& s = stack_of(domain);
+    if (s.dropped_from != none) { return false; }
+    return sample(domain, message, attr, s.depth == 0);
+  }
+
+ private:
+  static constexpr uint64_t all = UINT64_MAX;
+
+  /// splitmix64 finalizer: consecutive inputs give independent-looking outputs.
+  static uint64_t mix(uint64_t x) noexcept
+  {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+  }
+
+  uint32_t every_;
+  uint64_t threshold_;  ///< Top-level events are kept if their hash is below; `all` keeps all
+  uint64_t seed_;
+  uint64_t top_level_events_{0};
+
+  string_cache strings_;
+  std::unordered_map<range_key, uint32_t, range_key_hash> seen_;
+  std::vector<domain_stack> stacks_;
+};
+
+/// Per-thread sampler, null until the thread's first event.
+extern thread_local sampler_thread* tls_sampler;
+
+sampler_thread& register_sampler();
+
+inline sampler_thread& current_sampler()
+{
+  sampler_thread* s = tls_sampler;
+  if (NVTX_COLLECTOR_LIKELY(s != nullptr)) { return *s; }
+  return register_sampler();
+}
+
+/**
+ * @brief Collection mode `Mode` seeing only the events chosen by the calling
+ * thread's `sampler_thread`.
+ *
+ * Dropped start/end ranges get id 0, which every mode treats as no range.
+ * Push and pop return the nesting depth counting dropped ranges, as if every
+ * range had been recorded.
+ */
+template <typename Mode>
+struct sampled {
+  template <typename Message>
+  static void mark(uint16_t domain,
+                   Message const* message,
+                   nvtxEventAttributes_t const* attr,
+                   uint64_t time)
+  {
+    if (current_sampler().admit(domain, message, attr)) { Mode::mark(domain, message, attr, time); }
+  }
+
+  template <typename Message>
+  static nvtxRangeId_t range_start(uint16_t domain,
+                                   Message const* message,
+                                   nvtxEventAttributes_t const* attr,
+                                   uint64_t time)
+  {
+    if (!current_sampler().admit(domain, message, attr)) { return 0; }
+    return Mode::range_start(domain, message, attr, time);
+  }
+
+  static void range_end(uint16_t domain, nvtxRangeId_t id, uint64_t time)
+  {
+    if (id != 0) { Mode::range_end(domain, id, time); }
+  }
+
+  template <typename Message>
+  static int range_push(uint16_t domain,
+                        Message const* message,
+                        nvtxEventAttributes_t const* attr,
+                        uint64_t time)
+  {
+    sampler_thread& s                = current_sampler();
+    sampler_thread::domain_stack& st = s.stack_of(domain);
+    uint32_t const depth             = st.depth++;
+    if (st.dropped_from < depth) { return static_cast<int>(depth); }
+    if (!s.sample(domain, message, attr, depth == 0)) {
+      st.dropped_from = depth;
+      return static_cast<int>(depth);
+    }
+    Mode::range_push(domain, message, attr, time);
+    return static_cast<int>(depth);
+  }
+
+  static int range_pop(uint16_t domain, uint64_t time)
+  {
+    sampler_thread::domain_stack& st = current_sampler().stack_of(domain);
+    if (st.depth == 0) { return -1; }
+    uint32_t const depth = --st.depth;
+    if (depth >= st.dropped_from) {
+      if (depth == st.dropped_from) { st.dropped_from = sampler_thread::none; }
+    } else {
+      Mode::range_pop(domain, time);
+    }
+    return static_cast<int>(depth);
+  }
+};
+
+/**
+ * @brief Whether `o` asks for any event to be dropped.
+ */
+inline bool sampling_enabled(options const& o) noexcept
+{
+  return o.sample_every > 1 || o.sample_fraction < 1.0;
+}
+
+/**
+ * @brief Install the event handlers of `Mode`, behind `sampled` if the
+ * options ask for sampling.  Without sampling, `Mode` is installed directly
+ * and costs nothing extra.
+ */
+template <typename Mode>
+void install_mode_handlers(options const& o, module_tables const& tables)
+{
+  if (sampling_enabled(o)) {
+    install_event_handlers<sampled<Mode>>(tables);
+  } else {
+    install_event_handlers<Mode>(tables);
+  }
+}
+
+}  // namespace nvtx_collector
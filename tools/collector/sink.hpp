@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "event.hpp"
+#include "trace_format.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace nvtx_collector {
+
+class registry;
+
+/**
+ * @brief Identity of the thread a batch of events was recorded on.
+ */
+struct thread_info {
+  uint32_t index;   ///< Dense collector-assigned index, stable for the thread's lifetime
+  uint32_t os_tid;  ///< Operating system thread id
+};
+
+/**
+ * @brief Destination for events drained from the per-thread buffers.
+ *
+ * Sinks are only ever called from one thread at a time (the drain thread, or
+ * the thread calling `flush()`/`shutdown()`), so implementations need no
+ * locking of their own.  Events of one thread arrive in recording order.
+ */
+class sink {
+ public:
+  virtual ~sink() = default;
+
+  /**
+   * @brief Consume `count` events recorded by `thread`.
+   */
+  virtual void write(thread_info const& thread, event_record const* events, std::size_t count) = 0;
+
+  /**
+   * @brief Called after every pending event has been written.
+   */
+  virtual void flush() {}
+
+  /**
+   * @brief Called once at shutdown, after the final `write`.  Names referenced
+   * by the events are available from `reg`.
+   */
+  virtual void close(registry const& reg) { (void)reg; }
+};
+
+/**
+ * @brief Create a sink writing one comma-separated line per event to `path`.
+ *
+ * Messages and domains are resolved to their names while writing.  Intended
+ * for debugging and small captures.
+ */
+std::unique_ptr<sink> make_text_sink(std::string const& path, registry const& reg);
+
+/**
+ * @brief Create a sink writing the binary trace format of `trace_format.hpp`
+ * to `path`.
+ *
+ * Events are copied into per-thread segments of a shared file mapping, so
+ * writing costs a `memcpy` per batch.  The name tables are appended by
+ * `close`.  Read the result with `trace_reader`.
+ */
+std::unique_ptr<sink> make_binary_sink(std::string const& path,
+                                       registry const& reg,
+                                       uint32_t segment_size = trace_format::default_segment_size);
+
+/**
+ * @brief Create a sink streaming a Perfetto protobuf trace to `path`, for
+ * viewing in ui.perfetto.dev or querying with trace_processor.
+ *
+ * Packets are written as events arrive; memory use does not grow with the
+ * number of events.  `pid` identifies the process in the trace.
+ */
+std::unique_ptr<sink> make_perfetto_sink(std::string const& path, registry const& reg, uint32_t pid);
+
+/**
+ * @brief Create a sink streaming Chrome trace event JSON to `path`.
+ *
+ * Accepted by chrome://tracing and Perfetto.  JSON is several times larger and
+ * slower to load than the Perfetto format, so it is meant for small captures.
+ */
+std::unique_ptr<sink> make_json_sink(std::string const& path, registry const& reg, uint32_t pid);
+
+/**
+ * @brief Create a sink that discards events.
+ */
+std::unique_ptr<sink> make_null_sink();
+
+}  // namespace nvtx_collector
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Entry points of the statically linked collector (nvtx3-static-collector). */
+
+#include "collector.hpp"
+
+/**
+ * @brief Called by NVTX during its first API call, once per NVTX instance.
+ *
+ * Named differently from the dynamic entry point so a static and a dynamic
+ * collector never clash in the global symbol namespace.  The CMake target
+ * references this symbol with `-u` so the archive member holding it is always
+ * linked, even though the application itself never calls it.
+ */
+extern "C" int nvtxCollectorStaticInitialize(NvtxGetExportTableFunc_t get_export_table)
+{
+  return nvtx_collector::attach(get_export_table);
+}
+
+/**
+ * @brief Overrides the weak definition in `nvtxInit.h`.
+ *
+ * NVTX checks this pointer before reading `NVTX_INJECTION64_PATH`, so a
+ * process linking the static collector never calls `dlopen` or `dlsym` to
+ * initialize NVTX.
+ */
+extern "C" {
+NvtxInitializeInjectionNvtxFunc_t InitializeInjectionNvtx2_fnptr = nvtxCollectorStaticInitialize;
+}
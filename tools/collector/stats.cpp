@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stats.hpp"
+
+#include "collector_impl.hpp"
+#include "handlers.hpp"
+#include "sampling.hpp"
+#include "histogram.hpp"
+#include "pending_ranges.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstdio>
+#include <unordered_map>
+
+namespace nvtx_collector {
+
+namespace {
+
+/**
+ * @brief One thread's statistics of one key.
+ */
+struct shard_entry {
+  shard_counter count{0};
+  shard_counter total{0};
+  shard_counter min{UINT64_MAX};
+  shard_counter max{0};
+  std::array<shard_counter, log_linear_histogram::bucket_count> buckets{};
+
+  void add(uint64_t duration) noexcept
+  {
+    bump(count, 1);
+    bump(total, duration);
+    if (duration < min.load(std::memory_order_relaxed)) {
+      min.store(duration, std::memory_order_relaxed);
+    }
+    if (duration > max.load(std::memory_order_relaxed)) {
+      max.store(duration, std::memory_order_relaxed);
+    }
+    bump(buckets[log_linear_histogram::bucket_of(duration)], 1);
+  }
+
+  void merge_into(range_statistics& r) const noexcept
+  {
+    r.count += count.load(std::memory_order_relaxed);
+    r.total_ns += total.load(std::memory_order_relaxed);
+    r.min_ns = std::min(r.min_ns, min.load(std::memory_order_relaxed));
+    r.max_ns = std::max(r.max_ns, max.load(std::memory_order_relaxed));
+    for (unsigned b = 0; b < log_linear_histogram::bucket_count; ++b) {
+      uint64_t const n = buckets[b].load(std::memory_order_relaxed);
+      if (n) { r.histogram.add_bucket(b, n); }
+    }
+  }
+};
+
+/// A push/pop range waiting for its pop, or a start/end range for its end.
+struct open_range {
+  range_key key;
+  uint64_t start;
+};
+
+/**
+ * @brief Statistics shard of one thread.
+ *
+ * Only the owning thread adds entries or updates counters.  `entries` is
+ * changed under `mutex`, which the report also takes while reading, so the
+ * owner's lookups need no lock.
+ */
+struct stats_thread {
+  explicit stats_thread(registry& reg) : strings{reg} {}
+
+  string_cache strings;
+  std::mutex mutex;
+  std::unordered_map<range_key, std::unique_ptr<shard_entry>, range_key_hash> entries;
+
+  /// Open push/pop ranges, indexed by domain id.
+  std::vector<std::vector<open_range>> stacks;
+
+  /// Search position in the table of open start/end ranges.
+  uint32_t cursor{0};
+
+  std::atomic<bool> exited{false};
+
+  shard_entry& entry(range_key const& key)
+  {
+    auto it = entries.find(key);
+    if (NVTX_COLLECTOR_LIKELY(it != entries.end())) { return *it->second; }
+    std::unique_ptr<shard_entry> e(new shard_entry);
+    std::lock_guard<std::mutex> lock(mutex);
+    return *entries.emplace(key, std::move(e)).first->second;
+  }
+
+  std::vector<open_range>& stack_of(uint16_t domain)
+  {
+    if (NVTX_COLLECTOR_UNLIKELY(domain >= stacks.size())) { stacks.resize(domain + 1u); }
+    return stacks[domain];
+  }
+};
+
+using stats_map = std::unordered_map<range_key, range_statistics, range_key_hash>;
+
+range_statistics& statistics_of(stats_map& m, range_key const& key)
+{
+  auto it = m.find(key);
+  if (it == m.end()) {
+    range_statistics r{key.domain, key.message, key.category, 0, 0, UINT64_MAX, 0, {}};
+    it = m.emplace(key, r).first;
+  }
+  return it->second;
+}
+
+struct stats_state {
+  /// Guards `threads` and `retired`.
+  std::mutex mutex;
+  std::vector<std::unique_ptr<stats_thread>> threads;
+
+  /// Statistics of threads that have exited, already merged.
+  stats_map retired;
+
+  pending_ranges<open_range> pending;
+};
+
+stats_state* g_stats = nullptr;
+thread_local stats_thread* tls_stats = nullptr;
+
+struct stats_exit_guard {
+  ~stats_exit_guard()
+  {
+    if (tls_stats) {
+      tls_stats->exited.store(true, std::memory_order_release);
+      tls_stats = nullptr;
+    }
+  }
+};
+
+thread_local stats_exit_guard tls_stats_exit_guard;
+
+/// Fold the shards of exited threads into `retired`.  Caller holds `s.mutex`.
+void retire_exited(stats_state& s)
+{
+  auto keep = s.threads.begin();
+  for (auto& t : s.threads) {
+    if (t->exited.load(std::memory_order_acquire)) {
+      for (auto const& e : t->entries) { e.second->merge_into(statistics_of(s.retired, e.first)); }
+    } else {
+      *keep++ = std::move(t);
+    }
+  }
+  s.threads.erase(keep, s.threads.end());
+}
+
+stats_thread& register_stats_thread()
+{
+  stats_thread* t = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(g_stats->mutex);
+    retire_exited(*g_stats);
+    g_stats->threads.emplace_back(new stats_thread(g_state->names));
+    t = g_stats->threads.back().get();
+  }
+  (void)&tls_stats_exit_guard;  // Construct the guard so its destructor runs at thread exit
+  tls_stats = t;
+  return *t;
+}
+
+inline stats_thread& current_stats_thread()
+{
+  stats_thread* t = tls_stats;
+  if (NVTX_COLLECTOR_LIKELY(t != nullptr)) { return *t; }
+  return register_stats_thread();
+}
+
+/**
+ * @brief Event primitives of the statistics mode: ranges update the calling
+ * thread's shard when they end; no event is stored.
+ */
+struct stats_mode {
+  /// Marks have no duration and are not counted.
+  template <typename Message>
+  static void mark(uint16_t, Message const*, nvtxEventAttributes_t const*, uint64_t)
+  {
+  }
+
+  template <typename Message>
+  static nvtxRangeId_t range_start(uint16_t domain,
+                                   Message const* message,
+                                   nvtxEventAttributes_t const* attr,
+                                   uint64_t time)
+  {
+    stats_thread& t = current_stats_thread();
+    open_range r{key_of(domain, t.strings, message, attr), 0};
+    r.start = event_time(time);
+    return g_stats->pending.open(r, t.cursor);
+  }
+
+  static void range_end(uint16_t, nvtxRangeId_t id, uint64_t time)
+  {
+    uint64_t const end = event_time(time);
+    open_range r;
+    if (!g_stats->pending.close(id, r)) { return; }
+    current_stats_thread().entry(r.key).add(end - r.start);
+  }
+
+  template <typename Message>
+  static int range_push(uint16_t domain,
+                        Message const* message,
+                        nvtxEventAttributes_t const* attr,
+                        uint64_t time)
+  {
+    stats_thread& t                = current_stats_thread();
+    std::vector<open_range>& stack = t.stack_of(domain);
+    stack.push_back(open_range{key_of(domain, t.strings, message, attr), 0});
+    stack.back().start = event_time(time);
+    return static_cast<int>(stack.size() - 1);
+  }
+
+  static int range_pop(uint16_t domain, uint64_t time)
+  {
+    uint64_t const end             = event_time(time);
+    stats_thread& t                = current_stats_thread();
+    std::vector<open_range>& stack = t.stack_of(domain);
+    if (stack.empty()) { return -1; }
+    open_range const r = stack.back();
+    stack.pop_back();
+    t.entry(r.key).add(end - r.start);
+    return static_cast<int>(stack.size());
+  }
+};
+
+void create_stats_state() { g_stats = new stats_state; }
+
+}  // namespace
+
+void install_stats_handlers(module_tables const& tables)
+{
+  static std::once_flag created;
+  std::call_once(created, create_stats_state);
+  install_mode_handlers<stats_mode>(g_state->opts, tables);
+}
+
+std::vector<range_statistics> range_report()
+{
+  std::vector<range_statistics> out;
+  if (!g_stats) { return out; }
+
+  stats_map merged;
+  {
+    std::lock_guard<std::mutex> lock(g_stats->mutex);
+    merged = g_stats->retired;
+    for (auto const& t : g_stats->threads) {
+      std::lock_guard<std::mutex> entries_lock(t->mutex);
+      for (auto const& e : t->entries) { e.second->merge_into(statistics_of(merged, e.first)); }
+    }
+  }
+
+  out.reserve(merged.size());
+  for (auto& m : merged) { out.push_back(m.second); }
+  std::sort(out.begin(), out.end(), [](range_statistics const& a, range_statistics const& b) {
+    return a.total_ns > b.total_ns;
+  });
+  return out;
+}
+
+void write_stats_report(std::string const& path, registry const& reg)
+{
+  std::FILE* f = path == "-" ? stdout : std::fopen(path.c_str(), "w");
+  if (!f) {
+    std::fprintf(stderr, "NVTX collector: cannot open '%s', writing to stdout\n", path.c_str());
+    f = stdout;
+  }
+
+  std::vector<registry::domain_entry> const domains = reg.domains();
+  auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+  std::fprintf(f,
+               "%12s %14s %12s %12s %12s %12s %12s %12s  %s\n",
+               "count",
+               "total_us",
+               "mean_us",
+               "min_us",
+               "p50_us",
+               "p90_us",
+               "p99_us",
+               "max_us",
+               "domain:category:name");
+  for (range_statistics const& r : range_report()) {
+    if (r.count == 0) { continue; }
+    // Bucket bounds may lie outside the observed range
+    auto pct = [&](double q) {
+      return us(std::min(r.max_ns, std::max(r.min_ns, r.histogram.percentile(q))));
+    };
+    char const* domain = r.domain < domains.size() ? domains[r.domain].name.c_str() : "";
+    std::fprintf(f,
+                 "%12" PRIu64 " %14.3f %12.3f %12.3f %12.3f %12.3f %12.3f %12.3f  %s:%" PRIu32
+                 ":%s\n",
+                 r.count,
+                 us(r.total_ns),
+                 us(r.total_ns) / static_cast<double>(r.count),
+                 us(r.min_ns),
+                 pct(0.50),
+                 pct(0.90),
+                 pct(0.99),
+                 us(r.max_ns),
+                 domain,
+                 r.category,
+                 reg.lookup(r.message));
+  }
+  if (f != stdout) {
+    std::fclose(f);
+  } else {
+    std::fflush(f);
+  }
+}
+
+}  // namespace nvtx_collector
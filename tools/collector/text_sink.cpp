@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "registry.hpp"
+#include "sink.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+namespace nvtx_collector {
+
+namespace {
+
+char const* type_name(event_type type)
+{
+  switch (type) {
+    case event_type::mark: return "mark";
+    case event_type::push: return "push";
+    case event_type::pop: return "pop";
+    case event_type::range_start: return "start";
+    case event_type::range_end: return "end";
+    case event_type::counter: return "counter";
+    default: return "invalid";
+  }
+}
+
+/// Payload column: the raw bits, or the value of a counter sample.
+void format_payload(char (&out)[32], event_record const& e)
+{
+  if (e.type == event_type::counter && e.payload_type == NVTX_PAYLOAD_TYPE_DOUBLE) {
+    double value;
+    std::memcpy(&value, &e.payload, sizeof(value));
+    std::snprintf(out, sizeof(out), "%.17g", value);
+  } else if (e.type == event_type::counter) {
+    std::snprintf(out, sizeof(out), "%" PRId64, static_cast<int64_t>(e.payload));
+  } else {
+    std::snprintf(out, sizeof(out), "%" PRIu64, e.payload);
+  }
+}
+
+class text_sink final : public sink {
+ public:
+  text_sink(std::string const& path, registry const& reg) : registry_{reg}
+  {
+    file_ = path.empty() || path == "-" ? stdout : std::fopen(path.c_str(), "w");
+    if (!file_) {
+      std::fprintf(stderr, "NVTX collector: cannot open '%s', writing to stdout\n", path.c_str());
+      file_ = stdout;
+    }
+    std::fputs("timestamp_ns,tid,type,domain,message,category,color,payload,range_id\n", file_);
+  }
+
+  ~text_sink() override
+  {
+    if (file_ && file_ != stdout) { std::fclose(file_); }
+  }
+
+  void write(thread_info const& thread, event_record const* events, std::size_t count) override
+  {
+    char payload[32];
+    for (std::size_t i = 0; i < count; ++i) {
+      event_record const& e = events[i];
+      format_payload(payload, e);
+      std::fprintf(file_,
+                   "%" PRIu64 ",%" PRIu32 ",%s,%" PRIu16 ",\"%s\",%" PRIu32 ",0x%08" PRIx32
+                   ",%s,%" PRIu64 "\n",
+                   e.timestamp,
+                   thread.os_tid,
+                   type_name(e.type),
+                   e.domain,
+                   e.message ? registry_.lookup(e.message) : "",
+                   e.category,
+                   e.color,
+                   payload,
+                   e.range_id);
+    }
+  }
+
+  void flush() override { std::fflush(file_); }
+
+  void close(registry const&) override { std::fflush(file_); }
+
+ private:
+  registry const& registry_;
+  std::FILE* file_;
+};
+
+class null_sink final : public sink {
+ public:
+  void write(thread_info const&, event_record const*, std::size_t) override {}
+};
+
+}  // namespace
+
+std::unique_ptr<sink> make_text_sink(std::string const& path, registry const& reg)
+{
+  return std::unique_ptr<sink>(new text_sink(path, reg));
+}
+
+std::unique_ptr<sink> make_null_sink() { return std::unique_ptr<sink>(new null_sink()); }
+
+}  // namespace nvtx_collector
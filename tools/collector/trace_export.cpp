@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* nvtx3-trace-export: convert a binary trace to Perfetto protobuf or Chrome JSON. */
+
+#include "registry.hpp"
+#include "sink.hpp"
+#include "trace_reader.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+int usage()
+{
+  std::fputs("usage: nvtx3-trace-export [--format perfetto|json] INPUT.nvtxtrace OUTPUT\n", stderr);
+  return 2;
+}
+
+/**
+ * @brief Recreate the recording process' registry from the trace's tables.
+ *
+ * Registry ids are assigned densely in creation order, so adding the names in
+ * id order reproduces the ids the records refer to.
+ */
+void replay_names(nvtx_collector::trace_reader const& trace, nvtx_collector::registry& reg)
+{
+  auto const& strings = trace.strings();
+  for (std::size_t id = 1; id < strings.size(); ++id) {
+    reg.intern(strings[id] ? std::string(strings[id]) : "<id " + std::to_string(id) + ">");
+  }
+
+  std::vector<std::pair<uint32_t, char const*>> domains(trace.domains().begin(),
+                                                        trace.domains().end());
+  std::sort(domains.begin(), domains.end());
+  std::vector<nvtxDomainHandle_t> handles{nullptr};
+  for (auto const& d : domains) {
+    if (d.first == 0) { continue; }
+    while (handles.size() < d.first) {
+      handles.push_back(reg.create_domain("<domain " + std::to_string(handles.size()) + ">"));
+    }
+    handles.push_back(reg.create_domain(d.second));
+  }
+
+  for (auto const& c : trace.categories()) {
+    nvtxDomainHandle_t const domain = c.first.first < handles.size() ? handles[c.first.first] : nullptr;
+    reg.name_category(domain, c.first.second, c.second);
+  }
+  for (auto const& t : trace.thread_names()) { reg.name_thread(t.first, t.second); }
+  for (auto const& c : trace.counters()) {
+    nvtxDomainHandle_t const domain = c.first.first < handles.size() ? handles[c.first.first] : nullptr;
+    reg.register_counter(domain, trace.string(c.first.second), c.second);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  std::string format = "perfetto";
+  int arg            = 1;
+  if (arg + 1 < argc && std::strcmp(argv[arg], "--format") == 0) {
+    format = argv[arg + 1];
+    arg += 2;
+  }
+  if (argc - arg != 2 || (format != "perfetto" && format != "json")) { return usage(); }
+
+  try {
+    nvtx_collector::trace_reader trace(argv[arg]);
+    if (!trace.complete()) {
+      std::fprintf(stderr, "nvtx3-trace-export: '%s' was not closed, names are missing\n", argv[arg]);
+    }
+
+    nvtx_collector::registry names;
+    replay_names(trace, names);
+    std::unique_ptr<nvtx_collector::sink> out =
+      format == "json" ? nvtx_collector::make_json_sink(argv[arg + 1], names, trace.pid())
+                       : nvtx_collector::make_perfetto_sink(argv[arg + 1], names, trace.pid());
+
+    // One call per segment keeps memory bounded by the segment size
+    for (auto const& t : trace.threads()) {
+      nvtx_collector::thread_info const info{t.index, t.os_tid};
+      for (auto const& s : t.segments) { out->write(info, s.events, s.count); }
+    }
+    out->close(names);
+  } catch (std::exception const& e) {
+    std::fprintf(stderr, "nvtx3-trace-export: %s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
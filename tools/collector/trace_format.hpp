@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file trace_format.hpp
+ *
+ * @brief On-disk layout of the collector's binary trace files.
+ *
+ * A trace file is a `file_header`, followed by fixed-size segments of event
+ * records, followed by the name tables:
+ *
+ * ```
+ * +-------------+-----------+-----------+-----+-----------+--------+
+ * | file_header | segment 0 | segment 1 | ... | segment N | tables |
+ * +-------------+-----------+-----------+-----+-----------+--------+
+ * ```
+ *
+ * Each segment belongs to a single thread and holds a `segment_header`
+ * followed by `event_record`s in recording order.  A thread fills one segment
+ * at a time; its segments are ordered by `segment_header::sequence`.  Segments
+ * are written through a shared mapping of the file, so their contents reach
+ * the file page by page as the kernel writes them back.
+ *
+ * The tables are written when the trace is closed and hold the names the
+ * records refer to by id.  A file whose `file_header::flags` lacks
+ * `file_complete` was not closed (for example the process crashed); its
+ * segments are still readable up to each `segment_header::event_count`.
+ *
+ * All integers are little-endian.
+ */
+
+#pragma once
+
+#include "event.hpp"
+
+#include <cstdint>
+
+namespace nvtx_collector {
+namespace trace_format {
+
+constexpr char magic[8]          = {'N', 'V', 'T', 'X', 'T', 'R', 'C', 'E'};
+constexpr uint32_t version       = 1;
+constexpr uint32_t segment_magic = 0x4d474553u;  // "SEGM"
+
+/// Default segment size; a multiple of every supported page size.
+constexpr uint32_t default_segment_size = 64u * 1024u;
+
+/// `file_header::flags`: the tables were written and the header is final.
+constexpr uint32_t file_complete = 1u;
+
+struct file_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;     ///< `sizeof(file_header)`
+  uint32_t record_size;     ///< `sizeof(event_record)`
+  uint32_t segment_size;    ///< Bytes per segment, header included
+  uint64_t segments_offset; ///< File offset of the first segment
+  uint64_t segments_end;    ///< File offset past the last segment, 0 until complete
+  uint64_t tables_offset;   ///< File offset of the first table, 0 until complete
+  uint64_t tables_size;     ///< Bytes of tables
+  uint32_t flags;
+  uint32_t pid;             ///< Process the events were recorded in
+  uint32_t reserved[2];
+};
+
+static_assert(sizeof(file_header) == 72, "file_header layout must stay fixed-size");
+
+struct segment_header {
+  uint32_t magic;         ///< `segment_magic`
+  uint32_t thread_index;  ///< Collector thread index, dense from 0
+  uint32_t os_tid;        ///< Operating system thread id
+  uint32_t sequence;      ///< Position of this segment among its thread's segments
+  uint64_t event_count;   ///< Valid records following the header
+  uint64_t reserved;
+};
+
+static_assert(sizeof(segment_header) == 32, "segment_header layout must stay fixed-size");
+
+/// Records that fit in one segment of `segment_size` bytes.
+constexpr uint64_t segment_capacity(uint32_t segment_size)
+{
+  return (segment_size - sizeof(segment_header)) / sizeof(event_record);
+}
+
+enum class table_kind : uint32_t {
+  strings      = 1,  ///< key: string id (`event_record::message`)
+  domains      = 2,  ///< key: domain id
+  categories   = 3,  ///< key: domain id, key2: category
+  thread_names = 4,  ///< key: OS thread id
+  counters     = 5,  ///< key: domain id, key2: counter name string id; name: the counter's unit
+};
+
+/**
+ * @brief Header of one table; `count` entries follow.
+ */
+struct table_header {
+  table_kind kind;
+  uint32_t count;
+  uint64_t size;  ///< Bytes of entries following this header
+};
+
+static_assert(sizeof(table_header) == 16, "table_header layout must stay fixed-size");
+
+/**
+ * @brief Header of one table entry; followed by `length` bytes of UTF-8 name,
+ * a NUL terminator, and padding up to the next multiple of 8 bytes.
+ */
+struct table_entry {
+  uint32_t key;
+  uint32_t key2;
+  uint32_t length;
+  uint32_t reserved;
+};
+
+static_assert(sizeof(table_entry) == 16, "table_entry layout must stay fixed-size");
+
+/// Bytes taken by an entry whose name is `length` bytes long.
+constexpr uint64_t entry_size(uint32_t length)
+{
+  return (sizeof(table_entry) + length + 1u + 7u) & ~uint64_t{7};
+}
+
+}  // namespace trace_format
+}  // namespace nvtx_collector
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "trace_reader.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace nvtx_collector {
+
+namespace {
+
+[[noreturn]] void invalid(std::string const& path, char const* why)
+{
+  throw std::runtime_error("NVTX trace '" + path + "': " + why);
+}
+
+}  // namespace
+
+trace_reader::trace_reader(std::string const& path)
+{
+  int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) { invalid(path, std::strerror(errno)); }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    invalid(path, std::strerror(errno));
+  }
+  size_ = static_cast<std::size_t>(st.st_size);
+  if (size_ < sizeof(header_)) {
+    ::close(fd);
+    invalid(path, "file is too small");
+  }
+  void* p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) { invalid(path, std::strerror(errno)); }
+  data_ = static_cast<char const*>(p);
+
+  std::memcpy(&header_, data_, sizeof(header_));
+  char const* why = nullptr;
+  if (std::memcmp(header_.magic, trace_format::magic, sizeof(header_.magic)) != 0) {
+    why = "not an NVTX trace";
+  } else if (header_.version != trace_format::version) {
+    why = "unsupported version";
+  } else if (header_.record_size != sizeof(event_record) ||
+             header_.segment_size <= sizeof(trace_format::segment_header) ||
+             header_.segments_offset < sizeof(header_)) {
+    why = "corrupt header";
+  } else if (complete() && header_.tables_offset + header_.tables_size > size_) {
+    why = "truncated";
+  }
+  if (why) {
+    ::munmap(const_cast<char*>(data_), size_);
+    invalid(path, why);
+  }
+
+  index_segments();
+  if (complete()) { index_tables(); }
+}
+
+trace_reader::~trace_reader()
+{
+  if (data_) { ::munmap(const_cast<char*>(data_), size_); }
+}
+
+bool trace_reader::complete() const noexcept
+{
+  return (header_.flags & trace_format::file_complete) != 0;
+}
+
+uint64_t trace_reader::event_count() const noexcept
+{
+  uint64_t n = 0;
+  for (thread const& t : threads_) { n += t.event_count; }
+  return n;
+}
+
+void trace_reader::index_segments()
+{
+  // Incomplete traces end at an unused, zero-filled segment or at end of file
+  uint64_t const end      = complete() ? std::min<uint64_t>(header_.segments_end, size_) : size_;
+  uint64_t const capacity = trace_format::segment_capacity(header_.segment_size);
+
+  std::vector<std::pair<uint32_t, std::pair<uint32_t, segment>>> found;  // index, sequence, segment
+  std::unordered_map<uint32_t, uint32_t> os_tids;
+  for (uint64_t off = header_.segments_offset; off + header_.segment_size <= end;
+       off += header_.segment_size) {
+    trace_format::segment_header h;
+    std::memcpy(&h, data_ + off, sizeof(h));
+    if (h.magic != trace_format::segment_magic) { break; }
+    auto const* events =
+      reinterpret_cast<event_record const*>(data_ + off + sizeof(trace_format::segment_header));
+    found.push_back({h.thread_index,
+                     {h.sequence, segment{events, static_cast<std::size_t>(
+                                                    std::min<uint64_t>(h.event_count, capacity))}}});
+    os_tids[h.thread_index] = h.os_tid;
+  }
+
+  std::sort(found.begin(), found.end(), [](auto const& a, auto const& b) {
+    return a.first != b.first ? a.first < b.first : a.second.first < b.second.first;
+  });
+  for (auto const& f : found) {
+    if (threads_.empty() || threads_.back().index != f.first) {
+      threads_.push_back(thread{f.first, os_tids[f.first], {}, 0});
+    }
+    threads_.back().segments.push_back(f.second.second);
+    threads_.back().event_count += f.second.second.count;
+  }
+}
+
+void trace_reader::index_tables()
+{
+  char const* p   = data_ + header_.tables_offset;
+  char const* end = p + header_.tables_size;
+  while (p + sizeof(trace_format::table_header) <= end) {
+    trace_format::table_header t;
+    std::memcpy(&t, p, sizeof(t));
+    p += sizeof(t);
+    char const* const table_end = p + std::min<uint64_t>(t.size, end - p);
+    for (uint32_t i = 0; i < t.count && p + sizeof(trace_format::table_entry) <= table_end; ++i) {
+      trace_format::table_entry e;
+      std::memcpy(&e, p, sizeof(e));
+      if (p + trace_format::entry_size(e.length) > table_end) { break; }
+      char const* name = p + sizeof(e);
+      switch (t.kind) {
+        case trace_format::table_kind::strings:
+          if (e.key >= strings_.size()) { strings_.resize(e.key + 1u, nullptr); }
+          strings_[e.key] = name;
+          break;
+        case trace_format::table_kind::domains: domains_[e.key] = name; break;
+        case trace_format::table_kind::categories: categories_[{e.key, e.key2}] = name; break;
+        case trace_format::table_kind::thread_names: thread_names_[e.key] = name; break;
+        case trace_format::table_kind::counters: counters_[{e.key, e.key2}] = name; break;
+        default: break;  // Tables added by later versions
+      }
+      p += trace_format::entry_size(e.length);
+    }
+    p = table_end;
+  }
+}
+
+char const* trace_reader::string(uint32_t id) const noexcept
+{
+  return id < strings_.size() && strings_[id] ? strings_[id] : "";
+}
+
+char const* trace_reader::domain_name(uint16_t domain) const noexcept
+{
+  auto it = domains_.find(domain);
+  return it != domains_.end() ? it->second : "";
+}
+
+char const* trace_reader::category_name(uint16_t domain, uint32_t category) const noexcept
+{
+  auto it = categories_.find({domain, category});
+  return it != categories_.end() ? it->second : "";
+}
+
+char const* trace_reader::thread_name(uint32_t os_tid) const noexcept
+{
+  auto it = thread_names_.find(os_tid);
+  return it != thread_names_.end() ? it->second : "";
+}
+
+char const* trace_reader::counter_unit(uint16_t domain, uint32_t name) const noexcept
+{
+  auto it = counters_.find({domain, name});
+  return it != counters_.end() ? it->second : "";
+}
+
+}  // namespace nvtx_collector
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file trace_reader.hpp
+ *
+ * @brief Reader for the collector's binary trace files.
+ *
+ * The file is mapped read-only; events and names are returned as pointers
+ * into the mapping and stay valid for the life of the `trace_reader`.
+ */
+
+#pragma once
+
+#include "event.hpp"
+#include "trace_format.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace nvtx_collector {
+
+class trace_reader {
+ public:
+  /// Consecutive records of one thread.
+  struct segment {
+    event_record const* events;
+    std::size_t count;
+  };
+
+  /// Everything one thread recorded, in recording order.
+  struct thread {
+    uint32_t index;
+    uint32_t os_tid;
+    std::vector<segment> segments;
+    uint64_t event_count;
+  };
+
+  /**
+   * @brief Map and index the trace at `path`.
+   *
+   * @throws std::runtime_error if the file cannot be read or is not a trace
+   * of a supported version.
+   */
+  explicit trace_reader(std::string const& path);
+  ~trace_reader();
+
+  trace_reader(trace_reader const&) = delete;
+  trace_reader& operator=(trace_reader const&) = delete;
+
+  /// False if the writer did not close the trace; names are then unavailable.
+  bool complete() const noexcept;
+
+  /// Process the events were recorded in.
+  uint32_t pid() const noexcept { return header_.pid; }
+
+  /// Threads ordered by collector thread index.
+  std::vector<thread> const& threads() const noexcept { return threads_; }
+
+  uint64_t event_count() const noexcept;
+
+  /**
+   * @brief Call `f(thread const&, event_record const&)` for every event,
+   * thread by thread, each thread's events in recording order.
+   */
+  template <typename F>
+  void for_each_event(F&& f) const
+  {
+    for (thread const& t : threads_) {
+      for (segment const& s : t.segments) {
+        for (std::size_t i = 0; i < s.count; ++i) { f(t, s.events[i]); }
+      }
+    }
+  }
+
+  /// Names referenced by records; empty strings for unknown ids.
+  char const* string(uint32_t id) const noexcept;
+  char const* domain_name(uint16_t domain) const noexcept;
+  char const* category_name(uint16_t domain, uint32_t category) const noexcept;
+  char const* thread_name(uint32_t os_tid) const noexcept;
+  /// Unit of the counter whose samples have this domain and message.
+  char const* counter_unit(uint16_t domain, uint32_t name) const noexcept;
+
+  /// Name tables as written by the collector, for tools that copy them.
+  /// `strings()` is indexed by string id and may contain null entries.
+  std::vector<char const*> const& strings() const noexcept { return strings_; }
+  std::unordered_map<uint32_t, char const*> const& domains() const noexcept { return domains_; }
+  std::map<std::pair<uint32_t, uint32_t>, char const*> const& categories() const noexcept
+  {
+    return categories_;
+  }
+  std::unordered_map<uint32_t, char const*> const& thread_names() const noexcept
+  {
+    return thread_names_;
+  }
+  /// Units of the counters, by (domain id, name string id).
+  std::map<std::pair<uint32_t, uint32_t>, char const*> const& counters() const noexcept
+  {
+    return counters_;
+  }
+
+ private:
+  void index_segments();
+  void index_tables();
+
+  char const* data_{nullptr};
+  std::size_t size_{0};
+  trace_format::file_header header_{};
+  std::vector<thread> threads_;
+  std::vector<char const*> strings_;
+  std::unordered_map<uint32_t, char const*> domains_;
+  std::map<std::pair<uint32_t, uint32_t>, char const*> categories_;
+  std::unordered_map<uint32_t, char const*> thread_names_;
+  std::map<std::pair<uint32_t, uint32_t>, char const*> counters_;
+};
+
+}  // namespace nvtx_collector
@@ -0,0 +1,993 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/* NVTX injection library loading several tools and forwarding every NVTX call to each of them. */
+
+#include <nvtx3/nvToolsExt.h>
+#include <nvtx3/nvToolsExtBatch.h>
+#include <nvtx3/nvToolsExtCounters.h>
+#include <nvtx3/nvToolsExtSync.h>
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define NVTX_MUX_EXPORT extern "C" __attribute__((visibility("default")))
+
+namespace nvtx_mux {
+
+namespace {
+
+constexpr unsigned max_tools = 8;
+
+/// Largest callback module plus one, including those of extension headers.
+constexpr unsigned module_count = static_cast<unsigned>(NVTX_CB_MODULE_COUNTER) + 1;
+
+/// Largest callback id plus one of any module.
+constexpr unsigned max_slots = std::max({static_cast<unsigned>(NVTX_CBID_CORE_SIZE),
+                                         static_cast<unsigned>(NVTX_CBID_CUDA_SIZE),
+                                         static_cast<unsigned>(NVTX_CBID_OPENCL_SIZE),
+                                         static_cast<unsigned>(NVTX_CBID_CUDART_SIZE),
+                                         static_cast<unsigned>(NVTX_CBID_CORE2_SIZE),
+                                         static_cast<unsigned>(NVTX_CBID_SYNC_SIZE),
+                                         static_cast<unsigned>(NVTX_CBID_BATCH_SIZE),
+                                         static_cast<unsigned>(NVTX_CBID_COUNTER_SIZE)});
+
+unsigned module_size(unsigned module)
+{
+  switch (module) {
+    case NVTX_CB_MODULE_CORE: return NVTX_CBID_CORE_SIZE;
+    case NVTX_CB_MODULE_CUDA: return NVTX_CBID_CUDA_SIZE;
+    case NVTX_CB_MODULE_OPENCL: return NVTX_CBID_OPENCL_SIZE;
+    case NVTX_CB_MODULE_CUDART: return NVTX_CBID_CUDART_SIZE;
+    case NVTX_CB_MODULE_CORE2: return NVTX_CBID_CORE2_SIZE;
+    case NVTX_CB_MODULE_SYNC: return NVTX_CBID_SYNC_SIZE;
+    case NVTX_CB_MODULE_BATCH: return NVTX_CBID_BATCH_SIZE;
+    case NVTX_CB_MODULE_COUNTER: return NVTX_CBID_COUNTER_SIZE;
+    default: return 0;
+  }
+}
+
+/**
+ * @brief Function pointers the tools stored, by module, callback id and tool.
+ *
+ * The pointers of all tools for one callback share a cache line, which is
+ * all a forwarding handler reads besides its arguments.  Tools are attached
+ * to every NVTX instance of the process through the same tables, so they
+ * must store the same handlers in each, as NVTX tools do.
+ */
+alignas(64) NvtxFunctionPointer g_slots[module_count][max_slots][max_tools];
+
+/// Function tables handed to each tool, pointing into `g_slots`.
+NvtxFunctionPointer* g_tables[max_tools][module_count][max_slots + 1];
+
+struct tool {
+  std::string path;
+  NvtxInitializeInjectionNvtxFunc_t initialize;
+};
+
+tool g_tools[max_tools];
+unsigned g_tool_count = 0;
+
+/// Serializes attaching, which NVTX instances may do concurrently.
+std::mutex g_attach_mutex;
+
+/// Export table of the NVTX instance being attached, for the tables the multiplexer does not own.
+NvtxGetExportTableFunc_t g_attaching = nullptr;
+
+template <typename F>
+inline F slot(unsigned module, unsigned id, unsigned t)
+{
+  return reinterpret_cast<F>(g_slots[module][id][t]);
+}
+
+/**
+ * @brief Handles the tools returned for one handle the multiplexer returned.
+ *
+ * Domains, registered strings, resources, start/end ranges and counters are
+ * created in every tool, and the multiplexer hands out a pointer to the set,
+ * so each tool gets its own handle back.
+ */
+template <typename Handle>
+struct handle_set {
+  Handle of[max_tools];
+};
+
+using domain_set   = handle_set<nvtxDomainHandle_t>;
+using string_set   = handle_set<nvtxStringHandle_t>;
+using resource_set = handle_set<nvtxResourceHandle_t>;
+using range_set    = handle_set<nvtxRangeId_t>;
+using counter_set  = handle_set<nvtxCounterHandle_t>;
+
+inline nvtxDomainHandle_t for_tool(nvtxDomainHandle_t d, unsigned t)
+{
+  return d ? reinterpret_cast<domain_set const*>(d)->of[t] : nullptr;
+}
+
+/**
+ * @brief `a`, or a copy of it holding tool `t`'s handle if its message is a
+ * registered string.
+ */
+template <typename Attributes>
+inline Attributes const* for_tool(Attributes const* a, unsigned t, Attributes& copy)
+{
+  if (!a || a->messageType != NVTX_MESSAGE_TYPE_REGISTERED) { return a; }
+  std::size_t const size = std::min<std::size_t>(a->size, sizeof(copy));
+  std::memcpy(&copy, a, size);
+  copy.size = static_cast<uint16_t>(size);
+  copy.message.registered =
+    a->message.registered
+      ? reinterpret_cast<string_set const*>(a->message.registered)->of[t]
+      : nullptr;
+  return &copy;
+}
+
+template <typename Handle>
+inline Handle publish(handle_set<Handle>* set)
+{
+  return reinterpret_cast<Handle>(set);
+}
+
+inline nvtxRangeId_t publish(range_set* set)
+{
+  return static_cast<nvtxRangeId_t>(reinterpret_cast<uintptr_t>(set));
+}
+
+/// Result of push and pop: the depth reported by the first tool handling them.
+inline int depth_of(int first, int next) { return first < 0 ? next : first; }
+
+inline nvtxStringHandle_t for_tool(nvtxStringHandle_t m, unsigned t)
+{
+  return m ? reinterpret_cast<string_set const*>(m)->of[t] : nullptr;
+}
+
+inline nvtxCounterHandle_t for_tool(nvtxCounterHandle_t c, unsigned t)
+{
+  return c ? reinterpret_cast<counter_set const*>(c)->of[t] : nullptr;
+}
+
+/// Attributes of a compact event, for tools that only handle the `Ex` callbacks.
+inline nvtxEventAttributes_t compact_attributes(nvtxStringHandle_t m,
+                                                uint32_t category,
+                                                int32_t payload_type,
+                                                uint64_t payload)
+{
+  nvtxEventAttributes_t a{};
+  a.version            = NVTX_VERSION;
+  a.size               = NVTX_EVENT_ATTRIB_STRUCT_SIZE;
+  a.category           = category;
+  a.payloadType        = payload_type;
+  a.messageType        = m ? NVTX_MESSAGE_TYPE_REGISTERED : NVTX_MESSAGE_UNKNOWN;
+  a.message.registered = m;
+  switch (payload_type) {
+    case NVTX_PAYLOAD_TYPE_UNSIGNED_INT32:
+    case NVTX_PAYLOAD_TYPE_INT32:
+    case NVTX_PAYLOAD_TYPE_FLOAT: a.payload.uiValue = static_cast<uint32_t>(payload); break;
+    default: a.payload.ullValue = payload; break;
+  }
+  return a;
+}
+
+/**
+ * @brief Handlers calling every tool that stored a function for the callback.
+ */
+struct forward {
+  static constexpr unsigned core    = NVTX_CB_MODULE_CORE;
+  static constexpr unsigned core2   = NVTX_CB_MODULE_CORE2;
+  static constexpr unsigned sync    = NVTX_CB_MODULE_SYNC;
+  static constexpr unsigned batch   = NVTX_CB_MODULE_BATCH;
+  static constexpr unsigned counter = NVTX_CB_MODULE_COUNTER;
+
+  static void NVTX_API MarkEx(nvtxEventAttributes_t const* a)
+  {
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxMarkEx_impl_fntype>(core, NVTX_CBID_CORE_MarkEx, t)) {
+        nvtxEventAttributes_t copy;
+        f(for_tool(a, t, copy));
+      }
+    }
+  }
+
+  static void NVTX_API MarkA(char const* m)
+  {
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxMarkA_impl_fntype>(core, NVTX_CBID_CORE_MarkA, t)) { f(m); }
+    }
+  }
+
+  static void NVTX_API MarkW(wchar_t const* m)
+  {
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxMarkW_impl_fntype>(core, NVTX_CBID_CORE_MarkW, t)) { f(m); }
+    }
+  }
+
+  static nvtxRangeId_t NVTX_API RangeStartEx(nvtxEventAttributes_t const* a)
+  {
+    range_set* r = new range_set{};
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxRangeStartEx_impl_fntype>(core, NVTX_CBID_CORE_RangeStartEx, t)) {
+        nvtxEventAttributes_t copy;
+        r->of[t] = f(for_tool(a, t, copy));
+      }
+    }
+    return publish(r);
+  }
+
+  static nvtxRangeId_t NVTX_API RangeStartA(char const* m)
+  {
+    range_set* r = new range_set{};
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxRangeStartA_impl_fntype>(core, NVTX_CBID_CORE_RangeStartA, t)) {
+        r->of[t] = f(m);
+      }
+    }
+    return publish(r);
+  }
+
+  static nvtxRangeId_t NVTX_API RangeStartW(wchar_t const* m)
+  {
+    range_set* r = new range_set{};
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxRangeStartW_impl_fntype>(core, NVTX_CBID_CORE_RangeStartW, t)) {
+        r->of[t] = f(m);
+      }
+    }
+    return publish(r);
+  }
+
+  static void NVTX_API RangeEnd(nvtxRangeId_t id)
+  {
+    range_set* r = reinterpret_cast<range_set*>(static_cast<uintptr_t>(id));
+    if (!r) { return; }
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      auto f = slot<nvtxRangeEnd_impl_fntype>(core, NVTX_CBID_CORE_RangeEnd, t);
+      if (f && r->of[t]) { f(r->of[t]); }
+    }
+    delete r;
+  }
+
+  static int NVTX_API RangePushEx(nvtxEventAttributes_t const* a)
+  {
+    int depth = NVTX_NO_PUSH_POP_TRACKING;
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxRangePushEx_impl_fntype>(core, NVTX_CBID_CORE_RangePushEx, t)) {
+        nvtxEventAttributes_t copy;
+        depth = depth_of(depth, f(for_tool(a, t, copy)));
+      }
+    }
+    return depth;
+  }
+
+  static int NVTX_API RangePushA(char const* m)
+  {
+    int depth = NVTX_NO_PUSH_POP_TRACKING;
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxRangePushA_impl_fntype>(core, NVTX_CBID_CORE_RangePushA, t)) {
+        depth = depth_of(depth, f(m));
+      }
+    }
+    return depth;
+  }
+
+  static int NVTX_API RangePushW(wchar_t const* m)
+  {
+    int depth = NVTX_NO_PUSH_POP_TRACKING;
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxRangePushW_impl_fntype>(core, NVTX_CBID_CORE_RangePushW, t)) {
+        depth = depth_of(depth, f(m));
+      }
+    }
+    return depth;
+  }
+
+  static int NVTX_API RangePop()
+  {
+    int depth = NVTX_NO_PUSH_POP_TRACKING;
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxRangePop_impl_fntype>(core, NVTX_CBID_CORE_RangePop, t)) {
+        depth = depth_of(depth, f());
+      }
+    }
+    return depth;
+  }
+
+  static void NVTX_API NameCategoryA(uint32_t category, char const* name)
+  {
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxNameCategoryA_impl_fntype>(core, NVTX_CBID_CORE_NameCategoryA, t)) {
+        f(category, name);
+      }
+    }
+  }
+
+  static void NVTX_API NameCategoryW(uint32_t category, wchar_t const* name)
+  {
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxNameCategoryW_impl_fntype>(core, NVTX_CBID_CORE_NameCategoryW, t)) {
+        f(category, name);
+      }
+    }
+  }
+
+  static void NVTX_API NameOsThreadA(uint32_t thread, char const* name)
+  {
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxNameOsThreadA_impl_fntype>(core, NVTX_CBID_CORE_NameOsThreadA, t)) {
+        f(thread, name);
+      }
+    }
+  }
+
+  static void NVTX_API NameOsThreadW(uint32_t thread, wchar_t const* name)
+  {
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxNameOsThreadW_impl_fntype>(core, NVTX_CBID_CORE_NameOsThreadW, t)) {
+        f(thread, name);
+      }
+    }
+  }
+
+  static void NVTX_API DomainMarkEx(nvtxDomainHandle_t d, nvtxEventAttributes_t const* a)
+  {
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxDomainMarkEx_impl_fntype>(core2, NVTX_CBID_CORE2_DomainMarkEx, t)) {
+        nvtxEventAttributes_t copy;
+        f(for_tool(d, t), for_tool(a, t, copy));
+      }
+    }
+  }
+
+  static nvtxRangeId_t NVTX_API DomainRangeStartEx(nvtxDomainHandle_t d,
+                                                   nvtxEventAttributes_t const* a)
+  {
+    range_set* r = new range_set{};
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxDomainRangeStartEx_impl_fntype>(
+            core2, NVTX_CBID_CORE2_DomainRangeStartEx, t)) {
+        nvtxEventAttributes_t copy;
+        r->of[t] = f(for_tool(d, t), for_tool(a, t, copy));
+      }
+    }
+    return publish(r);
+  }
+
+  static void NVTX_API DomainRangeEnd(nvtxDomainHandle_t d, nvtxRangeId_t id)
+  {
+    range_set* r = reinterpret_cast<range_set*>(static_cast<uintptr_t>(id));
+    if (!r) { return; }
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      auto f = slot<nvtxDomainRangeEnd_impl_fntype>(core2, NVTX_CBID_CORE2_DomainRangeEnd, t);
+      if (f && r->of[t]) { f(for_tool(d, t), r->of[t]); }
+    }
+    delete r;
+  }
+
+  static int NVTX_API DomainRangePushEx(nvtxDomainHandle_t d, nvtxEventAttributes_t const* a)
+  {
+    int depth = NVTX_NO_PUSH_POP_TRACKING;
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxDomainRangePushEx_impl_fntype>(
+            core2, NVTX_CBID_CORE2_DomainRangePushEx, t)) {
+        nvtxEventAttributes_t copy;
+        depth = depth_of(depth, f(for_tool(d, t), for_tool(a, t, copy)));
+      }
+    }
+    return depth;
+  }
+
+  static void NVTX_API DomainMarkCompact(
+    nvtxDomainHandle_t d, nvtxStringHandle_t m, uint32_t category, int32_t type, uint64_t payload)
+  {
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxDomainMarkCompact_impl_fntype>(
+            core2, NVTX_CBID_CORE2_DomainMarkCompact, t)) {
+        f(for_tool(d, t), for_tool(m, t), category, type, payload);
+      } else if (auto g = slot<nvtxDomainMarkEx_impl_fntype>(
+                   core2, NVTX_CBID_CORE2_DomainMarkEx, t)) {
+        nvtxEventAttributes_t const a = compact_attributes(for_tool(m, t), category, type, payload);
+        g(for_tool(d, t), &a);
+      }
+    }
+  }
+
+  static nvtxRangeId_t NVTX_API DomainRangeStartCompact(
+    nvtxDomainHandle_t d, nvtxStringHandle_t m, uint32_t category, int32_t type, uint64_t payload)
+  {
+    range_set* r = new range_set{};
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxDomainRangeStartCompact_impl_fntype>(
+            core2, NVTX_CBID_CORE2_DomainRangeStartCompact, t)) {
+        r->of[t] = f(for_tool(d, t), for_tool(m, t), category, type, payload);
+      } else if (auto g = slot<nvtxDomainRangeStartEx_impl_fntype>(
+                   core2, NVTX_CBID_CORE2_DomainRangeStartEx, t)) {
+        nvtxEventAttributes_t const a = compact_attributes(for_tool(m, t), category, type, payload);
+        r->of[t] = g(for_tool(d, t), &a);
+      }
+    }
+    return publish(r);
+  }
+
+  static int NVTX_API DomainRangePushCompact(
+    nvtxDomainHandle_t d, nvtxStringHandle_t m, uint32_t category, int32_t type, uint64_t payload)
+  {
+    int depth = NVTX_NO_PUSH_POP_TRACKING;
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxDomainRangePushCompact_impl_fntype>(
+            core2, NVTX_CBID_CORE2_DomainRangePushCompact, t)) {
+        depth = depth_of(depth, f(for_tool(d, t), for_tool(m, t), category, type, payload));
+      } else if (auto g = slot<nvtxDomainRangePushEx_impl_fntype>(
+                   core2, NVTX_CBID_CORE2_DomainRangePushEx, t)) {
+        nvtxEventAttributes_t const a = compact_attributes(for_tool(m, t), category, type, payload);
+        depth = depth_of(depth, g(for_tool(d, t), &a));
+      }
+    }
+    return depth;
+  }
+
+  static int NVTX_API DomainRangePop(nvtxDomainHandle_t d)
+  {
+    int depth = NVTX_NO_PUSH_POP_TRACKING;
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxDomainRangePop_impl_fntype>(core2, NVTX_CBID_CORE2_DomainRangePop, t)) {
+        depth = depth_of(depth, f(for_tool(d, t)));
+      }
+    }
+    return depth;
+  }
+
+  static nvtxResourceHandle_t NVTX_API DomainResourceCreate(nvtxDomainHandle_t d,
+                                                            nvtxResourceAttributes_t* a)
+  {
+    resource_set* r = new resource_set{};
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxDomainResourceCreate_impl_fntype>(
+            core2, NVTX_CBID_CORE2_DomainResourceCreate, t)) {
+        nvtxResourceAttributes_t copy;
+        r->of[t] = f(for_tool(d, t), const_cast<nvtxResourceAttributes_t*>(for_tool(a, t, copy)));
+      }
+    }
+    return publish(r);
+  }
+
+  static void NVTX_API DomainResourceDestroy(nvtxResourceHandle_t resource)
+  {
+    resource_set* r = reinterpret_cast<resource_set*>(resource);
+    if (!r) { return; }
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      auto f = slot<nvtxDomainResourceDestroy_impl_fntype>(
+        core2, NVTX_CBID_CORE2_DomainResourceDestroy, t);
+      if (f && r->of[t]) { f(r->of[t]); }
+    }
+    delete r;
+  }
+
+  static void NVTX_API DomainNameCategoryA(nvtxDomainHandle_t d, uint32_t category, char const* n)
+  {
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxDomainNameCategoryA_impl_fntype>(
+            core2, NVTX_CBID_CORE2_DomainNameCategoryA, t)) {
+        f(for_tool(d, t), category, n);
+      }
+    }
+  }
+
+  static void NVTX_API DomainNameCategoryW(nvtxDomainHandle_t d,
+                                           uint32_t category,
+                                           wchar_t const* n)
+  {
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxDomainNameCategoryW_impl_fntype>(
+            core2, NVTX_CBID_CORE2_DomainNameCategoryW, t)) {
+        f(for_tool(d, t), category, n);
+      }
+    }
+  }
+
+  /// Registered strings live as long as the process, so their sets are never freed.
+  static nvtxStringHandle_t NVTX_API DomainRegisterStringA(nvtxDomainHandle_t d, char const* s)
+  {
+    string_set* r = new string_set{};
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxDomainRegisterStringA_impl_fntype>(
+            core2, NVTX_CBID_CORE2_DomainRegisterStringA, t)) {
+        r->of[t] = f(for_tool(d, t), s);
+      }
+    }
+    return publish(r);
+  }
+
+  static nvtxStringHandle_t NVTX_API DomainRegisterStringW(nvtxDomainHandle_t d, wchar_t const* s)
+  {
+    string_set* r = new string_set{};
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxDomainRegisterStringW_impl_fntype>(
+            core2, NVTX_CBID_CORE2_DomainRegisterStringW, t)) {
+        r->of[t] = f(for_tool(d, t), s);
+      }
+    }
+    return publish(r);
+  }
+
+  static nvtxDomainHandle_t NVTX_API DomainCreateA(char const* name)
+  {
+    domain_set* r = new domain_set{};
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxDomainCreateA_impl_fntype>(core2, NVTX_CBID_CORE2_DomainCreateA, t)) {
+        r->of[t] = f(name);
+      }
+    }
+    return publish(r);
+  }
+
+  static nvtxDomainHandle_t NVTX_API DomainCreateW(wchar_t const* name)
+  {
+    domain_set* r = new domain_set{};
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxDomainCreateW_impl_fntype>(core2, NVTX_CBID_CORE2_DomainCreateW, t)) {
+        r->of[t] = f(name);
+      }
+    }
+    return publish(r);
+  }
+
+  static void NVTX_API DomainDestroy(nvtxDomainHandle_t d)
+  {
+    domain_set* r = reinterpret_cast<domain_set*>(d);
+    if (!r) { return; }
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      auto f = slot<nvtxDomainDestroy_impl_fntype>(core2, NVTX_CBID_CORE2_DomainDestroy, t);
+      if (f && r->of[t]) { f(r->of[t]); }
+    }
+    delete r;
+  }
+
+  static void NVTX_API Initialize(void const* reserved)
+  {
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxInitialize_impl_fntype>(core2, NVTX_CBID_CORE2_Initialize, t)) {
+        f(reserved);
+      }
+    }
+  }
+
+  /// Sync objects belong to a single tool, `sync_owner`; only their domain is translated.
+  static nvtxSyncUser_t NVTX_API DomainSyncUserCreate(nvtxDomainHandle_t d,
+                                                      nvtxSyncUserAttributes_t const* a)
+  {
+    unsigned const t = sync_owner;
+    auto f =
+      slot<nvtxDomainSyncUserCreate_impl_fntype>(sync, NVTX_CBID_SYNC_DomainSyncUserCreate, t);
+    nvtxSyncUserAttributes_t copy;
+    return f ? f(for_tool(d, t), for_tool(a, t, copy)) : nullptr;
+  }
+
+  /// Submit `e` to tool `t`, which does not handle batches, one event at a time.
+  static void replay_batch(nvtxDomainHandle_t d, nvtxBatchEvent_t* e, std::size_t count, unsigned t)
+  {
+    for (std::size_t i = 0; i < count; ++i) {
+      nvtxEventAttributes_t compact;
+      nvtxEventAttributes_t const* a = e[i].attributes;
+      if (!a) {
+        compact = compact_attributes(e[i].message, e[i].category, NVTX_PAYLOAD_UNKNOWN, 0);
+        a       = &compact;
+      }
+      switch (e[i].type) {
+        case NVTX_BATCH_EVENT_MARK:
+          if (auto f = slot<nvtxDomainMarkEx_impl_fntype>(core2, NVTX_CBID_CORE2_DomainMarkEx, t)) {
+            f(d, a);
+          }
+          break;
+        case NVTX_BATCH_EVENT_RANGE_START:
+          if (auto f = slot<nvtxDomainRangeStartEx_impl_fntype>(
+                core2, NVTX_CBID_CORE2_DomainRangeStartEx, t)) {
+            e[i].rangeId = f(d, a);
+          }
+          break;
+        case NVTX_BATCH_EVENT_RANGE_END:
+          if (auto f =
+                slot<nvtxDomainRangeEnd_impl_fntype>(core2, NVTX_CBID_CORE2_DomainRangeEnd, t)) {
+            f(d, e[i].rangeId);
+          }
+          break;
+        case NVTX_BATCH_EVENT_RANGE_PUSH:
+          if (auto f = slot<nvtxDomainRangePushEx_impl_fntype>(
+                core2, NVTX_CBID_CORE2_DomainRangePushEx, t)) {
+            f(d, a);
+          }
+          break;
+        case NVTX_BATCH_EVENT_RANGE_POP:
+          if (auto f =
+                slot<nvtxDomainRangePop_impl_fntype>(core2, NVTX_CBID_CORE2_DomainRangePop, t)) {
+            f(d);
+          }
+          break;
+        default: break;
+      }
+    }
+  }
+
+  /**
+   * Each tool receives a copy of the batch holding its own handles, and the
+   * range ids it writes go to the range set of the caller's event.  Tools not
+   * handling batches get the events one at a time, at the time of the call.
+   */
+  static void NVTX_API DomainBatchSubmit(nvtxDomainHandle_t d,
+                                         nvtxBatchEvent_t* events,
+                                         std::size_t count)
+  {
+    thread_local std::vector<nvtxBatchEvent_t> copy;
+    thread_local std::vector<nvtxEventAttributes_t> attributes;
+    copy.resize(count);
+    attributes.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+      if (events[i].type == NVTX_BATCH_EVENT_RANGE_START) {
+        events[i].rangeId = publish(new range_set{});
+      }
+    }
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      for (std::size_t i = 0; i < count; ++i) {
+        nvtxBatchEvent_t& e = copy[i];
+        e                   = events[i];
+        e.message           = for_tool(events[i].message, t);
+        e.attributes        = for_tool(events[i].attributes, t, attributes[i]);
+        auto const* r = reinterpret_cast<range_set const*>(static_cast<uintptr_t>(e.rangeId));
+        if (e.type == NVTX_BATCH_EVENT_RANGE_START) { e.rangeId = 0; }
+        if (e.type == NVTX_BATCH_EVENT_RANGE_END) {
+          // Ranges this tool did not start are not its to end
+          e.rangeId = r ? r->of[t] : 0;
+          if (!e.rangeId) { e.type = NVTX_BATCH_EVENT_UNKNOWN; }
+        }
+      }
+      if (auto f = slot<nvtxDomainBatchSubmit_impl_fntype>(
+            batch, NVTX_CBID_BATCH_DomainBatchSubmit, t)) {
+        f(for_tool(d, t), copy.data(), count);
+      } else {
+        replay_batch(for_tool(d, t), copy.data(), count, t);
+      }
+      for (std::size_t i = 0; i < count; ++i) {
+        if (events[i].type == NVTX_BATCH_EVENT_RANGE_START) {
+          reinterpret_cast<range_set*>(static_cast<uintptr_t>(events[i].rangeId))->of[t] =
+            copy[i].rangeId;
+        }
+      }
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+      if (events[i].type == NVTX_BATCH_EVENT_RANGE_END) {
+        delete reinterpret_cast<range_set*>(static_cast<uintptr_t>(events[i].rangeId));
+      }
+    }
+  }
+
+  /// Counters live as long as their domain, which the mux never frees either.
+  static nvtxCounterHandle_t NVTX_API DomainCounterRegisterA(nvtxDomainHandle_t d,
+                                                             char const* name,
+                                                             char const* unit)
+  {
+    counter_set* r = new counter_set{};
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxDomainCounterRegisterA_impl_fntype>(
+            counter, NVTX_CBID_COUNTER_DomainCounterRegisterA, t)) {
+        r->of[t] = f(for_tool(d, t), name, unit);
+      }
+    }
+    return publish(r);
+  }
+
+  static void NVTX_API CounterSampleInt64(nvtxCounterHandle_t c, int64_t value)
+  {
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxCounterSampleInt64_impl_fntype>(
+            counter, NVTX_CBID_COUNTER_CounterSampleInt64, t)) {
+        f(for_tool(c, t), value);
+      }
+    }
+  }
+
+  static void NVTX_API CounterSampleDouble(nvtxCounterHandle_t c, double value)
+  {
+    for (unsigned t = 0; t < g_tool_count; ++t) {
+      if (auto f = slot<nvtxCounterSampleDouble_impl_fntype>(
+            counter, NVTX_CBID_COUNTER_CounterSampleDouble, t)) {
+        f(for_tool(c, t), value);
+      }
+    }
+  }
+
+  static unsigned sync_owner;
+};
+
+unsigned forward::sync_owner = 0;
+
+/**
+ * @brief Handler forwarding callback `id` of `module` to every tool, or null
+ * if the multiplexer does not know the callback's signature.
+ */
+NvtxFunctionPointer forwarder(unsigned module, unsigned id)
+{
+  auto fp = [](auto f) { return reinterpret_cast<NvtxFunctionPointer>(f); };
+  if (module == NVTX_CB_MODULE_CORE) {
+    switch (id) {
+      case NVTX_CBID_CORE_MarkEx: return fp(forward::MarkEx);
+      case NVTX_CBID_CORE_MarkA: return fp(forward::MarkA);
+      case NVTX_CBID_CORE_MarkW: return fp(forward::MarkW);
+      case NVTX_CBID_CORE_RangeStartEx: return fp(forward::RangeStartEx);
+      case NVTX_CBID_CORE_RangeStartA: return fp(forward::RangeStartA);
+      case NVTX_CBID_CORE_RangeStartW: return fp(forward::RangeStartW);
+      case NVTX_CBID_CORE_RangeEnd: return fp(forward::RangeEnd);
+      case NVTX_CBID_CORE_RangePushEx: return fp(forward::RangePushEx);
+      case NVTX_CBID_CORE_RangePushA: return fp(forward::RangePushA);
+      case NVTX_CBID_CORE_RangePushW: return fp(forward::RangePushW);
+      case NVTX_CBID_CORE_RangePop: return fp(forward::RangePop);
+      case NVTX_CBID_CORE_NameCategoryA: return fp(forward::NameCategoryA);
+      case NVTX_CBID_CORE_NameCategoryW: return fp(forward::NameCategoryW);
+      case NVTX_CBID_CORE_NameOsThreadA: return fp(forward::NameOsThreadA);
+      case NVTX_CBID_CORE_NameOsThreadW: return fp(forward::NameOsThreadW);
+      default: return nullptr;
+    }
+  }
+  if (module == NVTX_CB_MODULE_CORE2) {
+    switch (id) {
+      case NVTX_CBID_CORE2_DomainMarkEx: return fp(forward::DomainMarkEx);
+      case NVTX_CBID_CORE2_DomainRangeStartEx: return fp(forward::DomainRangeStartEx);
+      case NVTX_CBID_CORE2_DomainRangeEnd: return fp(forward::DomainRangeEnd);
+      case NVTX_CBID_CORE2_DomainRangePushEx: return fp(forward::DomainRangePushEx);
+      case NVTX_CBID_CORE2_DomainRangePop: return fp(forward::DomainRangePop);
+      case NVTX_CBID_CORE2_DomainResourceCreate: return fp(forward::DomainResourceCreate);
+      case NVTX_CBID_CORE2_DomainResourceDestroy: return fp(forward::DomainResourceDestroy);
+      case NVTX_CBID_CORE2_DomainNameCategoryA: return fp(forward::DomainNameCategoryA);
+      case NVTX_CBID_CORE2_DomainNameCategoryW: return fp(forward::DomainNameCategoryW);
+      case NVTX_CBID_CORE2_DomainRegisterStringA: return fp(forward::DomainRegisterStringA);
+      case NVTX_CBID_CORE2_DomainRegisterStringW: return fp(forward::DomainRegisterStringW);
+      case NVTX_CBID_CORE2_DomainCreateA: return fp(forward::DomainCreateA);
+      case NVTX_CBID_CORE2_DomainCreateW: return fp(forward::DomainCreateW);
+      case NVTX_CBID_CORE2_DomainDestroy: return fp(forward::DomainDestroy);
+      case NVTX_CBID_CORE2_Initialize: return fp(forward::Initialize);
+      case NVTX_CBID_CORE2_DomainMarkCompact: return fp(forward::DomainMarkCompact);
+      case NVTX_CBID_CORE2_DomainRangeStartCompact: return fp(forward::DomainRangeStartCompact);
+      case NVTX_CBID_CORE2_DomainRangePushCompact: return fp(forward::DomainRangePushCompact);
+      default: return nullptr;
+    }
+  }
+  if (module == NVTX_CB_MODULE_SYNC && id == NVTX_CBID_SYNC_DomainSyncUserCreate) {
+    return fp(forward::DomainSyncUserCreate);
+  }
+  if (module == NVTX_CB_MODULE_BATCH && id == NVTX_CBID_BATCH_DomainBatchSubmit) {
+    return fp(forward::DomainBatchSubmit);
+  }
+  if (module == NVTX_CB_MODULE_COUNTER) {
+    switch (id) {
+      case NVTX_CBID_COUNTER_DomainCounterRegisterA: return fp(forward::DomainCounterRegisterA);
+      case NVTX_CBID_COUNTER_CounterSampleInt64: return fp(forward::CounterSampleInt64);
+      case NVTX_CBID_COUNTER_CounterSampleDouble: return fp(forward::CounterSampleDouble);
+      default: return nullptr;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Whether callback `id` of `module` takes and returns no handle, so
+ * a single tool implementing it can be called directly.
+ */
+bool handle_free(unsigned module, unsigned id)
+{
+  if (module == NVTX_CB_MODULE_CORE) {
+    switch (id) {
+      case NVTX_CBID_CORE_MarkA:
+      case NVTX_CBID_CORE_MarkW:
+      case NVTX_CBID_CORE_RangePushA:
+      case NVTX_CBID_CORE_RangePushW:
+      case NVTX_CBID_CORE_RangePop:
+      case NVTX_CBID_CORE_NameCategoryA:
+      case NVTX_CBID_CORE_NameCategoryW:
+      case NVTX_CBID_CORE_NameOsThreadA:
+      case NVTX_CBID_CORE_NameOsThreadW: return true;
+      default: return false;
+    }
+  }
+  if (module == NVTX_CB_MODULE_CORE2) { return id == NVTX_CBID_CORE2_Initialize; }
+  // CUDA, CUDA runtime and OpenCL callbacks name objects of those APIs
+  return module != NVTX_CB_MODULE_SYNC && module != NVTX_CB_MODULE_BATCH &&
+         module != NVTX_CB_MODULE_COUNTER;
+}
+
+template <unsigned Tool>
+int NVTX_API get_module_function_table(NvtxCallbackModule module,
+                                       NvtxFunctionTable* out_table,
+                                       unsigned* out_size)
+{
+  unsigned const size = module_size(module);
+  if (size == 0) { return 0; }
+  if (out_table) { *out_table = g_tables[Tool][module]; }
+  if (out_size) { *out_size = size; }
+  return 1;
+}
+
+template <unsigned Tool>
+void const* NVTX_API get_export_table(uint32_t id)
+{
+  static NvtxExportTableCallbacks const callbacks{sizeof(NvtxExportTableCallbacks),
+                                                  get_module_function_table<Tool>};
+  if (id == NVTX_ETID_CALLBACKS) { return &callbacks; }
+  // Domain handles are the mux's own, which carry no flags
+  if (id == NVTX_ETID_DOMAINS) { return nullptr; }
+  // Version information is the NVTX instance's own
+  return g_attaching ? g_attaching(id) : nullptr;
+}
+
+template <unsigned... Tools>
+constexpr auto make_export_tables(std::integer_sequence<unsigned, Tools...>)
+{
+  return std::array<NvtxGetExportTableFunc_t, sizeof...(Tools)>{get_export_table<Tools>...};
+}
+
+/// Export table given to each tool, differing only in the function tables they return.
+constexpr auto g_export_tables =
+  make_export_tables(std::make_integer_sequence<unsigned, max_tools>{});
+
+void load_tools()
+{
+  for (unsigned t = 0; t < max_tools; ++t) {
+    for (unsigned m = 1; m < module_count; ++m) {
+      unsigned const size = module_size(m);
+      g_tables[t][m][0]   = nullptr;
+      for (unsigned id = 1; id < size; ++id) { g_tables[t][m][id] = &g_slots[m][id][t]; }
+      g_tables[t][m][size] = nullptr;
+    }
+  }
+
+  char const* list = std::getenv("NVTX_MUX_TOOLS");
+  if (!list) { return; }
+  std::string const paths(list);
+  std::size_t begin = 0;
+  while (begin <= paths.size()) {
+    std::size_t end = paths.find(':', begin);
+    if (end == std::string::npos) { end = paths.size(); }
+    std::string const path = paths.substr(begin, end - begin);
+    begin = end + 1;
+    if (path.empty()) { continue; }
+    if (g_tool_count == max_tools) {
+      std::fprintf(
+        stderr, "NVTX mux: more than %u tools, ignoring '%s'\n", max_tools, path.c_str());
+      continue;
+    }
+    void* library = ::dlopen(path.c_str(), RTLD_LAZY);
+    auto initialize =
+      library ? reinterpret_cast<NvtxInitializeInjectionNvtxFunc_t>(
+                  ::dlsym(library, "InitializeInjectionNvtx2"))
+              : nullptr;
+    if (!initialize) {
+      std::fprintf(stderr, "NVTX mux: cannot load tool '%s'\n", path.c_str());
+      if (library) { ::dlclose(library); }
+      continue;
+    }
+    g_tools[g_tool_count++] = tool{path, initialize};
+  }
+}
+
+/**
+ * @brief Fill NVTX table `table` of `module` from what the tools stored.
+ *
+ * A callback stored by one tool only is called directly if it involves no
+ * handle; otherwise the forwarding handler calls each tool in turn.
+ */
+void install_module(unsigned module, NvtxFunctionTable table, unsigned size)
+{
+  size = std::min(size, module_size(module));
+  for (unsigned id = 1; id < size; ++id) {
+    if (!table[id]) { continue; }
+    unsigned implementors = 0;
+    unsigned first        = 0;
+    for (unsigned t = g_tool_count; t-- > 0;) {
+      if (g_slots[module][id][t]) {
+        ++implementors;
+        first = t;
+      }
+    }
+    if (implementors == 0) { continue; }
+
+    if (module == NVTX_CB_MODULE_SYNC) { first = forward::sync_owner; }
+    NvtxFunctionPointer const forwarding = forwarder(module, id);
+    if (forwarding && !(implementors == 1 && handle_free(module, id))) {
+      *table[id] = forwarding;
+      continue;
+    }
+    if (implementors > 1 && module != NVTX_CB_MODULE_SYNC) {
+      std::fprintf(stderr,
+                   "NVTX mux: callback %u of module %u is only forwarded to '%s'\n",
+                   id,
+                   module,
+                   g_tools[first].path.c_str());
+    }
+    *table[id] = g_slots[module][id][first];
+  }
+}
+
+/// Tool owning the sync objects: the first one creating them.
+unsigned find_sync_owner()
+{
+  for (unsigned t = 0; t < g_tool_count; ++t) {
+    if (g_slots[NVTX_CB_MODULE_SYNC][NVTX_CBID_SYNC_DomainSyncUserCreate][t]) { return t; }
+  }
+  return 0;
+}
+
+int attach(NvtxGetExportTableFunc_t get_export_table)
+{
+  if (!get_export_table) { return 0; }
+  std::lock_guard<std::mutex> lock(g_attach_mutex);
+  static std::once_flag loaded;
+  std::call_once(loaded, load_tools);
+
+  // With a single tool there is nothing to multiplex: it gets the NVTX tables themselves
+  if (g_tool_count == 1) { return g_tools[0].initialize(get_export_table); }
+
+  auto const* callbacks =
+    static_cast<NvtxExportTableCallbacks const*>(get_export_table(NVTX_ETID_CALLBACKS));
+  if (!callbacks || callbacks->struct_size < sizeof(NvtxExportTableCallbacks) ||
+      !callbacks->GetModuleFunctionTable) {
+    return 0;
+  }
+
+  g_attaching   = get_export_table;
+  bool attached = false;
+  for (unsigned t = 0; t < g_tool_count; ++t) {
+    if (g_tools[t].initialize(g_export_tables[t])) {
+      attached = true;
+    } else {
+      std::fprintf(stderr, "NVTX mux: tool '%s' failed to initialize\n", g_tools[t].path.c_str());
+      for (auto& module : g_slots) {
+        for (auto& callback : module) { callback[t] = nullptr; }
+      }
+    }
+  }
+  g_attaching = nullptr;
+  if (!attached) { return 0; }
+
+  forward::sync_owner = find_sync_owner();
+  for (unsigned m = 1; m < module_count; ++m) {
+    NvtxFunctionTable table = nullptr;
+    unsigned size           = 0;
+    if (callbacks->GetModuleFunctionTable(static_cast<NvtxCallbackModule>(m), &table, &size) &&
+        table) {
+      install_module(m, table, size);
+    }
+  }
+  return 1;
+}
+
+}  // namespace
+
+}  // namespace nvtx_mux
+
+/**
+ * @brief Called by NVTX during its first API call, once per NVTX instance.
+ */
+NVTX_MUX_EXPORT int InitializeInjectionNvtx2(NvtxGetExportTableFunc_t get_export_table)
+{
+  return nvtx_mux::attach(get_export_table);
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <nvtx3/nvToolsExt.h>
+
+#include "async_init_tool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Built with NVTX_INIT_ASYNC=1 and linked with a tool whose initialization
+// blocks until async_init_tool::release().
+TEST(AsyncInit, EventsDoNotWaitForTool)
+{
+  // Initialization starts when the executable is loaded, without an NVTX call
+  ASSERT_TRUE(async_init_tool::wait_entered(std::chrono::seconds(10)));
+
+  // Events return at once and are dropped while the tool is loading
+  nvtxMarkA("before");
+  EXPECT_EQ(nvtxRangePushA("before"), NVTX_NO_PUSH_POP_TRACKING);
+  EXPECT_EQ(nvtxRangePop(), NVTX_NO_PUSH_POP_TRACKING);
+  nvtxRangeId_t const dropped_range = nvtxRangeStartA("before");
+  EXPECT_EQ(dropped_range, nvtxRangeId_t{0});
+  nvtxRangePushA("open");
+
+  // Creating a domain waits, so the handle is the tool's
+  std::atomic<bool> created{false};
+  nvtxDomainHandle_t domain = nullptr;
+  std::thread creator([&] {
+    domain = nvtxDomainCreateA("async_init_test");
+    created.store(true);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(created.load());
+
+  async_init_tool::release();
+  creator.join();
+  EXPECT_EQ(domain, async_init_tool::domain());
+
+  nvtxMarkA("after");
+  EXPECT_EQ(async_init_tool::marks(), 1);
+
+  // The tool sees no end of a range whose start it missed
+  nvtxRangePushA("after");
+  nvtxRangePop();
+  nvtxRangePop();
+  nvtxRangeEnd(dropped_range);
+  EXPECT_EQ(async_init_tool::pushes(), 1);
+  EXPECT_EQ(async_init_tool::pops(), 1);
+  EXPECT_EQ(async_init_tool::ends(), 0);
+}
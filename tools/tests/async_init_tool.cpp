@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/* Tool of ASYNC_INIT_TEST, whose initialization waits until the test releases it.  Its own
+ * translation unit, because one that includes the NVTX implementation already holds the weak
+ * definition of InitializeInjectionNvtx2_fnptr. */
+
+#define NVTX_NO_IMPL
+#include <nvtx3/nvToolsExt.h>
+
+#include "async_init_tool.hpp"
+
+#include <atomic>
+#include <thread>
+
+namespace {
+
+// NVTX starts initializing before static constructors of this file may have run, so the state
+// shared with the test is constant-initialized.
+std::atomic<bool> g_entered{false};
+std::atomic<bool> g_released{false};
+std::atomic<int> g_marks{0};
+std::atomic<int> g_pushes{0};
+std::atomic<int> g_pops{0};
+std::atomic<int> g_ends{0};
+int g_domain_storage = 0;
+
+void NVTX_API count_mark(char const*) { ++g_marks; }
+
+int NVTX_API count_push(char const*) { return g_pushes++; }
+
+int NVTX_API count_pop() { return g_pops++; }
+
+void NVTX_API count_end(nvtxRangeId_t) { ++g_ends; }
+
+nvtxDomainHandle_t NVTX_API create_domain(char const*)
+{
+  return reinterpret_cast<nvtxDomainHandle_t>(&g_domain_storage);
+}
+
+int NVTX_API blocking_tool_init(NvtxGetExportTableFunc_t get_export_table)
+{
+  g_entered.store(true);
+  while (!g_released.load()) { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }
+
+  auto const* callbacks =
+    static_cast<NvtxExportTableCallbacks const*>(get_export_table(NVTX_ETID_CALLBACKS));
+  NvtxFunctionTable core  = nullptr;
+  NvtxFunctionTable core2 = nullptr;
+  unsigned core_size      = 0;
+  unsigned core2_size     = 0;
+  if (!callbacks->GetModuleFunctionTable(NVTX_CB_MODULE_CORE, &core, &core_size) ||
+      !callbacks->GetModuleFunctionTable(NVTX_CB_MODULE_CORE2, &core2, &core2_size)) {
+    return 0;
+  }
+  *core[NVTX_CBID_CORE_MarkA]          = reinterpret_cast<NvtxFunctionPointer>(count_mark);
+  *core[NVTX_CBID_CORE_RangePushA]     = reinterpret_cast<NvtxFunctionPointer>(count_push);
+  *core[NVTX_CBID_CORE_RangePop]       = reinterpret_cast<NvtxFunctionPointer>(count_pop);
+  *core[NVTX_CBID_CORE_RangeEnd]       = reinterpret_cast<NvtxFunctionPointer>(count_end);
+  *core2[NVTX_CBID_CORE2_DomainCreateA] = reinterpret_cast<NvtxFunctionPointer>(create_domain);
+  return 1;
+}
+
+}  // namespace
+
+extern "C" {
+NvtxInitializeInjectionNvtxFunc_t InitializeInjectionNvtx2_fnptr = blocking_tool_init;
+}
+
+bool async_init_tool::wait_entered(std::chrono::milliseconds timeout)
+{
+  auto const deadline = std::chrono::steady_clock::now() + timeout;
+  while (!g_entered.load()) {
+    if (std::chrono::steady_clock::now() > deadline) { return false; }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+void async_init_tool::release() { g_released.store(true); }
+
+int async_init_tool::marks() { return g_marks.load(); }
+
+int async_init_tool::pushes() { return g_pushes.load(); }
+
+int async_init_tool::pops() { return g_pops.load(); }
+
+int async_init_tool::ends() { return g_ends.load(); }
+
+nvtxDomainHandle_t async_init_tool::domain()
+{
+  return reinterpret_cast<nvtxDomainHandle_t>(&g_domain_storage);
+}
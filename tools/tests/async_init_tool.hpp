@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/* Control of the tool used by ASYNC_INIT_TEST. */
+
+#pragma once
+
+#include <nvtx3/nvToolsExt.h>
+
+#include <chrono>
+
+namespace async_init_tool {
+
+/// Wait until NVTX has called the tool's initialization function.
+bool wait_entered(std::chrono::milliseconds timeout);
+
+/// Let the tool's initialization function finish.
+void release();
+
+/// Number of `nvtxMarkA` calls that reached the tool.
+int marks();
+
+/// Number of `nvtxRangePushA`, `nvtxRangePop` and `nvtxRangeEnd` calls that reached the tool.
+int pushes();
+int pops();
+int ends();
+
+/// Handle the tool returns from `nvtxDomainCreateA`.
+nvtxDomainHandle_t domain();
+
+}  // namespace async_init_tool
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <nvtx3/nvtx3.hpp>
+
+#include <collector.hpp>
+#include <registry.hpp>
+#include <sink.hpp>
+
+#include "memory_sink.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct batch_domain {
+  static constexpr char const* name{"batch_test"};
+};
+
+struct batch_item {
+  static constexpr char const* message{"batch_item"};
+};
+
+/// Record into `recorded()` until destroyed, which must happen before the collector shuts down.
+struct recording {
+  recording()
+  {
+    nvtx3::mark_in<batch_domain>("batch_init");
+    nvtx_collector::set_sink(std::unique_ptr<nvtx_collector::sink>(new memory_sink));
+    recorded().clear();
+  }
+  ~recording() { nvtx_collector::set_sink(nullptr); }
+};
+
+}  // namespace
+
+TEST(Batch, SubmitsEventsWithTheirTimestamps)
+{
+  recording r;
+  nvtxDomainHandle_t domain = nvtx3::domain::get<batch_domain>();
+  nvtxStringHandle_t item   = nvtxDomainRegisterStringA(domain, "batch_c_item");
+
+  nvtxEventAttributes_t attr{};
+  attr.version       = NVTX_VERSION;
+  attr.size          = NVTX_EVENT_ATTRIB_STRUCT_SIZE;
+  attr.messageType   = NVTX_MESSAGE_TYPE_ASCII;
+  attr.message.ascii = "batch_c_mark";
+
+  nvtxBatchEvent_t events[4]{};
+  events[0].type       = NVTX_BATCH_EVENT_RANGE_PUSH;
+  events[0].message    = item;
+  events[0].category   = 7;
+  events[0].timestamp  = 1000;
+  events[1].type       = NVTX_BATCH_EVENT_MARK;
+  events[1].attributes = &attr;
+  events[1].timestamp  = 1500;
+  events[2].type       = NVTX_BATCH_EVENT_RANGE_POP;
+  events[2].timestamp  = 2000;
+  events[3].type       = NVTX_BATCH_EVENT_RANGE_START;
+  events[3].message    = item;
+  nvtxDomainBatchSubmit(domain, events, 4);
+  EXPECT_NE(events[3].rangeId, 0u);
+
+  nvtxBatchEvent_t end{};
+  end.type    = NVTX_BATCH_EVENT_RANGE_END;
+  end.rangeId = events[3].rangeId;
+  nvtxDomainBatchSubmit(domain, &end, 1);
+  nvtx_collector::flush();
+
+  using nvtx_collector::event_type;
+  ASSERT_EQ(recorded().size(), 5u);
+  EXPECT_EQ(recorded()[0].type, event_type::push);
+  EXPECT_EQ(recorded()[0].timestamp, 1000u);
+  EXPECT_EQ(recorded()[0].category, 7u);
+  EXPECT_STREQ(nvtx_collector::names().lookup(recorded()[0].message), "batch_c_item");
+  EXPECT_EQ(recorded()[1].type, event_type::mark);
+  EXPECT_EQ(recorded()[1].timestamp, 1500u);
+  EXPECT_STREQ(nvtx_collector::names().lookup(recorded()[1].message), "batch_c_mark");
+  EXPECT_EQ(recorded()[2].type, event_type::pop);
+  EXPECT_EQ(recorded()[2].timestamp, 2000u);
+  // Without a timestamp, the time of the submission
+  EXPECT_EQ(recorded()[3].type, event_type::range_start);
+  EXPECT_GT(recorded()[3].timestamp, 2000u);
+  EXPECT_EQ(recorded()[4].type, event_type::range_end);
+  EXPECT_EQ(recorded()[4].range_id, recorded()[3].range_id);
+  EXPECT_NE(recorded()[0].domain, 0u);
+}
+
+TEST(Batch, ThreadBufferFlushesInOrder)
+{
+  recording r;
+  auto& batch = nvtx3::event_batch_in<batch_domain>::this_thread();
+  auto& item  = nvtx3::registered_string_in<batch_domain>::get<batch_item>();
+
+  uint64_t const before = nvtxGetTimestamp();
+  {
+    nvtx3::batched_range_in<batch_domain> outer{nvtx3::event_attributes{"batch_outer"}};
+    batch.mark(item, nvtx3::category{3});
+    { nvtx3::batched_range_in<batch_domain> inner{item}; }
+  }
+  EXPECT_EQ(batch.size(), 5u);
+  nvtx_collector::flush();
+  EXPECT_TRUE(recorded().empty());
+
+  batch.flush();
+  EXPECT_EQ(batch.size(), 0u);
+  nvtx_collector::flush();
+
+  using nvtx_collector::event_type;
+  ASSERT_EQ(recorded().size(), 5u);
+  EXPECT_EQ(recorded()[0].type, event_type::push);
+  EXPECT_STREQ(nvtx_collector::names().lookup(recorded()[0].message), "batch_outer");
+  EXPECT_EQ(recorded()[1].type, event_type::mark);
+  EXPECT_EQ(recorded()[1].category, 3u);
+  EXPECT_STREQ(nvtx_collector::names().lookup(recorded()[1].message), "batch_item");
+  EXPECT_EQ(recorded()[2].type, event_type::push);
+  EXPECT_EQ(recorded()[3].type, event_type::pop);
+  EXPECT_EQ(recorded()[4].type, event_type::pop);
+  EXPECT_GE(recorded()[0].timestamp, before);
+  for (std::size_t i = 1; i < recorded().size(); ++i) {
+    EXPECT_GE(recorded()[i].timestamp, recorded()[i - 1].timestamp);
+  }
+}
+
+TEST(Batch, FullBufferFlushes)
+{
+  recording r;
+  using batch_type = nvtx3::event_batch_in<batch_domain>;
+  auto& batch      = batch_type::this_thread();
+  for (std::size_t i = 0; i <= batch_type::capacity; ++i) {
+    batch.mark(nvtx3::event_attributes{"batch_many"});
+  }
+  EXPECT_EQ(batch.size(), 1u);
+  batch.flush();
+  nvtx_collector::flush();
+  ASSERT_EQ(recorded().size(), batch_type::capacity + 1);
+  for (auto const& e : recorded()) {
+    EXPECT_STREQ(nvtx_collector::names().lookup(e.message), "batch_many");
+  }
+}
+
+TEST(Timestamp, EventsKeepTheGivenTime)
+{
+  recording r;
+  nvtxDomainHandle_t domain = nvtx3::domain::get<batch_domain>();
+
+  nvtx3::mark_in<batch_domain>(nvtx3::timestamp{100}, "stamped_mark", nvtx3::category{2});
+  { nvtx3::checked_range_in<batch_domain> range{nvtx3::timestamp{200}, "stamped_range"}; }
+  auto h = nvtx3::start_range_in<batch_domain>(nvtx3::timestamp{300}, "stamped_start");
+  nvtx3::end_range_in<batch_domain>(h, nvtx3::timestamp{400});
+
+  nvtxEventAttributes_t attr{};
+  attr.version       = NVTX_VERSION;
+  attr.size          = NVTX_EVENT_ATTRIB_STRUCT_SIZE;
+  attr.messageType   = NVTX_MESSAGE_TYPE_ASCII;
+  attr.message.ascii = "stamped_push";
+  nvtxDomainRangePushExAt(domain, &attr, 500);
+  nvtxDomainRangePopAt(domain, 600);
+  nvtx_collector::flush();
+
+  using nvtx_collector::event_type;
+  ASSERT_EQ(recorded().size(), 7u);
+  EXPECT_EQ(recorded()[0].type, event_type::mark);
+  EXPECT_EQ(recorded()[0].timestamp, 100u);
+  EXPECT_EQ(recorded()[0].category, 2u);
+  EXPECT_STREQ(nvtx_collector::names().lookup(recorded()[0].message), "stamped_mark");
+  EXPECT_EQ(recorded()[1].type, event_type::push);
+  EXPECT_EQ(recorded()[1].timestamp, 200u);
+  // The scoped range ends when it is destroyed
+  EXPECT_EQ(recorded()[2].type, event_type::pop);
+  EXPECT_GT(recorded()[2].timestamp, 600u);
+  EXPECT_EQ(recorded()[3].type, event_type::range_start);
+  EXPECT_EQ(recorded()[3].timestamp, 300u);
+  EXPECT_NE(h.get_value(), 0u);
+  EXPECT_EQ(recorded()[4].type, event_type::range_end);
+  EXPECT_EQ(recorded()[4].timestamp, 400u);
+  EXPECT_EQ(recorded()[4].range_id, recorded()[3].range_id);
+  EXPECT_EQ(recorded()[5].type, event_type::push);
+  EXPECT_EQ(recorded()[5].timestamp, 500u);
+  EXPECT_EQ(recorded()[6].type, event_type::pop);
+  EXPECT_EQ(recorded()[6].timestamp, 600u);
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <nvtx3/nvtx3.hpp>
+
+#include <collector.hpp>
+#include <registry.hpp>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct site_domain {
+  static constexpr char const* name{"call_site_test"};
+};
+
+void enabled_function() { NVTX3_FUNC_RANGE_IN(site_domain); }
+
+// Turned off by NVTX_COLLECTOR_DISABLE_SITES
+void disabled_function() { NVTX3_FUNC_RANGE_IN(site_domain); }
+
+void conditional_function(int& evaluated) { NVTX3_FUNC_RANGE_IF_IN(site_domain, ++evaluated); }
+
+unsigned const loop_line = __LINE__ + 4;
+void loop(int n)
+{
+  for (int i = 0; i < n; ++i) {
+    NVTX3_SCOPED_RANGE_IN(site_domain, "site_loop", nvtx3::payload{i});
+  }
+}
+
+uint64_t count_of(char const* message)
+{
+  for (auto const& s : nvtx_collector::range_report()) {
+    if (std::string(nvtx_collector::names().lookup(s.message)) == message) { return s.count; }
+  }
+  return 0;
+}
+
+nvtxCallSite_t* find_site(char const* function)
+{
+  for (nvtxCallSite_t* s : nvtx_collector::call_sites()) {
+    if (std::strcmp(s->function, function) == 0) { return s; }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+TEST(CallSites, DisabledByCollectorOption)
+{
+  for (int i = 0; i < 3; ++i) {
+    enabled_function();
+    disabled_function();
+  }
+  EXPECT_EQ(count_of("enabled_function"), 3u);
+  EXPECT_EQ(count_of("disabled_function"), 0u);
+
+  auto const* on  = find_site("enabled_function");
+  auto const* off = find_site("disabled_function");
+  ASSERT_NE(on, nullptr);
+  ASSERT_NE(off, nullptr);
+  EXPECT_EQ(on->enabled, 1);
+  EXPECT_EQ(off->enabled, 0);
+  EXPECT_STREQ(on->domain, "call_site_test");
+}
+
+TEST(CallSites, ToggledAtRunTime)
+{
+  nvtxCallSite_t* site = find_site("loop");
+  ASSERT_NE(site, nullptr);
+  EXPECT_EQ(site->line, loop_line);
+  EXPECT_NE(std::strstr(site->file, "call_site_tests.cpp"), nullptr);
+
+  loop(2);
+  site->enabled = 0;
+  loop(5);
+  site->enabled = 1;
+  loop(1);
+  EXPECT_EQ(count_of("site_loop"), 3u);
+}
+
+TEST(CallSites, ConditionEvaluatedWhileDisabled)
+{
+  int evaluated = 0;
+  conditional_function(evaluated);
+  nvtxCallSite_t* site = find_site("conditional_function");
+  ASSERT_NE(site, nullptr);
+  site->enabled = 0;
+  conditional_function(evaluated);
+  site->enabled = 1;
+  // As with NVTX3_V1_FUNC_RANGE_IF_IN, the condition's side effects happen on every call
+  EXPECT_EQ(evaluated, 2);
+  EXPECT_EQ(count_of("conditional_function"), 1u);
+}
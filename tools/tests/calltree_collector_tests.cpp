@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <nvtx3/nvtx3.hpp>
+
+#include <collector.hpp>
+#include <registry.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct tree_domain {
+  static constexpr char const* name{"calltree_collector_test"};
+};
+
+/// Child of `node` for the range called `message`.
+nvtx_collector::call_tree_node const* find(nvtx_collector::call_tree_node const& node,
+                                           char const* message)
+{
+  for (auto const& c : node.children) {
+    if (std::string(nvtx_collector::names().lookup(c.message)) == message) { return &c; }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+TEST(CallTreeCollector, SeparatesCallPathsAndMergesThreads)
+{
+  constexpr int threads = 4;
+  constexpr int loops   = 500;
+  std::vector<std::thread> workers;
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back([] {
+      for (int r = 0; r < loops; ++r) {
+        nvtx3::scoped_range_in<tree_domain> outer{"tree_outer"};
+        {
+          nvtx3::scoped_range_in<tree_domain> a{"tree_a"};
+          nvtx3::scoped_range_in<tree_domain> leaf{"tree_leaf"};
+        }
+        {
+          nvtx3::scoped_range_in<tree_domain> b{"tree_b"};
+          nvtx3::scoped_range_in<tree_domain> leaf{"tree_leaf"};
+          nvtx3::scoped_range_in<tree_domain> again{"tree_leaf"};
+        }
+      }
+    });
+  }
+  for (auto& w : workers) { w.join(); }
+
+  auto const root   = nvtx_collector::call_tree();
+  auto const* outer = find(root, "tree_outer");
+  ASSERT_NE(outer, nullptr);
+  EXPECT_EQ(find(root, "tree_leaf"), nullptr);
+  EXPECT_EQ(outer->count, static_cast<uint64_t>(threads * loops));
+
+  auto const* a = find(*outer, "tree_a");
+  auto const* b = find(*outer, "tree_b");
+  ASSERT_NE(a, nullptr);
+  ASSERT_NE(b, nullptr);
+  auto const* leaf_a = find(*a, "tree_leaf");
+  auto const* leaf_b = find(*b, "tree_leaf");
+  ASSERT_NE(leaf_a, nullptr);
+  ASSERT_NE(leaf_b, nullptr);
+  EXPECT_EQ(leaf_a->count, static_cast<uint64_t>(threads * loops));
+  EXPECT_EQ(leaf_b->count, static_cast<uint64_t>(threads * loops));
+  ASSERT_NE(find(*leaf_b, "tree_leaf"), nullptr);
+  EXPECT_EQ(find(*leaf_a, "tree_leaf"), nullptr);
+
+  EXPECT_EQ(outer->exclusive_ns, outer->inclusive_ns - a->inclusive_ns - b->inclusive_ns);
+  EXPECT_EQ(leaf_a->exclusive_ns, leaf_a->inclusive_ns);
+}
+
+TEST(CallTreeCollector, PopsInnermostRangeOfDomain)
+{
+  nvtxDomainHandle_t const outer = nvtx3::domain::get<tree_domain>();
+  EXPECT_EQ(nvtxDomainRangePushEx(outer, nvtx3::event_attributes{"tree_cross"}.get()), 0);
+  EXPECT_EQ(nvtxRangePushA("tree_nested"), 0);
+  // Closes "tree_cross" although "tree_nested" of the default domain is inside it
+  EXPECT_EQ(nvtxDomainRangePop(outer), 0);
+  EXPECT_EQ(nvtxDomainRangePop(outer), -1);
+  EXPECT_EQ(nvtxRangePop(), 0);
+
+  auto const root   = nvtx_collector::call_tree();
+  auto const* cross = find(root, "tree_cross");
+  ASSERT_NE(cross, nullptr);
+  EXPECT_EQ(cross->count, 1u);
+  ASSERT_NE(find(*cross, "tree_nested"), nullptr);
+  EXPECT_EQ(find(*cross, "tree_nested")->count, 1u);
+}
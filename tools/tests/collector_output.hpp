@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/* Reading the output file of a collector loaded at runtime, named by NVTX_COLLECTOR_OUTPUT. */
+
+#pragma once
+
+#include <dlfcn.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/// Calls the exported flush of the collector at `path`, so its output file is complete.  Returns
+/// false if that library is not loaded.
+inline bool flush_collector(char const* path)
+{
+  void* handle = path ? dlopen(path, RTLD_LAZY | RTLD_NOLOAD) : nullptr;
+  if (!handle) { return false; }
+  auto flush = reinterpret_cast<void (*)()>(dlsym(handle, "nvtxCollectorFlush"));
+  if (flush) { flush(); }
+  dlclose(handle);
+  return flush != nullptr;
+}
+
+/// Lines of the collector's output that contain `needle`.
+inline std::vector<std::string> output_lines_containing(std::string const& needle)
+{
+  std::vector<std::string> lines;
+  std::ifstream in(std::getenv("NVTX_COLLECTOR_OUTPUT"));
+  for (std::string line; std::getline(in, line);) {
+    if (line.find(needle) != std::string::npos) { lines.push_back(line); }
+  }
+  return lines;
+}
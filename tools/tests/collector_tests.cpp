@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <nvtx3/nvtx3.hpp>
+
+#include <ring_buffer.hpp>
+
+#include "collector_output.hpp"
+
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// Flushes the collector NVTX loaded, so its output file is complete.
+void flush_injected_collector()
+{
+  ASSERT_TRUE(flush_collector(std::getenv("NVTX_INJECTION64_PATH")))
+    << "collector was not loaded by NVTX";
+}
+
+struct collector_domain {
+  static constexpr char const* name{"collector_test"};
+};
+
+struct compact_message {
+  static constexpr char const* message{"compact_range"};
+};
+
+struct queue_depth {
+  static constexpr char const* name{"queue_depth"};
+  static constexpr char const* unit{"items"};
+};
+
+struct pool_size {
+  static constexpr char const* name{"pool_size"};
+  static constexpr char const* unit{"items"};
+};
+
+}  // namespace
+
+TEST(RingBuffer, WrapsAndRejectsWhenFull)
+{
+  nvtx_collector::ring_buffer<int> ring(3);
+  EXPECT_EQ(ring.capacity(), 4u);
+  for (int i = 0; i < 4; ++i) { EXPECT_TRUE(ring.try_push(i)); }
+  EXPECT_FALSE(ring.try_push(4));
+
+  std::vector<int> seen;
+  auto collect = [&](int const* p, std::size_t n) { seen.insert(seen.end(), p, p + n); };
+  EXPECT_EQ(ring.consume(collect), 4u);
+  EXPECT_TRUE(ring.try_push(5));
+  EXPECT_TRUE(ring.try_push(6));
+  EXPECT_EQ(ring.consume(collect), 2u);
+  EXPECT_EQ(seen, (std::vector<int>{0, 1, 2, 3, 5, 6}));
+  EXPECT_EQ(ring.size(), 0u);
+}
+
+TEST(Collector, RecordsRangesAndMarks)
+{
+  {
+    nvtx3::scoped_range_in<collector_domain> outer{"outer_range"};
+    nvtx3::mark_in<collector_domain>("a_mark");
+    auto h = nvtx3::start_range_in<collector_domain>("start_end_range");
+    nvtx3::end_range_in<collector_domain>(h);
+  }
+  flush_injected_collector();
+
+  EXPECT_EQ(output_lines_containing("\"outer_range\"").size(), 1u);
+  EXPECT_EQ(output_lines_containing(",pop,").size(), 1u);
+  EXPECT_EQ(output_lines_containing("\"a_mark\"").size(), 1u);
+  EXPECT_EQ(output_lines_containing(",start,").size(), 1u);
+  EXPECT_EQ(output_lines_containing(",end,").size(), 1u);
+}
+
+TEST(Collector, KeepsEventsOfEveryThread)
+{
+  constexpr int threads = 4;
+  constexpr int ranges  = 1000;
+  std::vector<std::thread> workers;
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back([] {
+      for (int r = 0; r < ranges; ++r) { nvtx3::scoped_range range{"worker_range"}; }
+    });
+  }
+  for (auto& w : workers) { w.join(); }
+  flush_injected_collector();
+
+  EXPECT_EQ(output_lines_containing("\"worker_range\"").size(),
+            static_cast<std::size_t>(threads * ranges));
+}
+
+TEST(Collector, RecordsCompactEvents)
+{
+  auto& message = nvtx3::registered_string_in<collector_domain>::get<compact_message>();
+  {
+    nvtx3::checked_range_in<collector_domain> r{message, nvtx3::payload{uint64_t{42}}};
+    nvtx3::mark_in<collector_domain>(message, nvtx3::payload{uint32_t{7}});
+    nvtx3::end_range_in<collector_domain>(nvtx3::start_range_in<collector_domain>(message));
+  }
+  flush_injected_collector();
+
+  auto const lines = output_lines_containing("\"compact_range\"");
+  ASSERT_EQ(lines.size(), 3u);
+  EXPECT_NE(lines[0].find(",push,"), std::string::npos);
+  EXPECT_NE(lines[0].find(",42,"), std::string::npos);
+  EXPECT_NE(lines[1].find(",mark,"), std::string::npos);
+  EXPECT_NE(lines[1].find(",7,"), std::string::npos);
+  EXPECT_NE(lines[2].find(",start,"), std::string::npos);
+}
+
+// NVTX_COLLECTOR_COUNTER_INTERVAL_NS is one second for this test
+TEST(Collector, DownsamplesCounters)
+{
+  auto const& depth = nvtx3::counter_in<collector_domain>::get<queue_depth>();
+  ASSERT_NE(depth.get_handle(), nullptr);
+  nvtx3::counter_in<collector_domain> const load{"load", "%"};
+  std::thread worker([&] {
+    for (int i = 0; i < 1000; ++i) { depth.sample(i); }
+    load.sample(0.5);
+    load.sample(2.5);
+  });
+  worker.join();
+  flush_injected_collector();
+
+  // The first sample of the interval, then the last one, stored at thread exit
+  auto const lines = output_lines_containing("\"queue_depth\"");
+  ASSERT_EQ(lines.size(), 2u);
+  EXPECT_NE(lines[0].find(",counter,"), std::string::npos);
+  EXPECT_NE(lines[0].find(",0x00000000,0,"), std::string::npos);
+  EXPECT_NE(lines[1].find(",0x00000000,999,"), std::string::npos);
+
+  auto const doubles = output_lines_containing("\"load\"");
+  ASSERT_EQ(doubles.size(), 2u);
+  EXPECT_NE(doubles[1].find(",2.5,"), std::string::npos);
+}
+
+TEST(Collector, FlushesSamplesHeldByLiveThreads)
+{
+  auto const& size = nvtx3::counter_in<collector_domain>::get<pool_size>();
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool sampled = false;
+  bool done    = false;
+  std::thread worker([&] {
+    for (int i = 0; i < 100; ++i) { size.sample(i); }
+    std::unique_lock<std::mutex> lock(mutex);
+    sampled = true;
+    cv.notify_all();
+    cv.wait(lock, [&] { return done; });
+  });
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return sampled; });
+  }
+  flush_injected_collector();
+
+  // The held last sample is written although its thread neither exited nor sampled again
+  auto const lines = output_lines_containing("\"pool_size\"");
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+  }
+  cv.notify_all();
+  worker.join();
+  ASSERT_EQ(lines.size(), 2u);
+  EXPECT_NE(lines[0].find(",0x00000000,0,"), std::string::npos);
+  EXPECT_NE(lines[1].find(",0x00000000,99,"), std::string::npos);
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Built with NVTX_DIRECT_TOOL: the domain event functions call the statically
+ * linked collector without going through the NVTX function table. */
+
+#include <gtest/gtest.h>
+
+#include <nvtx3/nvtx3.hpp>
+
+#include <collector.hpp>
+#include <registry.hpp>
+#include <sink.hpp>
+
+#include "memory_sink.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct direct_domain {
+  static constexpr char const* name{"direct_tool_test"};
+};
+
+}  // namespace
+
+TEST(DirectTool, FirstCallInitializes)
+{
+  // No NVTX call has been made yet, and the global domain needs no nvtxDomainCreateA
+  nvtxEventAttributes_t attr{};
+  attr.version       = NVTX_VERSION;
+  attr.size          = NVTX_EVENT_ATTRIB_STRUCT_SIZE;
+  attr.messageType   = NVTX_MESSAGE_TYPE_ASCII;
+  attr.message.ascii = "first";
+  EXPECT_EQ(nvtxDomainRangePushEx(nullptr, &attr), 0);
+  EXPECT_EQ(nvtxDomainRangePop(nullptr), 0);
+  nvtx_collector::flush();
+  EXPECT_EQ(nvtx_collector::statistics().written, 2u);
+  EXPECT_NE(nvtxIsEnabled(), 0);
+}
+
+TEST(DirectTool, RecordsDomainEvents)
+{
+  nvtx3::mark_in<direct_domain>("direct_init");
+  nvtx_collector::set_sink(std::unique_ptr<nvtx_collector::sink>(new memory_sink));
+
+  nvtx3::mark_in<direct_domain>("direct_mark");
+  { nvtx3::scoped_range_in<direct_domain> range{"direct_push"}; }
+  auto id = nvtx3::start_range_in<direct_domain>("direct_start");
+  nvtx3::end_range_in<direct_domain>(id);
+  nvtx_collector::flush();
+
+  using nvtx_collector::event_type;
+  ASSERT_EQ(recorded().size(), 5u);
+  EXPECT_EQ(recorded()[0].type, event_type::mark);
+  EXPECT_EQ(recorded()[1].type, event_type::push);
+  EXPECT_EQ(recorded()[2].type, event_type::pop);
+  EXPECT_EQ(recorded()[3].type, event_type::range_start);
+  EXPECT_EQ(recorded()[4].type, event_type::range_end);
+  EXPECT_EQ(recorded()[3].range_id, recorded()[4].range_id);
+  EXPECT_STREQ(nvtx_collector::names().lookup(recorded()[1].message), "direct_push");
+  EXPECT_EQ(recorded()[1].domain, recorded()[0].domain);
+  EXPECT_NE(recorded()[1].domain, 0u);
+
+  // `recorded()` is destroyed before the collector shuts down
+  nvtx_collector::set_sink(nullptr);
+}
+
+TEST(DirectTool, SharesStateWithTableCalls)
+{
+  // nvtxRangePushA still goes through the function table
+  EXPECT_EQ(nvtxRangePushA("table_push"), 0);
+  EXPECT_EQ(nvtxDomainRangePop(nullptr), 0);
+  EXPECT_EQ(nvtxDomainRangePop(nullptr), -1);
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <nvtx3/nvtx3.hpp>
+
+#include <collector.hpp>
+#include <registry.hpp>
+
+#include <string>
+
+namespace {
+
+// Listed in NVTX_COLLECTOR_DOMAINS
+struct kept_domain {
+  static constexpr char const* name{"kept_domain"};
+};
+
+struct muted_domain {
+  static constexpr char const* name{"muted_domain"};
+};
+
+void kept_function() { NVTX3_FUNC_RANGE_IN(kept_domain); }
+
+void muted_function() { NVTX3_FUNC_RANGE_IN(muted_domain); }
+
+void muted_conditional_function(int& evaluated)
+{
+  NVTX3_FUNC_RANGE_IF_IN(muted_domain, ++evaluated);
+}
+
+uint64_t count_of(char const* message)
+{
+  for (auto const& s : nvtx_collector::range_report()) {
+    if (std::string(nvtx_collector::names().lookup(s.message)) == message) { return s.count; }
+  }
+  return 0;
+}
+
+}  // namespace
+
+TEST(DomainFilter, OnlyListedDomainsRecord)
+{
+  for (int i = 0; i < 3; ++i) {
+    kept_function();
+    muted_function();
+    nvtx3::checked_range_in<kept_domain> kept{"kept_range"};
+    nvtx3::checked_range_in<muted_domain> muted{"muted_range"};
+    nvtx3::scoped_range global{"global_range"};
+  }
+  EXPECT_EQ(count_of("kept_function"), 3u);
+  EXPECT_EQ(count_of("muted_function"), 0u);
+  EXPECT_EQ(count_of("kept_range"), 3u);
+  EXPECT_EQ(count_of("muted_range"), 0u);
+  EXPECT_EQ(count_of("global_range"), 3u);
+
+  EXPECT_TRUE(nvtx3::domain_enabled<kept_domain>());
+  EXPECT_FALSE(nvtx3::domain_enabled<muted_domain>());
+  EXPECT_TRUE(nvtx3::domain_enabled<nvtx3::domain::global>());
+  EXPECT_EQ(nvtxDomainIsEnabled(nvtx3::domain::get<muted_domain>()), 0);
+}
+
+TEST(DomainFilter, ConditionEvaluatedInDisabledDomain)
+{
+  int evaluated = 0;
+  for (int i = 0; i < 3; ++i) { muted_conditional_function(evaluated); }
+  EXPECT_EQ(evaluated, 3);
+  EXPECT_EQ(count_of("muted_conditional_function"), 0u);
+}
+
+TEST(DomainFilter, TurnedOnAndOffAtRunTime)
+{
+  EXPECT_FALSE(nvtx_collector::set_domain_enabled("no_such_domain", true));
+  ASSERT_TRUE(nvtx_collector::set_domain_enabled("muted_domain", true));
+  {
+    nvtx3::checked_range_in<muted_domain> range{"toggled_range"};
+    // A range begun while its domain was on still ends
+    nvtx_collector::set_domain_enabled("muted_domain", false);
+  }
+  { nvtx3::checked_range_in<muted_domain> range{"toggled_range"}; }
+  EXPECT_EQ(count_of("toggled_range"), 1u);
+}
+
+TEST(DomainFilter, LazyAttributesBuiltOnlyForEnabledDomains)
+{
+  ASSERT_TRUE(nvtx3::enabled());
+  EXPECT_TRUE(nvtx3::enabled_in<kept_domain>());
+  EXPECT_FALSE(nvtx3::enabled_in<muted_domain>());
+
+  int built = 0;
+  for (int i = 0; i < 2; ++i) {
+    nvtx3::checked_range_in<kept_domain> kept{[&] {
+      ++built;
+      return "lazy_" + std::to_string(i);
+    }};
+    nvtx3::checked_range_in<muted_domain> muted{[&] {
+      ++built;
+      return std::string("lazy_muted");
+    }};
+    nvtx3::mark_in<muted_domain>([&] {
+      ++built;
+      return nvtx3::event_attributes{"lazy_mark"};
+    });
+  }
+  EXPECT_EQ(built, 2);
+  EXPECT_EQ(count_of("lazy_0"), 1u);
+  EXPECT_EQ(count_of("lazy_1"), 1u);
+  EXPECT_EQ(count_of("lazy_muted"), 0u);
+}
+
+TEST(DomainFilter, LazyAttributesSkippedWhileDomainTurnedOff)
+{
+  ASSERT_TRUE(nvtx_collector::set_domain_enabled("kept_domain", false));
+  int built = 0;
+  { nvtx3::checked_range_in<kept_domain> r{[&] { ++built; return std::string("lazy_off"); }}; }
+  nvtx3::mark_in<kept_domain>([&] {
+    ++built;
+    return nvtx3::event_attributes{"lazy_off", nvtx3::payload{1}};
+  });
+  EXPECT_TRUE(nvtx3::enabled());
+  EXPECT_FALSE(nvtx3::enabled_in<kept_domain>());
+  nvtx_collector::set_domain_enabled("kept_domain", true);
+  EXPECT_EQ(built, 0);
+  EXPECT_EQ(count_of("lazy_off"), 0u);
+}
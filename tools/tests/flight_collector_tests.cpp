@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <nvtx3/nvtx3.hpp>
+
+#include <collector.hpp>
+#include <trace_reader.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct flight_domain {
+  static constexpr char const* name{"flight_collector_test"};
+};
+
+std::string trace_path(char const* file) { return std::string(std::getenv("TRACE_DIR")) + "/" + file; }
+
+/// Payloads of the marks in `trace`, in recording order.
+std::vector<uint64_t> payloads(nvtx_collector::trace_reader const& trace)
+{
+  std::vector<uint64_t> out;
+  trace.for_each_event([&](nvtx_collector::trace_reader::thread const&,
+                           nvtx_collector::event_record const& e) {
+    if (e.type == nvtx_collector::event_type::mark) { out.push_back(e.payload); }
+  });
+  return out;
+}
+
+void marks(uint64_t first, uint64_t count)
+{
+  for (uint64_t i = first; i < first + count; ++i) {
+    nvtx3::mark_in<flight_domain>(nvtx3::event_attributes{"flight_mark", nvtx3::payload{i}});
+  }
+}
+
+}  // namespace
+
+// Run with NVTX_COLLECTOR_MODE=flight, NVTX_COLLECTOR_BUFFER_EVENTS=64 and
+// NVTX_COLLECTOR_FORMAT=binary.
+TEST(FlightCollector, DumpsLatestEventsOfEveryThread)
+{
+  std::thread([] { marks(0, 1000); }).join();
+  marks(0, 10);
+
+  std::string const path = trace_path("flight_collector_test.nvtxtrace");
+  ASSERT_TRUE(nvtx_collector::dump(path));
+
+  nvtx_collector::trace_reader trace(path);
+  EXPECT_TRUE(trace.complete());
+  ASSERT_EQ(trace.threads().size(), 2u);
+
+  std::vector<uint64_t> const kept = payloads(trace);
+  ASSERT_EQ(kept.size(), 63u + 10u);
+  // The exited thread's ring holds its last marks, less the slot being reused
+  std::vector<uint64_t> expected;
+  for (uint64_t i = 1000 - 63; i < 1000; ++i) { expected.push_back(i); }
+  for (uint64_t i = 0; i < 10; ++i) { expected.push_back(i); }
+  std::sort(expected.begin(), expected.end());
+  std::vector<uint64_t> sorted = kept;
+  std::sort(sorted.begin(), sorted.end());
+  EXPECT_EQ(sorted, expected);
+}
+
+TEST(FlightCollector, DumpsOnSignal)
+{
+  std::string const path = std::string(std::getenv("NVTX_COLLECTOR_OUTPUT")) + ".1";
+  std::remove(path.c_str());
+  marks(0, 5);
+  std::raise(SIGUSR2);
+
+  std::unique_ptr<nvtx_collector::trace_reader> trace;
+  for (int tries = 0; tries < 500 && !(trace && trace->complete()); ++tries) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    try {
+      trace.reset(new nvtx_collector::trace_reader(path));
+    } catch (std::exception const&) {
+      trace.reset();
+    }
+  }
+  ASSERT_TRUE(trace && trace->complete());
+  EXPECT_GE(payloads(*trace).size(), 5u);
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <nvtx3/nvtx3.hpp>
+
+#include "collector_output.hpp"
+#include "looping_threads.hpp"
+
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+/// Path of the dynamic collector, which NVTX_INJECTION64_PATH does not name.
+char const* collector_path()
+{
+  char const* path = std::getenv("NVTX_COLLECTOR_PATH");
+  return path ? path : "";
+}
+
+struct late_domain {
+  static constexpr char const* name{"late_attach_domain"};
+};
+
+void late_attach_func_range() { NVTX3_FUNC_RANGE_IN(late_domain); }
+
+/// Number of the collector's output lines containing `needle` outside the default domain.
+std::size_t named_domain_lines_containing(std::string const& needle)
+{
+  std::size_t count = 0;
+  for (auto const& line : output_lines_containing(needle)) {
+    // timestamp_ns,tid,type,domain,...
+    std::size_t begin = 0;
+    for (int column = 0; column < 3; ++column) { begin = line.find(',', begin) + 1; }
+    if (line.compare(begin, 2, "0,") != 0) { ++count; }
+  }
+  return count;
+}
+
+}  // namespace
+
+// Run with NVTX_COLLECTOR_PATH naming the collector and NVTX_COLLECTOR_OUTPUT
+// set, but without NVTX_INJECTION64_PATH.
+TEST(LateAttach, AttachesToolWhileThreadsCallNvtx)
+{
+  nvtxMarkA("late_attach_before");
+  EXPECT_EQ(nvtxRangePushA("late_attach_before"), NVTX_NO_PUSH_POP_TRACKING);
+
+  // Without a tool, handles are null, and the C++ API caches them
+  uint32_t const generation = nvtxGetAttachGeneration();
+  nvtxDomainHandle_t c_domain = nvtxDomainCreateA("late_attach_c_domain");
+  EXPECT_EQ(c_domain, nullptr);
+  EXPECT_EQ(nvtxDomainRegisterStringA(c_domain, "late_attach_c_string"), nullptr);
+  late_attach_func_range();
+  { nvtx3::scoped_range_in<late_domain> r{"late_attach_cpp_before"}; }
+
+  EXPECT_EQ(nvtxAttachInjectionLibraryA("/nonexistent/libtool.so"), NVTX_ERR_INIT_LOAD_LIBRARY);
+  EXPECT_EQ(nvtxAttachInjectionLibraryA("libc.so.6"), NVTX_ERR_INIT_MISSING_LIBRARY_ENTRY_POINT);
+
+  looping_threads caller(1, [] {
+    nvtxRangePushA("late_attach_concurrent");
+    nvtxRangePop();
+  });
+  caller.wait_for_iterations(1);
+  EXPECT_EQ(nvtxAttachInjectionLibraryA(collector_path()), NVTX_SUCCESS);
+  caller.wait_for_iterations(1);
+  caller.stop();
+
+  nvtxMarkA("late_attach_after");
+  EXPECT_GE(nvtxRangePushA("late_attach_after"), 0);
+  nvtxRangePop();
+
+  // Handles created before attaching are the C caller's to create again
+  EXPECT_NE(nvtxGetAttachGeneration(), generation);
+  c_domain = nvtxDomainCreateA("late_attach_c_domain");
+  ASSERT_NE(c_domain, nullptr);
+  nvtxStringHandle_t const c_string = nvtxDomainRegisterStringA(c_domain, "late_attach_c_string");
+  EXPECT_NE(c_string, nullptr);
+  nvtxDomainMarkCompact(c_domain, c_string, 0, NVTX_PAYLOAD_UNKNOWN, 0);
+
+  // The C++ API creates its own again
+  EXPECT_TRUE(nvtx3::domain_enabled<late_domain>());
+  late_attach_func_range();
+  { nvtx3::scoped_range_in<late_domain> r{"late_attach_cpp_after"}; }
+
+  EXPECT_EQ(nvtxAttachInjectionLibraryA(collector_path()),
+            NVTX_ERR_INJECTION_LIBRARY_ALREADY_ATTACHED);
+
+  flush_collector(collector_path());
+  EXPECT_EQ(output_lines_containing("late_attach_before").size(), 0u);
+  // The mark and the push; pops carry no message
+  EXPECT_EQ(output_lines_containing("late_attach_after").size(), 2u);
+  EXPECT_GT(output_lines_containing("late_attach_concurrent").size(), 0u);
+  EXPECT_EQ(output_lines_containing("late_attach_cpp_before").size(), 0u);
+  EXPECT_EQ(named_domain_lines_containing("late_attach_c_string"), 1u);
+  EXPECT_EQ(named_domain_lines_containing("late_attach_func_range"), 1u);
+  EXPECT_EQ(named_domain_lines_containing("late_attach_cpp_after"), 1u);
+}
+
+TEST(LateAttach, DetachesToolWhileThreadsCallNvtx)
+{
+  // Attached by the previous test, unless this one runs alone
+  int const attached = nvtxAttachInjectionLibraryA(collector_path());
+  ASSERT_TRUE(attached == NVTX_SUCCESS || attached == NVTX_ERR_INJECTION_LIBRARY_ALREADY_ATTACHED);
+
+  looping_threads callers(2, [] {
+    nvtxRangePushA("late_detach_concurrent");
+    nvtxMarkA("late_detach_concurrent");
+    nvtxRangePop();
+  });
+  callers.wait_for_iterations(1);
+  EXPECT_EQ(nvtxDetachInjectionLibrary(), NVTX_SUCCESS);
+
+  nvtxMarkA("late_detach_off");
+  EXPECT_EQ(nvtxRangePushA("late_detach_off"), NVTX_NO_PUSH_POP_TRACKING);
+  EXPECT_EQ(nvtxDetachInjectionLibrary(), NVTX_ERR_NO_INJECTION_LIBRARY_AVAILABLE);
+  callers.wait_for_iterations(1);
+  callers.stop();
+
+  // The C++ API must not pass the detached tool's handles to the next one
+  late_attach_func_range();
+  { nvtx3::scoped_range_in<late_domain> r{"late_detach_cpp"}; }
+  uint32_t const generation = nvtxGetAttachGeneration();
+  EXPECT_EQ(nvtxAttachInjectionLibraryA(collector_path()), NVTX_SUCCESS);
+  EXPECT_NE(nvtxGetAttachGeneration(), generation);
+  nvtxMarkA("late_reattach");
+  EXPECT_TRUE(nvtx3::domain_enabled<late_domain>());
+  late_attach_func_range();
+  { nvtx3::scoped_range_in<late_domain> r{"late_reattach_cpp"}; }
+
+  flush_collector(collector_path());
+  EXPECT_EQ(output_lines_containing("late_detach_off").size(), 0u);
+  EXPECT_EQ(output_lines_containing("late_detach_cpp").size(), 0u);
+  EXPECT_EQ(output_lines_containing("late_reattach").size(), 2u);
+  // One function range each from the first attach and from this one
+  EXPECT_EQ(output_lines_containing("late_attach_func_range").size(), 2u);
+  EXPECT_EQ(named_domain_lines_containing("late_attach_func_range"), 2u);
+  EXPECT_EQ(named_domain_lines_containing("late_reattach_cpp"), 1u);
+}
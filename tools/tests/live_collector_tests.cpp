@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <nvtx3/nvtx3.hpp>
+
+#include <collector.hpp>
+#include <live_reader.hpp>
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct live_domain {
+  static constexpr char const* name{"live_collector_test"};
+};
+
+constexpr char const* segment = "/nvtx3_live_collector_test";
+
+using nvtx_collector::event_record;
+using nvtx_collector::event_type;
+using nvtx_collector::live_reader;
+
+/// Marks read from `reader`, with their payloads, message and domain names.
+struct live_mark {
+  uint32_t ring;
+  uint64_t payload;
+  std::string message;
+  std::string domain;
+};
+
+std::vector<live_mark> read_marks(live_reader& reader)
+{
+  std::vector<live_mark> out;
+  reader.poll([&](live_reader::thread const& t, event_record const& e) {
+    if (e.type != event_type::mark) { return; }
+    out.push_back(
+      live_mark{t.ring, e.payload, reader.string(e.message), reader.domain_name(e.domain)});
+  });
+  return out;
+}
+
+void marks(uint64_t first, uint64_t count)
+{
+  for (uint64_t i = first; i < first + count; ++i) {
+    nvtx3::mark_in<live_domain>(nvtx3::event_attributes{"live_mark", nvtx3::payload{i}});
+  }
+}
+
+}  // namespace
+
+// Run with NVTX_COLLECTOR_MODE=live, NVTX_COLLECTOR_OUTPUT=/nvtx3_live_collector_test and
+// NVTX_COLLECTOR_BUFFER_EVENTS=1024.
+TEST(LiveCollector, StreamsEventsToReader)
+{
+  // The first event creates the segment
+  marks(0, 1);
+  live_reader reader(segment);
+  EXPECT_FALSE(reader.closed());
+
+  std::thread([] { marks(1, 100); }).join();
+  marks(101, 10);
+
+  std::vector<live_mark> const got = read_marks(reader);
+  ASSERT_EQ(got.size(), 111u);
+  for (auto const& m : got) {
+    EXPECT_EQ(m.message, "live_mark");
+    EXPECT_EQ(m.domain, "live_collector_test");
+  }
+  // Records of each ring arrive in order
+  std::vector<uint64_t> main_thread;
+  for (auto const& m : got) {
+    if (m.ring == got.front().ring) { main_thread.push_back(m.payload); }
+  }
+  std::vector<uint64_t> expected{0};
+  for (uint64_t i = 101; i < 111; ++i) { expected.push_back(i); }
+  EXPECT_EQ(main_thread, expected);
+  EXPECT_TRUE(read_marks(reader).empty());
+}
+
+TEST(LiveCollector, DropsWhileRingIsFullAndRecovers)
+{
+  live_reader reader(segment);
+  read_marks(reader);
+  uint64_t const dropped = nvtx_collector::statistics().dropped;
+
+  marks(0, 2000);
+  std::vector<live_mark> got = read_marks(reader);
+  EXPECT_EQ(got.size(), 1024u);
+  EXPECT_EQ(nvtx_collector::statistics().dropped - dropped, 2000u - got.size());
+  ASSERT_FALSE(got.empty());
+  EXPECT_EQ(got.front().payload, 0u);
+  EXPECT_EQ(got.back().payload, got.size() - 1);
+
+  marks(5000, 10);
+  got = read_marks(reader);
+  ASSERT_EQ(got.size(), 10u);
+  EXPECT_EQ(got.front().payload, 5000u);
+}
+
+TEST(LiveCollector, ClosesOnShutdown)
+{
+  live_reader reader(segment);
+  marks(0, 5);
+  nvtx_collector::shutdown();
+  EXPECT_TRUE(reader.closed());
+  EXPECT_EQ(read_marks(reader).size(), 5u);
+  // The name is unlinked; the mapping stays valid
+  EXPECT_THROW(live_reader{segment}, std::runtime_error);
+}
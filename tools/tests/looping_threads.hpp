@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/* Threads calling NVTX in a loop while a test changes the attached tool. */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/// Threads running `body` in a loop until `stop` or destruction.
+class looping_threads {
+ public:
+  template <typename F>
+  looping_threads(int count, F body) : iterations_(new std::atomic<long>[count])
+  {
+    for (int i = 0; i < count; ++i) {
+      iterations_[i].store(0);
+      threads_.emplace_back([this, i, body] {
+        while (!stop_.load()) {
+          body();
+          ++iterations_[i];
+        }
+      });
+    }
+  }
+
+  ~looping_threads() { stop(); }
+
+  /// Waits until every thread has completed `n` more iterations, so it ran the body since the call.
+  void wait_for_iterations(long n) const
+  {
+    std::vector<long> targets;
+    for (std::size_t i = 0; i < threads_.size(); ++i) { targets.push_back(iterations_[i].load() + n); }
+    for (std::size_t i = 0; i < threads_.size(); ++i) {
+      while (iterations_[i].load() < targets[i]) { std::this_thread::yield(); }
+    }
+  }
+
+  void stop()
+  {
+    stop_.store(true);
+    for (auto& t : threads_) {
+      if (t.joinable()) { t.join(); }
+    }
+  }
+
+ private:
+  std::atomic<bool> stop_{false};
+  std::unique_ptr<std::atomic<long>[]> iterations_;
+  std::vector<std::thread> threads_;
+};
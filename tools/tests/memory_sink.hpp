@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/* Sink keeping the events of a statically linked collector in memory, for the tests to check. */
+
+#pragma once
+
+#include <sink.hpp>
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+/// Events written by the collector since the test installed `memory_sink`.
+inline std::vector<nvtx_collector::event_record>& recorded()
+{
+  static std::vector<nvtx_collector::event_record> events;
+  return events;
+}
+
+/// The same events, by thread index.
+inline std::map<uint32_t, std::vector<nvtx_collector::event_record>>& recorded_by_thread()
+{
+  static std::map<uint32_t, std::vector<nvtx_collector::event_record>> events;
+  return events;
+}
+
+class memory_sink : public nvtx_collector::sink {
+ public:
+  void write(nvtx_collector::thread_info const& thread,
+             nvtx_collector::event_record const* events,
+             std::size_t count) override
+  {
+    recorded().insert(recorded().end(), events, events + count);
+    auto& v = recorded_by_thread()[thread.index];
+    v.insert(v.end(), events, events + count);
+  }
+};
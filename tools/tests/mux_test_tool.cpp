@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/* Second tool of MUX_TEST, loaded next to the collector.  It checks that every handle it is
+ * given is one it returned itself. */
+
+#define NVTX_NO_IMPL
+#include <nvtx3/nvToolsExt.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace {
+
+constexpr int max_handles = 64;
+
+// Objects whose addresses are the handles returned by this tool
+char g_domains[max_handles];
+char g_strings[max_handles];
+std::atomic<int> g_domain_count{0};
+std::atomic<int> g_string_count{0};
+std::atomic<uint64_t> g_next_range{1};
+
+std::atomic<int> g_marks{0};
+std::atomic<int> g_ranges{0};
+std::atomic<int> g_bad_handles{0};
+
+template <typename Handle>
+bool owned(Handle h, char const (&objects)[max_handles])
+{
+  auto const* p = reinterpret_cast<char const*>(h);
+  return p >= objects && p < objects + max_handles;
+}
+
+void check_domain(nvtxDomainHandle_t d)
+{
+  if (d && !owned(d, g_domains)) { ++g_bad_handles; }
+}
+
+void check_attributes(nvtxEventAttributes_t const* a)
+{
+  if (a && a->messageType == NVTX_MESSAGE_TYPE_REGISTERED &&
+      !owned(a->message.registered, g_strings)) {
+    ++g_bad_handles;
+  }
+}
+
+void NVTX_API mark(char const*) { ++g_marks; }
+
+int NVTX_API push(char const*)
+{
+  ++g_ranges;
+  return 0;
+}
+
+int NVTX_API pop() { return 0; }
+
+nvtxDomainHandle_t NVTX_API domain_create(char const*)
+{
+  int const i = g_domain_count++ % max_handles;
+  return reinterpret_cast<nvtxDomainHandle_t>(&g_domains[i]);
+}
+
+nvtxStringHandle_t NVTX_API register_string(nvtxDomainHandle_t d, char const*)
+{
+  check_domain(d);
+  int const i = g_string_count++ % max_handles;
+  return reinterpret_cast<nvtxStringHandle_t>(&g_strings[i]);
+}
+
+void NVTX_API domain_mark(nvtxDomainHandle_t d, nvtxEventAttributes_t const* a)
+{
+  check_domain(d);
+  check_attributes(a);
+  ++g_marks;
+}
+
+nvtxRangeId_t NVTX_API domain_range_start(nvtxDomainHandle_t d, nvtxEventAttributes_t const* a)
+{
+  check_domain(d);
+  check_attributes(a);
+  return g_next_range++ << 8;
+}
+
+void NVTX_API domain_range_end(nvtxDomainHandle_t d, nvtxRangeId_t id)
+{
+  check_domain(d);
+  // Range ids of this tool are multiples of 256
+  if (id == 0 || (id & 0xff) != 0) { ++g_bad_handles; }
+  ++g_ranges;
+}
+
+template <typename F>
+void install(NvtxFunctionTable table, unsigned size, unsigned id, F fn)
+{
+  if (table && id < size && table[id]) { *table[id] = reinterpret_cast<NvtxFunctionPointer>(fn); }
+}
+
+}  // namespace
+
+extern "C" __attribute__((visibility("default"))) int InitializeInjectionNvtx2(
+  NvtxGetExportTableFunc_t get_export_table)
+{
+  auto const* callbacks =
+    static_cast<NvtxExportTableCallbacks const*>(get_export_table(NVTX_ETID_CALLBACKS));
+  NvtxFunctionTable core  = nullptr;
+  NvtxFunctionTable core2 = nullptr;
+  unsigned core_size      = 0;
+  unsigned core2_size     = 0;
+  if (!callbacks->GetModuleFunctionTable(NVTX_CB_MODULE_CORE, &core, &core_size) ||
+      !callbacks->GetModuleFunctionTable(NVTX_CB_MODULE_CORE2, &core2, &core2_size)) {
+    return 0;
+  }
+  install(core, core_size, NVTX_CBID_CORE_MarkA, mark);
+  install(core, core_size, NVTX_CBID_CORE_RangePushA, push);
+  install(core, core_size, NVTX_CBID_CORE_RangePop, pop);
+  install(core2, core2_size, NVTX_CBID_CORE2_DomainCreateA, domain_create);
+  install(core2, core2_size, NVTX_CBID_CORE2_DomainRegisterStringA, register_string);
+  install(core2, core2_size, NVTX_CBID_CORE2_DomainMarkEx, domain_mark);
+  install(core2, core2_size, NVTX_CBID_CORE2_DomainRangeStartEx, domain_range_start);
+  install(core2, core2_size, NVTX_CBID_CORE2_DomainRangeEnd, domain_range_end);
+  return 1;
+}
+
+/// Marks and ended ranges this tool saw, and handles it was given that it did not return.
+extern "C" __attribute__((visibility("default"))) void nvtxMuxTestToolCounts(int* marks,
+                                                                             int* ranges,
+                                                                             int* bad_handles)
+{
+  *marks       = g_marks.load();
+  *ranges      = g_ranges.load();
+  *bad_handles = g_bad_handles.load();
+}
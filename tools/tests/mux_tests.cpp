@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <nvtx3/nvToolsExtBatch.h>
+#include <nvtx3/nvtx3.hpp>
+
+#include "collector_output.hpp"
+
+#include <dlfcn.h>
+
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// Symbol `name` of the already loaded library at environment variable `path_variable`.
+template <typename F>
+F loaded_symbol(char const* path_variable, char const* name)
+{
+  char const* path = std::getenv(path_variable);
+  if (!path) { return nullptr; }
+  void* handle = dlopen(path, RTLD_LAZY | RTLD_NOLOAD);
+  if (!handle) { return nullptr; }
+  auto f = reinterpret_cast<F>(dlsym(handle, name));
+  dlclose(handle);
+  return f;
+}
+
+struct mux_domain {
+  static constexpr char const* name{"mux_test"};
+};
+
+struct mux_message {
+  static constexpr char const* message{"mux_registered"};
+};
+
+}  // namespace
+
+TEST(Mux, ForwardsEventsToEveryTool)
+{
+  constexpr int threads = 4;
+  constexpr int ranges  = 100;
+  std::vector<std::thread> workers;
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back([] {
+      for (int r = 0; r < ranges; ++r) {
+        // Push/pop and mark of the default domain: direct calls or forwarded
+        nvtxRangePushA("mux_push");
+        nvtxMarkA("mux_mark");
+        nvtxRangePop();
+        // Domain, registered string and range ids are translated per tool
+        auto& registered = nvtx3::registered_string_in<mux_domain>::get<mux_message>();
+        nvtx3::mark_in<mux_domain>(registered);
+        auto h = nvtx3::start_range_in<mux_domain>(registered);
+        nvtx3::end_range_in<mux_domain>(h);
+      }
+    });
+  }
+  for (auto& w : workers) { w.join(); }
+
+  auto flush = loaded_symbol<void (*)()>("NVTX_MUX_COLLECTOR_PATH", "nvtxCollectorFlush");
+  auto counts =
+    loaded_symbol<void (*)(int*, int*, int*)>("NVTX_MUX_TEST_TOOL_PATH", "nvtxMuxTestToolCounts");
+  ASSERT_NE(flush, nullptr) << "collector was not loaded by the multiplexer";
+  ASSERT_NE(counts, nullptr) << "test tool was not loaded by the multiplexer";
+  flush();
+
+  constexpr std::size_t events = threads * ranges;
+  EXPECT_EQ(output_lines_containing("\"mux_push\"").size(), events);
+  EXPECT_EQ(output_lines_containing("\"mux_mark\"").size(), events);
+  EXPECT_EQ(output_lines_containing("\"mux_registered\"").size(), 2 * events);
+  EXPECT_EQ(output_lines_containing(",end,").size(), events);
+
+  int marks       = 0;
+  int ended       = 0;
+  int bad_handles = -1;
+  counts(&marks, &ended, &bad_handles);
+  EXPECT_EQ(marks, static_cast<int>(2 * events));
+  EXPECT_EQ(ended, static_cast<int>(2 * events));
+  EXPECT_EQ(bad_handles, 0);
+}
+
+TEST(Mux, ForwardsBatchesToEveryTool)
+{
+  nvtxDomainHandle_t domain = nvtx3::domain::get<mux_domain>();
+  nvtxStringHandle_t item   = nvtxDomainRegisterStringA(domain, "mux_batch_item");
+
+  nvtxBatchEvent_t events[3]{};
+  events[0].type      = NVTX_BATCH_EVENT_MARK;
+  events[0].message   = item;
+  events[0].timestamp = 1234;
+  events[1].type      = NVTX_BATCH_EVENT_RANGE_START;
+  events[1].message   = item;
+  events[1].timestamp = 1500;
+  events[2].type      = NVTX_BATCH_EVENT_UNKNOWN;
+
+  auto counts =
+    loaded_symbol<void (*)(int*, int*, int*)>("NVTX_MUX_TEST_TOOL_PATH", "nvtxMuxTestToolCounts");
+  ASSERT_NE(counts, nullptr) << "test tool was not loaded by the multiplexer";
+  int marks_before = 0;
+  int ended_before = 0;
+  int bad_handles  = -1;
+  counts(&marks_before, &ended_before, &bad_handles);
+
+  nvtxDomainBatchSubmit(domain, events, 3);
+  ASSERT_NE(events[1].rangeId, 0u);
+  events[2].type    = NVTX_BATCH_EVENT_RANGE_END;
+  events[2].rangeId = events[1].rangeId;
+  nvtxDomainBatchSubmit(domain, &events[2], 1);
+
+  auto flush = loaded_symbol<void (*)()>("NVTX_MUX_COLLECTOR_PATH", "nvtxCollectorFlush");
+  ASSERT_NE(flush, nullptr) << "collector was not loaded by the multiplexer";
+  flush();
+
+  // The collector handles batches, and keeps the events' timestamps
+  auto const lines = output_lines_containing("\"mux_batch_item\"");
+  ASSERT_EQ(lines.size(), 2u);
+  EXPECT_EQ(lines[0].compare(0, 5, "1234,"), 0) << lines[0];
+  EXPECT_EQ(lines[1].compare(0, 5, "1500,"), 0) << lines[1];
+
+  // The test tool does not, and gets the events one at a time with its own handles
+  int marks = 0;
+  int ended = 0;
+  counts(&marks, &ended, &bad_handles);
+  EXPECT_EQ(marks - marks_before, 1);
+  EXPECT_EQ(ended - ended_before, 1);
+  EXPECT_EQ(bad_handles, 0);
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <nvtx3/nvtx3.hpp>
+
+#include <collector.hpp>
+#include <registry.hpp>
+
+#include <string>
+#include <thread>
+
+namespace {
+
+struct pause_domain {
+  static constexpr char const* name{"pause_domain"};
+};
+
+struct pause_message {
+  static constexpr char const* message{"pause_message"};
+};
+
+uint64_t count_of(char const* message)
+{
+  for (auto const& s : nvtx_collector::range_report()) {
+    if (std::string(nvtx_collector::names().lookup(s.message)) == message) { return s.count; }
+  }
+  return 0;
+}
+
+}  // namespace
+
+// Runs first: NVTX_COLLECTOR_START_PAUSED pauses the events from the attach
+TEST(Pause, StartsPausedUntilResumed)
+{
+  { nvtx3::scoped_range r{"warm_up"}; }
+  EXPECT_FALSE(nvtx3::enabled());
+
+  // Registration still reaches the collector while paused
+  auto const& message = nvtx3::registered_string_in<pause_domain>::get<pause_message>();
+  EXPECT_NE(message.get_handle(), nullptr);
+
+  EXPECT_EQ(nvtxResume(), NVTX_SUCCESS);
+  EXPECT_TRUE(nvtx3::enabled());
+  { nvtx3::scoped_range r{"steady_state"}; }
+  { nvtx3::scoped_range_in<pause_domain> r{message}; }
+
+  EXPECT_EQ(count_of("warm_up"), 0u);
+  EXPECT_EQ(count_of("steady_state"), 1u);
+  EXPECT_EQ(count_of("pause_message"), 1u);
+}
+
+TEST(Pause, PausedByTheTool)
+{
+  nvtx_collector::set_paused(true);
+  { nvtx3::scoped_range r{"tool_paused"}; }
+  nvtxMarkA("tool_paused_mark");
+  nvtx_collector::set_paused(false);
+  { nvtx3::scoped_range r{"tool_resumed"}; }
+
+  EXPECT_EQ(count_of("tool_paused"), 0u);
+  EXPECT_EQ(count_of("tool_resumed"), 1u);
+}
+
+TEST(Pause, PausedThreadIsMuted)
+{
+  std::thread background([] {
+    EXPECT_EQ(nvtxPauseThread(), NVTX_SUCCESS);
+    EXPECT_FALSE(nvtx3::enabled());
+    for (int i = 0; i < 3; ++i) {
+      nvtx3::scoped_range r{"background"};
+    }
+    EXPECT_EQ(nvtxResumeThread(), NVTX_SUCCESS);
+    { nvtx3::scoped_range r{"background_resumed"}; }
+  });
+  background.join();
+
+  // Another thread still records while one is paused
+  EXPECT_EQ(nvtxPauseThread(), NVTX_SUCCESS);
+  std::thread foreground([] { nvtx3::scoped_range r{"foreground"}; });
+  foreground.join();
+  EXPECT_EQ(nvtxResumeThread(), NVTX_SUCCESS);
+
+  EXPECT_EQ(count_of("background"), 0u);
+  EXPECT_EQ(count_of("background_resumed"), 1u);
+  EXPECT_EQ(count_of("foreground"), 1u);
+}
+
+TEST(Pause, ThreadExitingPausedMutesNoOther)
+{
+  std::thread([] {
+    EXPECT_EQ(nvtxPauseThread(), NVTX_SUCCESS);
+    nvtx3::scoped_range r{"exited_paused"};
+  }).join();
+
+  EXPECT_TRUE(nvtx3::enabled());
+  { nvtx3::scoped_range r{"after_paused_exit"}; }
+  std::thread([] { nvtx3::scoped_range r{"after_paused_exit"}; }).join();
+
+  EXPECT_EQ(count_of("exited_paused"), 0u);
+  EXPECT_EQ(count_of("after_paused_exit"), 2u);
+}
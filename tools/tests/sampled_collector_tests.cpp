@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <nvtx3/nvtx3.hpp>
+
+#include <collector.hpp>
+#include <registry.hpp>
+#include <sink.hpp>
+
+#include "memory_sink.hpp"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct sampled_domain {
+  static constexpr char const* name{"sampled_collector_test"};
+};
+
+std::string message_of(nvtx_collector::event_record const& e)
+{
+  return nvtx_collector::names().lookup(e.message);
+}
+
+}  // namespace
+
+// Run with NVTX_COLLECTOR_SAMPLE_EVERY=4 and NVTX_COLLECTOR_SAMPLE_FRACTION=0.5.
+TEST(SampledCollector, KeepsSubtreesConsistentAndDeterministic)
+{
+  nvtx3::mark_in<sampled_domain>("initialize");
+  nvtx_collector::set_sink(std::unique_ptr<nvtx_collector::sink>(new memory_sink));
+
+  constexpr int iterations = 4000;
+  constexpr int inner      = 4;
+  auto work                = [] {
+    for (int i = 0; i < iterations; ++i) {
+      nvtx3::scoped_range_in<sampled_domain> outer{"sampled_outer"};
+      for (int j = 0; j < inner; ++j) {
+        nvtx3::scoped_range_in<sampled_domain> child{"sampled_inner"};
+        nvtx3::mark_in<sampled_domain>("sampled_mark");
+      }
+    }
+  };
+  std::thread first(work);
+  first.join();
+  std::thread second(work);
+  second.join();
+  nvtx_collector::flush();
+
+  ASSERT_EQ(recorded_by_thread().size(), 2u);
+  auto const& a = recorded_by_thread().begin()->second;
+  auto const& b = recorded_by_thread().rbegin()->second;
+
+  // The same events on two threads give the same choices
+  ASSERT_EQ(a.size(), b.size());
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    EXPECT_EQ(a[i].type, b[i].type);
+    EXPECT_EQ(a[i].message, b[i].message);
+  }
+
+  std::vector<std::string> stack;
+  std::map<std::string, int> pushes;
+  for (auto const& e : a) {
+    switch (e.type) {
+      case nvtx_collector::event_type::push:
+        if (message_of(e) == "sampled_inner") {
+          ASSERT_EQ(stack.size(), 1u);
+          EXPECT_EQ(stack.back(), "sampled_outer");
+        } else {
+          EXPECT_TRUE(stack.empty());
+        }
+        stack.push_back(message_of(e));
+        ++pushes[message_of(e)];
+        break;
+      case nvtx_collector::event_type::pop:
+        ASSERT_FALSE(stack.empty());
+        stack.pop_back();
+        break;
+      case nvtx_collector::event_type::mark: EXPECT_FALSE(stack.empty()); break;
+      default: break;
+    }
+  }
+  EXPECT_TRUE(stack.empty());
+
+  // Half the outer ranges pass the fraction, a quarter of those are recorded
+  int const expected = iterations / 8;
+  EXPECT_GT(pushes["sampled_outer"], expected / 2);
+  EXPECT_LT(pushes["sampled_outer"], expected * 2);
+  // Each recorded outer range holds four inner ones, of which one is recorded
+  EXPECT_EQ(pushes["sampled_inner"], pushes["sampled_outer"]);
+}
+
+TEST(SampledCollector, ReportsNestingOfDroppedRanges)
+{
+  std::vector<int> depths;
+  for (int i = 0; i < 8; ++i) { depths.push_back(nvtxRangePushA("sampled_depth")); }
+  for (int i = 0; i < 8; ++i) { EXPECT_EQ(nvtxRangePop(), 7 - i); }
+  for (int i = 0; i < 8; ++i) { EXPECT_EQ(depths[i], i); }
+  EXPECT_EQ(nvtxRangePop(), -1);
+}
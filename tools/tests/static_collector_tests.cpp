@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <nvtx3/nvtx3.hpp>
+
+#include <collector.hpp>
+#include <registry.hpp>
+#include <sink.hpp>
+#include <trace_reader.hpp>
+
+#include "memory_sink.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct static_domain {
+  static constexpr char const* name{"static_collector_test"};
+};
+
+std::string trace_path(char const* file) { return std::string(std::getenv("TRACE_DIR")) + "/" + file; }
+
+std::string read_file(std::string const& path)
+{
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+/// Decoded protobuf field: varint value or length-delimited bytes.
+struct proto_field {
+  uint32_t number;
+  uint64_t value;
+  std::string bytes;
+};
+
+std::vector<proto_field> decode(std::string const& message)
+{
+  std::vector<proto_field> fields;
+  std::size_t i = 0;
+  auto varint   = [&] {
+    uint64_t v = 0;
+    for (int shift = 0; i < message.size(); shift += 7) {
+      auto const b = static_cast<unsigned char>(message[i++]);
+      v |= uint64_t{b & 0x7fu} << shift;
+      if (!(b & 0x80)) { break; }
+    }
+    return v;
+  };
+  while (i < message.size()) {
+    uint64_t const tag = varint();
+    proto_field f{static_cast<uint32_t>(tag >> 3), 0, {}};
+    switch (tag & 7) {
+      case 0: f.value = varint(); break;
+      case 1: i += 8; break;
+      case 2: {
+        auto const n = static_cast<std::size_t>(varint());
+        f.bytes      = message.substr(i, n);
+        i += n;
+        break;
+      }
+      default: ADD_FAILURE() << "unexpected wire type"; return fields;
+    }
+    fields.push_back(std::move(f));
+  }
+  return fields;
+}
+
+}  // namespace
+
+TEST(StaticCollector, RecordsWithoutInjectionPath)
+{
+  // The first NVTX call initializes NVTX, which attaches the linked-in collector.
+  nvtx3::mark_in<static_domain>("initialize");
+  nvtx_collector::set_sink(std::unique_ptr<nvtx_collector::sink>(new memory_sink));
+
+  { nvtx3::scoped_range_in<static_domain> range{"static_range"}; }
+  nvtx_collector::flush();
+
+  ASSERT_EQ(recorded().size(), 2u);
+  EXPECT_EQ(recorded()[0].type, nvtx_collector::event_type::push);
+  EXPECT_EQ(recorded()[1].type, nvtx_collector::event_type::pop);
+  EXPECT_STREQ(nvtx_collector::names().lookup(recorded()[0].message), "static_range");
+  EXPECT_EQ(nvtx_collector::statistics().dropped, 0u);
+}
+
+TEST(StaticCollector, WritesReadableBinaryTrace)
+{
+  std::string const path = trace_path("static_collector_test.nvtxtrace");
+  nvtx_collector::set_sink(nvtx_collector::make_binary_sink(path, nvtx_collector::names()));
+
+  // More events per thread than fit in one segment
+  constexpr int threads = 2;
+  constexpr int ranges  = 2000;
+  nvtx3::named_category_in<static_domain> const category{7, "static_category"};
+  std::vector<std::thread> workers;
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back([&] {
+      for (int r = 0; r < ranges; ++r) {
+        nvtx3::scoped_range_in<static_domain> range{"binary_range", category};
+      }
+    });
+  }
+  for (auto& w : workers) { w.join(); }
+  nvtx_collector::set_sink(nullptr);  // Closes the trace
+
+  nvtx_collector::trace_reader trace(path);
+  EXPECT_TRUE(trace.complete());
+  ASSERT_EQ(trace.threads().size(), static_cast<std::size_t>(threads));
+  for (auto const& t : trace.threads()) {
+    EXPECT_GT(t.segments.size(), 1u);
+    EXPECT_EQ(t.event_count, 2u * ranges);
+  }
+
+  int pushes = 0;
+  trace.for_each_event([&](nvtx_collector::trace_reader::thread const&,
+                           nvtx_collector::event_record const& e) {
+    if (e.type != nvtx_collector::event_type::push) { return; }
+    ++pushes;
+    EXPECT_STREQ(trace.string(e.message), "binary_range");
+    EXPECT_STREQ(trace.domain_name(e.domain), static_domain::name);
+    EXPECT_STREQ(trace.category_name(e.domain, e.category), "static_category");
+  });
+  EXPECT_EQ(pushes, threads * ranges);
+}
+
+TEST(StaticCollector, StreamsPerfettoTrace)
+{
+  std::string const path = trace_path("static_collector_test.perfetto-trace");
+  nvtx_collector::set_sink(nvtx_collector::make_perfetto_sink(path, nvtx_collector::names(), 1));
+  {
+    nvtx3::scoped_range_in<static_domain> range{"perfetto_range"};
+    nvtx3::mark_in<static_domain>("perfetto_mark");
+    nvtx3::end_range_in<static_domain>(nvtx3::start_range_in<static_domain>("perfetto_async"));
+  }
+  nvtx_collector::set_sink(nullptr);
+
+  // Every top-level field must be a TracePacket; count TrackEvent types
+  std::map<uint64_t, int> types;
+  std::vector<std::string> names;
+  for (auto const& packet : decode(read_file(path))) {
+    ASSERT_EQ(packet.number, 1u);
+    for (auto const& field : decode(packet.bytes)) {
+      if (field.number == 11) {  // track_event
+        for (auto const& e : decode(field.bytes)) {
+          if (e.number == 9) { ++types[e.value]; }
+        }
+      } else if (field.number == 12) {  // interned_data
+        for (auto const& i : decode(field.bytes)) {
+          if (i.number != 2) { continue; }  // event_names
+          for (auto const& n : decode(i.bytes)) {
+            if (n.number == 2) { names.push_back(n.bytes); }
+          }
+        }
+      }
+    }
+  }
+  EXPECT_EQ(types[1], 2);  // SLICE_BEGIN: push and start
+  EXPECT_EQ(types[2], 2);  // SLICE_END: pop and end
+  EXPECT_EQ(types[3], 1);  // INSTANT: mark
+  EXPECT_EQ(names, (std::vector<std::string>{"perfetto_range", "perfetto_mark", "perfetto_async"}));
+}
+
+TEST(StaticCollector, StreamsChromeJson)
+{
+  std::string const path = trace_path("static_collector_test.json");
+  nvtx_collector::set_sink(nvtx_collector::make_json_sink(path, nvtx_collector::names(), 1));
+  { nvtx3::scoped_range_in<static_domain> range{"json \"quoted\" range"}; }
+  nvtx_collector::set_sink(nullptr);
+
+  std::string const json = read_file(path);
+  EXPECT_EQ(json.rfind("{\"displayTimeUnit\"", 0), 0u);
+  EXPECT_NE(json.find("\"ph\":\"B\""), std::string::npos);
+  EXPECT_NE(json.find("\"ph\":\"E\""), std::string::npos);
+  EXPECT_NE(json.find("\"name\":\"json \\\"quoted\\\" range\""), std::string::npos);
+  EXPECT_NE(json.find("\"cat\":\"static_collector_test\""), std::string::npos);
+  EXPECT_EQ(json.substr(json.size() - 4), "\n]}\n");
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <nvtx3/nvToolsExt.h>
+
+#include "collector_output.hpp"
+#include "looping_threads.hpp"
+
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+char const* collector_path()
+{
+  char const* path = std::getenv("NVTX_COLLECTOR_PATH");
+  return path ? path : "";
+}
+
+/// Number of static key sites of this executable whose instruction starts with `opcode`.
+int sites_starting_with(unsigned char opcode)
+{
+  int n = 0;
+  for (auto const* site = NVTX_VERSIONED_IDENTIFIER(__start_nvtxStaticKeySites);
+       site && site < NVTX_VERSIONED_IDENTIFIER(__stop_nvtxStaticKeySites);
+       ++site) {
+    auto const* code = reinterpret_cast<unsigned char const*>(&site->code) + site->code;
+    if (*code == opcode) { ++n; }
+  }
+  return n;
+}
+
+constexpr unsigned char jmp = 0xe9;
+constexpr unsigned char cmp = 0x3d;
+
+/// Permissions in /proc/self/maps of the mapping holding the first static key site.
+std::string site_permissions()
+{
+  auto const* site = NVTX_VERSIONED_IDENTIFIER(__start_nvtxStaticKeySites);
+  auto const code  = reinterpret_cast<uintptr_t>(&site->code) + site->code;
+  std::string permissions;
+  if (FILE* maps = std::fopen("/proc/self/maps", "r")) {
+    unsigned long begin = 0;
+    unsigned long end   = 0;
+    char perms[5]       = {};
+    while (std::fscanf(maps, "%lx-%lx %4s%*[^\n]", &begin, &end, perms) == 3) {
+      if (code >= begin && code < end) { permissions = perms; }
+    }
+    std::fclose(maps);
+  }
+  return permissions;
+}
+
+std::atomic<int> g_application_traps{0};
+
+void application_trap(int) { ++g_application_traps; }
+
+/// Installed before NVTX initializes, so NVTX's SIGTRAP handler chains to it.
+bool const g_application_trap_installed = std::signal(SIGTRAP, application_trap) != SIG_ERR;
+
+}  // namespace
+
+// Run with NVTX_COLLECTOR_PATH naming the collector and NVTX_COLLECTOR_OUTPUT
+// set, but without NVTX_INJECTION64_PATH.
+TEST(StaticKeys, PatchesCallSitesWhenToolComesAndGoes)
+{
+  int const sites = sites_starting_with(jmp);
+  ASSERT_GT(sites, 0) << "call sites start as jumps into NVTX";
+
+  // No tool: initialization turns every site into a CMP
+  nvtxMarkA("static_keys_before");
+  EXPECT_EQ(sites_starting_with(cmp), sites);
+
+  looping_threads caller(1, [] {
+    nvtxRangePushA("static_keys_concurrent");
+    nvtxRangePop();
+  });
+  caller.wait_for_iterations(1);
+  EXPECT_EQ(nvtxAttachInjectionLibraryA(collector_path()), NVTX_SUCCESS);
+  EXPECT_EQ(sites_starting_with(jmp), sites);
+  caller.wait_for_iterations(1);
+  nvtxMarkA("static_keys_attached");
+
+  EXPECT_EQ(nvtxDetachInjectionLibrary(), NVTX_SUCCESS);
+  EXPECT_EQ(sites_starting_with(cmp), sites);
+  caller.wait_for_iterations(1);
+  caller.stop();
+  nvtxMarkA("static_keys_detached");
+
+  EXPECT_EQ(nvtxAttachInjectionLibraryA(collector_path()), NVTX_SUCCESS);
+  nvtxMarkA("static_keys_reattached");
+
+  flush_collector(collector_path());
+  EXPECT_EQ(output_lines_containing("static_keys_before").size(), 0u);
+  EXPECT_EQ(output_lines_containing("static_keys_attached").size(), 1u);
+  EXPECT_GT(output_lines_containing("static_keys_concurrent").size(), 0u);
+  EXPECT_EQ(output_lines_containing("static_keys_detached").size(), 0u);
+  EXPECT_EQ(output_lines_containing("static_keys_reattached").size(), 1u);
+}
+
+TEST(StaticKeys, CodeIsNeverWritable)
+{
+  // Patched into jumps by the attach of the previous test, and into CMPs by the detach
+  nvtxMarkA("static_keys_permissions");
+  ASSERT_GT(sites_starting_with(jmp), 0);
+  EXPECT_EQ(site_permissions(), "r-xp");
+  EXPECT_EQ(nvtxDetachInjectionLibrary(), NVTX_SUCCESS);
+  ASSERT_GT(sites_starting_with(cmp), 0);
+  EXPECT_EQ(site_permissions(), "r-xp");
+}
+
+TEST(StaticKeys, TrapsNotAtCallSitesReachTheApplication)
+{
+  ASSERT_TRUE(g_application_trap_installed);
+  nvtxMarkA("static_keys_trap");
+  int const before = g_application_traps.load();
+  std::raise(SIGTRAP);
+  EXPECT_EQ(g_application_traps.load(), before + 1);
+}
+
+TEST(StaticKeys, PatchesWhileThreadsRunCallSites)
+{
+  looping_threads callers(4, [] {
+    nvtxRangePushA("static_keys_stress");
+    nvtxMarkA("static_keys_stress");
+    nvtxRangePop();
+  });
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_EQ(nvtxAttachInjectionLibraryA(collector_path()), NVTX_SUCCESS);
+    callers.wait_for_iterations(1);
+    EXPECT_EQ(nvtxDetachInjectionLibrary(), NVTX_SUCCESS);
+    callers.wait_for_iterations(1);
+  }
+  callers.stop();
+  EXPECT_EQ(sites_starting_with(0xcc), 0);
+}
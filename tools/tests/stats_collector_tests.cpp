@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <nvtx3/nvtx3.hpp>
+
+#include <collector.hpp>
+#include <histogram.hpp>
+#include <registry.hpp>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct stats_domain {
+  static constexpr char const* name{"stats_collector_test"};
+};
+
+/// Statistics of the ranges called `message` in `stats_domain`.
+nvtx_collector::range_statistics const* find(std::vector<nvtx_collector::range_statistics> const& r,
+                                             char const* message)
+{
+  for (auto const& s : r) {
+    if (std::string(nvtx_collector::names().lookup(s.message)) == message) { return &s; }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+TEST(LogLinearHistogram, BucketsBoundValues)
+{
+  using h = nvtx_collector::log_linear_histogram;
+  for (uint64_t v : {0ull, 1ull, 7ull, 8ull, 9ull, 1000ull, 123456789ull, ~0ull}) {
+    unsigned const b = h::bucket_of(v);
+    EXPECT_LE(h::lower_bound(b), v);
+    EXPECT_GE(h::upper_bound(b), v);
+    // Relative width of a bucket is at most 1 / sub_buckets
+    EXPECT_LE(h::upper_bound(b) - h::lower_bound(b), h::lower_bound(b) / h::sub_buckets);
+  }
+  EXPECT_EQ(h::bucket_of(~0ull), h::bucket_count - 1);
+
+  h hist;
+  for (uint64_t v = 1; v <= 1000; ++v) { hist.add(v); }
+  EXPECT_EQ(hist.count(), 1000u);
+  EXPECT_NEAR(static_cast<double>(hist.percentile(0.5)), 500.0, 500.0 / h::sub_buckets);
+  EXPECT_GE(hist.percentile(1.0), 1000u);
+}
+
+TEST(StatsCollector, AggregatesRangesAcrossThreads)
+{
+  constexpr int threads = 4;
+  constexpr int ranges  = 1000;
+  std::vector<std::thread> workers;
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back([] {
+      for (int r = 0; r < ranges; ++r) {
+        nvtx3::scoped_range_in<stats_domain> outer{"stats_outer"};
+        nvtx3::scoped_range_in<stats_domain> inner{"stats_inner"};
+      }
+    });
+  }
+  for (auto& w : workers) { w.join(); }
+
+  auto const report = nvtx_collector::range_report();
+  auto const* outer = find(report, "stats_outer");
+  auto const* inner = find(report, "stats_inner");
+  ASSERT_NE(outer, nullptr);
+  ASSERT_NE(inner, nullptr);
+  EXPECT_EQ(outer->count, static_cast<uint64_t>(threads * ranges));
+  EXPECT_EQ(inner->count, static_cast<uint64_t>(threads * ranges));
+  EXPECT_EQ(outer->histogram.count(), outer->count);
+  EXPECT_GE(outer->total_ns, inner->total_ns);
+  EXPECT_LE(outer->min_ns, outer->max_ns);
+}
+
+TEST(StatsCollector, MatchesStartEndAcrossThreads)
+{
+  auto id = nvtx3::start_range_in<stats_domain>("stats_async");
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  std::thread([&] { nvtx3::end_range_in<stats_domain>(id); }).join();
+  // A second end of the same range is ignored
+  nvtx3::end_range_in<stats_domain>(id);
+
+  auto const report = nvtx_collector::range_report();
+  auto const* async = find(report, "stats_async");
+  ASSERT_NE(async, nullptr);
+  EXPECT_EQ(async->count, 1u);
+  EXPECT_GE(async->min_ns, 2000000u);
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <nvtx3/nvtx3.hpp>
+
+#include <collector.hpp>
+#include <registry.hpp>
+#include <sink.hpp>
+
+#include "memory_sink.hpp"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct threshold_domain {
+  static constexpr char const* name{"threshold_collector_test"};
+};
+
+/// Longer than NVTX_COLLECTOR_MIN_DURATION_NS of the test.
+void wait_long() { std::this_thread::sleep_for(std::chrono::milliseconds(3)); }
+
+std::string message_of(nvtx_collector::event_record const& e)
+{
+  return nvtx_collector::names().lookup(e.message);
+}
+
+}  // namespace
+
+// Run with NVTX_COLLECTOR_MIN_DURATION_NS=1000000.
+TEST(ThresholdCollector, KeepsLongPushPopRangesNested)
+{
+  nvtx3::mark_in<threshold_domain>("initialize");
+  nvtx_collector::set_sink(std::unique_ptr<nvtx_collector::sink>(new memory_sink));
+  recorded().clear();
+
+  {
+    nvtx3::scoped_range_in<threshold_domain> outer{"threshold_outer"};
+    { nvtx3::scoped_range_in<threshold_domain> brief{"threshold_short"}; }
+    {
+      nvtx3::scoped_range_in<threshold_domain> middle{"threshold_middle"};
+      { nvtx3::scoped_range_in<threshold_domain> brief{"threshold_short"}; }
+      nvtx3::scoped_range_in<threshold_domain> inner{"threshold_inner"};
+      wait_long();
+    }
+    { nvtx3::scoped_range_in<threshold_domain> brief{"threshold_short"}; }
+  }
+  { nvtx3::scoped_range_in<threshold_domain> brief{"threshold_short"}; }
+  nvtx_collector::flush();
+
+  using nvtx_collector::event_type;
+  std::vector<std::pair<event_type, std::string>> expected{{event_type::push, "threshold_outer"},
+                                                           {event_type::push, "threshold_middle"},
+                                                           {event_type::push, "threshold_inner"},
+                                                           {event_type::pop, ""},
+                                                           {event_type::pop, ""},
+                                                           {event_type::pop, ""}};
+  ASSERT_EQ(recorded().size(), expected.size());
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(recorded()[i].type, expected[i].first);
+    if (recorded()[i].type == event_type::push) {
+      EXPECT_EQ(message_of(recorded()[i]), expected[i].second);
+    }
+    if (i > 0) { EXPECT_LE(recorded()[i - 1].timestamp, recorded()[i].timestamp); }
+  }
+  EXPECT_GE(recorded()[5].timestamp - recorded()[0].timestamp, 1000000u);
+}
+
+TEST(ThresholdCollector, KeepsLongStartEndRanges)
+{
+  recorded().clear();
+  auto brief = nvtx3::start_range_in<threshold_domain>("threshold_brief");
+  nvtx3::end_range_in<threshold_domain>(brief);
+  auto slow = nvtx3::start_range_in<threshold_domain>("threshold_slow");
+  wait_long();
+  std::thread([&] { nvtx3::end_range_in<threshold_domain>(slow); }).join();
+  nvtx_collector::flush();
+
+  ASSERT_EQ(recorded().size(), 2u);
+  EXPECT_EQ(recorded()[0].type, nvtx_collector::event_type::range_start);
+  EXPECT_EQ(message_of(recorded()[0]), "threshold_slow");
+  EXPECT_EQ(recorded()[1].type, nvtx_collector::event_type::range_end);
+  EXPECT_EQ(recorded()[0].range_id, recorded()[1].range_id);
+  EXPECT_NE(recorded()[0].range_id, 0u);
+}
+
+TEST(ThresholdCollector, ReturnsNestingDepth)
+{
+  EXPECT_EQ(nvtxRangePushA("threshold_depth"), 0);
+  EXPECT_EQ(nvtxRangePushA("threshold_depth"), 1);
+  EXPECT_EQ(nvtxRangePop(), 1);
+  EXPECT_EQ(nvtxRangePop(), 0);
+  EXPECT_EQ(nvtxRangePop(), -1);
+}